@@ -2,30 +2,32 @@
 
 #include <QDebug>
 #include <qguiapplication.h>
+#include <algorithm>
+#include <chrono>
 
 using namespace std;
 
 #ifdef DEBUG
 static void ffmpeg_log_callback(void* ptr, int level, const char* fmt, va_list vargs)
 {
-    // ־ǿԺһЩϸϢ
+    // 检查日志级别，我们可以忽略一些过于详细的信息
     if (level > av_log_get_level())
         return;
 
-    // һ㹻Ļ洢ʽ־Ϣ
+    // 创建一个足够大的缓冲区来存储格式化后的日志消息
     char message[1024];
 
-    // ʹ vsnprintf ȫظʽ־
-    // FFmpeg ݵ fmt ʽַͨѾ "[libx264 @ ...]" Ϣ
+    // 使用 vsnprintf 安全地格式化日志内容
+    // FFmpeg 传递的 fmt 格式字符串通常已经包含了像 "[libx264 @ ...]" 这样的上下文信息
     vsnprintf(message, sizeof(message), fmt, vargs);
 
-    // ȥϢĩβĻзΪqDebugԶ
+    // 去掉消息末尾多余的换行符，因为qDebug会自动添加
     size_t len = strlen(message);
     if (len > 0 && message[len - 1] == '\n') {
         message[len - 1] = '\0';
     }
 
-    // FFmpeg־ѡʹQtĲͬ
+    // 根据FFmpeg的日志级别，选择使用Qt的不同输出流
     switch (level) {
     case AV_LOG_PANIC:
     case AV_LOG_FATAL:
@@ -58,6 +60,27 @@ static void avCheckRet(const char* operate, int ret)
 }
 
 
+// 复制一份编码参数（含 extradata），得到的上下文不会被打开，只用于创建输出流
+static AVCodecContext* copyCodecParams(const AVCodecContext* src)
+{
+    AVCodecContext* dst = avcodec_alloc_context3(nullptr);
+    AVCodecParameters* par = avcodec_parameters_alloc();
+    if (!dst || !par ||
+        avcodec_parameters_from_context(par, src) < 0 ||
+        avcodec_parameters_to_context(dst, par) < 0)
+    {
+        avcodec_parameters_free(&par);
+        avcodec_free_context(&dst);
+        return nullptr;
+    }
+    avcodec_parameters_free(&par);
+
+    dst->time_base = src->time_base;
+    dst->framerate = src->framerate;
+    dst->flags = src->flags;
+    return dst;
+}
+
 CAVRecorder::CAVRecorder()
 {
     av_register_all();
@@ -70,6 +93,7 @@ CAVRecorder::~CAVRecorder()
     {
         stopRecording();
     }
+    release();
 }
 
 QAudioFormat CAVRecorder::setAudioFormat(const AudioFormat& config)
@@ -92,20 +116,160 @@ bool CAVRecorder::initialize(AVConfig& config)
         qWarning() << "Controller is busy. Please stop recording first.";
         return false;
     }
+    if (isWarm_)
+    {
+        qWarning() << "Recorder is warm, call release() before initialize().";
+        return false;
+    }
 
     cleanup();
     config_ = config;
 
-    // ------------------------- muxerʼ -------------------------
-    muxer_.reset(new CMuxer{});
-    if (!muxer_->initialize(config_.path_.c_str())) 
+    if (!createComponents())
+        return false;
+    config.audioFmt_ = config_.audioFmt_;   // 录音设备最终使用的格式
+
+    replayEpochUs_ = 0;
+    if (!openSession(0))
     {
-        qCritical() << "Failed to initialize Muxer.";
         cleanup();
         return false;
     }
 
-    // ------------------------- Ƶʼ -------------------------
+    qInfo() << "Recorder Controller initialized successfully.";
+    return true;
+}
+
+bool CAVRecorder::prepare(AVConfig& config)
+{
+    if (isRecording_)
+    {
+        qWarning() << "Controller is busy. Please stop recording first.";
+        return false;
+    }
+    if (isWarm_)
+    {
+        qWarning() << "Recorder is already warm.";
+        return true;
+    }
+
+    cleanup();
+    config_ = config;
+    config_.path_.clear();
+
+    if (!createComponents())
+        return false;
+    config.audioFmt_ = config_.audioFmt_;
+
+    // 线程一直运行，没有录制任务时挂起；录音设备保持打开但暂停采集，开始录制时才恢复
+    isWarm_.store(true);
+    isRunning_.store(true);
+    startThreads();
+    audioCapturer_->start();
+    audioCapturer_->suspend();
+
+    // 开启即时回放时立即开始编码，未录制期间的数据只写入回放缓存
+    replayEpochUs_ = CMediaClock::nowUs();
+    if (replayBuffer_ && !beginSession(std::string{}))
+        qWarning() << "Failed to start replay capture, replay buffer stays empty until recording.";
+
+    qInfo() << "Recorder is warm, waiting for recording.";
+    return true;
+}
+
+bool CAVRecorder::startRecording(const std::string& filePath)
+{
+    if (!isWarm_)
+    {
+        qWarning() << "Recorder is not warm, call prepare() first.";
+        return false;
+    }
+    if (isRecording_.load())
+    {
+        qWarning() << "Recording is already in progress.";
+        return false;
+    }
+    if (filePath.empty())
+    {
+        qWarning() << "Recording path is empty.";
+        return false;
+    }
+
+    // 只需要打开输出文件；上一次录制可能仍在后台收尾，编码线程会先结束它，再编码本次录制的数据
+    if (!beginSession(filePath))
+    {
+        qCritical() << "Failed to open recording outputs.";
+        return false;
+    }
+    isRecording_.store(true);
+
+    qInfo() << "Recording started:" << filePath.c_str();
+    return true;
+}
+
+bool CAVRecorder::beginSession(const std::string& filePath)
+{
+    config_.path_ = filePath;
+    const int64_t startUs = CMediaClock::nowUs();
+    if (!openSession(startUs))
+        return false;
+
+    // 正在为回放缓存编码时先结束那一次，下一次的帧紧接在结束标记之后，回放缓存中两者时间连续
+    if (isCapturing_.load())
+        endSession();
+    sessionStartUs_ = startUs;
+    audioCapturer_->resume();
+
+    {
+        std::lock_guard<std::mutex> lock{ sessionMtx_ };
+        isCapturing_.store(true);
+    }
+    sessionCond_.notify_all();
+    return true;
+}
+
+void CAVRecorder::endSession()
+{
+    // 空帧作为本次录制的结束标记，排在最后一帧之后；音频编码线程通过 stoppedSessions_ 得知
+    rawVideoQueue_.push(RGBAUPtr{});
+    {
+        std::lock_guard<std::mutex> lock{ sessionMtx_ };
+        sessionStopUs_.store(CMediaClock::nowUs());
+        isCapturing_.store(false);
+        stoppedSessions_.fetch_add(1);
+    }
+    sessionCond_.notify_all();
+}
+
+void CAVRecorder::release()
+{
+    if (!isWarm_)
+        return;
+
+    // 结束正在进行的录制或回放缓存的编码
+    isRecording_.store(false);
+    if (isCapturing_.load())
+        endSession();
+
+    // 先停止线程再关闭设备，退出前会写完所有仍在收尾的录制
+    stopThreads();
+    audioCapturer_->stop();
+    isWarm_.store(false);
+
+    cleanup();
+    replayBuffer_.reset();
+    replayEpochUs_ = 0;
+
+    qInfo() << "Warm recorder released.";
+}
+
+bool CAVRecorder::createComponents()
+{
+    // ------------------------- 视频编码器初始化 -------------------------
+    // pts 来自采集时间戳，可变帧率时使用 90kHz 时间基，固定帧率时时间基与帧率一致
+    config_.videoCodecCfg_.time_base_ = config_.videoCodecCfg_.constant_frame_rate_ ?
+        av_inv_q(config_.videoCodecCfg_.framerate_) : AVRational{ 1, 90000 };
+
     videoEncoder_.reset(new CVideoEncoder{});
     if (!videoEncoder_->initialize(config_.videoCodecCfg_)) 
     {
@@ -113,89 +277,234 @@ bool CAVRecorder::initialize(AVConfig& config)
         cleanup();
         return false;
     }
-    AVStream* videoStream = muxer_->addStream(videoEncoder_->getCodecContext());
-    if (!videoStream)
-    {
-        qCritical() << "Failed to Add Video Stream.";
-        return false;
-    }
-    videoEncoder_->setStream(videoStream);
 
-    // ------------------------- ¼豸ʼ -------------------------
+    // ------------------------- 录音设备初始化 -------------------------
     audioCapturer_.reset(new CAudioCapturer{});
-    QAudioFormat audioFormat = setAudioFormat(config.audioFmt_);
-    if (!audioCapturer_->initialize(audioFormat, config.audioFmt_))
+    QAudioFormat audioFormat = setAudioFormat(config_.audioFmt_);
+    if (!audioCapturer_->initialize(audioFormat, config_.audioFmt_))
     {
         qCritical() << "Failed to initialize Audio Capturer.";
         cleanup();
         return false;
     }
 
-    // ------------------------- Ƶʼ -------------------------
+    // ------------------------- 音频编码器初始化 -------------------------
     audioEncoder_.reset(new CAudioEncoder{});
     //const QAudioFormat& finalAudioFormat = audioCapturer_->getAudioFormat();
-    if (!audioEncoder_->initialize(config.audioCodecCfg_, config.audioFmt_))
+    if (!audioEncoder_->initialize(config_.audioCodecCfg_, config_.audioFmt_))
     {
         qCritical() << "Failed to initialize Audio Encoder.";
         cleanup();
         return false;
     }
-    AVStream* audioStream = muxer_->addStream(audioEncoder_->getCodecContext());
-    if (!audioStream)
+
+    // 编码线程在每次录制结束后会重新打开编码器，开始录制时只使用这份参数副本
+    videoParams_ = copyCodecParams(videoEncoder_->getCodecContext());
+    audioParams_ = copyCodecParams(audioEncoder_->getCodecContext());
+    if (!videoParams_ || !audioParams_)
     {
-        qCritical() << "Failed to Add Audio Stream.";
+        qCritical() << "Failed to copy codec parameters.";
+        cleanup();
         return false;
     }
-    audioEncoder_->setStream(audioStream);
 
-    // ------------------------- дļͷ -------------------------
-    if (!muxer_->writeHeader()) 
+    // ------------------------- 质量调节 -------------------------
+    qualityGovernor_.reset();
+    if (config_.qualityCfg_.enable_)
     {
-        qCritical() << "Failed to write muxer header.";
-        cleanup();
-        return false;
+        qualityGovernor_.reset(new CQualityGovernor{});
+        qualityGovernor_->initialize(config_.qualityCfg_, config_.videoCodecCfg_, rawVideoQueue_.capacity());
     }
 
-    qInfo() << "Recorder Controller initialized successfully.";
+    // ------------------------- 即时回放缓存（可选） -------------------------
+    // 与编码器一同创建，各次录制共用，停止录制后仍可保存
+    replayBuffer_.reset();
+    if (config_.replayCfg_.enable_)
+    {
+        replayBuffer_.reset(new CReplayBuffer{});
+        replayBuffer_->initialize(config_.replayCfg_);
+        if (!replayBuffer_->addStream(videoParams_, videoParams_->time_base) ||
+            !replayBuffer_->addStream(audioParams_, audioParams_->time_base))
+        {
+            qWarning() << "Failed to initialize replay buffer, continue without it.";
+            replayBuffer_.reset();
+        }
+        else
+        {
+            // 单个 GOP 超过内存上限时请求 IDR 帧，使旧的 GOP 可以丢弃
+            replayBuffer_->setKeyFrameRequester([this] { videoEncoder_->requestKeyFrame(); });
+        }
+    }
+
+    setEncoderTimeBases();
     return true;
 }
 
+void CAVRecorder::setEncoderTimeBases()
+{
+    videoEncoder_->setTimeBase(videoParams_->time_base, 0);
+    audioEncoder_->setTimeBase(audioParams_->time_base, 1);
+}
+
+bool CAVRecorder::openSession(int64_t startUs)
+{
+    std::unique_ptr<RecordSession> session{ new RecordSession{} };
+    session->path = config_.path_;
+    session->startUs = startUs;
+    session->srcTimeBases[0] = videoParams_->time_base;
+    session->srcTimeBases[1] = audioParams_->time_base;
+
+    // ------------------------- muxer初始化 -------------------------
+    // 只开启即时回放且未指定录制路径时，编码后的包只进入回放缓存，不写录制文件
+    const bool replayOnly = config_.path_.empty() && replayBuffer_;
+    if (!replayOnly)
+    {
+        session->muxer.reset(new CMuxer{});
+        if (!session->muxer->initialize(config_.path_.c_str(), config_.muxerCfg_))
+        {
+            qCritical() << "Failed to initialize Muxer.";
+            return false;
+        }
+
+        AVStream* videoStream = session->muxer->addStream(videoParams_);
+        AVStream* audioStream = session->muxer->addStream(audioParams_);
+        if (!videoStream || !audioStream)
+        {
+            qCritical() << "Failed to Add Video/Audio Stream.";
+            return false;
+        }
+
+        // ------------------------- 写入文件头 -------------------------
+        if (!session->muxer->writeHeader())
+        {
+            qCritical() << "Failed to write muxer header.";
+            return false;
+        }
+        // 流的时间基在写入文件头时才最终确定
+        session->dstTimeBases[0] = videoStream->time_base;
+        session->dstTimeBases[1] = audioStream->time_base;
+    }
+
+    // ------------------------- 本地 HLS 输出（可选） -------------------------
+    if (config_.hlsCfg_.enable_ && !replayOnly)
+    {
+        // 流的添加顺序与 muxer 一致，两者共用 pkt 的 stream_index
+        session->hlsSink.reset(new CHlsSink{});
+        bool ok = session->hlsSink->initialize(config_.hlsCfg_) &&
+            session->hlsSink->addStream(videoParams_, session->srcTimeBases[0]) &&
+            session->hlsSink->addStream(audioParams_, session->srcTimeBases[1]) &&
+            session->hlsSink->writeHeader();
+        if (ok)
+        {
+            // 分段快到目标时长时，请求编码器生成 IDR 帧作为下一个分段的起点
+            session->hlsSink->setKeyFrameRequester([this] { videoEncoder_->requestKeyFrame(); });
+        }
+        else
+        {
+            qWarning() << "Failed to initialize HLS sink, continue without it.";
+            session->hlsSink.reset();
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock{ sessionMtx_ };
+        session->id = nextSessionId_++;
+        sessions_.push_back(std::move(session));
+    }
+    return true;
+}
+
+CAVRecorder::RecordSession* CAVRecorder::findSession(uint32_t id)
+{
+    std::lock_guard<std::mutex> lock{ sessionMtx_ };
+    for (const std::unique_ptr<RecordSession>& session : sessions_)
+    {
+        if (session->id == id)
+            return session.get();
+    }
+    return nullptr;
+}
+
+void CAVRecorder::writeSessionPacket(RecordSession* session, AVPacket* packet)
+{
+    const int index = packet->stream_index;
+    if (index < 0 || index > 1)
+        return;
+
+    // 回放缓存和 HLS 只引用 pkt，必须在 muxer 取走 pkt 之前写入
+    if (replayBuffer_)
+    {
+        // 每次录制的时间戳从0开始，加上本次录制开始的时间，使各次录制在回放缓存中首尾相接
+        const int64_t offset = av_rescale_q(session->startUs - replayEpochUs_, AV_TIME_BASE_Q, session->srcTimeBases[index]);
+        if (packet->pts != AV_NOPTS_VALUE) packet->pts += offset;
+        if (packet->dts != AV_NOPTS_VALUE) packet->dts += offset;
+        replayBuffer_->push(packet);
+        if (packet->pts != AV_NOPTS_VALUE) packet->pts -= offset;
+        if (packet->dts != AV_NOPTS_VALUE) packet->dts -= offset;
+    }
+    if (session->hlsSink)
+        session->hlsSink->writePacket(packet);
+
+    if (session->muxer)
+    {
+        av_packet_rescale_ts(packet, session->srcTimeBases[index], session->dstTimeBases[index]);
+        session->muxer->writePacket(packet);
+    }
+}
+
 void CAVRecorder::startRecording() {
+    if (isWarm_)
+    {
+        qWarning() << "Recorder is warm, use startRecording(filePath) instead.";
+        return;
+    }
     if (isRecording_.load()) 
     {
         qWarning() << "Recording is already in progress.";
         return;
     }
 
-    // 1. ʱ
+    // 1. 重置时间戳，视频帧的时间戳从这里开始计算
     videoEncoder_->resetTimestamp();
     audioEncoder_->resetTimestamp();
+    sessionStartUs_ = CMediaClock::nowUs();
 
-    // 2. ÿƱ־
+    // 2. 设置控制标志
     isRecording_.store(true);
-	isRunning_.store(true);  // ߳
+    isCapturing_.store(true);
+	isRunning_.store(true);  // 允许线程运行
 
-    // 3. к̨߳
+    // 3. 启动所有后台线程
     startThreads();
 
-    // 4. Ƶɼ豸
+    // 4. 启动音频采集设备
     audioCapturer_->start();
 
     qInfo() << "Asynchronous recording process started.";
 }
 
 void CAVRecorder::stopRecording() {
-    if (!isRecording_.exchange(false)) {
+    if (!isRecording_.load()) {
         return;
     }
     qInfo() << "Stopping recording process...";
 
-    audioCapturer_->stop(); // ֹͣ¼
+    endSession();
+    isRecording_.store(false);
 
-    stopThreads();
+    if (isWarm_)
+    {
+        // 开启即时回放时继续编码写入回放缓存，否则暂停录音设备
+        if (!replayBuffer_ || !beginSession(std::string{}))
+            audioCapturer_->suspend();
+        // 常驻模式：本次录制在后台收尾，完成后发出 recordingFinished 信号
+        qInfo() << "Recording stopped, finalizing in background.";
+        return;
+    }
 
-    qInfo() << "Flushing final packets and closing muxer...";
-    muxer_->close();
+    // 等待所有线程写完本次录制后退出
+    stopThreads();
+    audioCapturer_->stop(); // 停止录音
     cleanup();
 
     //aacFile->close();
@@ -204,25 +513,31 @@ void CAVRecorder::stopRecording() {
     qInfo() << "Recording process stopped and resources cleaned up.";
 }
 
-void CAVRecorder::pushRGBA(const unsigned char* rgbaData) {
-    // 1. ¼״ֹ̬ͣ֡
-    if (!isRecording_.load(std::memory_order_relaxed) || !rgbaData) {
+void CAVRecorder::pushRGBA(const unsigned char* rgbaData, int64_t timestampUs) {
+    // 1. 检查录制状态，如果已停止，则忽略新来的帧
+    if (!isCapturing_.load(std::memory_order_relaxed) || !rgbaData) {
         return;
     }
 
-    // 2. Ƿһ飬ԷֹȻѹ
+    // 2. 检查队列是否已满（这是一个软检查，可以防止过度积压）
+    //    编码跟不上时每帧都会走到这里，只按间隔输出日志，丢帧数交给质量调节
     if (rawVideoQueue_.isFull()) {
-        qWarning() << "Video queue is full, dropping frame to reduce latency.";
+        const uint64_t dropped = ++droppedFrames_;
+        if (dropped % 100 == 1)
+            qWarning() << "Video queue is full, dropping frame to reduce latency. Total dropped:" << dropped;
         return;
     }
 
-	// ʹunique_ptrֻҪһζڴ棬ֱʹvectorᷢζڴ䣺һڴ˴һlock_free_queuepushС
-    auto uptr_rgba = std::make_unique<std::vector<uint8_t>>();
+	// 这里使用unique_ptr，只需要分配一次堆内存，如果直接使用vector，会发生两次堆内存分配：一次在此处，一次在lock_free_queue的push函数中。
+    auto uptr_rgba = std::make_unique<RgbaFrame>();
     const size_t dataSize = static_cast<size_t>(config_.videoCodecCfg_.in_width_) * config_.videoCodecCfg_.in_height_ * 4;
-    uptr_rgba->resize(dataSize);
-    memcpy(uptr_rgba->data(), rgbaData, dataSize);
+    uptr_rgba->rgba_data.resize(dataSize);
+    memcpy(uptr_rgba->rgba_data.data(), rgbaData, dataSize);
+
+    // 4. 记录采集时间（相对本次录制开始），丢帧不会影响后续帧的 pts
+    uptr_rgba->timestampUs = (timestampUs < 0 ? CMediaClock::nowUs() : timestampUs) - sessionStartUs_.load(std::memory_order_relaxed);
 
-    // 5. ݵ֡
+    // 5. 将包含数据的帧对象移入无锁队列
     rawVideoQueue_.push(std::move(uptr_rgba));
 }
 
@@ -231,35 +546,87 @@ bool CAVRecorder::isRecording() const
     return isRecording_;
 }
 
+bool CAVRecorder::isCapturing() const
+{
+    return isCapturing_;
+}
+
+QualityStats CAVRecorder::getQualityStats() const
+{
+    if (!qualityGovernor_)
+        return QualityStats{};
+    return qualityGovernor_->stats();
+}
+
+double CAVRecorder::getAudioLatencyMs() const
+{
+    return audioLatencyUs_.load(std::memory_order_relaxed) / 1000.0;
+}
+
+bool CAVRecorder::saveReplay(const std::string& filePath)
+{
+    if (!replayBuffer_)
+    {
+        qWarning() << "Replay buffer is not enabled.";
+        return false;
+    }
+
+    // 完成回调在保存线程中执行，通过排队连接的信号回到接收者所在的线程
+    QString path = QString::fromStdString(filePath);
+    return replayBuffer_->saveAsync(filePath, [this, path](bool success) {
+        emit replaySaved(path, success);
+    });
+}
+
 void CAVRecorder::cleanup()
 {
-    muxer_.reset();
+    // 只在工作线程都已退出时调用，未开始的录制直接丢弃（CMuxer 析构时写入文件尾）
+    {
+        std::lock_guard<std::mutex> lock{ sessionMtx_ };
+        sessions_.clear();
+        nextSessionId_ = 0;
+        stoppedSessions_.store(0);
+    }
     videoEncoder_.reset();
     audioEncoder_.reset();
     audioCapturer_.reset();
+    qualityGovernor_.reset();
+    avcodec_free_context(&videoParams_);
+    avcodec_free_context(&audioParams_);
 }
 
-// ------------------------- 첽 -------------------------
+// ------------------------- 异步改造 -------------------------
 
 void CAVRecorder::startThreads() {
     qInfo() << "Starting background threads...";
 
-    // ÿ߳ʼִӦ Loop 
+    {
+        std::lock_guard<std::mutex> lock{ finalizeMtx_ };
+        isFinalizerRunning_ = true;
+    }
+
+    // 每个线程启动后会立即开始执行其对应的 Loop 函数
     videoEncoderThread_ = std::thread(&CAVRecorder::videoEncodingLoop, this);
     audioEncoderThread_ = std::thread(&CAVRecorder::audioEncodingLoop, this);
     muxerThread_ = std::thread(&CAVRecorder::muxingLoop, this);
+    finalizerThread_ = std::thread(&CAVRecorder::finalizingLoop, this);
 }
 
 void CAVRecorder::stopThreads() {
-    if (!isRunning_.exchange(false)) {
-        return;
+    {
+        // 在锁内修改，保证挂起的线程能被唤醒
+        std::lock_guard<std::mutex> lock{ sessionMtx_ };
+        if (!isRunning_.exchange(false)) {
+            return;
+        }
     }
+    sessionCond_.notify_all();
 
     qInfo() << "Signaling all threads to stop...";
 
-    // isRunning_ = false; Ƶ߳ ˳
-	// յEOSmuxer̻߳˳
-    // isRecording_ = false; ( stopRecording ) UI̲߳µƵ֡
+    // isRunning_ = false; 音视频编码线程结束所有已停止的录制后退出。
+	// 所有录制都收到两个EOS包后，muxer线程会退出。
+    // isCapturing_ = false; (在 endSession 中设置) 会让UI线程不再推入新的视频帧。
 
     if (audioEncoderThread_.joinable()) {
         audioEncoderThread_.join();
@@ -274,10 +641,21 @@ void CAVRecorder::stopThreads() {
         qInfo() << "Muxer thread joined.";
     }
 
+    // muxer线程退出后不会再有新的录制需要收尾，收尾线程写完队列中的录制后退出
+    {
+        std::lock_guard<std::mutex> lock{ finalizeMtx_ };
+        isFinalizerRunning_ = false;
+    }
+    finalizeCond_.notify_all();
+    if (finalizerThread_.joinable()) {
+        finalizerThread_.join();
+        qInfo() << "Finalizer thread joined.";
+    }
+
     qInfo() << "All background threads have been successfully joined.";
 }
 
-void CAVRecorder::sendVecPkt(const QVector<AVPacket*>& packets, const PacketType& type)
+void CAVRecorder::sendVecPkt(const QVector<AVPacket*>& packets, const PacketType& type, uint32_t session)
 {
     for (AVPacket* pkt : packets)
     {
@@ -287,9 +665,9 @@ void CAVRecorder::sendVecPkt(const QVector<AVPacket*>& packets, const PacketType
 			continue;
         }
 
-		MediaPacket mediaPkt{ AVPacketUPtr{ pkt }, type };
+		MediaPacket mediaPkt{ AVPacketUPtr{ pkt }, type, session };
 
-        //  AVPacket  MediaPacket УȨٴת
+        // 将包含 AVPacket 的 MediaPacket 移入队列，所有权再次转移
         encodedPktQueue_.push(std::move(mediaPkt));
     }
 }
@@ -298,42 +676,67 @@ void CAVRecorder::videoEncodingLoop()
 {
     qInfo() << "[Thread: VideoEncoder] Loop started.";
 
-    // ------------------------- ߳ѭ -------------------------
+    uint32_t session = 0;   // 当前编码的录制编号，每遇到一个结束标记加一
+
+    // ------------------------- 线程主循环 -------------------------
     while (isRunning_.load(std::memory_order_relaxed))
     {
-		// popֵunique_ptrһlock_free_queueڶǴ洢RGBAݵunique_ptr
+		// pop出来的值有两层unique_ptr，第一层是lock_free_queue的容器，第二层是存储RGBA数据的unique_ptr
         auto container = rawVideoQueue_.pop();
         if (!container) 
         {
-            // Ϊգߣæ
+            if (isWarm_.load(std::memory_order_relaxed) && !isCapturing_.load(std::memory_order_relaxed))
+            {
+                // 常驻模式下没有录制任务时挂起，结束标记入队后会被唤醒
+                waitForWork([this] { return !rawVideoQueue_.empty(); });
+                continue;
+            }
+            // 如果队列为空，短暂休眠，避免忙等
             std::this_thread::yield();
             continue;
 		}
         RGBAUPtr& pRawData = *container;
         if (!pRawData) 
         {
-            // Ϊգߣæ
-            std::this_thread::sleep_for(5ms);
+            // 空帧是录制的结束标记，之前的帧都已编码
+            finishVideoSession(session++);
+            continue;
+        }
+
+        if (!qualityGovernor_)
+        {
+            sendVecPkt(videoEncoder_->encode(pRawData->rgba_data.data(), pRawData->timestampUs), PacketType::VIDEO, session);
             continue;
         }
 
-        sendVecPkt(videoEncoder_->encode(pRawData->data()), PacketType::VIDEO);
+        // 降帧率时跳过的帧不编码，时间轴由采集时间戳决定
+        double encodeMs = -1.0;
+        if (qualityGovernor_->shouldEncode())
+        {
+            const auto begin = std::chrono::steady_clock::now();
+            QVector<AVPacket*> packets = videoEncoder_->encode(pRawData->rgba_data.data(), pRawData->timestampUs);
+            encodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+            sendVecPkt(packets, PacketType::VIDEO, session);
+        }
+        else
+        {
+            videoEncoder_->skipFrame(pRawData->timestampUs);
+        }
+
+        if (qualityGovernor_->onFrame(encodeMs, rawVideoQueue_.size(), droppedFrames_.load(std::memory_order_relaxed)))
+            applyQualityLevel();
     }
 
-    // ------------------------- ߳̽rawVideoQueue_л -------------------------
+    // ------------------------- 线程结束后，清空rawVideoQueue_中缓存 -------------------------
     while (auto container = rawVideoQueue_.pop())
     {
         RGBAUPtr& uptrRgba = *container;
-        sendVecPkt(videoEncoder_->encode(uptrRgba->data()), PacketType::VIDEO);
+        if (uptrRgba)
+            sendVecPkt(videoEncoder_->encode(uptrRgba->rgba_data.data(), uptrRgba->timestampUs), PacketType::VIDEO, session);
+        else
+            finishVideoSession(session++);
     }
 
-    // ------------------------- նл󣬵flush()ձ -------------------------
-    sendVecPkt(videoEncoder_->flush(), PacketType::VIDEO);
-
-    // ------------------------- ڱʾǰı̽ -------------------------
-    MediaPacket eosPkt{ AVPacketUPtr{ nullptr }, PacketType::END_OF_STREAM };
-    encodedPktQueue_.push(std::move(eosPkt));
-
     qInfo() << "[Thread: VideoEncoder] Loop finished.";
 }
 
@@ -341,7 +744,7 @@ void CAVRecorder::audioEncodingLoop()
 {
     qInfo() << "[Thread: AudioEncoder] Loop started.";
 
-    // ȡһ֡Ƶȷֽ
+    // 获取编码一帧音频所需的确切字节数
     const int audioBytesPerFrame = audioEncoder_->getBytesPerFrame();
     if (audioBytesPerFrame <= 0)
     {
@@ -349,40 +752,40 @@ void CAVRecorder::audioEncodingLoop()
         return;
     }
 
-    // ------------------------- ߳ѭ -------------------------
+    uint32_t session = 0;   // 当前编码的录制编号
+
+    // ------------------------- 线程主循环 -------------------------
     while (isRunning_.load(std::memory_order_relaxed))
     {
-        QByteArray pcmChunk = audioCapturer_->readChunk(audioBytesPerFrame);
-        if (pcmChunk.isEmpty() || pcmChunk.size() < audioBytesPerFrame)
+        // 结束已请求停止的录制
+        if (session < stoppedSessions_.load())
         {
-            std::this_thread::yield();
+            finishAudioSession(session++, audioBytesPerFrame);
             continue;
         }
-            
-        sendVecPkt(
-            audioEncoder_->encode(reinterpret_cast<const uint8_t*>(pcmChunk.constData())),
-            PacketType::AUDIO
-        );
-    }
 
-    // ------------------------- ߳̽pcm -------------------------
-    while (true)
-    {
-        QByteArray pcmChunk = audioCapturer_->readChunk(audioBytesPerFrame);
-        if (pcmChunk.isEmpty() || pcmChunk.size() < audioBytesPerFrame)
-            break;
-        sendVecPkt(
-            audioEncoder_->encode(reinterpret_cast<const uint8_t*>(pcmChunk.constData())),
-            PacketType::AUDIO
-        );
-    }
+        // 常驻模式下未录制时录音设备已暂停，仍需读走暂停前留在环形缓冲区中的数据
+        const bool isIdle = isWarm_.load(std::memory_order_relaxed) && !isCapturing_.load(std::memory_order_relaxed);
 
-    // ------------------------- pcm󣬵flush()ձ -------------------------
-    sendVecPkt(audioEncoder_->flush(), PacketType::AUDIO);
+        // 直接在环形缓冲区中编码，不拷贝PCM数据
+        int64_t captureUs = -1;
+        const char* pcmChunk = audioCapturer_->peekChunk(audioBytesPerFrame, &captureUs);
+        if (!pcmChunk)
+        {
+            if (isIdle)
+                std::this_thread::sleep_for(10ms);
+            else
+                std::this_thread::yield();
+            continue;
+        }
+        if (!isIdle)
+            encodeAudioChunk(pcmChunk, captureUs, session);
+        audioCapturer_->releaseChunk(audioBytesPerFrame);
+    }
 
-    // ------------------------- ڱʾǰı̽ -------------------------
-    MediaPacket eosPkt{ AVPacketUPtr{ nullptr }, PacketType::END_OF_STREAM };
-    encodedPktQueue_.push(std::move(eosPkt));
+    // ------------------------- 线程结束前，结束所有已停止的录制 -------------------------
+    while (session < stoppedSessions_.load())
+        finishAudioSession(session++, audioBytesPerFrame);
 
     qInfo() << "[Thread: AudioEncoder] Loop finished.";
 }
@@ -390,34 +793,222 @@ void CAVRecorder::audioEncodingLoop()
 void CAVRecorder::muxingLoop() {
     qInfo() << "[Thread: Muxer] Loop started.";
 
-	int streamFin = 0; // ¼ɵ
-	int streamTotal = muxer_->getFormatContext()->nb_streams; // ȡ
+	const int streamTotal = 2; // 音视频编码线程各为每次录制发送一个EOS包
 
-    // ------------------------- ߳ѭ -------------------------
-    while (streamFin < streamTotal)
+    // ------------------------- 线程主循环 -------------------------
+    while (true)
     {
-        // popֵunique_ptrһlock_free_queueڶǴ洢packetunique_ptr
+        // pop出来的值有两层unique_ptr，第一层是lock_free_queue的容器，第二层是存储packet的unique_ptr
         auto container = encodedPktQueue_.pop();
         if (!container)
         {
-            // Ϊգߣæ
+            if (!isRunning_.load())
+            {
+                // 退出前必须等所有录制都收到EOS包
+                std::lock_guard<std::mutex> lock{ sessionMtx_ };
+                if (sessions_.empty())
+                    break;
+            }
+            else if (isWarm_.load(std::memory_order_relaxed) && !isCapturing_.load(std::memory_order_relaxed))
+            {
+                waitForWork([this] { return !encodedPktQueue_.empty(); });
+                continue;
+            }
+            // 如果队列为空，短暂休眠，避免忙等
             std::this_thread::yield();
             continue;
         }
         MediaPacket& upPkt = *container;
 
+        RecordSession* session = findSession(upPkt.session);
+        if (!session)
+        {
+            qWarning() << "[Thread: Muxer] Dropping packet of unknown session" << upPkt.session;
+            continue;
+        }
+
         switch (upPkt.type)
         {
         case PacketType::VIDEO:
         case PacketType::AUDIO:
-			muxer_->writePacket(upPkt.pkt.get());
+            writeSessionPacket(session, upPkt.pkt.get());
             break;
         case PacketType::END_OF_STREAM:
             qInfo() << "[Thread: Muxer] Received end of stream packet.";
-			++streamFin;
+			if (++session->finishedStreams < streamTotal)
+                break;
+
+            // 两路编码都已结束，本次录制交给收尾线程写入文件尾，muxer线程继续处理下一次录制
+            {
+                std::unique_ptr<RecordSession> finished;
+                {
+                    std::lock_guard<std::mutex> lock{ sessionMtx_ };
+                    auto it = std::find_if(sessions_.begin(), sessions_.end(),
+                        [session](const std::unique_ptr<RecordSession>& s) { return s.get() == session; });
+                    finished = std::move(*it);
+                    sessions_.erase(it);
+                }
+                {
+                    std::lock_guard<std::mutex> lock{ finalizeMtx_ };
+                    finalizeQueue_.push_back(std::move(finished));
+                }
+                finalizeCond_.notify_one();
+            }
 			break;
         }
     }
 
     qInfo() << "[Thread: Muxer] Loop finished.";
 }
+
+void CAVRecorder::finalizingLoop()
+{
+    qInfo() << "[Thread: Finalizer] Loop started.";
+
+    while (true)
+    {
+        std::unique_ptr<RecordSession> session;
+        {
+            std::unique_lock<std::mutex> lock{ finalizeMtx_ };
+            finalizeCond_.wait(lock, [this] { return !finalizeQueue_.empty() || !isFinalizerRunning_; });
+            if (finalizeQueue_.empty())
+                break;
+            session = std::move(finalizeQueue_.front());
+            finalizeQueue_.pop_front();
+        }
+
+        session->hlsSink.reset();   // 析构时输出最后一个分段
+        if (!session->muxer)
+            continue;
+
+        qInfo() << "[Thread: Finalizer] Writing trailer of" << session->path.c_str();
+        const bool ok = session->muxer->close();
+        emit recordingFinished(QString::fromStdString(session->path), ok);
+    }
+
+    qInfo() << "[Thread: Finalizer] Loop finished.";
+}
+
+void CAVRecorder::waitForWork(const std::function<bool()>& hasWork)
+{
+    std::unique_lock<std::mutex> lock{ sessionMtx_ };
+    sessionCond_.wait(lock, [&] {
+        return !isRunning_.load() || isCapturing_.load() || hasWork();
+    });
+}
+
+void CAVRecorder::wakeThreads()
+{
+    // 先获取一次锁，保证挂起的线程要么还没检查条件，要么已经在等待
+    {
+        std::lock_guard<std::mutex> lock{ sessionMtx_ };
+    }
+    sessionCond_.notify_all();
+}
+
+void CAVRecorder::applyQualityLevel()
+{
+    // 级别只改变帧率，编码器不变
+    const QualityStats stats = qualityGovernor_->stats();
+    qInfo() << "[Thread: VideoEncoder] Quality level" << stats.level << "/" << stats.levelCount - 1
+        << QString::fromStdString(stats.description) << "-" << QString::fromStdString(stats.lastDecision);
+    emit qualityChanged(stats.level, QString::fromStdString(stats.description));
+}
+
+void CAVRecorder::finishVideoSession(uint32_t session)
+{
+    sendVecPkt(videoEncoder_->flush(), PacketType::VIDEO, session);
+
+    MediaPacket eosPkt{ AVPacketUPtr{ nullptr }, PacketType::END_OF_STREAM, session };
+    encodedPktQueue_.push(std::move(eosPkt));
+    wakeThreads();
+
+    // 清空缓存后的编码器不能再送入新帧，常驻模式下重新打开（x264 打开较慢），
+    // 下一次录制的帧在队列中等待，不会阻塞UI线程
+    if (isWarm_.load() && isRunning_.load())
+    {
+        if (videoEncoder_->initialize(config_.videoCodecCfg_))
+            videoEncoder_->setTimeBase(videoParams_->time_base, 0);
+        else
+            qCritical() << "[Thread: VideoEncoder] Failed to reopen video encoder.";
+
+        // 下一次录制从原始质量开始
+        if (qualityGovernor_)
+            qualityGovernor_->reset();
+    }
+    qInfo() << "[Thread: VideoEncoder] Session" << session << "finished.";
+}
+
+void CAVRecorder::encodeAudioChunk(const char* pcmChunk, int64_t captureUs, uint32_t session)
+{
+    // 每次录制的第一块数据时取得本次录制的零点，与视频帧共用
+    if (audioOriginUs_ < 0)
+        audioOriginUs_ = sessionStartUs_.load();
+
+    int64_t timestampUs = -1;
+    if (captureUs >= 0)
+    {
+        timestampUs = captureUs - audioOriginUs_;
+        // 录制开始前采集的数据（常驻模式下设备一直在运行）直接丢弃
+        if (timestampUs < 0)
+            return;
+
+        // ------------------------- 采集到编码的延迟，每10秒输出一次 -------------------------
+        const int64_t nowUs = CMediaClock::nowUs();
+        const int64_t latencyUs = nowUs - captureUs;
+        const int64_t smoothedUs = audioLatencyUs_.load(std::memory_order_relaxed);
+        audioLatencyUs_.store(smoothedUs == 0 ? latencyUs : smoothedUs + (latencyUs - smoothedUs) / 8, std::memory_order_relaxed);
+        audioLatencyMaxUs_ = std::max(audioLatencyMaxUs_, latencyUs);
+        if (audioLatencyLogUs_ < 0)
+            audioLatencyLogUs_ = nowUs;
+        else if (nowUs - audioLatencyLogUs_ >= 10000000)
+        {
+            qInfo() << "Audio capture-to-encode latency:" << getAudioLatencyMs() << "ms, max" << audioLatencyMaxUs_ / 1000.0 << "ms.";
+            audioLatencyMaxUs_ = 0;
+            audioLatencyLogUs_ = nowUs;
+        }
+    }
+
+    sendVecPkt(
+        audioEncoder_->encode(reinterpret_cast<const uint8_t*>(pcmChunk), timestampUs),
+        PacketType::AUDIO,
+        session
+    );
+}
+
+void CAVRecorder::finishAudioSession(uint32_t session, int audioBytesPerFrame)
+{
+    // 编码停止录制前已采集的数据；块的时间戳是末尾的采集时间，开始于停止时间之后的块不属于本次录制，
+    // 留在缓冲区中按空闲数据读走
+    const int64_t chunkUs = static_cast<int64_t>(audioBytesPerFrame) * 1000000 /
+        qMax(1, audioCapturer_->getAudioFormat().bytesForDuration(1000000));
+    const int64_t stopUs = sessionStopUs_.load();
+    while (true)
+    {
+        int64_t captureUs = -1;
+        const char* pcmChunk = audioCapturer_->peekChunk(audioBytesPerFrame, &captureUs);
+        if (!pcmChunk)
+            break;
+        if (captureUs >= 0 && captureUs - chunkUs >= stopUs)
+            break;
+        encodeAudioChunk(pcmChunk, captureUs, session);
+        audioCapturer_->releaseChunk(audioBytesPerFrame);
+    }
+    sendVecPkt(audioEncoder_->flush(), PacketType::AUDIO, session);
+    audioOriginUs_ = -1;
+    audioLatencyMaxUs_ = 0;
+    audioLatencyLogUs_ = -1;
+
+    MediaPacket eosPkt{ AVPacketUPtr{ nullptr }, PacketType::END_OF_STREAM, session };
+    encodedPktQueue_.push(std::move(eosPkt));
+    wakeThreads();
+
+    if (isWarm_.load() && isRunning_.load())
+    {
+        if (audioEncoder_->initialize(config_.audioCodecCfg_, config_.audioFmt_))
+            audioEncoder_->setTimeBase(audioParams_->time_base, 1);
+        else
+            qCritical() << "[Thread: AudioEncoder] Failed to reopen audio encoder.";
+    }
+    qInfo() << "[Thread: AudioEncoder] Session" << session << "finished.";
+}
@@ -2,8 +2,12 @@
 
 #include "AudioEncoder/AudioEncoder.h"
 #include "Common/LockFreeQueue.h"
+#include "Common/MediaClock.h"
 #include "Common/SingletonBase.h"
 #include "Muxer/Muxer.h"
+#include "HlsSink/HlsSink.h"
+#include "QualityGovernor/QualityGovernor.h"
+#include "ReplayBuffer/ReplayBuffer.h"
 #include "VideoEncoder/VideoEncoder.h"
 
 extern "C" {
@@ -15,6 +19,9 @@ extern "C" {
 }
 #include <iostream>
 #include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <functional>
 #include <QQueue>
 #include <QThread>
 #include <QWaitCondition>
@@ -25,11 +32,11 @@ extern "C" {
 
 /**
  * @class CAVRecorder
- * @brief Ƶ¼ƿ
+ * @brief 核心音视频录制控制器。
  *
- * ƵĲɼͻдȫ̡
- * ö߳첽ܹUI̡̺߳߳д߳̽
- * ȷܺUIӦ
+ * 该类管理音视频的采集、编码和混合写入的全过程。
+ * 它采用多线程异步架构，将UI线程、编码线程和写入线程解耦，
+ * 以确保高性能和UI的流畅响应。
  */
 class CAVRecorder : public QObject, public Singleton_Lazy_Base<CAVRecorder>
 {
@@ -41,124 +48,278 @@ private:
 
 public:
     /**
-     * @brief ʼ¼
-     * @param config Ƶ롢ʽϢĽṹ塣
-     * @return ʼɹtrue򷵻false
+     * @brief 初始化录制器所需的所有组件。
+     * @param config 包含音视频编码、格式等所有配置信息的结构体。
+     * @return 初始化成功返回true，否则返回false。
      */
     bool initialize(AVConfig& config);
 
     /**
-     * @brief 첽¼̡
+     * @brief 预热录制器（常驻模式）。
      *
-     * úк̨̣߳롢ϣʼɼƵ
-     * ˺ϵͳ׼ý pushRGBA() Ƶݡ
+     * 一次性创建编码器、录音设备并启动所有工作线程，之后线程挂起等待。
+     * 每次录制只需调用 startRecording(filePath) 打开新的输出文件，无需重新打开编码器和设备；
+     * stopRecording() 立即返回，当前文件在后台写完后发出 recordingFinished 信号，
+     * 期间可以马上开始下一次录制。
+     * 常驻期间录音设备保持打开，未录制时采集到的数据直接丢弃；
+     * 开启即时回放时未录制期间也持续编码，编码后的包只写入回放缓存。
+     * @param config 编码和音频格式配置，path_ 在此处被忽略。
+     * @return 成功返回true。
+     */
+    bool prepare(AVConfig& config);
+
+    /**
+     * @brief [常驻模式] 开始录制到指定文件。
+     * @param filePath 输出文件路径，不能为空。
+     * @return 未预热、路径为空或输出文件打开失败时返回false。
+     */
+    bool startRecording(const std::string& filePath);
+
+    /**
+     * @brief 退出常驻模式，停止录音设备和所有工作线程并释放资源。
+     */
+    void release();
+
+    bool isWarm() const { return isWarm_; }
+
+    /**
+     * @brief 启动异步录制流程。
+     *
+     * 该函数会启动所有后台工作线程（编码、混合），并开始采集音频。
+     * 此后，系统便准备好接收由 pushRGBA() 推入的视频数据。
      */
     void startRecording();
 
     /**
-     * @brief ֹͣ첽¼̡
+     * @brief 停止异步录制流程。
      *
-     * úֹᷢͣźŸк̨̣߳ȴŵʣ๤
-     * ߳̽ḺдļβԴ
+     * 常驻模式下只在视频帧队列中放入结束标记并立即返回，本次录制交给后台收尾：
+     * 编码线程清空编码器缓存，muxer线程写完剩余的包后由收尾线程写入文件尾，完成后发出 recordingFinished 信号。
+     * 非常驻模式下会等待所有线程结束并清理资源。
      */
     void stopRecording();
 
     /**
-     * @brief [UI̵߳] һ֡OpenGLȡԭʼRGBAݷС
-     *        ˺ǷģأԱ֤UI̵߳
-     * @param rgbaData ָPBOԴȡRGBAݵָ롣
+     * @brief [UI线程调用] 将一帧从OpenGL获取的原始RGBA数据放入待编码队列。
+     *        此函数是非阻塞的，会立即返回，以保证UI线程的流畅。
+     * @param rgbaData 指向从PBO等来源获取的RGBA像素数据的指针。
+     * @param timestampUs 该帧的渲染时间（CMediaClock::nowUs()），-1 表示使用当前时间。
      */
-    void pushRGBA(const unsigned char* rgbaData);
+    void pushRGBA(const unsigned char* rgbaData, int64_t timestampUs = -1);
 
     bool isRecording() const;
 
+    // 录制或即时回放正在接收视频帧，此时才需要调用 pushRGBA
+    bool isCapturing() const;
+
+    /**
+     * @brief 把即时回放缓存中最近 N 秒的内容在后台保存为 MP4，录制不受影响。
+     *        保存完成后发出 replaySaved 信号；常驻模式下未录制时同样可以保存。
+     * @param filePath 输出文件路径
+     * @return 未开启回放缓存、缓存为空或上一次保存尚未完成时返回false
+     */
+    bool saveReplay(const std::string& filePath);
+
+    // 录制质量自适应的当前级别和最近一个统计窗口的数据，未开启时返回默认值
+    QualityStats getQualityStats() const;
+
+    // 音频从采集（交付时间减去设备缓冲区中的积压）到送入编码器的平均延迟（毫秒），尚未录制时返回0
+    double getAudioLatencyMs() const;
+
+signals:
+    // 即时回放保存完成，在保存线程中发出
+    void replaySaved(const QString& filePath, bool success);
+
+    // 一次录制的文件已写完（含文件尾），在收尾线程中发出
+    void recordingFinished(const QString& filePath, bool success);
+
+    // 质量调节改变了级别（0 为原始质量），在视频编码线程中发出
+    void qualityChanged(int level, const QString& description);
+
 private:
     /**
-     * @brief ΪQAudioInputƵʽ
-     * @param config ƵʽϢá
-     * @return úõQAudioFormat
+     * @brief 根据配置为QAudioInput设置音频格式。
+     * @param config 包含音频格式信息的配置。
+     * @return 配置好的QAudioFormat对象。
      */
     QAudioFormat setAudioFormat(const AudioFormat& config);
 
-    // ------------------------- 첽̺߳ -------------------------
+    // ------------------------- 异步工作线程函数 -------------------------
     /**
-     * @brief Ƶ̵ִ߳塣
+     * @brief 视频编码线程的执行体。
      *
-     * ѭش`rawVideoQueue_`ȡԭʼƵ֡б룬
-     * Ȼ󽫱AVPacket`encodedPktQueue_`
+     * 循环地从`rawVideoQueue_`中取出原始视频帧，进行编码，
+     * 然后将编码后的AVPacket放入`encodedPktQueue_`。
      */
     void videoEncodingLoop();
 
     /**
-     * @brief Ƶ̵ִ߳塣
+     * @brief 音频编码线程的执行体。
      *
-     * ѭش`audioCapturer_`ȡPCMݣб룬
-     * Ȼ󽫱AVPacket`encodedPktQueue_`
+     * 循环地从`audioCapturer_`中拉取PCM数据，进行编码，
+     * 然后将编码后的AVPacket放入`encodedPktQueue_`。
      */
     void audioEncodingLoop();
 
     /**
-     * @brief д̵ִ߳塣
+     * @brief 混合写入线程的执行体。
      *
-     * ѭش`encodedPktQueue_`ȡõƵ
-     * ͨCMuxerд뵽յļС
+     * 循环地从`encodedPktQueue_`中取出编码好的音视频包，
+     * 并通过CMuxer写入到最终的文件中。
      */
     void muxingLoop();
 
     /**
-     * @brief к̨̡߳
+     * @brief 启动所有后台工作线程。
      */
     void startThreads();
 
     /**
-     * @brief ֹͣк̨̣߳ȴǽ
+     * @brief 停止所有后台工作线程，并等待它们结束。
      */
     void stopThreads();
 
     /**
-     * @brief һAVPacketбװMediaPacketС
-     * @param packets ӱصAVPacketָб
-     * @param type Щý (VIDEO, AUDIO, END_OF_STREAM)
+     * @brief 收尾线程的执行体。
+     *
+     * 依次取出已收到两个EOS包的录制，写入文件尾并关闭文件，
+     * 不阻塞UI线程，也不阻塞muxer线程写入下一次录制的包。
      */
-    void sendVecPkt(const QVector<AVPacket*>& packets, const PacketType& type);
+    void finalizingLoop();
+
+    /**
+     * @brief 辅助函数，将一个AVPacket列表封装成MediaPacket并推入队列。
+     * @param packets 从编码器返回的AVPacket裸指针列表。
+     * @param type 这些包的媒体类型 (VIDEO, AUDIO, END_OF_STREAM)。
+     * @param session 这些包所属的录制编号。
+     */
+    void sendVecPkt(const QVector<AVPacket*>& packets, const PacketType& type, uint32_t session);
+
+    // 一次录制的输出，停止后连同其中尚未写完的数据一起交给收尾线程
+    struct RecordSession
+    {
+        uint32_t id = 0;
+        std::string path;
+        std::unique_ptr<CMuxer> muxer;
+        std::unique_ptr<CHlsSink> hlsSink;
+        int64_t startUs = 0;            // 开始时的媒体时钟时间，回放缓存据此把各次录制接成连续的时间轴
+        AVRational srcTimeBases[2]{};   // 编码器输出pkt的时间基
+        AVRational dstTimeBases[2]{};   // muxer 中对应流的时间基
+        int finishedStreams = 0;        // 已收到的EOS包数量
+    };
+
+    // 创建编码器和录音设备
+    bool createComponents();
+    // 编码器始终以编码器时间基输出pkt，stream_index 固定为 视频0、音频1，由muxer线程按录制转换时间基
+    void setEncoderTimeBases();
+    // 按 config_.path_ 打开一次录制的输出（muxer、HLS），加入 sessions_；path_ 为空时只写入回放缓存
+    bool openSession(int64_t startUs);
+    // [muxer线程] 按 MediaPacket::session 查找正在写入的录制
+    RecordSession* findSession(uint32_t id);
+    // [muxer线程] 把编码后的包写入所属录制的各个输出
+    void writeSessionPacket(RecordSession* session, AVPacket* packet);
+
+    // ------------------------- 常驻模式 -------------------------
+    // 没有录制任务时挂起，直到开始录制、有新的工作或退出
+    void waitForWork(const std::function<bool()>& hasWork);
+    // 打开输出并开始接收数据，正在为回放缓存编码时先结束那一次，编码线程不中断
+    bool beginSession(const std::string& filePath);
+    // 放入结束标记，停止接收数据，本次录制交给后台收尾
+    void endSession();
+    // 唤醒挂起的工作线程
+    void wakeThreads();
+    // [编码线程] 清空编码器缓存，发送哨兵包，常驻模式下重新打开编码器供下次录制使用
+    void finishVideoSession(uint32_t session);
+    void finishAudioSession(uint32_t session, int audioBytesPerFrame);
+    // [音频编码线程] 按采集时间编码一块PCM，时间戳换算为相对本次录制开始
+    void encodeAudioChunk(const char* pcmChunk, int64_t captureUs, uint32_t session);
+    // [编码线程] 质量调节级别变化后记录日志并通知界面
+    void applyQualityLevel();
 private:
-    // Դ
+    // 清理所有资源
     void cleanup();
 
-    // 
-    /// @brief ý𽫱ƵдʽMP4
-    std::unique_ptr<CMuxer> muxer_;
-    /// @brief ƵRGBAͼΪH.264ȸʽ
+    // 核心组件
+    /// @brief 视频编码器，负责将RGBA图像编码为H.264等格式。
     std::unique_ptr<CVideoEncoder> videoEncoder_;
-    /// @brief ƵPCMƵΪAACȸʽ
+    /// @brief 音频编码器，负责将PCM音频编码为AAC等格式。
     std::unique_ptr<CAudioEncoder> audioEncoder_;
-    /// @brief Ƶɼ˷粶ԭʼPCMƵݡ
+    /// @brief 音频采集器，负责从麦克风捕获原始PCM音频数据。
     std::unique_ptr<CAudioCapturer> audioCapturer_;
+    /// @brief 编码参数的副本（不会被打开），开始录制时用于创建输出流，不受编码线程重新打开编码器的影响。
+    AVCodecContext* videoParams_ = nullptr;
+    AVCodecContext* audioParams_ = nullptr;
+    /// @brief 即时回放缓存（可选），与编码器一同创建，各次录制的包依次写入，停止录制后仍然保留。
+    std::unique_ptr<CReplayBuffer> replayBuffer_;
+    /// @brief 回放缓存时间轴的零点（媒体时钟时间），非常驻模式下为0。
+    int64_t replayEpochUs_ = 0;
+    /// @brief 录制质量自适应（可选），只在视频编码线程中调整。
+    std::unique_ptr<CQualityGovernor> qualityGovernor_;
+    /// @brief 本次录制开始的媒体时钟时间，音视频时间戳的零点。UI线程写入，
+    ///        视频帧在 pushRGBA 中换算，音频编码线程在每次录制的第一块数据时读取。
+    std::atomic<int64_t> sessionStartUs_{ 0 };
+    /// @brief 最近一次停止录制的媒体时钟时间，UI线程写入；音频编码线程收尾时只编码此前采集的数据。
+    std::atomic<int64_t> sessionStopUs_{ 0 };
+    /// @brief 音频编码线程当前录制的零点，-1 表示尚未开始。
+    int64_t audioOriginUs_ = -1;
+    /// @brief 音频采集到编码的延迟统计：平滑值由音频编码线程写入、任意线程读取，
+    ///        最大值和上次输出日志的时间只在音频编码线程中使用。
+    std::atomic<int64_t> audioLatencyUs_{ 0 };
+    int64_t audioLatencyMaxUs_ = 0;
+    int64_t audioLatencyLogUs_ = -1;
+    /// @brief 待编码队列满时丢弃的帧数，UI线程累加。
+    std::atomic<uint64_t> droppedFrames_{ 0 };
 
-	QFile* h264File = nullptr; // ڵԣH264
-	QFile* aacFile = nullptr; // ڵԣAAC
+	QFile* h264File = nullptr; // 用于调试，保存H264数据
+	QFile* aacFile = nullptr; // 用于调试，保存AAC数据
 
-    // ¼Ʋ
+    // 录制参数
     AVConfig config_;
 
-    // ״̬
-    /// @brief ־λʾ¼ǷUI߳ã̶߳ȡ
+    // 状态管理
+    /// @brief 标志位，表示录制流程是否已启动。由UI线程设置，所有线程读取。
     std::atomic<bool> isRecording_ = false;
+    /// @brief 是否正在接收数据（录制或即时回放），工作线程据此挂起或丢弃数据。
+    std::atomic<bool> isCapturing_{ false };
 
-    // ------------------------- 첽ĳԱ -------------------------
-    // ߳
-    /// @brief ִƵѭ̶߳
+    // ------------------------- 异步改造核心成员 -------------------------
+    // 三个工作线程
+    /// @brief 执行视频编码循环的线程对象。
     std::thread videoEncoderThread_;
-    /// @brief ִƵѭ̶߳
+    /// @brief 执行音频编码循环的线程对象。
     std::thread audioEncoderThread_;
-    /// @brief ִлдѭ̶߳
+    /// @brief 执行混合写入循环的线程对象。
     std::thread muxerThread_;
+    /// @brief 写入文件尾的收尾线程。
+    std::thread finalizerThread_;
 
-    // Ķ
-    lock_free_queue<RGBAUPtr, 60> rawVideoQueue_; // Լ230fpsƵ֡
-    lock_free_queue<MediaPacket, 300> encodedPktQueue_; // Ƶ
+    // 两个核心队列
+    lock_free_queue<RGBAUPtr, 60> rawVideoQueue_; // 缓冲约2秒的30fps视频帧
+    lock_free_queue<MediaPacket, 300> encodedPktQueue_; // 缓冲编码后的音视频包
 
-    // ߳пƱ־
-    /// @brief ȫб־ΪfalseʱرƵ̡߳
+    // 线程运行控制标志
+    /// @brief 全局运行标志。当设置为false时，关闭音视频编码线程。
     std::atomic<bool> isRunning_{ false };
+
+    // ------------------------- 常驻模式 -------------------------
+    /// @brief 是否处于常驻模式（prepare() 之后，release() 之前）。
+    std::atomic<bool> isWarm_{ false };
+    /// @brief 保护 sessions_ 以及线程挂起/唤醒的条件，isCapturing_ 和 isRunning_ 也在锁内修改。
+    std::mutex sessionMtx_;
+    std::condition_variable sessionCond_;
+
+    // ------------------------- 录制编号 -------------------------
+    // 录制严格按顺序开始和停止，编码线程各自数到第几次录制，无需与UI线程同步编号
+    /// @brief 正在写入（未收到两个EOS包）的录制，UI线程添加，muxer线程移除。
+    std::deque<std::unique_ptr<RecordSession>> sessions_;
+    /// @brief 下一次录制的编号，仅UI线程使用。
+    uint32_t nextSessionId_ = 0;
+    /// @brief 已请求停止的录制数量，音频编码线程据此结束录制。
+    std::atomic<uint32_t> stoppedSessions_{ 0 };
+
+    // ------------------------- 后台收尾 -------------------------
+    std::mutex finalizeMtx_;
+    std::condition_variable finalizeCond_;
+    std::deque<std::unique_ptr<RecordSession>> finalizeQueue_;
+    bool isFinalizerRunning_ = false;
 };
\ No newline at end of file
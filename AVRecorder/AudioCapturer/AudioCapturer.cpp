@@ -1,5 +1,5 @@
 #include "AudioCapturer.h"
-#include <QAudioDeviceInfo> // <--- ڻȡ豸Ϣ
+#include <QAudioDeviceInfo> // <--- 用于获取设备信息
 #include <QDebug>
 
 CAudioCapturer::CAudioCapturer(QObject* parent)
@@ -17,7 +17,7 @@ QAudioDeviceInfo CAudioCapturer::getDeviceInfo(const char* deviceName)
     QString expect = QString::fromUtf8(deviceName);
     QAudioDeviceInfo targetDevice{};
 
-    // 2. пõ豸
+    // 2. 查找所有可用的输入设备
     const QList<QAudioDeviceInfo> devices = QAudioDeviceInfo::availableDevices(QAudio::AudioInput);
     bool deviceFound = false;
     for (const QAudioDeviceInfo& deviceInfo : devices) {
@@ -39,12 +39,12 @@ QAudioDeviceInfo CAudioCapturer::getDeviceInfo(const char* deviceName)
         return QAudioDeviceInfo{};
     }
 
-    // 豸Ƿִ֧˸ʽ
+    // 检查设备是否支持此格式
     if (!targetDevice.isFormatSupported(format_)) {
         qWarning() << "Requested audio format not supported by default device, trying nearest.";
         format_ = targetDevice.nearestFormat(format_);
-        // ӽĸʽȻЧʧ
-        if (format_.sampleRate() == 0) { // ЧʽĲͨΪ0
+        // 如果最接近的格式仍然无效，则失败
+        if (format_.sampleRate() == 0) { // 无效格式的采样率通常为0
             qCritical() << "No valid audio format found for the default device.";
             return QAudioDeviceInfo{};
         }
@@ -62,22 +62,30 @@ bool CAudioCapturer::initialize(const QAudioFormat& format, AudioFormat& audioFm
 
     format_ = format;
 
-    // ------------------------- QAudioInputʼ -------------------------
-    audioInput_.reset(new QAudioInput(getDeviceInfo("Main Mic (Razer Seiren Mini)"), format_, this));
+    // ------------------------- QAudioInput初始化 -------------------------
+    // 拉取模式下 QAudioInput 会移入采集线程，有父对象的 QObject 不能移动线程，由 audioInput_ 管理释放
+    pullMode_ = audioFmt.pull_mode_;
+    audioInput_.reset(new QAudioInput(getDeviceInfo("Main Mic (Razer Seiren Mini)"), format_, pullMode_ ? nullptr : this));
     if (!audioInput_) {
         qCritical() << "Failed to create QAudioInput.";
         return false;
     }
 
-    audioInput_->setNotifyInterval(100);
+    // 缓冲区和通知间隔决定数据到达的粒度，默认值下数据按约 100ms 的大块到达
+    periodMs_ = qMax(1, audioFmt.period_ms_);
+    audioInput_->setBufferSize(format_.bytesForDuration(static_cast<qint64>(qMax(audioFmt.buffer_ms_, periodMs_ * 2)) * 1000));
+    audioInput_->setNotifyInterval(periodMs_);
 
     connect(audioInput_.data(), &QAudioInput::stateChanged, this, &CAudioCapturer::slot_StateChanged);
 
-    // ------------------------- QBufferʼ -------------------------
+    // ------------------------- QBuffer初始化 -------------------------
     audioIOBuffer_ = new CIOBuffer{ this };
     audioIOBuffer_->open(QIODevice::ReadWrite | QIODevice::Append);
+    audioIOBuffer_->setBytesPerSecond(format_.bytesForDuration(1000000));
+    // 推送模式下 QAudioInput 在所属线程中调用 writeData，拉取模式下由采集线程写入，两种情况都与 audioInput_ 同线程
+    audioIOBuffer_->setBacklogSource([this] { return static_cast<qint64>(audioInput_->bytesReady()); });
 
-    // -------------------------  -------------------------
+    // ------------------------- 其他 -------------------------
     audioFmt.sample_rate_ = format_.sampleRate();
     audioFmt.channels_ = format_.channelCount();
 
@@ -86,7 +94,9 @@ bool CAudioCapturer::initialize(const QAudioFormat& format, AudioFormat& audioFm
 			<< "Sample Rate:" << format_.sampleRate() << "\n"
 			<< "Channels:" << format_.channelCount() << "\n"
 			<< "Sample Size:" << format_.sampleSize() << "\n"
-			<< "Sample Format:" << format_.sampleType(); // ʹ sampleFormatName() ȡ
+			<< "Sample Format:" << format_.sampleType() << "\n" // 使用 sampleFormatName() 获取名称
+			<< "Period:" << periodMs_ << "ms" << (pullMode_ ? "(pull)" : "(push)") << "\n"
+			<< "Buffer:" << audioInput_->bufferSize() << "bytes";
 
     return true;
 }
@@ -100,8 +110,24 @@ void CAudioCapturer::start()
 
     if (audioInput_ && audioInput_->state() != QAudio::ActiveState) {
 
-        audioInput_->start(audioIOBuffer_); //  ʼPCMݣ
-        // ÷ѱ!
+        if (pullMode_)
+        {
+            // 拉取模式：设备数据留在 QAudioInput 中，由采集线程的定时器按固定周期取走
+            pullThread_.reset(new QThread{});
+            pullTimer_ = new QTimer{};
+            pullTimer_->setTimerType(Qt::PreciseTimer);
+            pullTimer_->setInterval(periodMs_);
+            connect(pullTimer_, &QTimer::timeout, pullTimer_, [this] { readPull(); });
+            connect(pullThread_.data(), &QThread::started, pullTimer_, [this] { startPull(); });
+
+            audioInput_->moveToThread(pullThread_.data());
+            pullTimer_->moveToThread(pullThread_.data());
+            pullThread_->start();
+            return;
+        }
+
+        audioInput_->start(audioIOBuffer_); //  开始接受PCM数据！
+        // 该方法已被抛弃，他妈的!
         /*if (audioIOBuffer_) {
             
             connect(audioIOBuffer_, &QIODevice::readyRead, this, &CAudioCapturer::slot_ReadPCM);
@@ -119,21 +145,114 @@ void CAudioCapturer::start()
 
 void CAudioCapturer::stop()
 {
+    // 先停止采集线程，之后不再读取 pullDevice_；QAudioInput 在采集线程中移回本线程，再按推送模式的方式关闭
+    if (pullThread_)
+    {
+        QThread* owner = thread();
+        QMetaObject::invokeMethod(pullTimer_, [this, owner] {
+            pullTimer_->stop();
+            audioInput_->moveToThread(owner);
+        }, Qt::BlockingQueuedConnection);
+        pullThread_->quit();
+        pullThread_->wait();
+        delete pullTimer_;
+        pullTimer_ = nullptr;
+        pullThread_.reset();
+    }
+    pullDevice_ = nullptr;
+
     if (audioInput_ && audioInput_->state() != QAudio::StoppedState) 
     {
         audioInput_->stop();
+        qInfo() << "Audio capture stopped.";
+    }
+
+    // 设备可能已因出错处于停止状态，缓冲区同样需要释放，之后需要重新 initialize()
+    if (audioInput_)
         disconnect(audioInput_.data(), &QAudioInput::stateChanged, this, &CAudioCapturer::slot_StateChanged);
-        if (audioIOBuffer_ && audioIOBuffer_->isOpen()) {
-            audioIOBuffer_->close();
+    if (audioIOBuffer_ && audioIOBuffer_->isOpen()) {
+        audioIOBuffer_->close();
+    }
+    delete audioIOBuffer_;
+    audioIOBuffer_ = nullptr;
+    isInitialized_ = false;
+}
+
+void CAudioCapturer::suspend()
+{
+    if (!audioInput_)
+        return;
+    runInCaptureThread([this] {
+        if (audioInput_->state() != QAudio::StoppedState && audioInput_->state() != QAudio::SuspendedState)
+        {
+            audioInput_->suspend();
+            qInfo() << "Audio capture suspended.";
         }
-        delete audioIOBuffer_;
-        qInfo() << "Audio capture stopped.";
+    });
+}
+
+void CAudioCapturer::resume()
+{
+    if (!audioInput_)
+        return;
+    runInCaptureThread([this] {
+        if (audioInput_->state() == QAudio::SuspendedState)
+        {
+            audioInput_->resume();
+            qInfo() << "Audio capture resumed.";
+        }
+    });
+}
+
+void CAudioCapturer::runInCaptureThread(const std::function<void()>& task)
+{
+    if (pullThread_ && pullThread_->isRunning())
+        QMetaObject::invokeMethod(pullTimer_, task, Qt::BlockingQueuedConnection);
+    else
+        task();
+}
+
+QByteArray CAudioCapturer::readChunk(qint64 chunkSize, int64_t* captureUs)
+{
+    if (!audioIOBuffer_)
+        return QByteArray{};
+    return audioIOBuffer_->readChunk(chunkSize, captureUs);
+}
+
+const char* CAudioCapturer::peekChunk(qint64 chunkSize, int64_t* captureUs)
+{
+    if (!audioIOBuffer_)
+        return nullptr;
+    return audioIOBuffer_->peekChunk(chunkSize, captureUs);
+}
+
+void CAudioCapturer::releaseChunk(qint64 chunkSize)
+{
+    if (audioIOBuffer_)
+        audioIOBuffer_->releaseChunk(chunkSize);
+}
+
+void CAudioCapturer::startPull()
+{
+    pullDevice_ = audioInput_->start();
+    if (!pullDevice_)
+    {
+        qCritical() << "Failed to start audio capture in pull mode.";
+        return;
     }
+    // 一次最多读取一个设备缓冲区的数据
+    pullBuffer_.resize(qMax(audioInput_->bufferSize(), format_.bytesForDuration(periodMs_ * 1000)));
+    pullTimer_->start();
+    qInfo() << "Audio capture started, period" << periodMs_ << "ms.";
 }
 
-QByteArray CAudioCapturer::readChunk(qint64 chunkSize)
+void CAudioCapturer::readPull()
 {
-	return audioIOBuffer_->readChunk(chunkSize);
+    // 取走设备中已有的全部数据，写入时打上时间戳（见 CIOBuffer::writeData）；
+    // 系统繁忙时定时器的超时会合并，不会连续补读
+    qint64 bytes = 0;
+    while ((bytes = pullDevice_->read(pullBuffer_.data(), pullBuffer_.size())) > 0)
+        audioIOBuffer_->write(pullBuffer_.constData(), bytes);
 }
 
 QAudioFormat CAudioCapturer::getAudioFormat() const
@@ -143,7 +262,7 @@ QAudioFormat CAudioCapturer::getAudioFormat() const
 
 void CAudioCapturer::slot_StateChanged(QAudio::State newState)
 {
-    // ҪڵԣԹ۲Ƶ豸״̬仯
+    // 这个槽主要用于调试，可以观察音频设备的状态变化
     qDebug() << "QAudioInput state changed to:" << newState;
     if (newState == QAudio::StoppedState) {
         if (audioInput_->error() != QAudio::NoError) {
@@ -151,7 +270,7 @@ void CAudioCapturer::slot_StateChanged(QAudio::State newState)
         }
     }
     else if (newState == QAudio::IdleState) {
-        // ֻص IdleState˵ʧ
+        // 如果在启动后又回到了 IdleState，说明启动失败
         if (audioInput_->error() != QAudio::NoError) {
             qWarning() << "Audio input failed to start, error:" << audioInput_->error();
         }
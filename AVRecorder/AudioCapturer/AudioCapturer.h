@@ -8,6 +8,9 @@
 #include <QMutex>
 #include <QBuffer>
 #include <QScopedPointer>
+#include <QThread>
+#include <QTimer>
+#include <functional>
 #include "AVRecorder/AudioCapturer/IOBuffer/IOBuffer.h"
 #include "Common/DataDefine.h"
 
@@ -19,34 +22,59 @@ public:
     explicit CAudioCapturer(QObject* parent = nullptr);
     ~CAudioCapturer();
 
-    // ʼƵ豸ͬʱ¼豸ֵ֧ƵʽaudioFmt
+    // 初始化音频捕获设备，同时将最终录音设备支持的音频格式存于audioFmt中；
+    // audioFmt 中的 period_ms_、buffer_ms_、pull_mode_ 决定采集周期和缓冲区大小
     bool initialize(const QAudioFormat& format, AudioFormat& audioFmt);
 
-    // ʼ
+    // 开始捕获
     void start();
 
-    // ֹͣ
+    // 停止捕获
     void stop();
 
-    // ȡchunksizeƵݣ̰߳ȫ
-    QByteArray readChunk(qint64 chunkSize);
+    // 暂停/恢复捕获，设备保持打开，暂停期间不产生数据（常驻模式下未录制时使用）
+    void suspend();
+    void resume();
 
-    // ȡȷƵʽ
+    // 读取chunksize个音频数据，线程安全；captureUs 可选，返回该块末尾的采集时间（CMediaClock），未知时为 -1
+    QByteArray readChunk(qint64 chunkSize, int64_t* captureUs = nullptr);
+
+    // 不拷贝地读取chunksize个音频数据（见 CIOBuffer::peekChunk），数据不足时返回 nullptr，用完后调用 releaseChunk()
+    const char* peekChunk(qint64 chunkSize, int64_t* captureUs = nullptr);
+    void releaseChunk(qint64 chunkSize);
+
+    // 获取最终确定的音频格式
     QAudioFormat getAudioFormat() const;
 
 private:
     QAudioDeviceInfo getDeviceInfo(const char* deviceName);
 
+    // [采集线程] 拉取模式：在采集线程中打开设备并启动定时器
+    void startPull();
+    // [采集线程] 拉取模式：读取设备中已有的全部数据，写入 audioIOBuffer_
+    void readPull();
+    // 在 audioInput_ 所在的线程中执行（拉取模式下为采集线程），等待执行完成
+    void runInCaptureThread(const std::function<void()>& task);
+
 private slots:
-    // QAudioInput ״̬仯ʱ
+    // QAudioInput 的状态变化时调用
     void slot_StateChanged(QAudio::State newState);
 
 private:
     QAudioFormat format_;
     QScopedPointer<QAudioInput> audioInput_;
-    CIOBuffer* audioIOBuffer_ = nullptr;       //  QAudioInput::start() ص豸
+    CIOBuffer* audioIOBuffer_ = nullptr;       // 推送模式下交给 QAudioInput::start() 写入；拉取模式下由采集线程写入
+
+    // 拉取模式：QAudioInput 及其返回的设备只能在所属线程中使用，开始捕获时移入采集线程，
+    // 由采集线程的定时器按固定周期读取；停止时移回原线程
+    bool pullMode_ = false;
+    int periodMs_ = 10;
+    QIODevice* pullDevice_ = nullptr;          // QAudioInput::start() 返回的设备，由 QAudioInput 管理
+    QScopedPointer<QThread> pullThread_;
+    QTimer* pullTimer_ = nullptr;              // 属于采集线程
+    QByteArray pullBuffer_;
 
-    // ̰߳ȫƵݻ
+    // 线程安全的音频数据缓冲区
     //mutable QMutex mtx_;
     //QByteArray buffer_;
 
@@ -1,4 +1,6 @@
 #include "IOBuffer.h"
+#include "Common/MediaClock.h"
+#include <algorithm>
 
 CIOBuffer::CIOBuffer(QObject* parent)
     : QIODevice(parent)
@@ -7,16 +9,16 @@ CIOBuffer::CIOBuffer(QObject* parent)
 
 bool CIOBuffer::open(OpenMode mode)
 {
-    // û open ȷģʽ
+    // 调用基类的 open 来设置正确的模式
     return QIODevice::open(mode);
 }
 
-// д뷽 QAudioInput ̵߳
+// 写入方：由 QAudioInput 线程调用
 qint64 CIOBuffer::writeData(const char* data, qint64 len)
 {
 	/*{
         QMutexLocker locker(&mtx_);
-        // ĩβ׷
+        // 在末尾追加数据
         buffer_.append(data, len);
 	}*/
 
@@ -25,45 +27,110 @@ qint64 CIOBuffer::writeData(const char* data, qint64 len)
 
 	while (has_write < expect)
 	{
-        has_write += ringBuffer_.write(data, len);
+        has_write += ringBuffer_.write(data + has_write, expect - has_write);
 	}
-    
+
+    // 记录这块数据的采集时间：设备按块交付，块内最后一个样本最接近当前时间，
+    // 但设备缓冲区中还积压着在它之后采集、尚未交付的数据，需要减去这部分时长
+    writtenBytes_ += expect;
+    int64_t captureUs = CMediaClock::nowUs();
+    if (backlogBytes_ && bytesPerSecond_ > 0)
+        captureUs -= static_cast<int64_t>(std::max<qint64>(backlogBytes_(), 0)) * 1000000 / bytesPerSecond_;
+    const size_t head = stampHead_.load(std::memory_order_relaxed);
+    if (head - stampTail_.load(std::memory_order_acquire) < kStampCount)
+    {
+        stamps_[head & (kStampCount - 1)] = ChunkStamp{ writtenBytes_, captureUs };
+        stampHead_.store(head + 1, std::memory_order_release);
+    }
 
     return len;
 }
 
-// ȡ̵߳
-QByteArray CIOBuffer::readChunk(qint64 chunkSize)
+// 读取方：由主线程调用
+QByteArray CIOBuffer::readChunk(qint64 chunkSize, int64_t* captureUs)
 {
     /*QMutexLocker locker(&mtx_);
 
-    // 1. ݳǷ㹻
+    // 1. 检查数据长度是否足够
     if (buffer_.size() < chunkSize) {
-        return QByteArray(); // ؿ飬ʾݲ
+        return QByteArray(); // 返回空数组，表示数据不够
     }
 
-    // 2. ͷ̶ȵݿ
+    // 2. 拷贝开头固定长度的数据块
     QByteArray chunk = buffer_.left(chunkSize);
 
-    // 3. ӻͷƳѱȡ
+    // 3. 从缓冲区开头移除已被读取的数据
     buffer_.remove(0, chunkSize);*/
 
     QByteArray chunk{ static_cast<int>(chunkSize), Qt::Initialization::Uninitialized };
 
-    // ӻλȡ
-	// úֵֻֽbytes_read==0 or bytes_read==chunkSize
+    // 从环形缓冲区读取数据
+	// 该函数返回值只可能有两种结果：bytes_read==0 or bytes_read==chunkSize
     size_t bytes_read = ringBuffer_.read(chunk.data(), chunkSize);
 
-    // û˵ݲ㣬ؿ
+    // 如果没读够，说明数据不足，返回空
     if (bytes_read < chunkSize) {
         return QByteArray{};
     }
-    // ȡɹС
-    // chunk.resize(bytes_read); // زchunkSizeݣҪ
+    readBytes_ += bytes_read;
+
+    if (captureUs)
+        *captureUs = stampAt(readBytes_);
+    // 如果读取成功，调整大小并返回
+    // chunk.resize(bytes_read); // 如果允许返回不足chunkSize的数据，则需要这行
 
     return chunk;
 }
 
+// 读取方：由音频编码线程调用
+const char* CIOBuffer::peekChunk(qint64 chunkSize, int64_t* captureUs)
+{
+    const char* first = nullptr;
+    const char* second = nullptr;
+    size_t firstSize = 0;
+    if (!ringBuffer_.peek(static_cast<size_t>(chunkSize), first, firstSize, second))
+        return nullptr;
+
+    if (captureUs)
+        *captureUs = stampAt(readBytes_ + chunkSize);
+
+    if (!second)
+        return first;
+
+    // 跨越末尾：拼接到内部缓冲区（块大小固定时很少发生）
+    wrapChunk_.resize(static_cast<int>(chunkSize));
+    memcpy(wrapChunk_.data(), first, firstSize);
+    memcpy(wrapChunk_.data() + firstSize, second, chunkSize - firstSize);
+    return wrapChunk_.constData();
+}
+
+void CIOBuffer::releaseChunk(qint64 chunkSize)
+{
+    ringBuffer_.consume(static_cast<size_t>(chunkSize));
+    readBytes_ += chunkSize;
+}
+
+int64_t CIOBuffer::stampAt(uint64_t endBytes)
+{
+    // 找到包含该字节的写入记录，按字节率回推该字节的采集时间
+    int64_t stampUs = -1;
+    const size_t head = stampHead_.load(std::memory_order_acquire);
+    size_t tail = stampTail_.load(std::memory_order_relaxed);
+    for (; tail != head; ++tail)
+    {
+        const ChunkStamp& stamp = stamps_[tail & (kStampCount - 1)];
+        if (stamp.endBytes >= endBytes)
+        {
+            if (bytesPerSecond_ > 0)
+                stampUs = stamp.captureUs - static_cast<int64_t>((stamp.endBytes - endBytes) * 1000000 / bytesPerSecond_);
+            break;
+        }
+    }
+    // 已经读完的写入记录不再需要
+    stampTail_.store(tail, std::memory_order_release);
+    return stampUs;
+}
+
 qint64 CIOBuffer::bytesAvailable() const
 {
     /*QMutexLocker locker(&mtx_);
@@ -72,7 +139,7 @@ qint64 CIOBuffer::bytesAvailable() const
     return ringBuffer_.get_size();
 }
 
-// ǲʹãΪ˱ QIODevice ԿԼʵ
+// 这个函数我们不再主动使用，但为了保持 QIODevice 的完整性可以简单实现
 qint64 CIOBuffer::readData(char* data, qint64 maxlen)
 {
     /*QMutexLocker locker(&mtx_);
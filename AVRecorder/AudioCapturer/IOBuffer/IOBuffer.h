@@ -4,6 +4,8 @@
 #include <QIODevice>
 #include <QByteArray>
 #include <QMutex>
+#include <atomic>
+#include <functional>
 #include "./Common/SPSCRingBuffer.h"
 
 class CIOBuffer : public QIODevice
@@ -13,24 +15,59 @@ class CIOBuffer : public QIODevice
 public:
     explicit CIOBuffer(QObject* parent = nullptr);
 
-    // chunkSize: ҪȡĹ̶С
-    QByteArray readChunk(qint64 chunkSize);
+    // chunkSize: 想要读取的固定块大小
+    // captureUs: 可选，返回该块最后一个样本的采集时间（CMediaClock），无法确定时为 -1
+    QByteArray readChunk(qint64 chunkSize, int64_t* captureUs = nullptr);
 
-    // д QIODevice ķ
+    // 不拷贝地读取一块：数据在环形缓冲区中连续时直接返回其地址，跨越末尾时才拷贝到内部缓冲区；
+    // 数据不足时返回 nullptr。用完后必须调用 releaseChunk()，之前写入方不会覆盖这块数据
+    const char* peekChunk(qint64 chunkSize, int64_t* captureUs = nullptr);
+    void releaseChunk(qint64 chunkSize);
+
+    // 每秒的字节数，用于根据写入时间推算块内任意位置的采集时间
+    void setBytesPerSecond(int64_t bytesPerSecond) { bytesPerSecond_ = bytesPerSecond; }
+
+    // 写入时设备中还未交付的字节数（如 QAudioInput::bytesReady()），在写入方线程调用；
+    // 交付的最后一个样本比这些积压数据更早采集，用于从到达时间回推采集时间
+    void setBacklogSource(std::function<qint64()> backlogBytes) { backlogBytes_ = std::move(backlogBytes); }
+
+    // 重写 QIODevice 的方法
     qint64 bytesAvailable() const override;
     bool open(OpenMode mode) override;
 
+private:
+    // 截止到累计读取 endBytes 字节时最后一个字节的采集时间，并丢弃已经读完的写入记录
+    int64_t stampAt(uint64_t endBytes);
+
 protected:
-    // QAudioInput д
+    // QAudioInput 将调用这个函数来写入数据
     qint64 writeData(const char* data, qint64 len) override;
 
-    // ǲҪԼʵ readDataΪǽͨ readChunk() ȡ
+    // 我们不再需要自己实现 readData，因为我们将通过 readChunk() 读取
     qint64 readData(char* data, qint64 maxlen) override;
 
 private:
     //mutable QMutex mtx_;
-    //QByteArray buffer_; // buffer ڲⲿָ
-    SpscRingBuffer ringBuffer_{4 * 1024 * 1024}; // 4MB
+    //QByteArray buffer_; // buffer 在内部管理，不再依赖外部指针
+    SpscRingBuffer ringBuffer_{4 * 1024 * 1024}; // 分配4MB容量
+
+    // 与 PCM 环形缓冲区并行的时间戳元数据：每次 writeData 记录写入后的总字节数和当时的时间，
+    // 同样是单生产者单消费者，元数据满时跳过记录（读取方用相邻的记录推算）
+    struct ChunkStamp
+    {
+        uint64_t endBytes;      // 写入该块后累计写入的字节数
+        int64_t captureUs;      // 该块最后一个样本的采集时间（到达时间减去设备积压）
+    };
+    static constexpr size_t kStampCount = 1024;
+    ChunkStamp stamps_[kStampCount];
+    std::atomic<size_t> stampHead_{ 0 };
+    std::atomic<size_t> stampTail_{ 0 };
+
+    uint64_t writtenBytes_ = 0;     // 仅写入方使用
+    uint64_t readBytes_ = 0;        // 仅读取方使用
+    QByteArray wrapChunk_;          // peekChunk 跨越环形缓冲区末尾时的拷贝，仅读取方使用
+    int64_t bytesPerSecond_ = 0;
+    std::function<qint64()> backlogBytes_;
 };
 
 #endif // IOBUFFER_H
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "AudioEncoder.h"
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <QObject>
 #include <QDebug>
 #include <libavutil/log.h>
@@ -7,27 +9,34 @@
 
 #include "Common/DataDefine.h"
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AUDIO_ENCODER_SSE2
+#endif
+
 #ifdef DEBUG
 static void ffmpeg_log_callback(void* ptr, int level, const char* fmt, va_list vargs)
 {
-    // ־ǿԺһЩϸϢ
+    // 检查日志级别，我们可以忽略一些过于详细的信息
     if (level > av_log_get_level())
         return;
 
-    // һ㹻Ļ洢ʽ־Ϣ
+    // 创建一个足够大的缓冲区来存储格式化后的日志消息
     char message[1024];
 
-    // ʹ vsnprintf ȫظʽ־
-    // FFmpeg ݵ fmt ʽַͨѾ "[libx264 @ ...]" Ϣ
+    // 使用 vsnprintf 安全地格式化日志内容
+    // FFmpeg 传递的 fmt 格式字符串通常已经包含了像 "[libx264 @ ...]" 这样的上下文信息
     vsnprintf(message, sizeof(message), fmt, vargs);
 
-    // ȥϢĩβĻзΪqDebugԶ
+    // 去掉消息末尾多余的换行符，因为qDebug会自动添加
     size_t len = strlen(message);
     if (len > 0 && message[len - 1] == '\n') {
         message[len - 1] = '\0';
     }
 
-    // FFmpeg־ѡʹQtĲͬ
+    // 根据FFmpeg的日志级别，选择使用Qt的不同输出流
     switch (level) {
     case AV_LOG_PANIC:
     case AV_LOG_FATAL:
@@ -60,6 +69,83 @@ static void avCheckRet(const char* operate, int ret)
 }
 
 
+/**
+ * @brief S16 交错 -> FLTP 平面，采样率相同、只需转换格式时代替 swr_convert。
+ *        编译时开启 AVX2（/arch:AVX2）使用 AVX2，否则 x86 上使用 SSE2，其他平台为标量实现。
+ */
+static void s16ToFltp(const int16_t* src, uint8_t* const* dst, int channels, int samples)
+{
+    const float scale = 1.0f / 32768.0f;
+    int i = 0;
+
+    if (channels == 2)
+    {
+        float* left = reinterpret_cast<float*>(dst[0]);
+        float* right = reinterpret_cast<float*>(dst[1]);
+#if defined(__AVX2__)
+        const __m256 vscale = _mm256_set1_ps(scale);
+        for (; i + 8 <= samples; i += 8)
+        {
+            // 16 个 int16：L0 R0 ... L7 R7，符号扩展为两组 8 个 int32
+            const __m256 a = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * i)))), vscale);
+            const __m256 b = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * i + 8)))), vscale);
+            // 每个 128 位通道内分离左右声道，再把 64 位块排回顺序
+            const __m256 l = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            const __m256 r = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+            _mm256_storeu_ps(left + i, _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(l), _MM_SHUFFLE(3, 1, 2, 0))));
+            _mm256_storeu_ps(right + i, _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(r), _MM_SHUFFLE(3, 1, 2, 0))));
+        }
+#elif defined(AUDIO_ENCODER_SSE2)
+        const __m128 vscale = _mm_set1_ps(scale);
+        for (; i + 4 <= samples; i += 4)
+        {
+            // 8 个 int16：L0 R0 L1 R1 L2 R2 L3 R3，与自身交错后算术右移完成符号扩展
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * i));
+            const __m128 lo = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16)), vscale);
+            const __m128 hi = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16)), vscale);
+            _mm_storeu_ps(left + i, _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)));
+            _mm_storeu_ps(right + i, _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1)));
+        }
+#endif
+        for (; i < samples; ++i)
+        {
+            left[i] = src[2 * i] * scale;
+            right[i] = src[2 * i + 1] * scale;
+        }
+        return;
+    }
+
+    if (channels == 1)
+    {
+        float* mono = reinterpret_cast<float*>(dst[0]);
+#if defined(__AVX2__)
+        const __m256 vscale = _mm256_set1_ps(scale);
+        for (; i + 8 <= samples; i += 8)
+        {
+            const __m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+            _mm256_storeu_ps(mono + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), vscale));
+        }
+#elif defined(AUDIO_ENCODER_SSE2)
+        const __m128 vscale = _mm_set1_ps(scale);
+        for (; i + 8 <= samples; i += 8)
+        {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            _mm_storeu_ps(mono + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16)), vscale));
+            _mm_storeu_ps(mono + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16)), vscale));
+        }
+#endif
+        for (; i < samples; ++i)
+            mono[i] = src[i] * scale;
+        return;
+    }
+
+    for (; i < samples; ++i)
+    {
+        for (int c = 0; c < channels; ++c)
+            reinterpret_cast<float*>(dst[c])[i] = src[i * channels + c] * scale;
+    }
+}
+
 CAudioEncoder::CAudioEncoder()
 {
 }
@@ -73,31 +159,31 @@ bool CAudioEncoder::initialize(const AudioCodecCfg& dstFmt, const AudioFormat& s
 {
     cleanup();
 
-    // 1.  AAC 
+    // 1. 查找 AAC 编码器
     const AVCodec* codec = avcodec_find_encoder(AV_CODEC_ID_AAC);
     if (!codec) {
         qCritical() << "Audio Encoder: AAC codec not found.";
         return false;
     }
 
-    // 2. 
+    // 2. 分配编码器上下文
     codecCtx_ = avcodec_alloc_context3(codec);
     if (!codecCtx_) {
         qCritical() << "Audio Encoder: Could not allocate codec context.";
         return false;
     }
 
-    // 3. ñ (Ŀʽ)
+    // 3. 设置编码器参数 (目标格式)
     codecCtx_->bit_rate = dstFmt.bit_rate_;
     codecCtx_->sample_rate = dstFmt.sample_rate_;
     codecCtx_->channels = dstFmt.channels_;
     codecCtx_->channel_layout = dstFmt.channel_layout_;
-    // AAC ͨʹ Planar ʽ (FLTP) Ի
+    // AAC 编码器通常使用 Planar 浮点数格式 (FLTP) 以获得最佳质量
     codecCtx_->sample_fmt = dstFmt.sample_fmt_;
-    codecCtx_->time_base = dstFmt.time_base_; // ʱԲΪλ
+    codecCtx_->time_base = dstFmt.time_base_; // 时间基以采样率为单位
     codecCtx_->flags |= dstFmt.flags_;
 
-    // 4. 򿪱
+    // 4. 打开编码器
     int ret = avcodec_open2(codecCtx_, codec, nullptr);
     if (ret < 0) {
         qCritical() << "Audio Encoder: Could not open codec.";
@@ -114,12 +200,12 @@ bool CAudioEncoder::initialize(const AudioCodecCfg& dstFmt, const AudioFormat& s
             return AV_SAMPLE_FMT_NONE;
         };
 
-    // 5. ʼز (SwrContext)
-    // ΪǴ CAudioCapturer յ S16 Packed ʽҪ FLTP Planar ʽ
+    // 5. 初始化重采样上下文 (SwrContext)
+    // 因为我们从 CAudioCapturer 接收的是 S16 Packed 格式，但编码器需要 FLTP Planar 格式
     swrCtx_ = swr_alloc_set_opts(nullptr,
-        // Ŀ (Ҫ)
+        // 目标参数 (编码器想要的)
         codecCtx_->channel_layout, codecCtx_->sample_fmt, codecCtx_->sample_rate,
-        // Դ (ṩ)
+        // 源参数 (我们提供的)
         av_get_default_channel_layout(srcFmt.channels_), qt2FFmpeg_sampleFmt(srcFmt), srcFmt.sample_rate_,
         0, nullptr);
     if (!swrCtx_) 
@@ -137,7 +223,7 @@ bool CAudioEncoder::initialize(const AudioCodecCfg& dstFmt, const AudioFormat& s
         return false;
     }
 
-    // 6. ڴزݵ AVFrame
+    // 6. 分配用于存放重采样后数据的 AVFrame
     resampleFrame_ = av_frame_alloc();
     if (!resampleFrame_) 
     {
@@ -156,6 +242,30 @@ bool CAudioEncoder::initialize(const AudioCodecCfg& dstFmt, const AudioFormat& s
         return false;
     }
 
+    // 7. 转换后的样本先进入 fifo，再按编码器的帧长取出
+    fifo_ = av_audio_fifo_alloc(codecCtx_->sample_fmt, codecCtx_->channels, codecCtx_->frame_size * 2);
+    if (!fifo_)
+    {
+        qCritical() << "Audio Encoder: Could not allocate audio fifo.";
+        cleanup();
+        return false;
+    }
+
+    srcSampleRate_ = srcFmt.sample_rate_;
+    srcChannels_ = srcFmt.channels_;
+
+    // 只需要 S16 交错 -> FLTP 平面转换时不经过 swr
+    fastPath_ = srcFmt.sample_rate_ == codecCtx_->sample_rate &&
+        srcFmt.channels_ == codecCtx_->channels &&
+        qt2FFmpeg_sampleFmt(srcFmt) == AV_SAMPLE_FMT_S16 &&
+        codecCtx_->sample_fmt == AV_SAMPLE_FMT_FLTP;
+    driftCompensation_ = dstFmt.drift_compensation_;
+    hasStartPts_ = false;
+    startPts_ = 0;
+    inputSamples_ = 0;
+    pendingCompensation_ = 0;
+    driftEstimator_.reset(srcSampleRate_);
+
     ptsCnt_ = 0;
     qInfo() << "Audio Encoder initialized successfully. Frame size:" << codecCtx_->frame_size;
     return true;
@@ -164,9 +274,14 @@ bool CAudioEncoder::initialize(const AudioCodecCfg& dstFmt, const AudioFormat& s
 void CAudioEncoder::resetTimestamp()
 {
 	ptsCnt_ = 0;
+    hasStartPts_ = false;
+    startPts_ = 0;
+    inputSamples_ = 0;
+    pendingCompensation_ = 0;
+    driftEstimator_.reset(srcSampleRate_);
     if (resampleFrame_) 
     {
-        resampleFrame_->pts = 0; // ز֡PTS
+        resampleFrame_->pts = 0; // 重置重采样帧的PTS
     }
 	qInfo() << "Audio Encoder: Timestamp reset.";
 }
@@ -178,43 +293,249 @@ QVector<AVPacket*> CAudioEncoder::encode(const unsigned char* pcmData)
         return QVector<AVPacket*>{};
     }
 
-    // --- 1. ز͸ʽת (S16 Packed -> FLTP Planar) ---
-    // swr_convert Ҫ const uint8_t** ͵
-    const uint8_t** inData = &pcmData;
+    // 每次送入一帧的样本数（getBytesPerFrame() 字节）
+    inputSamples_ += codecCtx_->frame_size;
+    return convertAndEncode(pcmData, codecCtx_->frame_size, false);
+}
 
-    //  swr_convert
-    int ret = swr_convert(swrCtx_,
-        resampleFrame_->data, resampleFrame_->nb_samples,
-        inData, resampleFrame_->nb_samples);
-    if (ret < 0) 
+QVector<AVPacket*> CAudioEncoder::encode(const unsigned char* pcmData, int64_t captureUs)
+{
+    if (!codecCtx_ || !swrCtx_ || !resampleFrame_)
     {
-        avCheckRet("swr_convert", ret);
-        qWarning() << "Audio Encoder: Error during resampling.";
         return QVector<AVPacket*>{};
     }
 
-    // 2. pts
-    resampleFrame_->pts = ptsCnt_;
-    ptsCnt_ += resampleFrame_->nb_samples;
+    const int inSamples = codecCtx_->frame_size;
+    inputSamples_ += inSamples;
+
+    if (captureUs >= 0)
+    {
+        // 第一块数据的开头对应的时间即为起始 pts，录制开始前采集的部分从 0 开始
+        if (!hasStartPts_)
+        {
+            const int64_t startUs = captureUs - av_rescale(inSamples, 1000000, srcSampleRate_);
+            startPts_ = std::max<int64_t>(0, av_rescale_q(startUs, AVRational{ 1, 1000000 }, codecCtx_->time_base));
+            ptsCnt_ = startPts_;
+            hasStartPts_ = true;
+        }
+        if (driftCompensation_)
+            compensateDrift(captureUs);
+    }
+
+    return convertAndEncode(pcmData, inSamples, false);
+}
+
+void CAudioEncoder::compensateDrift(int64_t captureUs)
+{
+    if (!driftEstimator_.addChunk(inputSamples_, captureUs))
+        return;
+
+    const int dstRate = codecCtx_->sample_rate;
 
-    // --- 3. úı뺯 ---
-    return doEncode(resampleFrame_);
+    // 已经多输出（或少输出）的样本：输出（含 fifo 和 swr 内部缓存）减去输入按目标采样率换算的样本数
+    const int64_t produced = ptsCnt_ - startPts_ + av_audio_fifo_size(fifo_) + swr_get_delay(swrCtx_, dstRate);
+    const int64_t consumed = av_rescale(inputSamples_, dstRate, srcSampleRate_);
+    const double target = driftEstimator_.driftUs() * dstRate / 1000000.0;
+    const int delta = static_cast<int>(std::lround(target - static_cast<double>(produced - consumed)));
+
+    // 1ms 以内的误差不调整，避免来回微调
+    if (std::abs(delta) < dstRate / 1000)
+        return;
+
+    // 快速路径不经过 swr，每块数据最多增减一个样本，在块边界处几乎听不出来
+    if (fastPath_)
+    {
+        pendingCompensation_ = delta;
+        qInfo() << "Audio Encoder: clock drift" << driftEstimator_.driftUs() / 1000.0 << "ms ("
+            << driftEstimator_.ppm() << "ppm), compensate" << delta << "samples";
+        return;
+    }
+
+    // 在约一个估计窗口内补偿完，变速不超过 0.1%，听不出音调变化
+    const int distance = std::max(dstRate * 2, std::abs(delta) * 1000);
+    const int ret = swr_set_compensation(swrCtx_, delta, distance);
+    if (ret < 0)
+    {
+        avCheckRet("swr_set_compensation", ret);
+        driftCompensation_ = false;
+        return;
+    }
+    qInfo() << "Audio Encoder: clock drift" << driftEstimator_.driftUs() / 1000.0 << "ms ("
+        << driftEstimator_.ppm() << "ppm), compensate" << delta << "samples over" << distance;
+}
+
+bool CAudioEncoder::ensureConvertCapacity(int samples)
+{
+    if (samples <= convertCapacity_)
+        return true;
+
+    if (convertData_)
+        av_freep(&convertData_[0]);
+    av_freep(&convertData_);
+    if (av_samples_alloc_array_and_samples(&convertData_, nullptr, codecCtx_->channels,
+        samples, codecCtx_->sample_fmt, 0) < 0)
+    {
+        qCritical() << "Audio Encoder: Could not allocate convert buffer.";
+        convertCapacity_ = 0;
+        return false;
+    }
+    convertCapacity_ = samples;
+    return true;
+}
+
+QVector<AVPacket*> CAudioEncoder::convertAndEncode(const unsigned char* pcmData, int inSamples, bool flush)
+{
+    if (fastPath_ && pcmData)
+        return fastConvertAndEncode(reinterpret_cast<const int16_t*>(pcmData), inSamples);
+
+    // --- 1. 进行重采样和格式转换 (S16 Packed -> FLTP Planar) ---
+    // 漂移补偿会让输出略多于 swr_get_out_samples() 的估计，多留一些余量，放不下的样本留在 swr 中下次取出
+    if (!ensureConvertCapacity(swr_get_out_samples(swrCtx_, inSamples) + 64))
+        return QVector<AVPacket*>{};
+
+    // swr_convert 需要 const uint8_t** 类型的输入，flush 时传入空指针取出内部缓存的样本
+    const uint8_t** inData = pcmData ? &pcmData : nullptr;
+    int ret = 0;
+    do
+    {
+        ret = swr_convert(swrCtx_, convertData_, convertCapacity_, inData, pcmData ? inSamples : 0);
+        if (ret < 0)
+        {
+            avCheckRet("swr_convert", ret);
+            qWarning() << "Audio Encoder: Error during resampling.";
+            return QVector<AVPacket*>{};
+        }
+        if (ret > 0 && av_audio_fifo_write(fifo_, reinterpret_cast<void**>(convertData_), ret) < ret)
+        {
+            qWarning() << "Audio Encoder: Could not write audio fifo.";
+            return QVector<AVPacket*>{};
+        }
+        // flush 时反复取出，直到 swr 中没有剩余样本
+    } while (flush && ret > 0);
+
+    return encodeFromFifo(flush);
+}
+
+QVector<AVPacket*> CAudioEncoder::fastConvertAndEncode(const int16_t* pcmData, int inSamples)
+{
+    const int channels = codecCtx_->channels;
+
+    // 没有待补偿的样本时（常见情况），直接转换到编码帧中，省去一次拷贝。
+    // 漂移补偿增减样本后 fifo 中会一直留有不足一帧的余量：先取出余量放在帧首，
+    // 本块的前一部分直接转换到余量之后，只有末尾与余量等长的部分写入 fifo
+    const int residual = av_audio_fifo_size(fifo_);
+    if (pendingCompensation_ == 0 && residual < inSamples && inSamples == codecCtx_->frame_size && channels <= AV_NUM_DATA_POINTERS)
+    {
+        if (av_frame_make_writable(resampleFrame_) < 0)
+        {
+            qWarning() << "Audio Encoder: Resample frame is not writable.";
+            return QVector<AVPacket*>{};
+        }
+        const int direct = inSamples - residual;
+        if (residual > 0)
+        {
+            av_audio_fifo_read(fifo_, reinterpret_cast<void**>(resampleFrame_->data), residual);
+
+            uint8_t* planes[AV_NUM_DATA_POINTERS] = {};
+            for (int c = 0; c < channels; ++c)
+                planes[c] = resampleFrame_->data[c] + residual * sizeof(float);
+            s16ToFltp(pcmData, planes, channels, direct);
+
+            if (!ensureConvertCapacity(residual))
+                return QVector<AVPacket*>{};
+            s16ToFltp(pcmData + static_cast<ptrdiff_t>(direct) * channels, convertData_, channels, residual);
+            av_audio_fifo_write(fifo_, reinterpret_cast<void**>(convertData_), residual);
+        }
+        else
+        {
+            s16ToFltp(pcmData, resampleFrame_->data, channels, inSamples);
+        }
+        resampleFrame_->pts = ptsCnt_;
+        ptsCnt_ += resampleFrame_->nb_samples;
+        return doEncode(resampleFrame_);
+    }
+
+    if (!ensureConvertCapacity(inSamples + 1))
+        return QVector<AVPacket*>{};
+    s16ToFltp(pcmData, convertData_, channels, inSamples);
+
+    // 漂移补偿：重复或丢弃块末尾的一个样本
+    int outSamples = inSamples;
+    if (pendingCompensation_ > 0)
+    {
+        for (int c = 0; c < channels; ++c)
+        {
+            float* plane = reinterpret_cast<float*>(convertData_[c]);
+            plane[inSamples] = plane[inSamples - 1];
+        }
+        ++outSamples;
+        --pendingCompensation_;
+    }
+    else if (pendingCompensation_ < 0 && inSamples > 1)
+    {
+        --outSamples;
+        ++pendingCompensation_;
+    }
+
+    if (av_audio_fifo_write(fifo_, reinterpret_cast<void**>(convertData_), outSamples) < outSamples)
+    {
+        qWarning() << "Audio Encoder: Could not write audio fifo.";
+        return QVector<AVPacket*>{};
+    }
+    return encodeFromFifo(false);
+}
+
+QVector<AVPacket*> CAudioEncoder::encodeFromFifo(bool flush)
+{
+    QVector<AVPacket*> packetList;
+
+    // 按编码器帧长取出并编码，flush 时最后一帧可以不足帧长
+    const int frameSize = codecCtx_->frame_size;
+    while (av_audio_fifo_size(fifo_) >= frameSize || (flush && av_audio_fifo_size(fifo_) > 0))
+    {
+        if (av_frame_make_writable(resampleFrame_) < 0)
+        {
+            qWarning() << "Audio Encoder: Resample frame is not writable.";
+            break;
+        }
+        resampleFrame_->nb_samples = std::min(frameSize, av_audio_fifo_size(fifo_));
+        av_audio_fifo_read(fifo_, reinterpret_cast<void**>(resampleFrame_->data), resampleFrame_->nb_samples);
+
+        // 设置pts
+        resampleFrame_->pts = ptsCnt_;
+        ptsCnt_ += resampleFrame_->nb_samples;
+
+        // 调用核心编码函数
+        packetList += doEncode(resampleFrame_);
+    }
+    resampleFrame_->nb_samples = frameSize;
+    return packetList;
 }
 
 QVector<AVPacket*> CAudioEncoder::flush()
 {
     qInfo() << "Flushing Audio Encoder...";
-    return doEncode(nullptr);
+    QVector<AVPacket*> packetList;
+    if (swrCtx_ && fifo_)
+        packetList = convertAndEncode(nullptr, 0, true);
+    packetList += doEncode(nullptr);
+    return packetList;
 }
 
-void CAudioEncoder::setStream(AVStream* stream)
+void CAudioEncoder::setStream(const AVStream* stream)
 {
-    stream_ = stream;
+    if (stream) {
+        setTimeBase(stream->time_base, stream->index);
+    }
+    else {
+        streamIndex_ = -1;
+    }
 }
 
-void CAudioEncoder::setTimeBase(AVRational timeBase)
+void CAudioEncoder::setTimeBase(AVRational timeBase, int streamIndex)
 {
     timeBase_ = timeBase;
+    streamIndex_ = streamIndex;
 }
 
 int CAudioEncoder::getFrameSize() const
@@ -225,7 +546,7 @@ int CAudioEncoder::getFrameSize() const
 int CAudioEncoder::getBytesPerFrame() const
 {
     if (!codecCtx_) return 0;
-    //  S16 Packed ʽÿֽ֡
+    // 计算 S16 Packed 格式每帧所需的字节数
     return codecCtx_->frame_size * codecCtx_->channels * av_get_bytes_per_sample(AV_SAMPLE_FMT_S16);
 }
 
@@ -263,14 +584,11 @@ QVector<AVPacket*> CAudioEncoder::doEncode(AVFrame* frame)
             break;
         }
 
-        if (stream_) 
-        {
-            av_packet_rescale_ts(pkt, codecCtx_->time_base, stream_->time_base);
-            pkt->stream_index = stream_->index;
-        }
-        else if (timeBase_.den != 0)
+        if (timeBase_.den != 0)
         {
             av_packet_rescale_ts(pkt, codecCtx_->time_base, timeBase_);
+            if (streamIndex_ >= 0)
+                pkt->stream_index = streamIndex_;
         }
         else
         {
@@ -288,7 +606,7 @@ void CAudioEncoder::cleanup()
         avcodec_free_context(&codecCtx_);
         codecCtx_ = nullptr;
     }
-    if (pcmFrame_) { // Ȼ汾ûãԷδҪ
+    if (pcmFrame_) { // 虽然这个版本没用，但保留以防未来需要
         av_frame_free(&pcmFrame_);
         pcmFrame_ = nullptr;
     }
@@ -300,5 +618,14 @@ void CAudioEncoder::cleanup()
         swr_free(&swrCtx_);
         swrCtx_ = nullptr;
     }
-    stream_ = nullptr;
+    if (fifo_) {
+        av_audio_fifo_free(fifo_);
+        fifo_ = nullptr;
+    }
+    if (convertData_) {
+        av_freep(&convertData_[0]);
+        av_freep(&convertData_);
+    }
+    convertCapacity_ = 0;
+    streamIndex_ = -1;
 }
\ No newline at end of file
@@ -11,11 +11,13 @@ extern "C" {
 #include <libavutil/common.h>
 #include <libavutil/frame.h>
 #include <libavutil/samplefmt.h>
+#include <libavutil/audio_fifo.h>
 #include <libswresample/swresample.h>
 }
 #include <iostream>
 #include <mutex>
 #include "AVRecorder/AudioCapturer/AudioCapturer.h"
+#include "DriftEstimator/DriftEstimator.h"
 
 class CAudioEncoder
 {
@@ -23,75 +25,113 @@ public:
     CAudioEncoder();
     ~CAudioEncoder();
 
-    // ֹ͸ֵ
+    // 禁止拷贝和赋值
     CAudioEncoder(const CAudioEncoder&) = delete;
     CAudioEncoder& operator=(const CAudioEncoder&) = delete;
 
     /**
-     * @brief ʼƵ
+     * @brief 初始化音频编码器。
      * @param dstFmt
      * @param srcFmt
-     * @return ɹ true
+     * @return 成功返回 true。
      */
     bool initialize(const AudioCodecCfg& dstFmt, const AudioFormat& srcFmt);
 
     /**
-     * @brief ڿʼ/¼Ƶʱã
-     *          ʱԷ¼/
+     * @brief 在开始推流/录制音视频时调用，
+     *          用于清空时间戳，可以反复录制/推流。
      */
     void resetTimestamp();
 
     /**
-     * @brief һ֡Ƶݡ
-     * @param pcmData ָԭʼ S16 (ʽ) PCM ݵָ롣
-     * @return һõ AVPacket б
-     *         ʹ packet 븺 av_packet_free() ͷǡ
+     * @brief 编码一帧音频数据。
+     * @param pcmData 指向原始 S16 (交错格式) PCM 数据的指针。
+     * @return 返回一个包含零个或多个编码好的 AVPacket 的列表。
+     *         调用者在使用完 packet 后必须负责调用 av_packet_free() 来释放它们。
      */
     QVector<AVPacket*> encode(const unsigned char* pcmData);
 
     /**
-     * @brief ձл֡
-     * @return һʣ AVPacket б
+     * @brief 按采集时间编码一帧音频数据。
+     *        第一块数据的时间决定起始 pts（与视频共用 CMediaClock 的零点），
+     *        之后按样本数递增，并根据漂移估计用 swr_set_compensation 增减样本，使音频时间轴跟随媒体时钟。
+     * @param captureUs 该块最后一个样本的采集时间（相对录制开始，微秒），< 0 表示未知，按普通 encode() 处理。
+     */
+    QVector<AVPacket*> encode(const unsigned char* pcmData, int64_t captureUs);
+
+    /**
+     * @brief 清空编码器中所有缓存的帧。
+     * @return 返回一个包含所有剩余 AVPacket 的列表。
      */
     QVector<AVPacket*> flush();
 
     /**
-     * @brief ô˱ AVStream
-     * @param stream Muxer Ƶ
+     * @brief 设置此编码器关联的 AVStream。
+     *        只保存流的 index 和 time_base，必须在 avformat_write_header() 之后调用。
+     * @param stream Muxer 创建的音频流。
      */
-    void setStream(AVStream* stream);
+    void setStream(const AVStream* stream);
 
     /**
-     * @brief úpktҪתʱûsetStreamҪøú
-     * @param timeBase ֶõʱ
+     * @brief 设置后续pkt需要转换的时间戳，如果没调用setStream，则需要调用该函数。
+     * @param timeBase 手动设置的时间基。
+     * @param streamIndex 写入pkt的 stream_index，-1 表示不设置。
      */
-    void setTimeBase(AVRational timeBase);
+    void setTimeBase(AVRational timeBase, int streamIndex = -1);
 
-    // ṩԱĵֻ
+    // 提供对编码器上下文的只读访问
     const AVCodecContext* getCodecContext() const { return codecCtx_; }
 
-    // ȡÿ֡
+    // 获取编码器期望的每帧样本数
     int getFrameSize() const;
 
-    // ȡÿֽ֡ ( S16_PACKED ʽ)
+    // 获取编码器期望的每帧字节数 (对于 S16_PACKED 格式)
     int getBytesPerFrame() const;
 
 private:
-    // ڲı뺯
+    // 把转换后的样本写入 fifo_，凑满一帧就编码；flush 时编码剩余不足一帧的样本
+    QVector<AVPacket*> convertAndEncode(const unsigned char* pcmData, int inSamples, bool flush);
+
+    // 采样率相同时的快速路径：SIMD 完成 S16 交错 -> FLTP 平面转换，不经过 swr
+    QVector<AVPacket*> fastConvertAndEncode(const int16_t* pcmData, int inSamples);
+
+    // 从 fifo_ 中按帧长取出样本编码
+    QVector<AVPacket*> encodeFromFifo(bool flush);
+
+    bool ensureConvertCapacity(int samples);
+
+    // 根据漂移估计调整重采样的补偿量
+    void compensateDrift(int64_t captureUs);
+
+    // 内部核心编码函数
     QVector<AVPacket*> doEncode(AVFrame* frame);
 
-    // Դ
+    // 清理所有资源
     void cleanup();
 
 private:
     AVCodecContext* codecCtx_ = nullptr;
-    AVFrame* pcmFrame_ = nullptr;   // ڴŴ S16 Packed PCM 
-    AVFrame* resampleFrame_ = nullptr; // ڴز FLTP Planar  (Ҫ)
-    SwrContext* swrCtx_ = nullptr;    //  PCM ʽͲʵת
+    AVFrame* pcmFrame_ = nullptr;   // 用于存放待编码的 S16 Packed PCM 数据
+    AVFrame* resampleFrame_ = nullptr; // 用于存放重采样后的 FLTP Planar 数据 (如果需要)
+    SwrContext* swrCtx_ = nullptr;    // 用于 PCM 格式和采样率的转换
+    AVAudioFifo* fifo_ = nullptr;     // swr 输出的样本数不固定（重采样、漂移补偿），先缓存再按帧取出
+    uint8_t** convertData_ = nullptr; // swr 的输出缓冲
+    int convertCapacity_ = 0;
 
-    AVStream* stream_ = nullptr;    // Muxer Ƶ
-    AVRational timeBase_{};         // ûavstreamҪtimeBase
+    int streamIndex_ = -1;          // Muxer 创建的音频流的 index，-1 表示没有关联流
+    AVRational timeBase_{};         // 输出pkt的时间基，来自 setStream() 或 setTimeBase()
 
-    // ڼPTS
+    // 用于计算PTS
     int64_t ptsCnt_ = 0;
+
+    // 采集时间戳与漂移补偿
+    int srcSampleRate_ = 0;
+    int srcChannels_ = 0;
+    bool driftCompensation_ = false;
+    bool fastPath_ = false;         // 只需格式转换，不经过 swr
+    int pendingCompensation_ = 0;   // 快速路径下尚未补偿的样本数，正数为需要补充
+    bool hasStartPts_ = false;
+    int64_t startPts_ = 0;
+    int64_t inputSamples_ = 0;      // 本次录制送入的样本数（源采样率，每声道）
+    CDriftEstimator driftEstimator_;
 };
\ No newline at end of file
@@ -0,0 +1,66 @@
+#include "DriftEstimator.h"
+
+#include <algorithm>
+
+namespace
+{
+    // 漂移估计的平滑系数，单个窗口的测量误差约为一个交付块的长度
+    const double kSmoothing = 0.25;
+}
+
+void CDriftEstimator::reset(int sampleRate, int64_t windowUs)
+{
+    sampleRate_ = sampleRate;
+    windowUs_ = windowUs;
+    firstCaptureUs_ = -1;
+    windowStartUs_ = -1;
+    windowMinOffsetUs_ = 0.0;
+    lastCaptureUs_ = 0;
+    hasBaseline_ = false;
+    baselineUs_ = 0.0;
+    driftUs_ = 0.0;
+}
+
+bool CDriftEstimator::addChunk(int64_t samplesEnd, int64_t captureUs)
+{
+    if (sampleRate_ <= 0 || captureUs < 0)
+        return false;
+
+    const double offsetUs = captureUs - samplesEnd * 1000000.0 / sampleRate_;
+    lastCaptureUs_ = captureUs;
+
+    if (windowStartUs_ < 0)
+    {
+        if (firstCaptureUs_ < 0)
+            firstCaptureUs_ = captureUs;
+        windowStartUs_ = captureUs;
+        windowMinOffsetUs_ = offsetUs;
+        return false;
+    }
+
+    windowMinOffsetUs_ = std::min(windowMinOffsetUs_, offsetUs);
+    if (captureUs - windowStartUs_ < windowUs_)
+        return false;
+
+    // ------------------------- 窗口结束 -------------------------
+    const double windowOffsetUs = windowMinOffsetUs_;
+    windowStartUs_ = -1;
+
+    if (!hasBaseline_)
+    {
+        baselineUs_ = windowOffsetUs;
+        hasBaseline_ = true;
+        return false;
+    }
+
+    driftUs_ += kSmoothing * ((windowOffsetUs - baselineUs_) - driftUs_);
+    return true;
+}
+
+double CDriftEstimator::ppm() const
+{
+    const int64_t elapsedUs = lastCaptureUs_ - firstCaptureUs_;
+    if (firstCaptureUs_ < 0 || elapsedUs <= 0)
+        return 0.0;
+    return driftUs_ / elapsedUs * 1000000.0;
+}
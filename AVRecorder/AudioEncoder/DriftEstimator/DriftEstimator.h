@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+ * 录音设备时钟漂移估计：比较设备交付的样本数和媒体时钟（CMediaClock）经过的时间。
+ * 每个块的 偏移 = 采集时间 - 样本数 / 标称采样率，理想设备的偏移保持不变；
+ * 数据按块交付带来的抖动只会让偏移变大，因此每个窗口取最小值作为该窗口的偏移，
+ * 与第一个窗口的偏移之差即为累计漂移（平滑后输出）。
+ * 只在音频编码线程中使用。
+ */
+class CDriftEstimator
+{
+public:
+    /**
+     * @brief 开始新的估计。
+     * @param sampleRate 设备的标称采样率
+     * @param windowUs 统计窗口长度（微秒）
+     */
+    void reset(int sampleRate, int64_t windowUs = 2000000);
+
+    /**
+     * @brief 记录一个块。
+     * @param samplesEnd 到该块末尾为止设备交付的样本数（每声道）
+     * @param captureUs 该块最后一个样本的采集时间
+     * @return 一个窗口结束、漂移估计更新时返回true
+     */
+    bool addChunk(int64_t samplesEnd, int64_t captureUs);
+
+    // 累计漂移（微秒）：正数表示设备时钟偏慢，交付的样本少于实际经过的时间，需要补充样本
+    double driftUs() const { return driftUs_; }
+
+    // 漂移速率（百万分之一），用于日志
+    double ppm() const;
+
+private:
+    int sampleRate_ = 0;
+    int64_t windowUs_ = 0;
+
+    int64_t firstCaptureUs_ = -1;
+    int64_t windowStartUs_ = -1;
+    double windowMinOffsetUs_ = 0.0;
+    int64_t lastCaptureUs_ = 0;
+
+    bool hasBaseline_ = false;
+    double baselineUs_ = 0.0;
+    double driftUs_ = 0.0;
+};
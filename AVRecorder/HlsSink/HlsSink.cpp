@@ -0,0 +1,508 @@
+#include "HlsSink.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <cmath>
+#include "Common/H264NalParser.h"
+
+extern "C" {
+#include <libavutil/opt.h>
+}
+
+static void avCheckRet(const char* operate, int ret)
+{
+    char err_buf[AV_ERROR_MAX_STRING_SIZE] = { 0 };
+    av_strerror(ret, err_buf, AV_ERROR_MAX_STRING_SIZE);
+    qCritical() << operate << " failed: " << err_buf << " (error code: " << ret << ")";
+}
+
+CHlsSink::~CHlsSink()
+{
+    close();
+}
+
+bool CHlsSink::initialize(const HlsCfg& cfg)
+{
+    close();
+
+    cfg_ = cfg;
+    isFmp4_ = (cfg_.segmentType_ == HlsSegmentType::FMP4);
+    targetUs_ = static_cast<int64_t>(std::max(cfg_.targetDurationMs_, 500)) * 1000;
+    partUs_ = static_cast<int64_t>(std::max(cfg_.partDurationMs_, 0)) * 1000;
+    if (partUs_ >= targetUs_)
+        partUs_ = 0;
+
+    if (cfg_.dir_.empty() || !QDir().mkpath(QString::fromStdString(cfg_.dir_)))
+    {
+        qWarning() << "HlsSink Error: Invalid output directory" << QString::fromStdString(cfg_.dir_);
+        return false;
+    }
+
+    int ret = avformat_alloc_output_context2(&formatCtx_, nullptr, isFmp4_ ? "mp4" : "mpegts", nullptr);
+    if (ret < 0 || !formatCtx_)
+    {
+        avCheckRet("avformat_alloc_output_context2", ret);
+        return false;
+    }
+
+    // muxer 输出到内存，由本类切分后写文件
+    unsigned char* avioBuffer = static_cast<unsigned char*>(av_malloc(AVIO_BUFFER_SIZE));
+    avioCtx_ = avioBuffer ? avio_alloc_context(avioBuffer, AVIO_BUFFER_SIZE, 1, this, nullptr, &CHlsSink::writePacketCb, nullptr) : nullptr;
+    if (!avioCtx_)
+    {
+        av_free(avioBuffer);
+        cleanup();
+        return false;
+    }
+    formatCtx_->pb = avioCtx_;
+    formatCtx_->flags |= AVFMT_FLAG_CUSTOM_IO;
+
+    {
+        std::lock_guard<std::mutex> lock{ fileMtx_ };
+        fileRunning_ = true;
+    }
+    fileThread_ = std::thread(&CHlsSink::fileLoop, this);
+
+    qInfo() << "HlsSink initialized, output:" << filePath(QString::fromStdString(cfg_.playlistName_));
+    return true;
+}
+
+bool CHlsSink::addStream(const AVCodecContext* codecContext, AVRational srcTimeBase)
+{
+    if (!formatCtx_ || !codecContext)
+        return false;
+
+    AVStream* stream = avformat_new_stream(formatCtx_, nullptr);
+    if (!stream)
+        return false;
+
+    int ret = avcodec_parameters_from_context(stream->codecpar, codecContext);
+    if (ret < 0)
+    {
+        avCheckRet("avcodec_parameters_from_context", ret);
+        return false;
+    }
+    stream->codecpar->codec_tag = 0;
+    stream->time_base = srcTimeBase;
+    srcTimeBases_.push_back(srcTimeBase);
+
+    if (codecContext->codec_type == AVMEDIA_TYPE_VIDEO && refIndex_ < 0)
+    {
+        refIndex_ = stream->index;
+        if (codecContext->extradata && codecContext->extradata_size > 0)
+            videoParamSets_.assign(codecContext->extradata, codecContext->extradata + codecContext->extradata_size);
+    }
+    return true;
+}
+
+bool CHlsSink::writeHeader()
+{
+    if (!formatCtx_ || formatCtx_->nb_streams == 0)
+        return false;
+    // 没有视频流时按第一个流切分
+    if (refIndex_ < 0)
+        refIndex_ = 0;
+
+    AVDictionary* opts = nullptr;
+    if (isFmp4_)
+    {
+        // frag_custom：只在调用 av_write_frame(nullptr) 时输出片段，片段边界完全由本类控制
+        av_dict_set(&opts, "movflags", "frag_custom+empty_moov+default_base_moof", 0);
+    }
+    int ret = avformat_write_header(formatCtx_, &opts);
+    av_dict_free(&opts);
+    if (ret < 0)
+    {
+        avCheckRet("avformat_write_header", ret);
+        return false;
+    }
+    avio_flush(avioCtx_);
+    isHeadWritten_ = true;
+
+    // fMP4 的文件头（ftyp + moov）即初始化分段
+    if (isFmp4_)
+    {
+        postWrite("init.mp4", std::move(muxBuffer_));
+        muxBuffer_.clear();
+    }
+    return true;
+}
+
+int CHlsSink::writePacketCb(void* opaque, uint8_t* buf, int bufSize)
+{
+    CHlsSink* sink = static_cast<CHlsSink*>(opaque);
+    sink->muxBuffer_.insert(sink->muxBuffer_.end(), buf, buf + bufSize);
+    return bufSize;
+}
+
+bool CHlsSink::writePacket(const AVPacket* packet)
+{
+    if (!formatCtx_ || !packet || packet->stream_index < 0 ||
+        packet->stream_index >= static_cast<int>(srcTimeBases_.size()))
+    {
+        return false;
+    }
+
+    const int index = packet->stream_index;
+    const bool isRef = (index == refIndex_);
+    const bool isKey = (packet->flags & AV_PKT_FLAG_KEY) != 0;
+    const int64_t ts = (packet->dts != AV_NOPTS_VALUE) ? packet->dts : packet->pts;
+    const int64_t nowUs = av_rescale_q(ts, srcTimeBases_[index], AV_TIME_BASE_Q);
+    if (isRef)
+    {
+        // 没有 duration 时用相邻两帧的间隔
+        const int64_t frameUs = packet->duration > 0 ? av_rescale_q(packet->duration, srcTimeBases_[index], AV_TIME_BASE_Q)
+            : (isStarted_ && nowUs > lastEndUs_ - refFrameUs_ ? nowUs - (lastEndUs_ - refFrameUs_) : 0);
+        if (frameUs > 0)
+            refFrameUs_ = frameUs;
+        lastEndUs_ = nowUs + refFrameUs_;
+    }
+
+    // ------------------------- 在参考流的包边界上切分 -------------------------
+    if (!isStarted_)
+    {
+        if (!isRef || !isKey)
+            return true;    // 从第一个关键帧开始
+        isStarted_ = true;
+        startSegment(nowUs);
+    }
+    else if (isRef)
+    {
+        // 分段到达目标时长后的第一个关键帧开始新分段；提前一帧请求 IDR，编码器把请求用在下一个送入的帧上，
+        // 该帧不会早于目标时长。提前更多时 IDR 可能落在目标时长之前，不能切分，分段反而要等到下一个 GOP
+        const int64_t elapsedUs = nowUs - segmentStartUs_;
+        const int64_t requestUs = targetUs_ - std::max<int64_t>(refFrameUs_, 1);
+        if (isKey && elapsedUs >= targetUs_)
+        {
+            finishPart(nowUs);
+            finishSegment(nowUs);
+            startSegment(nowUs);
+        }
+        else
+        {
+            if (!keyFrameRequested_ && elapsedUs >= requestUs)
+            {
+                keyFrameRequested_ = true;
+                if (keyFrameRequester_)
+                    keyFrameRequester_();
+            }
+            if (partUs_ > 0 && nowUs - partStartUs_ >= partUs_)
+            {
+                finishPart(nowUs);
+                partStartUs_ = nowUs;
+                partIndependent_ = isKey;
+            }
+        }
+    }
+
+    // ------------------------- 写入 muxer -------------------------
+    AVPacket* pkt = av_packet_alloc();
+    if (!pkt)
+        return false;
+
+    int ret = 0;
+    bool needParamSets = false;
+    if (!isFmp4_ && isRef && isKey && !videoParamSets_.empty())
+    {
+        // 编码器使用全局头时关键帧不带 SPS/PPS，TS 分段需要在关键帧前带上才能独立解码
+        std::vector<NalUnit> nals;
+        splitAnnexB(packet->data, static_cast<size_t>(packet->size), nals);
+        needParamSets = true;
+        for (const NalUnit& nal : nals)
+        {
+            if (nal.type() == H264_NAL_SPS)
+            {
+                needParamSets = false;
+                break;
+            }
+        }
+    }
+
+    if (needParamSets)
+    {
+        ret = av_new_packet(pkt, static_cast<int>(videoParamSets_.size()) + packet->size);
+        if (ret >= 0)
+        {
+            memcpy(pkt->data, videoParamSets_.data(), videoParamSets_.size());
+            memcpy(pkt->data + videoParamSets_.size(), packet->data, static_cast<size_t>(packet->size));
+            ret = av_packet_copy_props(pkt, packet);
+        }
+    }
+    else
+    {
+        ret = av_packet_ref(pkt, packet);
+    }
+    if (ret < 0)
+    {
+        av_packet_free(&pkt);
+        return false;
+    }
+
+    av_packet_rescale_ts(pkt, srcTimeBases_[index], formatCtx_->streams[index]->time_base);
+    // 包已按时间顺序到达，直接写入，不经过 muxer 的交织缓存，切分位置才准确
+    ret = av_write_frame(formatCtx_, pkt);
+    av_packet_free(&pkt);
+    if (ret < 0)
+    {
+        avCheckRet("av_write_frame", ret);
+        return false;
+    }
+    return true;
+}
+
+void CHlsSink::startSegment(int64_t startUs)
+{
+    current_ = Segment{};
+    current_.sequence = nextSequence_++;
+    current_.uri = segmentUri(current_.sequence);
+    segmentData_.clear();
+
+    segmentStartUs_ = startUs;
+    partStartUs_ = startUs;
+    partIndependent_ = true;
+    keyFrameRequested_ = false;
+
+    // 每个 TS 分段都以 PAT/PMT 开始
+    if (!isFmp4_)
+        av_opt_set(formatCtx_->priv_data, "mpegts_flags", "+resend_headers", 0);
+}
+
+void CHlsSink::finishPart(int64_t endUs)
+{
+    // 刷新 muxer 中缓存的数据：TS 输出缓存的音频 PES，fMP4 输出一个 moof + mdat
+    av_write_frame(formatCtx_, nullptr);
+    avio_flush(avioCtx_);
+    if (muxBuffer_.empty())
+        return;
+
+    if (partUs_ > 0)
+    {
+        Part part{};
+        part.uri = QString("seg%1.%2.%3").arg(current_.sequence).arg(current_.parts.size()).arg(isFmp4_ ? "m4s" : "ts");
+        part.duration = (endUs - partStartUs_) / 1e6;
+        part.independent = partIndependent_;
+        postWrite(part.uri, muxBuffer_);
+        current_.parts.push_back(part);
+        writePlaylist();
+    }
+
+    segmentData_.insert(segmentData_.end(), muxBuffer_.begin(), muxBuffer_.end());
+    muxBuffer_.clear();
+}
+
+void CHlsSink::finishSegment(int64_t endUs)
+{
+    if (segmentData_.empty())
+        return;
+
+    current_.duration = (endUs - segmentStartUs_) / 1e6;
+    postWrite(current_.uri, std::move(segmentData_));
+    segmentData_.clear();
+
+    maxSegmentDuration_ = std::max(maxSegmentDuration_, current_.duration);
+    segments_.push_back(current_);
+
+    // 滚动窗口：移出播放列表的分段延后删除
+    while (static_cast<int>(segments_.size()) > std::max(cfg_.playlistSize_, 1))
+    {
+        retiredSegments_.push_back(segments_.front());
+        segments_.pop_front();
+    }
+    while (static_cast<int>(retiredSegments_.size()) > RETAINED_SEGMENTS)
+    {
+        removeSegmentFiles(retiredSegments_.front());
+        retiredSegments_.pop_front();
+    }
+
+    current_ = Segment{};
+    writePlaylist();
+}
+
+void CHlsSink::writePlaylist(bool endList)
+{
+    const double partTarget = partUs_ / 1e6;
+    const int targetDuration = static_cast<int>(std::ceil(std::max(targetUs_ / 1e6, maxSegmentDuration_)));
+
+    QString m3u8;
+    m3u8 += "#EXTM3U\n";
+    m3u8 += QString("#EXT-X-VERSION:%1\n").arg(partUs_ > 0 ? 9 : (isFmp4_ ? 7 : 3));
+    m3u8 += QString("#EXT-X-TARGETDURATION:%1\n").arg(targetDuration);
+    if (partUs_ > 0)
+    {
+        // 静态文件服务器不支持阻塞式刷新，只声明部分分段和播放器的保持距离
+        m3u8 += QString("#EXT-X-PART-INF:PART-TARGET=%1\n").arg(partTarget, 0, 'f', 3);
+        m3u8 += QString("#EXT-X-SERVER-CONTROL:PART-HOLD-BACK=%1\n").arg(partTarget * 3, 0, 'f', 3);
+    }
+    m3u8 += QString("#EXT-X-MEDIA-SEQUENCE:%1\n").arg(segments_.empty() ? current_.sequence : segments_.front().sequence);
+    if (isFmp4_)
+        m3u8 += "#EXT-X-MAP:URI=\"init.mp4\"\n";
+
+    auto appendParts = [&](const Segment& segment) {
+        for (const Part& part : segment.parts)
+        {
+            m3u8 += QString("#EXT-X-PART:DURATION=%1,URI=\"%2\"%3\n")
+                .arg(part.duration, 0, 'f', 3).arg(part.uri).arg(part.independent ? ",INDEPENDENT=YES" : "");
+        }
+    };
+
+    // 只有最近的几个分段列出部分分段
+    const size_t firstWithParts = segments_.size() > PARTS_SEGMENTS - 1 ? segments_.size() - (PARTS_SEGMENTS - 1) : 0;
+    for (size_t i = 0; i < segments_.size(); ++i)
+    {
+        if (partUs_ > 0 && i >= firstWithParts)
+            appendParts(segments_[i]);
+        m3u8 += QString("#EXTINF:%1,\n%2\n").arg(segments_[i].duration, 0, 'f', 3).arg(segments_[i].uri);
+    }
+    // 当前分段还没有完成，只列出已经写好的部分分段
+    if (partUs_ > 0 && !endList)
+        appendParts(current_);
+
+    if (endList)
+        m3u8 += "#EXT-X-ENDLIST\n";
+
+    const QByteArray data = m3u8.toUtf8();
+    postWrite(QString::fromStdString(cfg_.playlistName_),
+        std::vector<uint8_t>(data.constData(), data.constData() + data.size()));
+}
+
+QString CHlsSink::filePath(const QString& name) const
+{
+    return QString::fromStdString(cfg_.dir_) + "/" + name;
+}
+
+QString CHlsSink::segmentUri(unsigned sequence) const
+{
+    return QString("seg%1.%2").arg(sequence).arg(isFmp4_ ? "m4s" : "ts");
+}
+
+bool CHlsSink::writeFileAtomic(const QString& name, const uint8_t* data, size_t size)
+{
+    // QSaveFile 先写临时文件，commit() 时重命名为目标文件
+    QSaveFile file(filePath(name));
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qWarning() << "HlsSink Error: Failed to open" << file.fileName();
+        return false;
+    }
+    if (file.write(reinterpret_cast<const char*>(data), static_cast<qint64>(size)) != static_cast<qint64>(size) || !file.commit())
+    {
+        qWarning() << "HlsSink Error: Failed to write" << file.fileName();
+        return false;
+    }
+    return true;
+}
+
+void CHlsSink::removeSegmentFiles(const Segment& segment)
+{
+    postRemove(segment.uri);
+    for (const Part& part : segment.parts)
+        postRemove(part.uri);
+}
+
+// ------------------------- 文件写入线程 -------------------------
+void CHlsSink::postWrite(const QString& name, std::vector<uint8_t> data)
+{
+    {
+        std::lock_guard<std::mutex> lock{ fileMtx_ };
+        fileJobs_.push_back(FileJob{ name, std::move(data), false });
+    }
+    fileCond_.notify_one();
+}
+
+void CHlsSink::postRemove(const QString& name)
+{
+    {
+        std::lock_guard<std::mutex> lock{ fileMtx_ };
+        fileJobs_.push_back(FileJob{ name, {}, true });
+    }
+    fileCond_.notify_one();
+}
+
+void CHlsSink::fileLoop()
+{
+    qInfo() << "[Thread: HlsSink] Loop started.";
+    while (true)
+    {
+        FileJob job{};
+        {
+            std::unique_lock<std::mutex> lock{ fileMtx_ };
+            fileCond_.wait(lock, [this] { return !fileJobs_.empty() || !fileRunning_; });
+            if (fileJobs_.empty())
+                break;  // 已停止且没有剩余的文件
+            job = std::move(fileJobs_.front());
+            fileJobs_.pop_front();
+        }
+
+        if (job.remove)
+            QFile::remove(filePath(job.name));
+        else
+            writeFileAtomic(job.name, job.data.data(), job.data.size());
+    }
+    qInfo() << "[Thread: HlsSink] Loop finished.";
+}
+
+void CHlsSink::stopFileThread()
+{
+    {
+        std::lock_guard<std::mutex> lock{ fileMtx_ };
+        fileRunning_ = false;
+    }
+    fileCond_.notify_one();
+    if (fileThread_.joinable())
+        fileThread_.join();
+    fileJobs_.clear();
+}
+
+void CHlsSink::close()
+{
+    if (!formatCtx_)
+        return;
+
+    // 输出最后一个分段，播放列表标记结束
+    if (isStarted_)
+    {
+        finishPart(lastEndUs_);
+        finishSegment(lastEndUs_);
+        writePlaylist(true);
+    }
+    // 文件尾（fMP4 的 mfra）不属于任何分段，直接丢弃
+    if (isHeadWritten_)
+        av_write_trailer(formatCtx_);
+
+    qInfo() << "HlsSink closed," << nextSequence_ << "segments written.";
+    cleanup();
+}
+
+void CHlsSink::cleanup()
+{
+    // 最后一个分段和播放列表写完后才返回
+    stopFileThread();
+
+    if (formatCtx_)
+    {
+        avformat_free_context(formatCtx_);
+        formatCtx_ = nullptr;
+    }
+    if (avioCtx_)
+    {
+        av_freep(&avioCtx_->buffer);
+        avio_context_free(&avioCtx_);
+    }
+    muxBuffer_.clear();
+    srcTimeBases_.clear();
+    videoParamSets_.clear();
+    refIndex_ = -1;
+
+    isHeadWritten_ = false;
+    isStarted_ = false;
+    keyFrameRequested_ = false;
+    nextSequence_ = 0;
+    lastEndUs_ = 0;
+    refFrameUs_ = 0;
+    current_ = Segment{};
+    segmentData_.clear();
+    segments_.clear();
+    retiredSegments_.clear();
+    maxSegmentDuration_ = 0.0;
+}
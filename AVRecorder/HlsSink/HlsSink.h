@@ -0,0 +1,152 @@
+#pragma once
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+}
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <QString>
+
+#include "Common/DataDefine.h"
+
+/*
+ * 本地 HLS / LL-HLS 输出，与 CMuxer 并列，直接使用编码后的包，不重新编码。
+ * 所有包写入同一个 MPEG-TS 或分片 MP4 muxer（输出到内存），在包边界处切出部分分段（EXT-X-PART），
+ * 在视频 IDR 帧处切出完整分段；分段快到目标时长时通过回调请求编码器生成 IDR。
+ * 分段、部分分段和播放列表都先写临时文件再重命名（QSaveFile），静态文件服务器不会读到写了一半的文件。
+ * 文件的写入和删除按提交顺序在独立的线程中进行，调用 writePacket 的 muxer 线程不等待磁盘；
+ * 部分分段总是先于引用它的播放列表写完。
+ *
+ * 输出目录结构：
+ *   live.m3u8                       播放列表
+ *   init.mp4                        fMP4 的初始化分段（EXT-X-MAP）
+ *   seg<N>.ts / seg<N>.m4s          完整分段
+ *   seg<N>.<M>.ts / seg<N>.<M>.m4s  部分分段
+ */
+class CHlsSink
+{
+public:
+    CHlsSink() = default;
+    ~CHlsSink();
+
+    CHlsSink(const CHlsSink&) = delete;
+    CHlsSink& operator=(const CHlsSink&) = delete;
+
+public:
+    bool initialize(const HlsCfg& cfg);
+
+    /**
+     * @brief 添加一个流，添加顺序必须与 CMuxer 一致，写入的 pkt 使用相同的 stream_index。
+     * @param codecContext 编码器上下文
+     * @param srcTimeBase 写入的 pkt 所使用的时间基
+     */
+    bool addStream(const AVCodecContext* codecContext, AVRational srcTimeBase);
+
+    bool writeHeader();
+
+    /**
+     * @brief 写入一个编码后的包，不获取 pkt 的所有权，也不修改它。
+     *        第一个视频关键帧之前的包会被丢弃，保证第一个分段可以独立解码。
+     */
+    bool writePacket(const AVPacket* packet);
+
+    // 输出最后一个分段，在播放列表中写入 EXT-X-ENDLIST
+    void close();
+
+    // 分段即将到达目标时长时调用，用于请求视频编码器生成 IDR 帧
+    void setKeyFrameRequester(std::function<void()> requester) { keyFrameRequester_ = std::move(requester); }
+
+private:
+    struct Part
+    {
+        QString uri;
+        double duration = 0.0;
+        bool independent = false;   // 以关键帧开始
+    };
+
+    struct Segment
+    {
+        unsigned sequence = 0;
+        QString uri;
+        double duration = 0.0;
+        std::vector<Part> parts;
+    };
+
+    static int writePacketCb(void* opaque, uint8_t* buf, int bufSize);
+
+    void startSegment(int64_t startUs);
+    // 把 muxer 中已产生的数据切成一个部分分段
+    void finishPart(int64_t endUs);
+    void finishSegment(int64_t endUs);
+    void writePlaylist(bool endList = false);
+
+    QString filePath(const QString& name) const;
+    QString segmentUri(unsigned sequence) const;
+    bool writeFileAtomic(const QString& name, const uint8_t* data, size_t size);
+    void removeSegmentFiles(const Segment& segment);
+
+    // ------------------------- 文件写入线程 -------------------------
+    struct FileJob
+    {
+        QString name;
+        std::vector<uint8_t> data;
+        bool remove = false;        // 删除文件，而不是写入
+    };
+    // 交给写入线程，按提交顺序执行
+    void postWrite(const QString& name, std::vector<uint8_t> data);
+    void postRemove(const QString& name);
+    void fileLoop();
+    // 等待已提交的文件全部写完后结束写入线程
+    void stopFileThread();
+
+    void cleanup();
+
+private:
+    static constexpr int AVIO_BUFFER_SIZE = 32 * 1024;
+    static constexpr int PARTS_SEGMENTS = 3;     // 带部分分段信息的分段数（含当前分段）
+    static constexpr int RETAINED_SEGMENTS = 2;  // 移出播放列表后仍保留在磁盘上的分段数，给较慢的客户端
+
+    HlsCfg cfg_{};
+    bool isFmp4_ = false;
+    int64_t targetUs_ = 0;
+    int64_t partUs_ = 0;
+
+    AVFormatContext* formatCtx_ = nullptr;
+    AVIOContext* avioCtx_ = nullptr;
+    std::vector<uint8_t> muxBuffer_;        // muxer 已输出、尚未切出的数据
+
+    // 流信息
+    std::vector<AVRational> srcTimeBases_;
+    int refIndex_ = -1;                     // 用于切分的参考流（视频流）
+    std::vector<uint8_t> videoParamSets_;   // Annex B 格式的 SPS/PPS，TS 分段的关键帧前需要带上
+
+    // 分段状态
+    bool isHeadWritten_ = false;
+    bool isStarted_ = false;
+    bool keyFrameRequested_ = false;
+    unsigned nextSequence_ = 0;
+    Segment current_{};
+    std::vector<uint8_t> segmentData_;
+    int64_t segmentStartUs_ = 0;
+    int64_t partStartUs_ = 0;
+    bool partIndependent_ = false;
+    int64_t lastEndUs_ = 0;                 // 参考流最后一个包的结束时间
+    int64_t refFrameUs_ = 0;                // 参考流一帧的时长，用于提前一帧请求 IDR
+    std::deque<Segment> segments_;          // 播放列表中的完整分段
+    std::deque<Segment> retiredSegments_;   // 已移出播放列表、等待删除的分段
+    double maxSegmentDuration_ = 0.0;
+
+    std::function<void()> keyFrameRequester_;
+
+    std::thread fileThread_;
+    std::mutex fileMtx_;
+    std::condition_variable fileCond_;
+    std::deque<FileJob> fileJobs_;
+    bool fileRunning_ = false;
+};
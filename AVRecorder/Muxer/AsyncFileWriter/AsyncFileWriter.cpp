@@ -0,0 +1,583 @@
+#include "AsyncFileWriter.h"
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+
+extern "C" {
+#include <libavutil/mem.h>
+#include <libavutil/error.h>
+}
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdlib.h>
+#endif
+
+CAsyncFileWriter::~CAsyncFileWriter()
+{
+    close();
+}
+
+// ------------------------- 写缓冲块分配 -------------------------
+uint8_t* CAsyncFileWriter::allocBlock(size_t size)
+{
+#ifdef _WIN32
+    return static_cast<uint8_t*>(_aligned_malloc(size, BLOCK_ALIGNMENT));
+#else
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, BLOCK_ALIGNMENT, size) != 0)
+        return nullptr;
+    return static_cast<uint8_t*>(ptr);
+#endif
+}
+
+void CAsyncFileWriter::freeBlock(uint8_t* data)
+{
+#ifdef _WIN32
+    _aligned_free(data);
+#else
+    free(data);
+#endif
+}
+
+// ------------------------- 平台相关的文件操作 -------------------------
+#ifdef _WIN32
+
+bool CAsyncFileWriter::fileOpen(const std::string& filePath)
+{
+    // 路径为 UTF-8，转为宽字符后打开，与 avio_open 的行为一致
+    int len = MultiByteToWideChar(CP_UTF8, 0, filePath.c_str(), -1, nullptr, 0);
+    if (len <= 0)
+        return false;
+    std::wstring widePath(static_cast<size_t>(len), L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, filePath.c_str(), -1, &widePath[0], len);
+
+    HANDLE hFile = CreateFileW(widePath.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+        CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE)
+        return false;
+
+    hFile_ = hFile;
+    return true;
+}
+
+bool CAsyncFileWriter::fileWriteAt(const uint8_t* data, size_t size, int64_t offset)
+{
+    while (size > 0)
+    {
+        // 同步句柄上带偏移的 WriteFile 即定位写，不依赖也不修改文件指针
+        OVERLAPPED ov{};
+        ov.Offset = static_cast<DWORD>(offset & 0xFFFFFFFF);
+        ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+        DWORD toWrite = static_cast<DWORD>(std::min<size_t>(size, 1u << 30));
+        DWORD written = 0;
+        if (!WriteFile(static_cast<HANDLE>(hFile_), data, toWrite, &written, &ov) || written == 0)
+            return false;
+
+        data += written;
+        size -= written;
+        offset += written;
+    }
+    return true;
+}
+
+void CAsyncFileWriter::filePreallocate(int64_t end)
+{
+    if (cfg_.preallocateStep_ <= 0 || end <= preallocatedEnd_)
+        return;
+
+    int64_t newEnd = (end + cfg_.preallocateStep_ - 1) / cfg_.preallocateStep_ * cfg_.preallocateStep_;
+    // 只分配磁盘空间，不改变文件大小，关闭时截掉未使用的部分
+    FILE_ALLOCATION_INFO info{};
+    info.AllocationSize.QuadPart = newEnd;
+    if (!SetFileInformationByHandle(static_cast<HANDLE>(hFile_), FileAllocationInfo, &info, sizeof(info)))
+    {
+        qWarning() << "AsyncFileWriter: Failed to preallocate file space, error:" << GetLastError();
+        cfg_.preallocateStep_ = 0;
+        return;
+    }
+    preallocatedEnd_ = newEnd;
+}
+
+void CAsyncFileWriter::fileDropCache(int64_t, size_t)
+{
+    // Windows 没有按区间丢弃页缓存的接口，FILE_FLAG_SEQUENTIAL_SCAN 已提示系统尽早回收
+}
+
+void CAsyncFileWriter::fileClose()
+{
+    if (hFile_)
+    {
+        // 截到实际写入的大小，释放预分配但未使用的磁盘空间（不依赖关闭句柄时系统的回收）
+        if (preallocatedEnd_ > 0)
+        {
+            FILE_END_OF_FILE_INFO eofInfo{};
+            eofInfo.EndOfFile.QuadPart = size_;
+            if (!SetFileInformationByHandle(static_cast<HANDLE>(hFile_), FileEndOfFileInfo, &eofInfo, sizeof(eofInfo)))
+                qWarning() << "AsyncFileWriter: Failed to truncate file, error:" << GetLastError();
+        }
+        CloseHandle(static_cast<HANDLE>(hFile_));
+        hFile_ = nullptr;
+    }
+}
+
+#else
+
+bool CAsyncFileWriter::fileOpen(const std::string& filePath)
+{
+    fd_ = ::open(filePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    return fd_ >= 0;
+}
+
+bool CAsyncFileWriter::fileWriteAt(const uint8_t* data, size_t size, int64_t offset)
+{
+    while (size > 0)
+    {
+        ssize_t written = ::pwrite(fd_, data, size, static_cast<off_t>(offset));
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        if (written == 0)
+            return false;
+
+        data += written;
+        size -= static_cast<size_t>(written);
+        offset += written;
+    }
+    return true;
+}
+
+void CAsyncFileWriter::filePreallocate(int64_t end)
+{
+    if (cfg_.preallocateStep_ <= 0 || end <= preallocatedEnd_)
+        return;
+
+#ifdef __linux__
+    int64_t newEnd = (end + cfg_.preallocateStep_ - 1) / cfg_.preallocateStep_ * cfg_.preallocateStep_;
+    // FALLOC_FL_KEEP_SIZE：只分配磁盘空间，不改变文件大小，关闭时截掉多余部分
+    if (::fallocate(fd_, FALLOC_FL_KEEP_SIZE, preallocatedEnd_, newEnd - preallocatedEnd_) != 0)
+    {
+        qWarning() << "AsyncFileWriter: Failed to preallocate file space, errno:" << errno;
+        cfg_.preallocateStep_ = 0;
+        return;
+    }
+    preallocatedEnd_ = newEnd;
+#else
+    cfg_.preallocateStep_ = 0;
+#endif
+}
+
+void CAsyncFileWriter::fileDropCache(int64_t offset, size_t size)
+{
+#ifdef __linux__
+    // 等待该区间回写完成，之后页缓存是干净的，posix_fadvise 才能真正丢弃
+    ::sync_file_range(fd_, offset, static_cast<off_t>(size),
+        SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+    ::posix_fadvise(fd_, offset, static_cast<off_t>(size), POSIX_FADV_DONTNEED);
+#else
+    (void)offset;
+    (void)size;
+#endif
+}
+
+void CAsyncFileWriter::fileClose()
+{
+    if (fd_ < 0)
+        return;
+
+    // 截到实际写入的大小，释放预分配但未使用的磁盘空间
+    if (preallocatedEnd_ > 0 && ::ftruncate(fd_, static_cast<off_t>(size_)) != 0)
+        qWarning() << "AsyncFileWriter: Failed to truncate file, errno:" << errno;
+
+    ::close(fd_);
+    fd_ = -1;
+}
+
+#endif // _WIN32
+
+// ------------------------- 打开与关闭 -------------------------
+bool CAsyncFileWriter::open(const std::string& filePath, const MuxerCfg& cfg)
+{
+    close();
+
+    cfg_ = cfg;
+    cfg_.writeBlockSize_ = std::max<size_t>(cfg_.writeBlockSize_, AVIO_BUFFER_SIZE);
+    cfg_.writeBlockSize_ = (cfg_.writeBlockSize_ + BLOCK_ALIGNMENT - 1) / BLOCK_ALIGNMENT * BLOCK_ALIGNMENT;
+    cfg_.maxWriteBlocks_ = std::max<size_t>(cfg_.maxWriteBlocks_, 2);
+
+    current_ = Block{};
+    pos_ = 0;
+    size_ = 0;
+    preallocatedEnd_ = 0;
+    syncedEnd_ = 0;
+    writtenEnd_ = 0;
+    completedRanges_.clear();
+    writtenBytes_ = 0;
+    stallCount_ = 0;
+    hasError_ = false;
+
+    if (!fileOpen(filePath))
+    {
+        qCritical() << "AsyncFileWriter: Failed to open" << filePath.c_str() << "for writing.";
+        return false;
+    }
+
+    unsigned char* avioBuffer = static_cast<unsigned char*>(av_malloc(AVIO_BUFFER_SIZE));
+    if (!avioBuffer)
+    {
+        fileClose();
+        return false;
+    }
+    avioCtx_ = avio_alloc_context(avioBuffer, AVIO_BUFFER_SIZE, 1, this, nullptr, &CAsyncFileWriter::writePacketCb, &CAsyncFileWriter::seekCb);
+    if (!avioCtx_)
+    {
+        av_free(avioBuffer);
+        fileClose();
+        return false;
+    }
+    avioCtx_->seekable = AVIO_SEEKABLE_NORMAL;
+
+#ifdef LME_USE_IO_URING
+    useRing_ = (io_uring_queue_init(static_cast<unsigned>(cfg_.maxWriteBlocks_), &ring_, 0) == 0);
+    if (!useRing_)
+        qWarning() << "AsyncFileWriter: io_uring is not available, fall back to pwrite.";
+    appendEnd_ = 0;
+    inFlight_ = 0;
+#endif
+
+    {
+        std::lock_guard<std::mutex> lock{ mtx_ };
+        isRunning_ = true;
+    }
+    writerThread_ = std::thread(&CAsyncFileWriter::writingLoop, this);
+
+    qInfo() << "AsyncFileWriter: Opened" << filePath.c_str()
+        << ", block size:" << cfg_.writeBlockSize_ << ", max blocks:" << cfg_.maxWriteBlocks_;
+    return true;
+}
+
+void CAsyncFileWriter::flush()
+{
+    if (!avioCtx_)
+        return;
+
+    // 把 AVIOContext 缓冲区中剩余的数据交给当前块，再把当前块交给写线程
+    avio_flush(avioCtx_);
+    if (current_.data && current_.size > 0)
+        submitBlock();
+}
+
+bool CAsyncFileWriter::close()
+{
+    if (!avioCtx_)
+        return !hasError();
+
+    flush();
+    if (current_.data)
+    {
+        releaseBlock(current_.data);
+        current_ = Block{};
+    }
+
+    {
+        std::lock_guard<std::mutex> lock{ mtx_ };
+        isRunning_ = false;
+    }
+    pendingCond_.notify_one();
+    if (writerThread_.joinable())
+        writerThread_.join();
+
+#ifdef LME_USE_IO_URING
+    if (useRing_)
+    {
+        io_uring_queue_exit(&ring_);
+        useRing_ = false;
+    }
+#endif
+    fileClose();
+
+    for (uint8_t* data : freeBlocks_)
+        freeBlock(data);
+    freeBlocks_.clear();
+    allocatedBlocks_ = 0;
+
+    av_freep(&avioCtx_->buffer);
+    avio_context_free(&avioCtx_);
+
+    qInfo() << "AsyncFileWriter: Closed, written" << writtenBytes_ << "bytes, waited for disk" << stallCount_ << "times"
+        << (hasError() ? "with errors." : ".");
+    return !hasError();
+}
+
+// ------------------------- muxer 线程：AVIOContext 回调 -------------------------
+int CAsyncFileWriter::writePacketCb(void* opaque, uint8_t* buf, int bufSize)
+{
+    return static_cast<CAsyncFileWriter*>(opaque)->onWrite(buf, bufSize);
+}
+
+int64_t CAsyncFileWriter::seekCb(void* opaque, int64_t offset, int whence)
+{
+    return static_cast<CAsyncFileWriter*>(opaque)->onSeek(offset, whence);
+}
+
+int CAsyncFileWriter::onWrite(const uint8_t* buf, int bufSize)
+{
+    if (hasError())
+        return AVERROR(EIO);
+    if (bufSize <= 0)
+        return 0;
+
+    size_t copied = 0;
+    const size_t total = static_cast<size_t>(bufSize);
+    while (copied < total)
+    {
+        if (!current_.data && !acquireBlock())
+            return AVERROR(ENOMEM);
+        if (current_.size == 0)
+            current_.offset = pos_ + static_cast<int64_t>(copied);
+
+        size_t n = std::min(total - copied, cfg_.writeBlockSize_ - current_.size);
+        memcpy(current_.data + current_.size, buf + copied, n);
+        current_.size += n;
+        copied += n;
+
+        if (current_.size == cfg_.writeBlockSize_)
+            submitBlock();
+    }
+
+    pos_ += bufSize;
+    size_ = std::max(size_, pos_);
+    return bufSize;
+}
+
+int64_t CAsyncFileWriter::onSeek(int64_t offset, int whence)
+{
+    if (whence & AVSEEK_SIZE)
+        return size_;
+
+    int64_t target = 0;
+    switch (whence & ~AVSEEK_FORCE)
+    {
+    case SEEK_SET: target = offset; break;
+    case SEEK_CUR: target = pos_ + offset; break;
+    case SEEK_END: target = size_ + offset; break;
+    default: return AVERROR(EINVAL);
+    }
+    if (target < 0)
+        return AVERROR(EINVAL);
+
+    // 位置变化后，后续数据写入新块，新块的偏移在第一次写入时确定
+    if (target != pos_ && current_.data && current_.size > 0)
+        submitBlock();
+
+    pos_ = target;
+    return target;
+}
+
+// ------------------------- 块池 -------------------------
+bool CAsyncFileWriter::acquireBlock()
+{
+    std::unique_lock<std::mutex> lock{ mtx_ };
+    if (freeBlocks_.empty() && allocatedBlocks_ >= cfg_.maxWriteBlocks_)
+    {
+        // 写线程跟不上，所有块都在等待落盘，此时只能等待；只在第一次时打印，关闭时汇总次数
+        if (stallCount_++ == 0)
+            qWarning() << "AsyncFileWriter: All write blocks are pending, muxer is waiting for disk.";
+        freeCond_.wait(lock, [this] { return !freeBlocks_.empty(); });
+    }
+
+    uint8_t* data = nullptr;
+    if (!freeBlocks_.empty())
+    {
+        data = freeBlocks_.back();
+        freeBlocks_.pop_back();
+    }
+    else
+    {
+        data = allocBlock(cfg_.writeBlockSize_);
+        if (!data)
+        {
+            qCritical() << "AsyncFileWriter: Failed to allocate write block.";
+            return false;
+        }
+        ++allocatedBlocks_;
+    }
+
+    current_ = Block{ data, 0, pos_ };
+    return true;
+}
+
+void CAsyncFileWriter::submitBlock()
+{
+    {
+        std::lock_guard<std::mutex> lock{ mtx_ };
+        pendingBlocks_.push_back(current_);
+    }
+    pendingCond_.notify_one();
+    current_ = Block{};
+}
+
+void CAsyncFileWriter::releaseBlock(uint8_t* data)
+{
+    {
+        std::lock_guard<std::mutex> lock{ mtx_ };
+        freeBlocks_.push_back(data);
+    }
+    freeCond_.notify_one();
+}
+
+// ------------------------- 写线程 -------------------------
+void CAsyncFileWriter::onBlockWritten(const Block& block)
+{
+    writtenBytes_ += block.size;
+
+    // 只处理顺序追加的块，seek 回写的小块（如 mdat 大小）不需要
+    if (!cfg_.dropPageCache_ || block.offset < writtenEnd_)
+        return;
+
+    // io_uring 的完成顺序不一定是提交顺序，只有从 writtenEnd_ 开始连续写完的区间才能推进
+    completedRanges_[block.offset] = block.offset + static_cast<int64_t>(block.size);
+    const int64_t previousEnd = writtenEnd_;
+    while (!completedRanges_.empty() && completedRanges_.begin()->first <= writtenEnd_)
+    {
+        writtenEnd_ = std::max(writtenEnd_, completedRanges_.begin()->second);
+        completedRanges_.erase(completedRanges_.begin());
+    }
+    if (writtenEnd_ == previousEnd)
+        return;
+
+#ifdef __linux__
+    // 立即开始新增区间的异步回写
+    ::sync_file_range(fd_, previousEnd, static_cast<off_t>(writtenEnd_ - previousEnd), SYNC_FILE_RANGE_WRITE);
+#endif
+    // 等待之前的区间回写完成并丢弃其页缓存，回写始终只积压最近一次新增的区间
+    if (previousEnd > syncedEnd_)
+        fileDropCache(syncedEnd_, static_cast<size_t>(previousEnd - syncedEnd_));
+    syncedEnd_ = previousEnd;
+}
+
+void CAsyncFileWriter::writeBlock(const Block& block)
+{
+    if (hasError())
+    {
+        releaseBlock(block.data);
+        return;
+    }
+
+    filePreallocate(block.offset + static_cast<int64_t>(block.size));
+
+#ifdef LME_USE_IO_URING
+    if (useRing_)
+    {
+        if (inFlight_ >= cfg_.maxWriteBlocks_)
+            reapCompletions(true);
+
+        io_uring_sqe* sqe = io_uring_get_sqe(&ring_);
+        if (sqe)
+        {
+            io_uring_prep_write(sqe, fd_, block.data, static_cast<unsigned>(block.size), static_cast<__u64>(block.offset));
+            // 非追加写（seek 回写）必须等之前的写请求完成，保证覆盖顺序
+            if (block.offset < appendEnd_)
+                sqe->flags |= IOSQE_IO_DRAIN;
+            io_uring_sqe_set_data(sqe, new Block{ block });
+            io_uring_submit(&ring_);
+
+            ++inFlight_;
+            appendEnd_ = std::max(appendEnd_, block.offset + static_cast<int64_t>(block.size));
+            reapCompletions(false);
+            return;
+        }
+        // 提交队列满，退回同步写
+        reapCompletions(true);
+    }
+#endif
+
+    if (fileWriteAt(block.data, block.size, block.offset))
+    {
+        onBlockWritten(block);
+    }
+    else if (!hasError_.exchange(true))
+    {
+        qCritical() << "AsyncFileWriter: Failed to write" << block.size << "bytes at offset" << block.offset;
+    }
+    releaseBlock(block.data);
+}
+
+#ifdef LME_USE_IO_URING
+void CAsyncFileWriter::reapCompletions(bool wait)
+{
+    while (inFlight_ > 0)
+    {
+        io_uring_cqe* cqe = nullptr;
+        int ret = wait ? io_uring_wait_cqe(&ring_, &cqe) : io_uring_peek_cqe(&ring_, &cqe);
+        if (ret < 0 || !cqe)
+            break;
+
+        Block* block = static_cast<Block*>(io_uring_cqe_get_data(cqe));
+        int res = cqe->res;
+        io_uring_cqe_seen(&ring_, cqe);
+        --inFlight_;
+        wait = false;   // 等到一个后，其余的只收取已完成的
+
+        bool ok = (res >= 0);
+        // 短写时同步补写剩余部分
+        if (ok && static_cast<size_t>(res) < block->size)
+            ok = fileWriteAt(block->data + res, block->size - res, block->offset + res);
+
+        if (ok)
+            onBlockWritten(*block);
+        else if (!hasError_.exchange(true))
+            qCritical() << "AsyncFileWriter: io_uring write failed at offset" << block->offset << ", res:" << res;
+
+        releaseBlock(block->data);
+        delete block;
+    }
+}
+#endif
+
+void CAsyncFileWriter::writingLoop()
+{
+    qInfo() << "[Thread: AsyncFileWriter] Loop started.";
+
+    while (true)
+    {
+        Block block{};
+        {
+            std::unique_lock<std::mutex> lock{ mtx_ };
+#ifdef LME_USE_IO_URING
+            // 没有新块时先收回所有进行中的写请求，避免 muxer 线程等待空闲块
+            if (pendingBlocks_.empty() && inFlight_ > 0)
+            {
+                lock.unlock();
+                reapCompletions(true);
+                continue;
+            }
+#endif
+            pendingCond_.wait(lock, [this] { return !pendingBlocks_.empty() || !isRunning_; });
+            if (pendingBlocks_.empty())
+                break;  // 已停止且没有剩余数据
+
+            block = pendingBlocks_.front();
+            pendingBlocks_.pop_front();
+        }
+        writeBlock(block);
+    }
+
+#ifdef LME_USE_IO_URING
+    while (inFlight_ > 0)
+        reapCompletions(true);
+#endif
+
+    qInfo() << "[Thread: AsyncFileWriter] Loop finished.";
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+extern "C" {
+#include <libavformat/avio.h>
+}
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <vector>
+#include <atomic>
+
+#include "Common/DataDefine.h"
+
+#ifdef LME_USE_IO_URING
+#include <liburing.h>
+#endif
+
+/*
+ * 录制文件的异步写入后端，为 CMuxer 提供自定义的 AVIOContext。
+ * muxer 线程写入的数据先拷贝进大块对齐的内存（默认 4MB），写满后交给独立的写线程落盘，
+ * 磁盘抖动、页缓存回写等延迟不会再阻塞 av_interleaved_write_frame。
+ *
+ * 每个数据块都带有文件偏移，写线程使用定位写（pwrite / 带 OVERLAPPED 偏移的 WriteFile），
+ * 因此 mp4 muxer 在结束时回写 moov/mdat 大小等 seek 操作可以正常工作；
+ * 但该后端不支持回读，不能与需要回读文件的选项（如 movflags=faststart）同时使用。
+ *
+ * 可选的平台优化：
+ *   - preallocateStep_ > 0 时按步长预分配文件空间（fallocate / FileAllocationInfo），关闭时截到实际大小
+ *   - dropPageCache_ 为 true 时在数据落盘后丢弃对应页缓存（Linux: sync_file_range + posix_fadvise）
+ *   - 定义 LME_USE_IO_URING 并链接 liburing 时，Linux 下使用 io_uring 提交写请求
+ */
+class CAsyncFileWriter
+{
+public:
+    CAsyncFileWriter() = default;
+    ~CAsyncFileWriter();
+
+    CAsyncFileWriter(const CAsyncFileWriter&) = delete;
+    CAsyncFileWriter& operator=(const CAsyncFileWriter&) = delete;
+
+    /**
+     * @brief 创建输出文件，分配 AVIOContext 并启动写线程
+     * @param filePath 输出文件路径（UTF-8）
+     * @param cfg 写缓冲块大小、数量以及平台优化选项
+     * @return 成功返回true
+     */
+    bool open(const std::string& filePath, const MuxerCfg& cfg);
+
+    // 交给 AVFormatContext::pb 使用，生命周期由本类管理
+    AVIOContext* getAVIOContext() const { return avioCtx_; }
+
+    // 把已写入 AVIOContext 的数据立即交给写线程，不等当前块写满（muxer 线程调用）
+    void flush();
+
+    /**
+     * @brief 刷新 AVIOContext，等待写线程写完所有数据后关闭文件
+     * @return 全部数据写入成功返回true
+     */
+    bool close();
+
+    bool hasError() const { return hasError_.load(std::memory_order_relaxed); }
+
+private:
+    struct Block
+    {
+        uint8_t* data = nullptr;
+        size_t size = 0;        // 已填充的字节数
+        int64_t offset = 0;     // 该块在文件中的起始偏移
+    };
+
+    // AVIOContext 回调，在 muxer 线程中执行
+    static int writePacketCb(void* opaque, uint8_t* buf, int bufSize);
+    static int64_t seekCb(void* opaque, int64_t offset, int whence);
+    int onWrite(const uint8_t* buf, int bufSize);
+    int64_t onSeek(int64_t offset, int whence);
+
+    // 取一个空闲块作为当前块，没有空闲块且已达上限时等待写线程归还（唯一的反压点）
+    bool acquireBlock();
+    // 把当前块交给写线程
+    void submitBlock();
+    // 写线程归还已写完的块
+    void releaseBlock(uint8_t* data);
+
+    void writingLoop();
+    void writeBlock(const Block& block);
+    void onBlockWritten(const Block& block);
+
+    // ------------------------- 平台相关的文件操作 -------------------------
+    bool fileOpen(const std::string& filePath);
+    bool fileWriteAt(const uint8_t* data, size_t size, int64_t offset);
+    void filePreallocate(int64_t end);
+    void fileDropCache(int64_t offset, size_t size);
+    void fileClose();
+
+    static uint8_t* allocBlock(size_t size);
+    static void freeBlock(uint8_t* data);
+
+private:
+    static constexpr int AVIO_BUFFER_SIZE = 64 * 1024;     // AVIOContext 自身的缓冲区
+    static constexpr size_t BLOCK_ALIGNMENT = 4096;        // 写缓冲块按页对齐
+
+    MuxerCfg cfg_{};
+    AVIOContext* avioCtx_ = nullptr;
+
+#ifdef _WIN32
+    void* hFile_ = nullptr;     // HANDLE
+#else
+    int fd_ = -1;
+#endif
+
+    // ------------------------- muxer 线程使用 -------------------------
+    Block current_{};
+    int64_t pos_ = 0;           // 逻辑写位置
+    int64_t size_ = 0;          // 逻辑文件大小
+
+    // ------------------------- 两个线程共享 -------------------------
+    std::mutex mtx_;
+    std::condition_variable pendingCond_;   // 有新块待写，或需要退出
+    std::condition_variable freeCond_;      // 有块被归还
+    std::deque<Block> pendingBlocks_;
+    std::vector<uint8_t*> freeBlocks_;
+    size_t allocatedBlocks_ = 0;
+    uint64_t stallCount_ = 0;   // muxer 线程等待空闲块的次数
+    bool isRunning_ = false;
+
+    std::thread writerThread_;
+    std::atomic<bool> hasError_{ false };
+
+    // ------------------------- 写线程使用 -------------------------
+    int64_t preallocatedEnd_ = 0;   // 已预分配到的文件偏移
+    int64_t syncedEnd_ = 0;         // 已回写并丢弃页缓存的文件偏移
+    int64_t writtenEnd_ = 0;        // 从文件开头连续写完的结束偏移
+    std::map<int64_t, int64_t> completedRanges_;    // writtenEnd_ 之后提前完成的追加块，起始偏移 -> 结束偏移
+    uint64_t writtenBytes_ = 0;
+#ifdef LME_USE_IO_URING
+    struct io_uring ring_{};
+    bool useRing_ = false;
+    int64_t appendEnd_ = 0;         // 已提交写请求的最大结束偏移
+    unsigned inFlight_ = 0;
+    void reapCompletions(bool wait);
+#endif
+};
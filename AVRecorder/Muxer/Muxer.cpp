@@ -3,29 +3,32 @@
 #include <QObject>
 #include <QDebug>
 #include <libavutil/log.h>
+extern "C" {
+#include <libavutil/avstring.h>
+}
 #include <stdarg.h> 
 
 #ifdef DEBUG
 static void ffmpeg_log_callback(void* ptr, int level, const char* fmt, va_list vargs)
 {
-    // ־ǿԺһЩϸϢ
+    // 检查日志级别，我们可以忽略一些过于详细的信息
     if (level > av_log_get_level())
         return;
 
-    // һ㹻Ļ洢ʽ־Ϣ
+    // 创建一个足够大的缓冲区来存储格式化后的日志消息
     char message[1024];
 
-    // ʹ vsnprintf ȫظʽ־
-    // FFmpeg ݵ fmt ʽַͨѾ "[libx264 @ ...]" Ϣ
+    // 使用 vsnprintf 安全地格式化日志内容
+    // FFmpeg 传递的 fmt 格式字符串通常已经包含了像 "[libx264 @ ...]" 这样的上下文信息
     vsnprintf(message, sizeof(message), fmt, vargs);
 
-    // ȥϢĩβĻзΪqDebugԶ
+    // 去掉消息末尾多余的换行符，因为qDebug会自动添加
     size_t len = strlen(message);
     if (len > 0 && message[len - 1] == '\n') {
         message[len - 1] = '\0';
     }
 
-    // FFmpeg־ѡʹQtĲͬ
+    // 根据FFmpeg的日志级别，选择使用Qt的不同输出流
     switch (level) {
     case AV_LOG_PANIC:
     case AV_LOG_FATAL:
@@ -64,19 +67,30 @@ CMuxer::CMuxer()
 
 CMuxer::~CMuxer()
 {
-    // ȷʱԴͷ
+    // 确保在析构时资源被释放
     close();
 }
 
-bool CMuxer::initialize(const char* filePath)
+bool CMuxer::initialize(const char* filePath, const MuxerCfg& cfg)
 {
     if (!filePath) {
         qWarning() << "Muxer Error: Filename is null.";
         return false;
     }
 
-    // 
-    int ret = avformat_alloc_output_context2(&formatCtx_, nullptr, nullptr, filePath);
+    cfg_ = cfg;
+    basePath_ = filePath;
+    segmentIndex_ = 0;
+    segmentStartUs_ = 0;
+
+    // 分段录制时第一个文件也带序号
+    return openOutput(isSegmented() ? segmentPath(0) : basePath_);
+}
+
+bool CMuxer::openOutput(const std::string& filePath)
+{
+    // 分配输出上下文
+    int ret = avformat_alloc_output_context2(&formatCtx_, nullptr, nullptr, filePath.c_str());
     if (ret < 0 || !formatCtx_) {
         avCheckRet("avformat_alloc_output_context2", ret);
         qWarning() << "Muxer Error: Could not allocate output context.";
@@ -84,8 +98,23 @@ bool CMuxer::initialize(const char* filePath)
     }
     filePath_ = filePath;
 
-    // ļ IO
-    ret = avio_open(&formatCtx_->pb, filePath, AVIO_FLAG_WRITE);
+    // 打开文件 IO
+    if (cfg_.asyncWrite_ && !(formatCtx_->oformat->flags & AVFMT_NOFILE)) {
+        asyncWriter_.reset(new CAsyncFileWriter{});
+        if (!asyncWriter_->open(filePath_, cfg_)) {
+            qWarning() << "Muxer Error: Could not open output file" << QString::fromStdString(filePath_);
+            asyncWriter_.reset();
+            avformat_free_context(formatCtx_);
+            formatCtx_ = nullptr;
+            return false;
+        }
+        formatCtx_->pb = asyncWriter_->getAVIOContext();
+        formatCtx_->flags |= AVFMT_FLAG_CUSTOM_IO;
+        ret = 0;
+    }
+    else {
+        ret = avio_open(&formatCtx_->pb, filePath_.c_str(), AVIO_FLAG_WRITE);
+    }
     if (ret < 0) {
         avCheckRet("avio_open", ret);
         qWarning() << "Muxer Error: Could not open output file" << QString::fromStdString(filePath_);
@@ -99,6 +128,148 @@ bool CMuxer::initialize(const char* filePath)
     return true;
 }
 
+std::string CMuxer::segmentPath(int index) const
+{
+    // out.mp4 -> out_000.mp4
+    char suffix[16] = { 0 };
+    snprintf(suffix, sizeof(suffix), "_%03d", index);
+
+    const size_t slash = basePath_.find_last_of("/\\");
+    const size_t dot = basePath_.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        return basePath_ + suffix;
+    return basePath_.substr(0, dot) + suffix + basePath_.substr(dot);
+}
+
+bool CMuxer::shouldRotate(const AVPacket* packet) const
+{
+    if (cfg_.segmentMaxBytes_ > 0 && formatCtx_->pb &&
+        avio_tell(formatCtx_->pb) >= cfg_.segmentMaxBytes_) {
+        return true;
+    }
+    if (cfg_.segmentDurationMs_ > 0 && packet->dts != AV_NOPTS_VALUE) {
+        int64_t nowUs = av_rescale_q(packet->dts, srcTimeBases_[packet->stream_index], AV_TIME_BASE_Q);
+        if (nowUs - segmentStartUs_ >= cfg_.segmentDurationMs_ * 1000) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CMuxer::rotateSegment(int64_t startUs)
+{
+    qInfo() << "Muxer: Finishing segment" << QString::fromStdString(filePath_);
+
+    // 上一个分段还在等待晚到的音频时，到这里也该关闭了
+    closePrevSegment();
+
+    // 当前文件先不写文件尾，dts 早于新分段起点的音频仍写入该文件；编码器和各个队列不受影响
+    prevFormatCtx_ = formatCtx_;
+    prevAsyncWriter_ = std::move(asyncWriter_);
+    prevFilePath_ = filePath_;
+    prevSegmentStartUs_ = segmentStartUs_;
+    formatCtx_ = nullptr;
+    isHeadWritten_ = false;
+
+    ++segmentIndex_;
+    if (!openOutput(segmentPath(segmentIndex_))) {
+        closePrevSegment();
+        return false;
+    }
+
+    // 使用与第一个文件相同的参数重建所有流，mp4 的 avcC/esds 来自 extradata，新文件可以独立解码
+    bool hasAudio = false;
+    for (size_t i = 0; i < streamParams_.size(); ++i) {
+        AVStream* stream = avformat_new_stream(formatCtx_, nullptr);
+        if (!stream || avcodec_parameters_copy(stream->codecpar, streamParams_[i]) < 0) {
+            qWarning() << "Muxer Error: Failed to recreate stream for new segment.";
+            closeOutput();
+            closePrevSegment();
+            return false;
+        }
+        stream->codecpar->codec_tag = 0;
+        stream->time_base = srcTimeBases_[i];
+        hasAudio = hasAudio || streamParams_[i]->codec_type == AVMEDIA_TYPE_AUDIO;
+    }
+
+    if (!writeHeader()) {
+        closeOutput();
+        closePrevSegment();
+        return false;
+    }
+    segmentStartUs_ = startUs;
+
+    // 没有音频流时不会有晚到的包
+    if (!hasAudio)
+        closePrevSegment();
+    return true;
+}
+
+void CMuxer::closePrevSegment()
+{
+    if (!prevFormatCtx_)
+        return;
+    qInfo() << "Muxer: Closing previous segment" << QString::fromStdString(prevFilePath_);
+
+    PendingClose pending;
+    pending.formatCtx = prevFormatCtx_;
+    pending.asyncWriter = std::move(prevAsyncWriter_);
+    pending.filePath = std::move(prevFilePath_);
+    prevFormatCtx_ = nullptr;
+    prevFilePath_.clear();
+    {
+        std::lock_guard<std::mutex> lock{ closeMtx_ };
+        if (!isCloserRunning_) {
+            isCloserRunning_ = true;
+            closerThread_ = std::thread(&CMuxer::closingLoop, this);
+        }
+        closeQueue_.push_back(std::move(pending));
+    }
+    closeCond_.notify_one();
+}
+
+void CMuxer::closingLoop()
+{
+    while (true)
+    {
+        PendingClose pending;
+        {
+            std::unique_lock<std::mutex> lock{ closeMtx_ };
+            closeCond_.wait(lock, [this] { return !closeQueue_.empty() || !isCloserRunning_; });
+            if (closeQueue_.empty())
+                break;
+            pending = std::move(closeQueue_.front());
+            closeQueue_.pop_front();
+        }
+
+        if (!closeOutput(pending.formatCtx, pending.asyncWriter, true, pending.filePath)) {
+            std::lock_guard<std::mutex> lock{ closeMtx_ };
+            closeOk_ = false;
+        }
+    }
+}
+
+bool CMuxer::stopCloser()
+{
+    bool wasRunning = false;
+    {
+        std::lock_guard<std::mutex> lock{ closeMtx_ };
+        wasRunning = isCloserRunning_;
+        isCloserRunning_ = false;
+    }
+    // 不持有任何锁等待，关闭线程会处理完队列中剩余的分段再退出
+    if (wasRunning) {
+        closeCond_.notify_all();
+        if (closerThread_.joinable())
+            closerThread_.join();
+    }
+
+    std::lock_guard<std::mutex> lock{ closeMtx_ };
+    const bool ok = closeOk_;
+    closeOk_ = true;
+    return ok;
+}
+
 AVStream* CMuxer::addStream(const AVCodecContext* codecContext)
 {
     if (!formatCtx_) {
@@ -110,31 +281,42 @@ AVStream* CMuxer::addStream(const AVCodecContext* codecContext)
         return nullptr;
     }
 
-    // һµ
+    // 创建一个新的流
     AVStream* stream = avformat_new_stream(formatCtx_, nullptr);
     if (!stream) {
         qWarning() << "Muxer Error: Failed to create new stream.";
         return nullptr;
     }
 
-    // ӱп codecpar
+    // 从编码器上下文中拷贝参数到流的 codecpar
     int ret = avcodec_parameters_from_context(stream->codecpar, codecContext);
     if (ret < 0) {
         avCheckRet("avcodec_parameters_from_context", ret);
         qWarning() << "Muxer Error: Failed to copy codec parameters to stream.";
-        // ﲻstreamϲֱmuxer
+        // 这里不清理stream，返回上层直接清理muxer
         return nullptr;
     }
 
-    //  H.264/AACҪ flag
+    // 对于 H.264/AAC，可能需要这个 flag
     if (formatCtx_->oformat->flags & AVFMT_GLOBALHEADER) {
-        // ע⣺޸ĵǱĵ flagΪ addStream  avcodec_open2 ֮ǰõ
-        // õ Encoder ڲú flag
+        // 注意：这里我们修改的是编码器上下文的 flag，因为 addStream 是在 avcodec_open2 之前调用的
+        // 更好的做法是在 Encoder 内部设置好这个 flag
         // (AVCodecContext*)codecContext->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
     }
 
     stream->codecpar->codec_tag = 0;
 
+    // 保存流参数，分段录制切换文件时用于重建流
+    AVCodecParameters* params = avcodec_parameters_alloc();
+    if (params && avcodec_parameters_copy(params, stream->codecpar) >= 0) {
+        streamParams_.push_back(params);
+    }
+    else {
+        avcodec_parameters_free(&params);
+        qWarning() << "Muxer Error: Failed to save codec parameters.";
+        return nullptr;
+    }
+
     qInfo() << "Muxer: Added new stream #" << stream->index
         << " (type:" << av_get_media_type_string(codecContext->codec_type) << ")";
 
@@ -152,10 +334,27 @@ bool CMuxer::writeHeader()
         return true;
     }
 
-    // ӡϢڵ
+    // 打印容器信息，用于调试
     av_dump_format(formatCtx_, 0, filePath_.c_str(), 1);
 
-    int ret = avformat_write_header(formatCtx_, nullptr);
+    // 分片 MP4：文件头只写空的 moov，之后每个片段以 moof+mdat 的形式追加
+    AVDictionary* opts = nullptr;
+    if (cfg_.fragmented_) {
+        if (av_match_name(formatCtx_->oformat->name, "mp4,mov,ismv,ipod,3gp,3g2,psp,f4v")) {
+            av_dict_set(&opts, "movflags", "frag_keyframe+empty_moov+default_base_moof", 0);
+            if (cfg_.fragDurationMs_ > 0) {
+                av_dict_set_int(&opts, "frag_duration", static_cast<int64_t>(cfg_.fragDurationMs_) * 1000, 0);
+            }
+        }
+        else {
+            qWarning() << "Muxer Warning: Fragmented mode is only supported by MP4/MOV, ignored for"
+                << formatCtx_->oformat->name;
+            cfg_.fragmented_ = false;
+        }
+    }
+
+    int ret = avformat_write_header(formatCtx_, &opts);
+    av_dict_free(&opts);
     if (ret < 0) 
     {
         avCheckRet("avformat_write_header", ret);
@@ -164,6 +363,13 @@ bool CMuxer::writeHeader()
     }
 
     isHeadWritten_ = true;
+
+    // 第一个文件的流时间基就是编码器输出 pkt 使用的时间基，之后的分段都以它为准
+    if (srcTimeBases_.empty()) {
+        for (unsigned int i = 0; i < formatCtx_->nb_streams; ++i) {
+            srcTimeBases_.push_back(formatCtx_->streams[i]->time_base);
+        }
+    }
     qInfo() << "Muxer: Header written successfully.";
     return true;
 }
@@ -182,36 +388,145 @@ bool CMuxer::writePacket(AVPacket* packet)
 
     {
         std::lock_guard<std::mutex> lock{ mtx_ };
-        int ret = av_interleaved_write_frame(formatCtx_, packet);
-        if (ret < 0) 
+        if (!formatCtx_ || packet->stream_index < 0 || packet->stream_index >= static_cast<int>(srcTimeBases_.size()))
+        {
+            qWarning() << "Muxer Error: Invalid stream index" << packet->stream_index;
+            return false;
+        }
+
+        // 写入后 packet 会被 muxer 取走，先记录是否为视频关键帧
+        const int index = packet->stream_index;
+        const bool isVideoKey = (packet->flags & AV_PKT_FLAG_KEY) &&
+            streamParams_[index]->codec_type == AVMEDIA_TYPE_VIDEO;
+
+        // 分段录制：达到阈值后在视频关键帧处切换文件，该关键帧成为新文件的第一帧
+        if (isVideoKey && isSegmented() && shouldRotate(packet))
+        {
+            if (!rotateSegment(av_rescale_q(packet->dts, srcTimeBases_[index], AV_TIME_BASE_Q)))
+            {
+                qWarning() << "Muxer Error: Failed to start new segment.";
+                return false;
+            }
+        }
+
+        // 切换后晚到的音频：dts 早于新分段起点的写入上一个分段，否则在新分段中会得到负的时间戳；
+        // 音频按顺序到达，第一个属于新分段的音频到达后上一个分段就不会再有数据
+        AVFormatContext* targetCtx = formatCtx_;
+        int64_t targetStartUs = segmentStartUs_;
+        if (prevFormatCtx_ && streamParams_[index]->codec_type == AVMEDIA_TYPE_AUDIO)
+        {
+            if (packet->dts != AV_NOPTS_VALUE &&
+                av_rescale_q(packet->dts, srcTimeBases_[index], AV_TIME_BASE_Q) < segmentStartUs_)
+            {
+                targetCtx = prevFormatCtx_;
+                targetStartUs = prevSegmentStartUs_;
+            }
+            else
+            {
+                closePrevSegment();
+            }
+        }
+
+        // 每个分段的时间戳从 0 开始，并转换到目标文件中流的时间基
+        if (targetStartUs != 0)
+        {
+            const int64_t offset = av_rescale_q(targetStartUs, AV_TIME_BASE_Q, srcTimeBases_[index]);
+            if (packet->pts != AV_NOPTS_VALUE) packet->pts -= offset;
+            if (packet->dts != AV_NOPTS_VALUE) packet->dts -= offset;
+        }
+        const AVRational dstTimeBase = targetCtx->streams[index]->time_base;
+        if (av_cmp_q(srcTimeBases_[index], dstTimeBase) != 0)
+        {
+            av_packet_rescale_ts(packet, srcTimeBases_[index], dstTimeBase);
+        }
+
+        if (!writeFrame(targetCtx, packet))
         {
-            avCheckRet("av_interleaved_write_frame", ret);
             qWarning() << "Muxer Error: Failed to write packet to file.";
             return false;
         }
+
+        // 视频关键帧结束了上一个片段，立即把它交给写线程或磁盘；
+        // 进程异常退出时丢失的只有还在 muxer 内存中的当前片段，以及写线程尚未落盘的数据
+        if (cfg_.fragmented_ && isVideoKey) {
+            if (asyncWriter_)
+                asyncWriter_->flush();
+            else
+                avio_flush(formatCtx_->pb);
+        }
     }
     return true;
 }
 
-void CMuxer::close()
+bool CMuxer::writeFrame(AVFormatContext* formatCtx, AVPacket* packet)
 {
-    if (!formatCtx_) {
-        return;
+    // 分片模式下 mov muxer 自己缓存当前片段，各流的 dts 各自递增即可，不需要交错队列；
+    // 直接写入保证关键帧返回时上一个片段（moof+mdat）已经写进 pb，
+    // 经过交错队列时关键帧可能还在队列中等待音频，此时刷新不到该片段
+    int ret = cfg_.fragmented_ ? av_write_frame(formatCtx, packet) : av_interleaved_write_frame(formatCtx, packet);
+    if (ret < 0)
+    {
+        avCheckRet(cfg_.fragmented_ ? "av_write_frame" : "av_interleaved_write_frame", ret);
+        return false;
     }
+    return true;
+}
 
-    // дļβ
-    if (isHeadWritten_) {
-        av_write_trailer(formatCtx_);
-    }
+bool CMuxer::close()
+{
+    closePrevSegment();
+    bool ok = stopCloser();
+    ok = closeOutput() && ok;
 
-    // رļ IO
-    if (formatCtx_->pb) {
-        avio_closep(&formatCtx_->pb);
+    for (AVCodecParameters*& params : streamParams_) {
+        avcodec_parameters_free(&params);
     }
+    streamParams_.clear();
+    srcTimeBases_.clear();
+    return ok;
+}
 
-    // ͷ
-    avformat_free_context(formatCtx_);
-    formatCtx_ = nullptr;
+bool CMuxer::closeOutput()
+{
+    const bool ok = closeOutput(formatCtx_, asyncWriter_, isHeadWritten_, filePath_);
     isHeadWritten_ = false;
-    qInfo() << "Muxer closed successfully.";
+    return ok;
+}
+
+bool CMuxer::closeOutput(AVFormatContext*& formatCtx, std::unique_ptr<CAsyncFileWriter>& asyncWriter,
+    bool isHeadWritten, const std::string& filePath)
+{
+    if (!formatCtx) {
+        return true;
+    }
+    bool ok = true;
+
+    // 写入文件尾
+    if (isHeadWritten) {
+        int ret = av_write_trailer(formatCtx);
+        if (ret < 0) {
+            avCheckRet("av_write_trailer", ret);
+            ok = false;
+        }
+    }
+
+    // 关闭文件 IO
+    if (asyncWriter) {
+        // 等待写线程写完所有数据，AVIOContext 由 CAsyncFileWriter 释放
+        if (!asyncWriter->close()) {
+            qWarning() << "Muxer Error: Some data failed to be written to" << QString::fromStdString(filePath);
+            ok = false;
+        }
+        asyncWriter.reset();
+        formatCtx->pb = nullptr;
+    }
+    else if (formatCtx->pb) {
+        avio_closep(&formatCtx->pb);
+    }
+
+    // 释放上下文
+    avformat_free_context(formatCtx);
+    formatCtx = nullptr;
+    qInfo() << "Muxer closed" << (ok ? "successfully." : "with errors.");
+    return ok;
 }
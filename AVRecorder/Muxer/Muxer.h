@@ -9,8 +9,12 @@ extern "C" {
 }
 #include <iostream>
 #include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <deque>
 #include "AVRecorder/AudioCapturer/AudioCapturer.h"
 #include "Common/DataDefine.h"
+#include "AsyncFileWriter/AsyncFileWriter.h"
 
 class CMuxer
 {
@@ -18,49 +22,117 @@ public:
     CMuxer();
     ~CMuxer();
 
-    // ֹ͸ֵ
+    // 禁止拷贝和赋值
     CMuxer(const CMuxer&) = delete;
     CMuxer& operator=(const CMuxer&) = delete;
 
 public:
-    // ʼ Muxer
-    bool initialize(const char* filePath);
+    /**
+     * @brief 初始化 Muxer
+     * @param filePath 输出文件路径
+     * @param cfg 文件写入参数，cfg.asyncWrite_ 为 true 时由 CAsyncFileWriter 在独立线程中落盘；
+     *        设置了分段阈值时，实际输出为 <文件名>_000.mp4、<文件名>_001.mp4 ...
+     */
+    bool initialize(const char* filePath, const MuxerCfg& cfg = MuxerCfg{});
 
     /**
-     * @brief һµýƵƵ
-     *        Ӧñ CVideoEncoder  CAudioEncoder ǳʼá
-     * @param codecContext ѾúõıģMuxerȡϢ
-     * @return ش AVStream ָ룬ʧ򷵻 nullptr
-     *         Ҫָ룬Ա֪Լ stream_index
+     * @brief 添加一个新的媒体流（视频或音频）。
+     *        这个函数应该被 CVideoEncoder 或 CAudioEncoder 在它们初始化后调用。
+     * @param codecContext 已经配置好的编码器上下文，Muxer将从中提取流信息。
+     * @return 返回创建的 AVStream 指针，如果失败则返回 nullptr。
+     *         编码器在 writeHeader() 之后从中读取 stream_index 和 time_base，不应长期持有该指针。
      */
     AVStream* addStream(const AVCodecContext* codecContext);
 
     /**
-     * @brief дļͷϢ
-     *        ͨ addStream() Ϻá
-     * @return ɹ trueʧܷ false
+     * @brief 写入文件头信息。
+     *        必须在所有流都通过 addStream() 添加完毕后调用。
+     * @return 成功返回 true，失败返回 false。
      */
     bool writeHeader();
 
     /**
-     * @brief һõݰдļ
-     *        ̰߳ȫġ
-     * @param packet Ҫд AVPacket
-     * @return ɹ trueʧܷ false
+     * @brief 将一个编码好的数据包写入文件。
+     *        这个函数是线程安全的。
+     *        分段录制时，达到时长或大小阈值后会在下一个视频关键帧处切换到新文件，
+     *        编码器无需感知：pkt 始终使用第一个文件中流的时间基，由 Muxer 负责转换。
+     * @param packet 要写入的 AVPacket。
+     * @return 成功返回 true，失败返回 false。
      */
     bool writePacket(AVPacket* packet);
 
-    // ر MuxerдļβͷԴ
-    void close();
+    /**
+     * @brief 关闭 Muxer，写入文件尾并释放所有资源。
+     * @return 文件尾和所有数据都写入成功返回true。
+     */
+    bool close();
+
+    // 当前输出文件的路径（分段录制时随切换变化）
+    const std::string& getFilePath() const { return filePath_; }
 
-    // ṩ AVFormatContext ֻʣĳЩ߼Ҫ
+    // 提供对 AVFormatContext 的只读访问，某些高级场景可能需要
     const AVFormatContext* getFormatContext() const { return formatCtx_; }
 
+private:
+    // 打开/关闭单个输出文件
+    bool openOutput(const std::string& filePath);
+    bool closeOutput();
+    static bool closeOutput(AVFormatContext*& formatCtx, std::unique_ptr<CAsyncFileWriter>& asyncWriter,
+        bool isHeadWritten, const std::string& filePath);
+    // 写入一个已转换到 formatCtx 流时间基的 pkt
+    bool writeFrame(AVFormatContext* formatCtx, AVPacket* packet);
+
+    // ------------------------- 分段录制 -------------------------
+    bool isSegmented() const { return cfg_.segmentDurationMs_ > 0 || cfg_.segmentMaxBytes_ > 0; }
+    std::string segmentPath(int index) const;
+    bool shouldRotate(const AVPacket* packet) const;
+    // 保留当前文件等待晚到的音频，用相同的流参数打开下一个文件并写入文件头，成功后 segmentStartUs_ = startUs
+    bool rotateSegment(int64_t startUs);
+    // 把上一个分段交给关闭线程写文件尾，不阻塞写包
+    void closePrevSegment();
+    // 关闭线程：按切换顺序写文件尾，并等待写线程落盘
+    void closingLoop();
+    // 等待已交给关闭线程的分段全部写完并结束线程，返回这些分段是否都写入成功
+    bool stopCloser();
+
 private:
     AVFormatContext* formatCtx_ = nullptr;
     std::string filePath_;
     bool isHeadWritten_ = false;
+    MuxerCfg cfg_{};
+
+    // 分段录制
+    std::string basePath_;                          // initialize() 传入的原始路径
+    int segmentIndex_ = 0;
+    int64_t segmentStartUs_ = 0;                    // 当前分段第一个关键帧的时间（微秒）
+    std::vector<AVCodecParameters*> streamParams_;  // 各个流的参数，用于重建流
+    std::vector<AVRational> srcTimeBases_;          // 编码器输出 pkt 的时间基（第一个文件的流时间基）
+
+    // 切换后暂不关闭的上一个分段：音频与视频分别编码，dts 早于切换点的音频可能在关键帧之后才到达，
+    // 这些音频仍写入上一个分段；第一个属于新分段的音频到达后关闭
+    AVFormatContext* prevFormatCtx_ = nullptr;
+    std::unique_ptr<CAsyncFileWriter> prevAsyncWriter_;
+    std::string prevFilePath_;
+    int64_t prevSegmentStartUs_ = 0;
+
+    // 等待关闭的分段：av_write_trailer 和等待写线程落盘都可能耗时较长，
+    // 放在 mtx_ 内执行会让切换时的写包卡住，因此交给独立线程完成
+    struct PendingClose
+    {
+        AVFormatContext* formatCtx = nullptr;
+        std::unique_ptr<CAsyncFileWriter> asyncWriter;
+        std::string filePath;
+    };
+    std::thread closerThread_;
+    std::mutex closeMtx_;
+    std::condition_variable closeCond_;
+    std::deque<PendingClose> closeQueue_;
+    bool isCloserRunning_ = false;
+    bool closeOk_ = true;                           // 关闭线程中的分段是否都写入成功，受 closeMtx_ 保护
+
+    // 异步写入后端，为空时使用 avio_open 打开的同步 IO
+    std::unique_ptr<CAsyncFileWriter> asyncWriter_;
 
-    // ʹû av_interleaved_write_frame ĵ
+    // 使用互斥锁保护对 av_interleaved_write_frame 的调用
     mutable std::mutex mtx_;
 };
\ No newline at end of file
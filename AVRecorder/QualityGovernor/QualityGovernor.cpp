@@ -0,0 +1,175 @@
+#include "QualityGovernor.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace
+{
+    // 升级后在该窗口数内又降级，认为升级过早
+    const int kUpProbeWindows = 3;
+    // 升级前稳定窗口数的上限
+    const int kMaxHoldWindows = 60;
+}
+
+void CQualityGovernor::initialize(const QualityCfg& cfg, const VideoCodecCfg& baseCfg, size_t queueCapacity)
+{
+    cfg_ = cfg;
+    baseCfg_ = baseCfg;
+    queueCapacity_ = queueCapacity;
+
+    const double fps = baseCfg.framerate_.den > 0 ? av_q2d(baseCfg.framerate_) : 30.0;
+    frameIntervalMs_ = 1000.0 / fps;
+    windowFrames_ = std::max(1, static_cast<int>(fps + 0.5));
+
+    levels_.clear();
+    Level level{ 1 };
+    levels_.push_back(level);
+
+    // 降低帧率，不低于 minFps_；不更换 preset，中途改变的 SPS/PPS 不会写进容器
+    for (int step = 2; fps / step >= cfg.minFps_; ++step) {
+        level.frameStep = step;
+        levels_.push_back(level);
+    }
+
+    upHoldWindows_.assign(levels_.size(), std::max(1, cfg.stableWindows_));
+    reset();
+}
+
+void CQualityGovernor::reset()
+{
+    level_ = 0;
+    frameCounter_ = 0;
+    windowCount_ = 0;
+    encodedCount_ = 0;
+    encodeMsSum_ = 0.0;
+    windowMaxQueue_ = 0;
+    windowStartDrops_ = 0;
+    stableWindows_ = 0;
+    cooldownWindows_ = 0;
+    windowsSinceUp_ = -1;
+    std::fill(upHoldWindows_.begin(), upHoldWindows_.end(), std::max(1, cfg_.stableWindows_));
+
+    std::lock_guard<std::mutex> lock(statsMtx_);
+    stats_ = QualityStats{};
+    stats_.levelCount = static_cast<int>(levels_.size());
+    if (!levels_.empty())
+        stats_.description = describe(levels_[0]);
+}
+
+bool CQualityGovernor::shouldEncode()
+{
+    const int step = levels_.empty() ? 1 : levels_[level_].frameStep;
+    return frameCounter_++ % step == 0;
+}
+
+bool CQualityGovernor::onFrame(double encodeMs, size_t queueDepth, uint64_t totalDrops)
+{
+    if (levels_.empty())
+        return false;
+
+    if (windowCount_ == 0)
+        windowStartDrops_ = totalDrops;
+    ++windowCount_;
+    if (encodeMs >= 0.0) {
+        ++encodedCount_;
+        encodeMsSum_ += encodeMs;
+    }
+    windowMaxQueue_ = std::max(windowMaxQueue_, queueDepth);
+
+    if (windowCount_ < windowFrames_)
+        return false;
+
+    // ------------------------- 窗口结束，评估负载 -------------------------
+    const Level& current = levels_[level_];
+    const double avgMs = encodedCount_ > 0 ? encodeMsSum_ / encodedCount_ : 0.0;
+    // 跳帧时每编码一帧可用的时间相应变长
+    const double load = avgMs / (frameIntervalMs_ * current.frameStep);
+    const uint64_t drops = totalDrops - windowStartDrops_;
+    const size_t maxQueue = windowMaxQueue_;
+
+    windowCount_ = 0;
+    encodedCount_ = 0;
+    encodeMsSum_ = 0.0;
+    windowMaxQueue_ = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(statsMtx_);
+        stats_.avgEncodeMs = avgMs;
+        stats_.load = load;
+        stats_.maxQueueDepth = maxQueue;
+        stats_.windowDrops = drops;
+        stats_.totalDrops = totalDrops;
+    }
+
+    if (windowsSinceUp_ >= 0 && ++windowsSinceUp_ > kUpProbeWindows)
+        windowsSinceUp_ = -1;
+
+    if (cooldownWindows_ > 0) {
+        --cooldownWindows_;
+        return false;
+    }
+
+    const bool overloaded = drops > 0 || load > cfg_.highLoad_ || maxQueue > queueCapacity_ / 2;
+    if (overloaded) {
+        stableWindows_ = 0;
+        if (level_ + 1 >= static_cast<int>(levels_.size()))
+            return false;
+
+        // 刚升级就过载，说明上一级还撑不住，下次需要更长的稳定时间
+        if (windowsSinceUp_ >= 0)
+            upHoldWindows_[level_ + 1] = std::min(upHoldWindows_[level_ + 1] * 2, kMaxHoldWindows);
+
+        char reason[128];
+        snprintf(reason, sizeof(reason), "down: load %.2f, queue %zu, drops %llu",
+            load, maxQueue, static_cast<unsigned long long>(drops));
+        setLevel(level_ + 1, reason);
+        return true;
+    }
+
+    const bool headroom = load < cfg_.lowLoad_ && maxQueue <= 2;
+    if (!headroom || level_ == 0) {
+        stableWindows_ = 0;
+        return false;
+    }
+
+    if (++stableWindows_ < upHoldWindows_[level_])
+        return false;
+
+    char reason[128];
+    snprintf(reason, sizeof(reason), "up: load %.2f for %d windows", load, stableWindows_);
+    setLevel(level_ - 1, reason);
+    windowsSinceUp_ = 0;
+    return true;
+}
+
+void CQualityGovernor::setLevel(int level, const std::string& reason)
+{
+    const bool down = level > level_;
+    level_ = level;
+    frameCounter_ = 0;
+    stableWindows_ = 0;
+    cooldownWindows_ = 1;
+
+    std::lock_guard<std::mutex> lock(statsMtx_);
+    stats_.level = level_;
+    stats_.description = describe(levels_[level_]);
+    stats_.lastDecision = reason;
+    if (down)
+        ++stats_.stepDowns;
+    else
+        ++stats_.stepUps;
+}
+
+QualityStats CQualityGovernor::stats() const
+{
+    std::lock_guard<std::mutex> lock(statsMtx_);
+    return stats_;
+}
+
+std::string CQualityGovernor::describe(const Level& level) const
+{
+    const double fps = 1000.0 / frameIntervalMs_ / level.frameStep;
+    char text[96];
+    snprintf(text, sizeof(text), "%s %dx%d %.0ffps", baseCfg_.preset_.c_str(), baseCfg_.out_width_, baseCfg_.out_height_, fps);
+    return text;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Common/DataDefine.h"
+
+// 质量调节器的统计信息，供界面显示
+struct QualityStats
+{
+    int         level = 0;              // 当前级别，0 为配置的原始质量
+    int         levelCount = 1;         // 级别总数
+    std::string description;            // 当前级别的参数，如 "veryfast 1280x720 30fps"
+    double      avgEncodeMs = 0.0;      // 上一个统计窗口的平均单帧编码耗时
+    double      load = 0.0;             // 平均编码耗时 / 帧间隔
+    size_t      maxQueueDepth = 0;      // 上一个统计窗口内待编码队列的最大长度
+    uint64_t    windowDrops = 0;        // 上一个统计窗口内因队列满丢弃的帧数
+    uint64_t    totalDrops = 0;         // 累计丢弃的帧数
+    uint64_t    stepDowns = 0;
+    uint64_t    stepUps = 0;
+    std::string lastDecision;           // 最近一次调整及原因
+};
+
+/*
+ * 录制质量自适应：视频编码线程每处理一帧调用一次 onFrame()，
+ * 每个统计窗口（约 1 秒的输入帧）根据平均编码耗时、待编码队列长度和丢帧数决定是否调整级别。
+ * 级别从配置的质量开始逐级降低帧率；编码器参数始终不变，
+ * MP4/FLV 等容器只记录第一组 SPS/PPS，中途更换分辨率或 x264 preset（会改变 CABAC、参考帧数、8x8dct）
+ * 的文件在多数播放器中无法正确解码。
+ * 连续若干个窗口有充足余量时逐级恢复，升级后很快又降级的级别需要更长的稳定时间才会再次尝试。
+ * 只在视频编码线程中修改，stats() 可在任意线程调用。
+ */
+class CQualityGovernor
+{
+public:
+    struct Level
+    {
+        int frameStep = 1;      // 每 frameStep 帧编码一帧
+    };
+
+    /**
+     * @brief 按原始编码参数生成级别表。
+     * @param cfg 调节参数
+     * @param baseCfg 原始编码参数，即级别 0
+     * @param queueCapacity 待编码队列容量，用于判断积压
+     */
+    void initialize(const QualityCfg& cfg, const VideoCodecCfg& baseCfg, size_t queueCapacity);
+
+    // 回到级别 0 并清空统计，每次录制开始时调用
+    void reset();
+
+    /**
+     * @brief [视频编码线程] 统计一帧。
+     * @param encodeMs 编码耗时（毫秒），< 0 表示该帧因降帧率被跳过
+     * @param queueDepth 当前待编码队列长度
+     * @param totalDrops 累计丢帧数
+     * @return 级别发生变化时返回true
+     */
+    bool onFrame(double encodeMs, size_t queueDepth, uint64_t totalDrops);
+
+    // [视频编码线程] 当前帧是否需要编码（降帧率时跳过部分帧）
+    bool shouldEncode();
+
+    int level() const { return level_; }
+    std::string description() const { return describe(levels_[level_]); }
+
+    QualityStats stats() const;
+
+private:
+    std::string describe(const Level& level) const;
+    void setLevel(int level, const std::string& reason);
+
+private:
+    QualityCfg cfg_{};
+    VideoCodecCfg baseCfg_{};
+    size_t queueCapacity_ = 0;
+    double frameIntervalMs_ = 0.0;
+    int windowFrames_ = 30;
+
+    std::vector<Level> levels_;
+    int level_ = 0;
+    uint64_t frameCounter_ = 0;
+
+    // 当前统计窗口
+    int windowCount_ = 0;
+    int encodedCount_ = 0;
+    double encodeMsSum_ = 0.0;
+    size_t windowMaxQueue_ = 0;
+    uint64_t windowStartDrops_ = 0;
+
+    int stableWindows_ = 0;     // 连续有余量的窗口数
+    int cooldownWindows_ = 0;   // 调整后跳过的窗口数，避开切换带来的抖动
+    int windowsSinceUp_ = -1;   // 距离上一次升级的窗口数，-1 表示不在观察期
+    std::vector<int> upHoldWindows_;    // 每个级别升级前需要的稳定窗口数
+
+    mutable std::mutex statsMtx_;
+    QualityStats stats_;
+};
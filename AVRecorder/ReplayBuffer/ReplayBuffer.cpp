@@ -0,0 +1,232 @@
+#include "ReplayBuffer.h"
+#include <QDebug>
+#include "AVRecorder/Muxer/Muxer.h"
+
+CReplayBuffer::~CReplayBuffer()
+{
+    cleanup();
+}
+
+void CReplayBuffer::initialize(const ReplayCfg& cfg)
+{
+    cleanup();
+    cfg_ = cfg;
+}
+
+bool CReplayBuffer::addStream(const AVCodecContext* codecContext, AVRational srcTimeBase)
+{
+    if (!codecContext)
+        return false;
+
+    // 复制一份编码参数，编码器销毁后仍然可以保存缓存中的数据
+    StreamInfo info{};
+    info.params = avcodec_alloc_context3(nullptr);
+    AVCodecParameters* par = avcodec_parameters_alloc();
+    if (!info.params || !par ||
+        avcodec_parameters_from_context(par, codecContext) < 0 ||
+        avcodec_parameters_to_context(info.params, par) < 0)
+    {
+        avcodec_parameters_free(&par);
+        avcodec_free_context(&info.params);
+        qWarning() << "ReplayBuffer: Failed to copy codec parameters.";
+        return false;
+    }
+    avcodec_parameters_free(&par);
+
+    info.params->time_base = codecContext->time_base;
+    info.params->framerate = codecContext->framerate;
+    info.timeBase = srcTimeBase;
+    info.isVideo = (codecContext->codec_type == AVMEDIA_TYPE_VIDEO);
+    if (info.isVideo && videoIndex_ < 0)
+        videoIndex_ = static_cast<int>(streams_.size());
+
+    streams_.push_back(info);
+    return true;
+}
+
+int64_t CReplayBuffer::toUs(const AVPacket* packet) const
+{
+    const int64_t ts = (packet->dts != AV_NOPTS_VALUE) ? packet->dts : packet->pts;
+    return av_rescale_q(ts, streams_[packet->stream_index].timeBase, AV_TIME_BASE_Q);
+}
+
+bool CReplayBuffer::isVideoKey(const AVPacket* packet) const
+{
+    return packet->stream_index == videoIndex_ && (packet->flags & AV_PKT_FLAG_KEY);
+}
+
+void CReplayBuffer::push(const AVPacket* packet)
+{
+    if (!packet || packet->size <= 0 || packet->stream_index < 0 ||
+        packet->stream_index >= static_cast<int>(streams_.size()))
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock{ mtx_ };
+
+    // 队首必须是视频关键帧，之前的包没有意义
+    if (packets_.empty() && !isVideoKey(packet))
+        return;
+
+    AVPacket* ref = av_packet_alloc();
+    if (!ref || av_packet_ref(ref, packet) < 0)
+    {
+        av_packet_free(&ref);
+        return;
+    }
+
+    if (packet->stream_index == videoIndex_)
+        lastVideoUs_ = toUs(packet);
+    if (isVideoKey(packet))
+        keyFrameRequested_ = false;
+    bytes_ += static_cast<size_t>(ref->size);
+    packets_.emplace_back(ref);
+
+    trim();
+}
+
+void CReplayBuffer::trim()
+{
+    const int64_t durationUs = static_cast<int64_t>(cfg_.durationSec_) * AV_TIME_BASE;
+
+    while (!packets_.empty())
+    {
+        // 找到第二个 GOP 的起点，只剩一个 GOP 时不再丢弃
+        auto next = packets_.begin() + 1;
+        while (next != packets_.end() && !isVideoKey(next->get()))
+            ++next;
+        if (next == packets_.end())
+        {
+            // 单个 GOP 已超过内存上限，请求关键帧，新的 GOP 开始后即可丢弃这一个
+            if (bytes_ > cfg_.maxBytes_ && !keyFrameRequested_ && keyFrameRequester_)
+            {
+                qWarning() << "ReplayBuffer: GOP exceeds" << cfg_.maxBytes_ << "bytes, requesting a key frame.";
+                keyFrameRequester_();
+                keyFrameRequested_ = true;
+            }
+            return;
+        }
+
+        // 丢弃第一个 GOP 后仍能保留 durationSec_，或超出内存上限时才丢弃
+        const bool enoughWithout = (lastVideoUs_ - toUs(next->get())) >= durationUs;
+        if (!enoughWithout && bytes_ <= cfg_.maxBytes_)
+            return;
+
+        for (auto it = packets_.begin(); it != next; ++it)
+            bytes_ -= static_cast<size_t>((*it)->size);
+        packets_.erase(packets_.begin(), next);
+    }
+}
+
+double CReplayBuffer::bufferedSeconds() const
+{
+    std::lock_guard<std::mutex> lock{ mtx_ };
+    if (packets_.empty())
+        return 0.0;
+    return (lastVideoUs_ - toUs(packets_.front().get())) / static_cast<double>(AV_TIME_BASE);
+}
+
+bool CReplayBuffer::saveAsync(const std::string& filePath, std::function<void(bool)> onFinished)
+{
+    if (isSaving_.exchange(true))
+    {
+        qWarning() << "ReplayBuffer: A clip is still being saved.";
+        return false;
+    }
+    if (saverThread_.joinable())
+        saverThread_.join();
+
+    // 在锁内只做引用计数的拷贝，编码线程几乎不受影响
+    std::vector<AVPacketUPtr> snapshot;
+    {
+        std::lock_guard<std::mutex> lock{ mtx_ };
+        snapshot.reserve(packets_.size());
+        for (const AVPacketUPtr& pkt : packets_)
+        {
+            AVPacket* ref = av_packet_alloc();
+            if (ref && av_packet_ref(ref, pkt.get()) >= 0)
+                snapshot.emplace_back(ref);
+            else
+                av_packet_free(&ref);
+        }
+    }
+    if (snapshot.empty())
+    {
+        qWarning() << "ReplayBuffer: Nothing to save.";
+        isSaving_ = false;
+        return false;
+    }
+
+    saverThread_ = std::thread([this, filePath, onFinished, packets = std::move(snapshot)]() mutable {
+        qInfo() << "[Thread: ReplaySaver] Saving" << packets.size() << "packets to" << QString::fromStdString(filePath);
+        bool ok = writeClip(filePath, packets);
+        qInfo() << "[Thread: ReplaySaver] Finished," << (ok ? "succeeded." : "failed.");
+        isSaving_ = false;
+        if (onFinished)
+            onFinished(ok);
+    });
+    return true;
+}
+
+bool CReplayBuffer::writeClip(const std::string& filePath, std::vector<AVPacketUPtr>& packets)
+{
+    CMuxer muxer;
+    if (!muxer.initialize(filePath.c_str()))
+        return false;
+    for (const StreamInfo& info : streams_)
+    {
+        if (!muxer.addStream(info.params))
+            return false;
+    }
+    if (!muxer.writeHeader())
+        return false;
+
+    // 片段的时间从第一个关键帧开始，早于它的音频包丢弃
+    const int64_t startUs = toUs(packets.front().get());
+    // 缓存中相邻两次录制的衔接处编码器重新打开，dts 可能与上一次的最后一个包重叠，顺延保证单调递增
+    std::vector<int64_t> lastDts(streams_.size(), AV_NOPTS_VALUE);
+    for (AVPacketUPtr& pkt : packets)
+    {
+        const int index = pkt->stream_index;
+        if (toUs(pkt.get()) < startUs)
+            continue;
+
+        const int64_t offset = av_rescale_q(startUs, AV_TIME_BASE_Q, streams_[index].timeBase);
+        if (pkt->pts != AV_NOPTS_VALUE) pkt->pts -= offset;
+        if (pkt->dts != AV_NOPTS_VALUE) pkt->dts -= offset;
+        av_packet_rescale_ts(pkt.get(), streams_[index].timeBase, muxer.getFormatContext()->streams[index]->time_base);
+        if (pkt->dts != AV_NOPTS_VALUE)
+        {
+            if (lastDts[index] != AV_NOPTS_VALUE && pkt->dts <= lastDts[index])
+                pkt->dts = lastDts[index] + 1;
+            if (pkt->pts != AV_NOPTS_VALUE && pkt->pts < pkt->dts)
+                pkt->pts = pkt->dts;
+            lastDts[index] = pkt->dts;
+        }
+
+        if (!muxer.writePacket(pkt.get()))
+            return false;
+    }
+
+    return muxer.close();
+}
+
+void CReplayBuffer::cleanup()
+{
+    if (saverThread_.joinable())
+        saverThread_.join();
+
+    {
+        std::lock_guard<std::mutex> lock{ mtx_ };
+        packets_.clear();
+        bytes_ = 0;
+        lastVideoUs_ = 0;
+        keyFrameRequested_ = false;
+    }
+
+    for (StreamInfo& info : streams_)
+        avcodec_free_context(&info.params);
+    streams_.clear();
+    videoIndex_ = -1;
+}
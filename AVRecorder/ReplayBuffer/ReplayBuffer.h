@@ -0,0 +1,92 @@
+#pragma once
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+}
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Common/DataDefine.h"
+
+/*
+ * 即时回放缓存：在内存中保留最近 N 秒编码后的音视频包（av_packet_ref，不拷贝数据），
+ * 按 GOP 丢弃最旧的数据，队首始终是视频关键帧，内存占用不超过 码率 x 时长 和 maxBytes_。
+ * 只能整个 GOP 丢弃，单个 GOP 超过 maxBytes_ 时（关键帧间隔很长）会请求编码器提前生成关键帧，
+ * 在新的关键帧到达前内存会短暂超出 maxBytes_。
+ * 需要时把当前缓存交给后台线程，由一个独立的 CMuxer 写成 MP4，不影响正在进行的编码。
+ * 可以依次写入多次录制的包，调用者负责把时间戳换算到同一条时间轴上。
+ */
+class CReplayBuffer
+{
+public:
+    CReplayBuffer() = default;
+    ~CReplayBuffer();
+
+    CReplayBuffer(const CReplayBuffer&) = delete;
+    CReplayBuffer& operator=(const CReplayBuffer&) = delete;
+
+public:
+    void initialize(const ReplayCfg& cfg);
+
+    /**
+     * @brief 添加一个流，添加顺序与 pkt 的 stream_index 对应。
+     * @param codecContext 编码器上下文，保存其参数（含 extradata）用于写文件
+     * @param srcTimeBase 写入的 pkt 所使用的时间基
+     */
+    bool addStream(const AVCodecContext* codecContext, AVRational srcTimeBase);
+
+    // 设置请求关键帧的回调，当前 GOP 超过内存上限时调用，使最旧的数据可以丢弃
+    void setKeyFrameRequester(std::function<void()> requester) { keyFrameRequester_ = std::move(requester); }
+
+    // [编码线程调用] 缓存一个编码后的包，只增加引用计数
+    void push(const AVPacket* packet);
+
+    /**
+     * @brief 把当前缓存的内容在后台保存为文件。
+     * @param filePath 输出文件路径
+     * @param onFinished 保存完成后在后台线程中调用，参数为是否成功
+     * @return 缓存为空或上一次保存尚未完成时返回false
+     */
+    bool saveAsync(const std::string& filePath, std::function<void(bool)> onFinished);
+
+    bool isSaving() const { return isSaving_.load(); }
+
+    // 当前缓存的时长（秒）
+    double bufferedSeconds() const;
+
+private:
+    struct StreamInfo
+    {
+        AVCodecContext* params = nullptr;   // 只用于保存编码参数，不会被打开
+        AVRational timeBase{};
+        bool isVideo = false;
+    };
+
+    int64_t toUs(const AVPacket* packet) const;
+    bool isVideoKey(const AVPacket* packet) const;
+    // 按 GOP 丢弃最旧的数据，调用时必须持有 mtx_
+    void trim();
+    bool writeClip(const std::string& filePath, std::vector<AVPacketUPtr>& packets);
+    void cleanup();
+
+private:
+    ReplayCfg cfg_{};
+    std::vector<StreamInfo> streams_;
+    int videoIndex_ = -1;
+
+    mutable std::mutex mtx_;
+    std::deque<AVPacketUPtr> packets_;
+    size_t bytes_ = 0;
+    int64_t lastVideoUs_ = 0;
+    bool keyFrameRequested_ = false;
+    std::function<void()> keyFrameRequester_;
+
+    std::thread saverThread_;
+    std::atomic<bool> isSaving_{ false };
+};
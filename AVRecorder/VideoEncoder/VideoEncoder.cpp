@@ -1,4 +1,5 @@
 #include "VideoEncoder.h"
+#include <algorithm>
 #include <chrono>
 #include <QObject>
 #include <QDebug>
@@ -8,24 +9,24 @@
 #ifdef DEBUG
 static void ffmpeg_log_callback(void* ptr, int level, const char* fmt, va_list vargs)
 {
-    // ־ǿԺһЩϸϢ
+    // 检查日志级别，我们可以忽略一些过于详细的信息
     if (level > av_log_get_level())
         return;
 
-    // һ㹻Ļ洢ʽ־Ϣ
+    // 创建一个足够大的缓冲区来存储格式化后的日志消息
     char message[1024];
 
-    // ʹ vsnprintf ȫظʽ־
-    // FFmpeg ݵ fmt ʽַͨѾ "[libx264 @ ...]" Ϣ
+    // 使用 vsnprintf 安全地格式化日志内容
+    // FFmpeg 传递的 fmt 格式字符串通常已经包含了像 "[libx264 @ ...]" 这样的上下文信息
     vsnprintf(message, sizeof(message), fmt, vargs);
 
-    // ȥϢĩβĻзΪqDebugԶ
+    // 去掉消息末尾多余的换行符，因为qDebug会自动添加
     size_t len = strlen(message);
     if (len > 0 && message[len - 1] == '\n') {
         message[len - 1] = '\0';
     }
 
-    // FFmpeg־ѡʹQtĲͬ
+    // 根据FFmpeg的日志级别，选择使用Qt的不同输出流
     switch (level) {
     case AV_LOG_PANIC:
     case AV_LOG_FATAL:
@@ -69,46 +70,48 @@ CVideoEncoder::~CVideoEncoder()
 
 bool CVideoEncoder::initialize(const VideoCodecCfg& cfg)
 {
-    cleanup(); // ɵԴ
+    cleanup(); // 清理旧的资源
 
     inWidth_ = cfg.in_width_;
     inHeight_ = cfg.in_height_;
     outWidth_ = cfg.out_width_;
     outHeight_ = cfg.out_height_;
 
-    // 1.  H.264 
+    // 1. 查找 H.264 编码器
     const AVCodec* codec = avcodec_find_encoder(AV_CODEC_ID_H264);
     if (!codec) {
         qCritical() << "Video Encoder: H.264 codec not found.";
         return false;
     }
 
-    // 2. 
+    // 2. 分配编码器上下文
     codecCtx_ = avcodec_alloc_context3(codec);
     if (!codecCtx_) {
         qCritical() << "Video Encoder: Could not allocate codec context.";
         return false;
     }
 
-    // 3. ñ
+    // 3. 设置编码器参数
     codecCtx_->width = cfg.out_width_;
     codecCtx_->height = cfg.out_height_;
     //codecCtx_->bit_rate = cfg.bit_rate;
     codecCtx_->framerate = cfg.framerate_;
-    codecCtx_->time_base = cfg.time_base_; // ʱ֡ʱһ
-    codecCtx_->gop_size = cfg.gop_size_; //  GOP С1һI֡
-    codecCtx_->max_b_frames = cfg.max_b_frames_;     // B֡ѹ
+    codecCtx_->time_base = cfg.time_base_; // 时间基与帧率保持一致
+    codecCtx_->gop_size = cfg.gop_size_; // 设置 GOP 大小，例如1秒一个I帧
+    codecCtx_->max_b_frames = cfg.max_b_frames_;     // 允许B帧以提高压缩率
     codecCtx_->pix_fmt = cfg.pix_fmt_;
     codecCtx_->flags |= cfg.flags_;
     codecCtx_->codec_id = cfg.codec_id_;
 
-    // һЩ H.264 Żѡ
+    // 设置一些 H.264 的优化选项
     if (codec->id == AV_CODEC_ID_H264) {
-        av_opt_set(codecCtx_->priv_data, "preset", "ultrafast", 0);
+        av_opt_set(codecCtx_->priv_data, "preset", cfg.preset_.c_str(), 0);
         av_opt_set(codecCtx_->priv_data, "tune", "zerolatency", 0);
     }
+    constantFrameRate_ = cfg.constant_frame_rate_;
+    frameRate_ = cfg.framerate_;
 
-    // 4. 򿪱
+    // 4. 打开编码器
     int ret = avcodec_open2(codecCtx_, codec, nullptr);
     if (ret < 0) {
         avCheckRet("avcodec_open2", ret);
@@ -117,7 +120,7 @@ bool CVideoEncoder::initialize(const VideoCodecCfg& cfg)
         return false;
     }
 
-    // 5. ʼʽת (SwsContext)
+    // 5. 初始化格式转换上下文 (SwsContext)
     swsCtx_ = sws_getContext(
         inWidth_, inHeight_, AV_PIX_FMT_RGBA,
         outWidth_, outHeight_, AV_PIX_FMT_YUV420P,
@@ -128,7 +131,7 @@ bool CVideoEncoder::initialize(const VideoCodecCfg& cfg)
         return false;
     }
 
-    // 6. ڴ YUV ݵ AVFrame
+    // 6. 分配用于存放 YUV 数据的 AVFrame
     yuvFrame_ = av_frame_alloc();
     if (!yuvFrame_) {
         qCritical() << "Video Encoder: Could not allocate YUV frame.";
@@ -147,6 +150,8 @@ bool CVideoEncoder::initialize(const VideoCodecCfg& cfg)
     }
 
     ptsCnt_ = 0;
+    lastPts_ = -1;
+    hasPicture_ = false;
     qInfo() << "Video Encoder initialized successfully.";
     return true;
 }
@@ -154,6 +159,7 @@ bool CVideoEncoder::initialize(const VideoCodecCfg& cfg)
 void CVideoEncoder::resetTimestamp()
 {
     ptsCnt_ = 0;
+    lastPts_ = -1;
 }
 
 QVector<AVPacket*> CVideoEncoder::encode(const unsigned char* rgbData)
@@ -161,59 +167,123 @@ QVector<AVPacket*> CVideoEncoder::encode(const unsigned char* rgbData)
     if (!codecCtx_ || !swsCtx_ || !yuvFrame_) {
         return QVector<AVPacket*>{};
     }
+    return encodeFrame(rgbData, ptsCnt_++);
+}
+
+QVector<AVPacket*> CVideoEncoder::encode(const unsigned char* rgbData, int64_t timestampUs)
+{
+    QVector<AVPacket*> packets;
+    if (!codecCtx_ || !swsCtx_ || !yuvFrame_) {
+        return packets;
+    }
+
+    // 录制开始前渲染、开始后才取回的帧，时间戳可能为负
+    int64_t pts = std::max<int64_t>(0, av_rescale_q(timestampUs, AVRational{ 1, 1000000 }, codecCtx_->time_base));
+
+    if (constantFrameRate_) {
+        const int64_t slot = av_rescale_q(pts, codecCtx_->time_base, av_inv_q(frameRate_));
+        const int64_t lastSlot = lastPts_ < 0 ? -1 : av_rescale_q(lastPts_, codecCtx_->time_base, av_inv_q(frameRate_));
+        // 该时间槽已有帧（渲染快于帧率），丢弃
+        if (slot <= lastSlot) {
+            return packets;
+        }
+
+        // 渲染慢于帧率或丢帧时重复上一帧补齐中间的时间槽，最多补 1 秒
+        if (hasPicture_) {
+            const int64_t maxRepeat = std::max<int64_t>(1, frameRate_.num / std::max(1, frameRate_.den));
+            for (int64_t s = std::max(lastSlot + 1, slot - maxRepeat); s < slot; ++s) {
+                packets += encodeFrame(nullptr, av_rescale_q(s, av_inv_q(frameRate_), codecCtx_->time_base));
+            }
+        }
+        pts = av_rescale_q(slot, av_inv_q(frameRate_), codecCtx_->time_base);
+    }
+    else if (pts <= lastPts_) {
+        // 可变帧率：两帧时间戳过近（小于时间基精度）时顺延，保证 pts 严格递增
+        pts = lastPts_ + 1;
+    }
+
+    packets += encodeFrame(rgbData, pts);
+    return packets;
+}
 
-    // ȷ֡ǿд
+void CVideoEncoder::skipFrame(int64_t timestampUs)
+{
+    if (!codecCtx_ || !constantFrameRate_) {
+        return;
+    }
+    const int64_t pts = av_rescale_q(timestampUs, AVRational{ 1, 1000000 }, codecCtx_->time_base);
+    lastPts_ = std::max(lastPts_, pts);
+}
+
+QVector<AVPacket*> CVideoEncoder::encodeFrame(const unsigned char* rgbData, int64_t pts)
+{
+    // 确保帧数据是可写的（编码器仍引用该帧时会复制一份，画面保持不变）
     if (av_frame_make_writable(yuvFrame_) < 0) {
         qWarning() << "Video Encoder: YUV frame is not writable.";
         return QVector<AVPacket*>{};
     }
 
-    // --- 1. ɫʿռת (RGB -> YUV) ---
-    // ע⣺ǼRGBAµߵ (OpenGL)
-    const uint8_t* const inData[1] = { rgbData + static_cast<ptrdiff_t>(inWidth_ * (inHeight_ - 1) * 4) }; // ָһУʱinData[0]rgbDataһݵĵַ
-    const int inLinesize[1] = { -inWidth_ * 4 }; // linesizeΪʵֱִת
-    sws_scale(swsCtx_, inData, inLinesize, 0, inHeight_, yuvFrame_->data, yuvFrame_->linesize);
+    // --- 1. 进行色彩空间转换和缩放 (RGB -> YUV) ---
+    // 注意：这里我们假设输入的RGBA数据是上下颠倒的 (来自OpenGL)
+    if (rgbData) {
+        const uint8_t* const inData[1] = { rgbData + static_cast<ptrdiff_t>(inWidth_ * (inHeight_ - 1) * 4) }; // 指向最后一行，此时inData[0]存放了rgbData的最后一行数据的地址
+        const int inLinesize[1] = { -inWidth_ * 4 }; // linesize为负，实现垂直翻转
+        sws_scale(swsCtx_, inData, inLinesize, 0, inHeight_, yuvFrame_->data, yuvFrame_->linesize);
+        hasPicture_ = true;
+    }
+
+    // --- 2. 设置时间戳 (PTS) ---
+    yuvFrame_->pts = pts;
+    lastPts_ = pts;
 
-    // --- 2. ʱ (PTS) ---
-    yuvFrame_->pts = ptsCnt_++;
+    // 外部请求的关键帧，libx264 会将 AV_PICTURE_TYPE_I 编码为 IDR
+    yuvFrame_->pict_type = keyFrameRequested_.exchange(false) ? AV_PICTURE_TYPE_I : AV_PICTURE_TYPE_NONE;
 
-    // --- 3. úı뺯 ---
+    // --- 3. 调用核心编码函数 ---
     return doEncode(yuvFrame_);
 }
 
 QVector<AVPacket*> CVideoEncoder::flush()
 {
     qInfo() << "Flushing Video Encoder...";
-    //  NULL frame ձ
+    // 传入 NULL frame 来清空编码器
     return doEncode(nullptr);
 }
 
-void CVideoEncoder::setStream(AVStream* stream)
+void CVideoEncoder::requestKeyFrame()
 {
-    stream_ = stream;
-    /* AVStreamʱmuxeravformat_write_header()ʱԶ룬Ӧֶ
-    if (stream_) {
-        stream_->time_base = codecCtx_->time_base;
-    }*/
+    keyFrameRequested_ = true;
 }
 
-void CVideoEncoder::setTimeBase(AVRational timeBase)
+void CVideoEncoder::setStream(const AVStream* stream)
+{
+    // AVStream的时间基由muxer在avformat_write_header()时自动填入，这里只读取
+    if (stream) {
+        setTimeBase(stream->time_base, stream->index);
+    }
+    else {
+        streamIndex_ = -1;
+    }
+}
+
+void CVideoEncoder::setTimeBase(AVRational timeBase, int streamIndex)
 {
     timeBase_ = timeBase;
+    streamIndex_ = streamIndex;
 }
 
 QVector<AVPacket*> CVideoEncoder::doEncode(AVFrame* frame)
 {
     QVector<AVPacket*> packetList;
 
-    // ֡
+    // 发送帧到编码器
     int ret = avcodec_send_frame(codecCtx_, frame);
     if (ret < 0) {
         qWarning() << "Video Encoder: Error sending frame to encoder.";
         return packetList;
     }
 
-    // ѭпõ packet
+    // 循环接收所有可用的 packet
     while (ret >= 0) {
         AVPacket* pkt = av_packet_alloc();
         if (!pkt) {
@@ -225,8 +295,8 @@ QVector<AVPacket*> CVideoEncoder::doEncode(AVFrame* frame)
         if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) 
         {
             av_packet_unref(pkt);
-            av_packet_free(&pkt); // ûpacketͷŷڴ
-            break; // ˳
+            av_packet_free(&pkt); // 没有packet产出，释放分配的内存
+            break; // 正常退出
         }
         else if (ret < 0) 
         {
@@ -234,17 +304,15 @@ QVector<AVPacket*> CVideoEncoder::doEncode(AVFrame* frame)
             qWarning() << "Video Encoder: Error receiving packet from encoder.";
             av_packet_unref(pkt);
             av_packet_free(&pkt);
-            break; // ˳
+            break; // 发生错误，退出
         }
 
-        // ÿһpktʱstream_index
-        if (stream_) {
-            av_packet_rescale_ts(pkt, codecCtx_->time_base, stream_->time_base);
-            pkt->stream_index = stream_->index;
-        }
-        else if (timeBase_.den != 0)
+        // 设置每一个pkt的时间基和stream_index
+        if (timeBase_.den != 0)
         {
             av_packet_rescale_ts(pkt, codecCtx_->time_base, timeBase_);
+            if (streamIndex_ >= 0)
+                pkt->stream_index = streamIndex_;
         }
         else
         {
@@ -270,5 +338,5 @@ void CVideoEncoder::cleanup()
         sws_freeContext(swsCtx_);
         swsCtx_ = nullptr;
     }
-    stream_ = nullptr;
+    streamIndex_ = -1;
 }
\ No newline at end of file
@@ -9,6 +9,7 @@ extern "C" {
 }
 #include <QVector>
 #include <mutex>
+#include <atomic>
 #include "AVRecorder/AudioCapturer/AudioCapturer.h"
 #include "Common/DataDefine.h"
 
@@ -18,64 +19,97 @@ public:
     CVideoEncoder();
     ~CVideoEncoder();
 
-    // ֹ͸ֵ
+    // 禁止拷贝和赋值
     CVideoEncoder(const CVideoEncoder&) = delete;
     CVideoEncoder& operator=(const CVideoEncoder&) = delete;
 
 public:
-    // ʼƵ
+    // 初始化视频编码器
     bool initialize(const VideoCodecCfg& cfg);
 
     /**
-     * @brief ڿʼ/¼Ƶʱã
-     *          ʱԷ¼/
+     * @brief 在开始推流/录制音视频时调用，
+     *          用于清空时间戳，可以反复录制/推流。
      */
     void resetTimestamp();
 
     /**
-     * @brief һ֡Ƶݡ
-     * @param rgbData ָԭʼRGBAݵָ루С inWidth * inHeight * 4
-     * @return һõ AVPacket б
-     *         ʹ packet 븺 av_packet_free() ͷǡ
+     * @brief 编码一帧视频数据。
+     * @param rgbData 指向原始RGBA数据的指针（大小必须是 inWidth * inHeight * 4）。
+     * @return 返回一个包含零个或多个编码好的 AVPacket 的列表。
+     *         调用者在使用完 packet 后必须负责调用 av_packet_free() 来释放它们。
      */
     QVector<AVPacket*> encode(const unsigned char* rgbData);
 
-    // ձлpacket
+    /**
+     * @brief 按采集时间戳编码一帧，pts 由时间戳换算，丢帧或帧率波动不会影响音画同步。
+     *        可变帧率时 pts 严格递增；固定帧率（constant_frame_rate_）时按时间槽重采样。
+     * @param timestampUs 相对录制开始的采集时间（微秒）。
+     */
+    QVector<AVPacket*> encode(const unsigned char* rgbData, int64_t timestampUs);
+
+    // 清空编码器中所有缓存的packet
     QVector<AVPacket*> flush();
 
+    // 跳过一帧（降帧率时使用），固定帧率时占用该时间槽，避免后续被重复帧补齐
+    void skipFrame(int64_t timestampUs);
+
+    /**
+     * @brief 请求下一帧编码为 IDR 帧（如 HLS 切片需要在指定位置开始新分段）。
+     *        线程安全，可以在编码线程之外调用。
+     */
+    void requestKeyFrame();
+
     /**
-     * @brief ô˱ AVStream
-     *        Muxer  stream 󣬱ô˺ stream Ϣݽ
-     * @param stream Muxer Ƶ
+     * @brief 设置此编码器关联的 AVStream。
+     *        只保存流的 index 和 time_base，不持有 AVStream 指针（分段录制时 Muxer 会重建流），
+     *        因此必须在 avformat_write_header() 确定流的时间基之后调用。
+     * @param stream Muxer 创建的视频流。
      */
-    void setStream(AVStream* stream);
+    void setStream(const AVStream* stream);
 
-    void setTimeBase(AVRational timeBase);
+    /**
+     * @brief 设置输出pkt的时间基，没有 muxer 时使用（如推流、只缓存在内存中的回放）。
+     * @param streamIndex 写入pkt的 stream_index，-1 表示不设置。
+     */
+    void setTimeBase(AVRational timeBase, int streamIndex = -1);
 
-    // ṩԱĵֻʣԱ Muxer Դлȡ
+    // 提供对编码器上下文的只读访问，以便 Muxer 可以从中获取参数
     const AVCodecContext* getCodecContext() const { return codecCtx_; }
 
 private:
-    // ڲı뺯
+    // 转换一帧并以指定 pts 编码，rgbData 为空时重复编码上一帧画面
+    QVector<AVPacket*> encodeFrame(const unsigned char* rgbData, int64_t pts);
+
+    // 内部核心编码函数
     QVector<AVPacket*> doEncode(AVFrame* frame);
 
-    // Դ
+    // 清理所有资源
     void cleanup();
 
 private:
     AVCodecContext* codecCtx_ = nullptr;
-    AVFrame* yuvFrame_ = nullptr;   // ڴת YUV 
-    SwsContext* swsCtx_ = nullptr;    //  RGB -> YUV ת
+    AVFrame* yuvFrame_ = nullptr;   // 用于存放转换后的 YUV 数据
+    SwsContext* swsCtx_ = nullptr;    // 用于 RGB -> YUV 的转换
 
-    AVStream* stream_ = nullptr; // Muxer Ƶ
-    AVRational timeBase_{};         // ûavstreamҪtimeBase
+    int streamIndex_ = -1;          // Muxer 创建的视频流的 index，-1 表示没有关联流
+    AVRational timeBase_{};         // 输出pkt的时间基，来自 setStream() 或 setTimeBase()
 
-    // 
+    // 编码参数
     int inWidth_ = 0;
     int inHeight_ = 0;
     int outWidth_ = 0;
     int outHeight_ = 0;
 
-    // ڼPTS
+    // 用于计算PTS
     int64_t ptsCnt_ = 0;
+    // 按时间戳编码时，上一帧的 pts
+    int64_t lastPts_ = -1;
+    bool constantFrameRate_ = false;
+    AVRational frameRate_{};
+    // yuvFrame_ 中已有画面，固定帧率补帧时才能重复
+    bool hasPicture_ = false;
+
+    // 下一帧强制编码为关键帧
+    std::atomic<bool> keyFrameRequested_{ false };
 };
\ No newline at end of file
@@ -47,7 +47,7 @@ void CGLCamera::setKeyPress(Camera_Movement direction, qint64 deltaTime)
         this->position_ -= this->cameraWorldUp * sensitivity;
 }
 
-// yaw_ָ ͷķ xļнǣpitch_ָ ͷķ zḺļн
+// 其中yaw_指的是 摄像机镜头的方向 与x轴正方向的夹角，pitch_指的是 摄像机镜头的方向 与z轴负方向的夹角
 void CGLCamera::setMouseMove(float xoffset, float yoffset, bool constraintPitch)
 {
     xoffset *= this->mouseSensitivity;
@@ -100,7 +100,7 @@ void CGLCamera::updateCamera()
     front.y = sin(glm::radians(pitch_));
     front.z = cos(glm::radians(pitch_)) * sin(glm::radians(yaw_));
 
-    // ƶʱ򣬻ıϵķ
+    // 移动鼠标的时候，会改变摄像机坐标系的方向
     this->cameraFront = glm::normalize(front);
     this->cameraRight = glm::normalize(glm::cross(cameraFront, cameraWorldUp));
     this->cameraUp_ = glm::normalize(glm::cross(cameraRight, cameraFront));
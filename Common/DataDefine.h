@@ -17,7 +17,7 @@ extern "C" {
 #include <libavcodec/avcodec.h>
 }
 
-// ------------------------- YUVȾ -------------------------
+// ------------------------- YUV渲染所需数据 -------------------------
 #pragma pack(push, 1)
 typedef struct framePlaneDef
 {
@@ -48,7 +48,66 @@ typedef struct  YUVBuffDef
 }YUVBuffer;
 #pragma pack(pop)
 
-// ------------------------- ģȾ -------------------------
+// 摄像头帧的像素排列，决定上传的纹理格式和着色器中的颜色转换，取值与 yuvOffSecreen.fs 中的 inputFormat 一致
+enum class PixelLayout
+{
+    I420 = 0,   // Y、U、V三个平面，色度宽高各为一半
+    BGR = 1,    // OpenCV默认的打包格式
+    GRAY = 2,
+    YUYV = 3,   // 每两个像素4字节：Y0 U Y1 V
+    NV12 = 4,   // Y平面 + UV交错平面，色度宽高各为一半
+    I422 = 5,   // Y、U、V三个平面，色度宽度为一半（MJPEG解码的常见输出）
+};
+
+// 一帧摄像头图像，只引用数据，不持有内存
+struct CameraImage
+{
+    PixelLayout layout = PixelLayout::BGR;
+    int width = 0;
+    int height = 0;
+    const uint8_t* data[3] = {};    // 各平面的起始地址，打包格式只使用 data[0]
+    int stride[3] = {};             // 各平面每行的字节数（可能包含填充）
+    // YUV 的取值范围：true 为全范围（0-255，MJPEG 解码得到的 YUVJ），false 为有限范围
+    // （Y 16-235、UV 16-240，摄像头的原始 YUYV/NV12），有限范围需要在着色器中扩展；BGR、GRAY 不使用
+    bool fullRange = true;
+};
+
+// 摄像头请求的采集格式
+enum class CameraFormat
+{
+    MJPEG,      // 带宽最小，高分辨率高帧率时通常只有这种格式可用，由解码线程池解码为平面YUV
+    YUYV,       // 原始数据，直接上传
+    NV12,       // 原始数据，直接上传
+    OPENCV,     // 使用 cv::VideoCapture 的默认设置（BGR），格式协商失败时也回退到这里
+};
+
+// 摄像头采集参数（见 CCameraSource）
+struct CameraCfg
+{
+    // dshow 下为设备名称，v4l2 下为设备路径；为空时使用系统默认摄像头
+    std::string     device_;
+    // 非空时从该文件读取并按帧率循环播放，格式由文件决定，用于没有摄像头时测试
+    std::string     file_;
+    CameraFormat    format_ = CameraFormat::MJPEG;
+    int             width_ = 1920;
+    int             height_ = 1080;
+    int             fps_ = 30;
+    // MJPEG 解码线程数，每帧独立解码，线程之间不需要同步
+    int             decodeThreads_ = 2;
+};
+
+// 人脸跟踪参数（见 VideoCaptureThread::trackLoop）
+struct FaceTrackCfg
+{
+    // 每秒跟踪次数，0 表示每一帧都跟踪
+    int             rateHz_ = 15;
+    // 送入跟踪器的图像宽度上限，区域更大时先缩小
+    int             trackWidth_ = 480;
+    // 跟踪区域占整帧的比例（宽、高相同），以上一次的人脸位置为中心
+    float           roiFraction_ = 0.5f;
+};
+
+// ------------------------- 模型渲染所需数据 -------------------------
 #pragma pack(push, 4)
 typedef struct vec3f
 {
@@ -75,7 +134,7 @@ typedef struct VertexAttr
 static_assert(std::is_pod_v<VertexAttr>, "VertexAttr is not POD!!");
 #pragma pack(pop)
 
-// ------------------------- Ƶ¼ -------------------------
+// ------------------------- 音视频录制所需数据 -------------------------
 
 enum class avACT : uint8_t
 {
@@ -84,6 +143,13 @@ enum class avACT : uint8_t
     RTSPPUSH
 };
 
+// RTSP 推流时 RTP/RTCP 的传输方式
+enum class RtpTransport : uint8_t
+{
+    UDP,                // RTP/AVP/UDP，局域网下延迟最低
+    TCP_INTERLEAVED     // RTP/AVP/TCP，复用 RTSP 控制连接，可穿越防火墙
+};
+
 typedef struct VideoCodecCfg {
     int     in_width_;
     int     in_height_;
@@ -96,17 +162,24 @@ typedef struct VideoCodecCfg {
     AVPixelFormat   pix_fmt_;
     int     flags_;
     AVCodecID       codec_id_;
-    int     bit_rate = 2000000; // Ĭ 2 Mbps
+    int     bit_rate = 2000000; // 默认 2 Mbps
+    std::string preset_ = "ultrafast";  // x264 preset
+    // 按采集时间戳编码时（CVideoEncoder::encode(rgb, timestampUs)）：
+    // false 为可变帧率，pts 直接取自时间戳；true 为固定帧率，按 framerate_ 的时间槽重采样，多余的帧丢弃、缺失的帧重复上一帧
+    bool    constant_frame_rate_ = false;
 }VideoCodecCfg;
 
 typedef struct AudioCodecCfg {
-    int64_t bit_rate_ = 128000; // Ĭ 128 kbps
-    int     sample_rate_ = 48000;  // Ĭ 48 kHz
-    int     channels_ = 2;    // Ĭ
+    int64_t bit_rate_ = 128000; // 默认 128 kbps
+    int     sample_rate_ = 48000;  // 默认 48 kHz
+    int     channels_ = 2;    // 默认立体声
     int64_t         channel_layout_;
     AVSampleFormat  sample_fmt_;
     AVRational      time_base_;
     int     flags_;
+    // 按采集时间戳编码时（CAudioEncoder::encode(pcm, captureUs)），用 swr_set_compensation 微调样本数，
+    // 抵消录音设备时钟与媒体时钟之间的漂移
+    bool    drift_compensation_ = true;
 }AudioCodecCfg;
 
 typedef struct AudioFormat {
@@ -116,23 +189,116 @@ typedef struct AudioFormat {
     QAudioFormat::SampleType    sample_fmt_;
     QAudioFormat::Endian        byte_order_;
     QString codec_;
+    // 采集周期（毫秒）：拉取模式下采集线程按此间隔从设备读取，推送模式下为 QAudioInput 的通知间隔
+    int     period_ms_ = 10;
+    // QAudioInput 内部缓冲区大小（毫秒），越小延迟越低，过小时设备可能丢数据
+    int     buffer_ms_ = 40;
+    // 拉取模式：由采集线程按固定周期读取设备；false 时由 QAudioInput 推送写入（数据按大块到达）
+    bool    pull_mode_ = true;
 }AudioFormat;
 
+// 录制文件的写入参数
+typedef struct MuxerCfg {
+    // 使用异步写线程（CAsyncFileWriter）落盘，false 时退回 avio_open 同步写入
+    bool    asyncWrite_ = true;
+    // 单个写缓冲块大小，muxer 的小块写入先在内存中拼成大块再交给写线程
+    size_t  writeBlockSize_ = 4 << 20;
+    // 写缓冲块数量上限，决定写入积压时的内存上限（默认 16 x 4MB）
+    size_t  maxWriteBlocks_ = 16;
+    // 文件空间按此步长预先分配（fallocate），减少长时间录制的文件碎片，0 表示不预分配；
+    // 步长过大会让短录制或异常退出时的文件占用远大于实际内容
+    int64_t preallocateStep_ = 16ll << 20;
+    // 写入完成后通知系统丢弃对应的页缓存，长时间录制时内存占用保持平稳
+    bool    dropPageCache_ = true;
+
+    // 使用分片 MP4（fMP4/CMAF，movflags=frag_keyframe+empty_moov+default_base_moof）：
+    // 每个片段自带索引，异常退出时已写入的片段仍可播放，停止录制时也无需生成完整的 moov
+    bool    fragmented_ = false;
+    // 片段的最大时长（毫秒），0 表示只在视频关键帧处分片
+    int     fragDurationMs_ = 0;
+
+    // 分段录制：达到时长或大小上限后，在下一个视频关键帧处切换到新文件，
+    // 文件名为 <文件名>_000.mp4、<文件名>_001.mp4 ...，编码器和采集不中断；0 表示不限制
+    int64_t segmentDurationMs_ = 0;
+    int64_t segmentMaxBytes_ = 0;
+}MuxerCfg;
+
+// HLS 分段的封装格式
+enum class HlsSegmentType
+{
+    MPEGTS,     // .ts 分段
+    FMP4        // init.mp4 + .m4s 分段
+};
+
+// 本地 HLS/LL-HLS 输出参数（见 CHlsSink）
+typedef struct HlsCfg {
+    bool            enable_ = false;
+    // 输出目录，由任意静态文件服务器对外提供
+    std::string     dir_;
+    std::string     playlistName_ = "live.m3u8";
+    HlsSegmentType  segmentType_ = HlsSegmentType::MPEGTS;
+    // 分段目标时长，到达前会请求视频编码器生成 IDR 帧，在该帧处切分
+    int             targetDurationMs_ = 2000;
+    // LL-HLS 部分分段（EXT-X-PART）的目标时长，0 表示不生成部分分段
+    int             partDurationMs_ = 333;
+    // 播放列表中保留的分段数量
+    int             playlistSize_ = 6;
+}HlsCfg;
+
+// 录制质量自适应（见 CQualityGovernor）：编码跟不上时逐级降低帧率，有余量时逐级恢复；分辨率和 x264 preset 不变
+typedef struct QualityCfg {
+    bool    enable_ = true;
+    // 统计窗口（约 1 秒）内平均编码耗时占帧间隔的比例超过该值，或发生丢帧、队列积压时降一级
+    double  highLoad_ = 0.85;
+    // 连续 stableWindows_ 个窗口低于该比例、没有丢帧且队列基本为空时升一级
+    double  lowLoad_ = 0.5;
+    int     stableWindows_ = 5;
+    // 降帧率的下限
+    int     minFps_ = 15;
+}QualityCfg;
+
+// 即时回放：在内存中保留最近一段时间的编码数据，按需保存为文件（见 CReplayBuffer）
+typedef struct ReplayCfg {
+    bool    enable_ = false;
+    // 保留最近多少秒
+    int     durationSec_ = 60;
+    // 内存上限，超过时即使不足 durationSec_ 也按 GOP 丢弃最旧的数据
+    size_t  maxBytes_ = 256 << 20;
+}ReplayCfg;
+
 typedef struct AVConfig {
-    // ͨã¼ʱΪļ·ʱΪRTMP/RTSP·
+    // 通用设置（录制时为文件路径，推流时为RTMP/RTSP路径）
     std::string     path_;
 
-    // Ƶ
+    // 视频编码器参数
     VideoCodecCfg   videoCodecCfg_;
 
-    // Ƶ
+    // 音频编码器参数
     AudioCodecCfg   audioCodecCfg_;
 
-    // ¼豸
+    // 录音设备参数
     AudioFormat    audioFmt_;
+
+    // RTSP 推流时 RTP 的传输方式
+    RtpTransport   rtpTransport_ = RtpTransport::UDP;
+
+    // 推流时是否旁路保存 H.264/AAC 裸流用于调试（见 CEsTap），默认关闭
+    bool    enableEsTap_ = false;
+
+    // 录制文件的写入参数
+    MuxerCfg    muxerCfg_{};
+
+    // 录制时同时输出本地 HLS，默认关闭
+    HlsCfg      hlsCfg_{};
+
+    // 即时回放缓存，默认关闭；path_ 为空时只缓存在内存中，不写录制文件
+    ReplayCfg   replayCfg_{};
+
+    // 录制质量自适应
+    QualityCfg  qualityCfg_{};
 }AVConfig;
 
-// ------------------------- Ƶ¼/첽 -------------------------
+// ------------------------- 音视频录制/推流异步改造 -------------------------
 
 struct AVPacketDeleter {
     void operator()(AVPacket* pkt) const {
@@ -144,26 +310,25 @@ struct AVPacketDeleter {
 };
 
 /*
- *  AVPackeṭ
- *  1. Encoder
- *	2. ȨתƸMediaPacketṹ塣
- *	3. ȨMediaPacketstd::moveתƵС
- *	4. MuxerӶȡMediaPacketٴλȨ
- *	5. MuxerʹϺMediaPacket٣ӵеAVPacketҲӦ֮١
- *	УAVPacketͬһʱֻᱻһ߳УᱻAVPacketڲüʼΪ1ʹunique_ptrй
- *	ںУÿһAVPacketԼҪ¼ƣҪҪΪshared_ptrͬʱʹav_packet_refü
+ *  AVPacket生命流程：
+ *  1. 由Encoder创建。
+ *	2. 所有权转移给MediaPacket结构体。
+ *	3. 所有权随着MediaPacket被std::move转移到队列中。
+ *	4. Muxer从队列中取出MediaPacket，再次获得所有权。
+ *	5. Muxer使用完毕后，MediaPacket被销毁，其拥有的AVPacket也应随之销毁。
+ *	在以上流程中，AVPacket同一时间只会被一个消费者持有，不会被拷贝，AVPacket内部的引用计数始终为1，所以使用unique_ptr进行管理。
+ *	在后续改造中，如果对于每一个AVPacket而言既需要录制，又需要推流，则需要改为shared_ptr，同时使用av_packet_ref增加引用计数。
  */
 
 using AVPacketUPtr = std::unique_ptr<AVPacket, AVPacketDeleter>;
 
-using RGBAUPtr = std::unique_ptr<std::vector<uint8_t>>;
-
-/*// עRgbaFrameavFrameһFrame
+// 注意RgbaFrame和avFrame不是一个Frame
 struct RgbaFrame {
     std::vector<uint8_t> rgba_data;
-    int width;
-    int height;
-};*/
+    int64_t timestampUs = 0;    // 采集（渲染）时间，相对本次录制开始，来自 CMediaClock
+};
+
+using RGBAUPtr = std::unique_ptr<RgbaFrame>;
 
 enum class PacketType : uint8_t
 {
@@ -172,8 +337,9 @@ enum class PacketType : uint8_t
 	END_OF_STREAM
 };
 
-// unique_ptrֻƶܸƣMediaPacketҲֻƶܸ
+// 由于unique_ptr只能移动不能复制，所以MediaPacket也只能移动不能复制
 struct MediaPacket {
     AVPacketUPtr pkt;
     PacketType type;
+    uint32_t session = 0;   // 所属的录制编号，CAVRecorder 用于区分正在收尾的上一次录制
 };
\ No newline at end of file
@@ -0,0 +1,143 @@
+#include "EsTap.h"
+#include <QDebug>
+#include <chrono>
+
+using namespace std::chrono_literals;
+
+CEsTap::~CEsTap()
+{
+    close();
+}
+
+FILE* CEsTap::openFile(const std::string& path)
+{
+    FILE* fp = fopen(path.c_str(), "wb");
+    if (!fp)
+    {
+        qCritical() << "EsTap: Failed to open" << path.c_str() << "for writing.";
+        return nullptr;
+    }
+    // 使用大缓冲区，把大量小包合并为少量大块写入
+    setvbuf(fp, nullptr, _IOFBF, FILE_BUFFER_SIZE);
+    return fp;
+}
+
+void CEsTap::writeHeader(const std::string& path, const AVCodecContext* codecCtx)
+{
+    if (!codecCtx || !codecCtx->extradata || codecCtx->extradata_size <= 0)
+        return;
+
+    // extradata 只有几十字节，且在开始推流前写入，直接同步写即可
+    FILE* fp = fopen(path.c_str(), "wb");
+    if (!fp)
+    {
+        qCritical() << "EsTap: Failed to open" << path.c_str() << "for writing.";
+        return;
+    }
+    fwrite(codecCtx->extradata, 1, static_cast<size_t>(codecCtx->extradata_size), fp);
+    fclose(fp);
+}
+
+bool CEsTap::open(const std::string& dir, const AVCodecContext* videoCtx, const AVCodecContext* audioCtx)
+{
+    close();
+
+    writeHeader(dir + "/h264_head.h264", videoCtx);
+    writeHeader(dir + "/aac_head.aac", audioCtx);
+
+    videoFile_ = openFile(dir + "/h264_data.h264");
+    audioFile_ = openFile(dir + "/aac_data.aac");
+    if (!videoFile_ && !audioFile_)
+        return false;
+
+    droppedPkts_ = 0;
+    writtenBytes_ = 0;
+    isRunning_ = true;
+    writerThread_ = std::thread(&CEsTap::writingLoop, this);
+
+    qInfo() << "EsTap: Dumping elementary streams to" << dir.c_str();
+    return true;
+}
+
+void CEsTap::tap(const AVPacket* pkt, PacketType type)
+{
+    if (!isRunning_.load(std::memory_order_relaxed) || !pkt || pkt->size <= 0)
+        return;
+
+    // 队列满时丢弃，绝不阻塞推流线程
+    if (pktQueue_.isFull())
+    {
+        ++droppedPkts_;
+        return;
+    }
+
+    AVPacket* ref = av_packet_alloc();
+    if (!ref)
+        return;
+    // 编码器输出的包带有引用计数的 buf，av_packet_ref 只增加引用，不拷贝数据
+    if (av_packet_ref(ref, pkt) < 0)
+    {
+        av_packet_free(&ref);
+        return;
+    }
+
+    MediaPacket mediaPkt{ AVPacketUPtr{ ref }, type };
+    pktQueue_.push(std::move(mediaPkt));
+}
+
+void CEsTap::writePacket(const MediaPacket& mediaPkt)
+{
+    FILE* fp = (mediaPkt.type == PacketType::VIDEO) ? videoFile_ : audioFile_;
+    if (!fp || !mediaPkt.pkt)
+        return;
+
+    writtenBytes_ += fwrite(mediaPkt.pkt->data, 1, static_cast<size_t>(mediaPkt.pkt->size), fp);
+}
+
+void CEsTap::writingLoop()
+{
+    qInfo() << "[Thread: EsTap] Loop started.";
+
+    // ------------------------- 线程主循环 -------------------------
+    while (isRunning_.load(std::memory_order_relaxed))
+    {
+        auto container = pktQueue_.pop();
+        if (!container)
+        {
+            // 调试数据对实时性没有要求，队列为空时休眠，让出 CPU
+            std::this_thread::sleep_for(10ms);
+            continue;
+        }
+        writePacket(*container);
+    }
+
+    // ------------------------- 线程结束后，写完队列中剩余的数据 -------------------------
+    while (auto container = pktQueue_.pop())
+    {
+        writePacket(*container);
+    }
+
+    qInfo() << "[Thread: EsTap] Loop finished.";
+}
+
+void CEsTap::close()
+{
+    if (!isRunning_.exchange(false))
+        return;
+
+    if (writerThread_.joinable())
+        writerThread_.join();
+
+    if (videoFile_)
+    {
+        fclose(videoFile_);
+        videoFile_ = nullptr;
+    }
+    if (audioFile_)
+    {
+        fclose(audioFile_);
+        audioFile_ = nullptr;
+    }
+
+    qInfo() << "EsTap: Closed, written" << writtenBytes_ << "bytes, dropped" << droppedPkts_.load() << "packets.";
+}
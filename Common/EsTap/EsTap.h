@@ -0,0 +1,71 @@
+#pragma once
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <atomic>
+
+#include "Common/DataDefine.h"
+#include "Common/LockFreeQueue.h"
+
+/*
+ * 码流旁路（Elementary Stream Tap），用于调试时保存编码后的 H.264/AAC 裸流。
+ * 推流线程只对 AVPacket 做一次 av_packet_ref（引用计数，不拷贝数据）并放入无锁队列，
+ * 由后台写线程使用大缓冲区的 fwrite 批量落盘，磁盘延迟不会影响推流。
+ * 输出文件与之前同步写入的版本保持一致：
+ *   h264_head.h264 / aac_head.aac  ：extradata（SPS/PPS、AudioSpecificConfig）
+ *   h264_data.h264 / aac_data.aac  ：编码器输出的原始数据
+ */
+class CEsTap
+{
+public:
+    CEsTap() = default;
+    ~CEsTap();
+
+    CEsTap(const CEsTap&) = delete;
+    CEsTap& operator=(const CEsTap&) = delete;
+
+    /**
+     * @brief 打开输出文件并启动写线程
+     * @param dir 输出目录
+     * @param videoCtx 视频编码器上下文，用于写入 extradata，可为空
+     * @param audioCtx 音频编码器上下文，用于写入 extradata，可为空
+     * @return 至少一个数据文件打开成功返回true
+     */
+    bool open(const std::string& dir, const AVCodecContext* videoCtx, const AVCodecContext* audioCtx);
+
+    /**
+     * @brief 旁路一个编码后的包，只增加引用计数，不阻塞调用线程。
+     *        队列满时直接丢弃该包（仅影响调试文件，不影响推流）。
+     */
+    void tap(const AVPacket* pkt, PacketType type);
+
+    // 停止写线程，写完队列中剩余的数据后关闭文件
+    void close();
+
+    bool isOpen() const { return isRunning_.load(std::memory_order_relaxed); }
+
+private:
+    void writingLoop();
+    void writePacket(const MediaPacket& mediaPkt);
+
+    static FILE* openFile(const std::string& path);
+    static void writeHeader(const std::string& path, const AVCodecContext* codecCtx);
+
+private:
+    static constexpr size_t FILE_BUFFER_SIZE = 1 << 20;    // 每个文件 1MB 的 stdio 缓冲区
+
+    FILE* videoFile_ = nullptr;
+    FILE* audioFile_ = nullptr;
+
+    std::thread writerThread_;
+    std::atomic<bool> isRunning_{ false };
+    lock_free_queue<MediaPacket, 512> pktQueue_;
+
+    // 统计信息
+    std::atomic<uint64_t> droppedPkts_{ 0 };
+    uint64_t writtenBytes_ = 0;
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/*
+ * H.264 Annex B 码流的辅助函数。
+ * x264 输出的每个 AVPacket 都是一个完整的 Access Unit，内部可能包含多个以起始码分隔的 NAL 单元
+ * （例如 SEI + IDR，或在关闭全局头时的 SPS + PPS + IDR），RTMP/RTSP 打包时都需要先拆成单独的 NAL。
+ */
+
+struct NalUnit
+{
+    const uint8_t* data;    // 指向 NAL Header（不含起始码）
+    size_t size;            // NAL 长度（不含起始码）
+
+    uint8_t type() const { return data[0] & 0x1F; }
+};
+
+enum H264NalType : uint8_t
+{
+    H264_NAL_SLICE = 1,
+    H264_NAL_IDR = 5,
+    H264_NAL_SEI = 6,
+    H264_NAL_SPS = 7,
+    H264_NAL_PPS = 8,
+    H264_NAL_AUD = 9
+};
+
+/**
+ * @brief 查找下一个起始码（00 00 01 或 00 00 00 01）。
+ * @param data 查找起点
+ * @param end 数据末尾
+ * @param startCodeLen [out] 找到的起始码长度（3 或 4），未找到时为 0
+ * @return 起始码首字节地址，未找到时返回 end
+ */
+inline const uint8_t* findNalStartCode(const uint8_t* data, const uint8_t* end, size_t& startCodeLen)
+{
+    startCodeLen = 0;
+    for (const uint8_t* p = data; p + 3 <= end; ++p)
+    {
+        if (p[0] != 0x00 || p[1] != 0x00)
+            continue;
+        if (p[2] == 0x01)
+        {
+            // 00 00 00 01 的情况下，前一个字节也属于起始码
+            if (p > data && p[-1] == 0x00)
+            {
+                startCodeLen = 4;
+                return p - 1;
+            }
+            startCodeLen = 3;
+            return p;
+        }
+    }
+    return end;
+}
+
+/**
+ * @brief 将 Annex B 格式的数据拆分为 NAL 单元列表，返回的指针均指向原始缓冲区，不发生拷贝。
+ * @param data Annex B 数据
+ * @param len 数据长度
+ * @param nals [out] 拆分结果（会先被清空）
+ * @return 拆分得到的 NAL 数量
+ */
+inline size_t splitAnnexB(const uint8_t* data, size_t len, std::vector<NalUnit>& nals)
+{
+    nals.clear();
+    if (!data || len == 0)
+        return 0;
+
+    const uint8_t* end = data + len;
+    size_t scLen = 0;
+    const uint8_t* curr = findNalStartCode(data, end, scLen);
+    while (curr != end)
+    {
+        const uint8_t* nalBegin = curr + scLen;
+        const uint8_t* next = findNalStartCode(nalBegin, end, scLen);
+
+        // 去掉 NAL 尾部的 trailing_zero_8bits
+        const uint8_t* nalEnd = next;
+        while (nalEnd > nalBegin && nalEnd[-1] == 0x00)
+            --nalEnd;
+
+        if (nalEnd > nalBegin)
+            nals.push_back(NalUnit{ nalBegin, static_cast<size_t>(nalEnd - nalBegin) });
+        curr = next;
+    }
+    return nals.size();
+}
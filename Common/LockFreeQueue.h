@@ -292,6 +292,14 @@ public:
         return false;
     }
 
+    // 当前元素个数，仅用于统计和监控（其他线程同时读写时为近似值）
+    size_t size() const
+    {
+        return nCurrLen_.load(std::memory_order_relaxed);
+    }
+
+    static constexpr size_t capacity() { return LENGTH; }
+
     bool isFull()
     {
         return nCurrLen_.load(std::memory_order_relaxed) >= LENGTH;
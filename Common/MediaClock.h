@@ -0,0 +1,18 @@
+#ifndef MEDIA_CLOCK_H
+#define MEDIA_CLOCK_H
+
+#include <chrono>
+#include <cstdint>
+
+// 音视频共用的单调媒体时钟（微秒），基于 steady_clock，不受系统时间调整影响。
+// 各采集端在数据产生时打上时间戳，编码时减去本次录制的起点得到 pts，
+// 丢帧或渲染帧率波动只会让画面停留得更久，不会拉伸或压缩时间轴。
+class CMediaClock {
+public:
+    static int64_t nowUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
+
+#endif // MEDIA_CLOCK_H
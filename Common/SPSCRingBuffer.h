@@ -11,8 +11,8 @@
 #ifdef __cpp_lib_hardware_interference_size
 using std::hardware_destructive_interference_size;
 #else
-// x86 - 64Ϊ64ֽ  L1_CACHE_BYTES  L1_CACHE_SHIFT  __cacheline_aligned ...
-// L1дСͨ64ֽ
+// x86 - 64上为64字节 │ L1_CACHE_BYTES │ L1_CACHE_SHIFT │ __cacheline_aligned │...
+// L1缓存行大小通常是64字节
 constexpr std::size_t hardware_destructive_interference_size = 64;
 #endif
 
@@ -21,12 +21,12 @@ class SpscRingBuffer
 {
 public:
     /**
-     * @brief һλ
-     * @param capacity ֽڣᱻΪ2Żģ㡣
+     * @brief 构造一个环形缓冲区。
+     * @param capacity 缓冲区的总容量（字节），会被调整为2的幂以优化模运算。
      */
     explicit SpscRingBuffer(size_t capacity)
-        : capacity_(next_power_of_2(capacity)), // ʹ2ݴ
-        mask_(capacity_ - 1),              // λȡģ
+        : capacity_(next_power_of_2(capacity)), // 使用2的幂次容量
+        mask_(capacity_ - 1),              // 用于位运算代替取模
         buffer_(capacity_)
     {
     }
@@ -35,16 +35,16 @@ public:
     SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
 
     /**
-     * @brief [̵߳] 򻺳дݡ
-     * @param data ָҪдݵָ롣
-     * @param bytes Ҫдֽ
-     * @return ʵдֽСռ䲻㣩
+     * @brief [生产者线程调用] 向缓冲区写入数据。
+     * @param data 指向要写入数据的指针。
+     * @param bytes 要写入的字节数。
+     * @return 实际写入的字节数（可能小于请求数，如果缓冲区空间不足）。
      */
     [[nodiscard]] size_t write(const char* data, size_t bytes) noexcept
     {
-        // ʹ memory_order_relaxedΪֻ̻߳޸ head_
+        // 使用 memory_order_relaxed，因为只有生产者线程会修改 head_
         const size_t current_head = head_.load(std::memory_order_relaxed);
-        // ʹ memory_order_acquireȷ̶ܿ߳ tail_ ޸
+        // 使用 memory_order_acquire，确保能看到消费者线程对 tail_ 的最新修改
         const size_t current_tail = tail_.load(std::memory_order_acquire);
 
         const size_t free_space = capacity_ - (current_head - current_tail);
@@ -54,11 +54,11 @@ public:
             return 0;
         }
 
-        // ߼תΪ
-        // ʹλȡģΪ2
+        // 将逻辑索引转换为物理索引
+        // 使用位与操作代替取模，因为容量是2的幂
         size_t head_idx = current_head & mask_;
 
-        // ݿҪοдԽĩβʱ
+        // 数据可能需要分两次拷贝（当写操作跨越了物理缓冲区的末尾时）
         size_t part1_size = std::min(bytes_to_write, capacity_ - head_idx);
         memcpy(buffer_.data() + head_idx, data, part1_size);
 
@@ -67,25 +67,25 @@ public:
             memcpy(buffer_.data(), data + part1_size, part2_size);
         }
 
-        // ʹ memory_order_releaseȷڸ head_ ֮ǰ
-        //  memcpy ̶߳ɼ
-        // ߺ֮ͬ㡣
+        // 使用 memory_order_release，确保在更新 head_ 之前，
+        // 上面的 memcpy 操作对所有其他线程都可见。
+        // 这是生产者和消费者之间的同步点。
         head_.store(current_head + bytes_to_write, std::memory_order_release);
 
         return bytes_to_write;
     }
 
     /**
-     * @brief [̵߳] ӻȡݡ
-     * @param data ָڴŶȡݵĻָ롣
-     * @param bytes Ҫȡֽ
-     * @return ʵʶȡֽbytesȣreturn 0
+     * @brief [消费者线程调用] 从缓冲区读取数据。
+     * @param data 指向用于存放读取数据的缓冲区的指针。
+     * @param bytes 要读取的字节数。
+     * @return 实际读取的字节数（必须和bytes相等，否则return 0）。
      */
     [[nodiscard]] size_t read(char* data, size_t bytes) noexcept
     {
-        // ʹ memory_order_acquireȷ̶ܿ߳ head_ ޸
+        // 使用 memory_order_acquire，确保能看到生产者线程对 head_ 的最新修改
         const size_t current_head = head_.load(std::memory_order_acquire);
-        // ʹ memory_order_relaxedΪֻ̻߳޸ tail_
+        // 使用 memory_order_relaxed，因为只有消费者线程会修改 tail_
         const size_t current_tail = tail_.load(std::memory_order_relaxed);
 
         const size_t bytes_available = current_head - current_tail;
@@ -105,36 +105,62 @@ public:
             memcpy(data + part1_size, buffer_.data(), part2_size);
         }
 
-        // ʹ memory_order_releaseȷڸ tail_ ֮ǰ
-        // ̣߳ߣܿռѾͷš
+        // 使用 memory_order_release，确保在更新 tail_ 之前，
+        // 其他线程（即生产者）能看到这块空间已经被释放。
         tail_.store(current_tail + bytes_to_read, std::memory_order_release);
 
         return bytes_to_read;
     }
 
-    // صǰɶ
+    /**
+     * @brief [消费者线程调用] 不拷贝地查看开头的 bytes 字节，之后用 consume() 释放。
+     *        数据跨越物理缓冲区末尾时分为两段，second 为第二段的起点（大小为 bytes - firstSize），否则为 nullptr。
+     * @return 数据不足 bytes 时返回false
+     */
+    [[nodiscard]] bool peek(size_t bytes, const char*& first, size_t& firstSize, const char*& second) const noexcept
+    {
+        const size_t current_head = head_.load(std::memory_order_acquire);
+        const size_t current_tail = tail_.load(std::memory_order_relaxed);
+        if (current_head - current_tail < bytes) {
+            return false;
+        }
+
+        const size_t tail_idx = current_tail & mask_;
+        first = buffer_.data() + tail_idx;
+        firstSize = std::min(bytes, capacity_ - tail_idx);
+        second = firstSize < bytes ? buffer_.data() : nullptr;
+        return true;
+    }
+
+    // [消费者线程调用] 释放 peek() 查看过的数据，之后生产者才能覆盖
+    void consume(size_t bytes) noexcept
+    {
+        tail_.store(tail_.load(std::memory_order_relaxed) + bytes, std::memory_order_release);
+    }
+
+    // 返回当前可读的数据量
     [[nodiscard]] size_t get_size() const noexcept {
         return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
     }
 
-    // صǰдĿռ
+    // 返回当前可写的空余空间
     [[nodiscard]] size_t get_free_space() const noexcept {
         return capacity_ - get_size();
     }
 
-    // 
+    // 返回总容量
     [[nodiscard]] size_t get_capacity() const noexcept {
         return capacity_;
     }
 
 private:
-    // ڵvС2
+    // 辅助函数，计算大于等于v的最小的2的幂
     static size_t next_power_of_2(size_t v) {
-        // Ѿ2ݵֱӷ
+        // 对于已经是2的幂的数，直接返回
         if (v > 0 && (v & (v - 1)) == 0) {
             return v;
         }
-        // ҵһ2
+        // 否则，找到下一个2的幂
         size_t p = 1;
         while (p < v) {
             p <<= 1;
@@ -143,15 +169,69 @@ private:
     }
 
 private:
-    // C++17 ׼ڱαĳ
+    // C++17 标准中用于避免伪共享的常量
     static constexpr size_t CACHELINE_SIZE = hardware_destructive_interference_size;
 
-    // ߺڲͬ߳޸ģʹ alignas α
+    // 生产者和消费者在不同线程上修改，使用 alignas 避免伪共享
     alignas(CACHELINE_SIZE) std::atomic<size_t> head_ = { 0 };
     alignas(CACHELINE_SIZE) std::atomic<size_t> tail_ = { 0 };
 
     const size_t capacity_;
-    const size_t mask_; // λȡģmask = capacity - 1
+    const size_t mask_; // 用于位运算代替取模，mask = capacity - 1
 
     std::vector<char> buffer_;
 };
+
+
+/*
+ * 固定容量的单生产者单消费者对象队列，容量为2的幂，不分配内存。
+ * 用于线程之间传递缓冲区下标等小对象，队列满或空时立即返回false，由调用者决定等待还是丢弃。
+ */
+template<typename T, size_t CAPACITY>
+class SpscQueue
+{
+    static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0, "capacity must be a power of 2");
+
+public:
+    SpscQueue() = default;
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // [生产者线程调用] 队列满时返回false
+    [[nodiscard]] bool tryPush(const T& value) noexcept
+    {
+        const size_t current_head = head_.load(std::memory_order_relaxed);
+        if (current_head - tail_.load(std::memory_order_acquire) == CAPACITY) {
+            return false;
+        }
+        items_[current_head & (CAPACITY - 1)] = value;
+        head_.store(current_head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // [消费者线程调用] 队列空时返回false
+    [[nodiscard]] bool tryPop(T& value) noexcept
+    {
+        const size_t current_tail = tail_.load(std::memory_order_relaxed);
+        if (head_.load(std::memory_order_acquire) == current_tail) {
+            return false;
+        }
+        value = items_[current_tail & (CAPACITY - 1)];
+        tail_.store(current_tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    [[nodiscard]] size_t size() const noexcept {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    static constexpr size_t capacity() { return CAPACITY; }
+
+private:
+    static constexpr size_t CACHELINE_SIZE = hardware_destructive_interference_size;
+
+    alignas(CACHELINE_SIZE) std::atomic<size_t> head_ = { 0 };
+    alignas(CACHELINE_SIZE) std::atomic<size_t> tail_ = { 0 };
+
+    T items_[CAPACITY];
+};
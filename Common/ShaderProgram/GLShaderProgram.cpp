@@ -96,12 +96,12 @@ void GLShaderProgram::unuse()
     glUseProgram(0);
 }
 
-// uniformֵ
+// 设置uniform值
 void GLShaderProgram::set1b(const std::string& name, bool value)
 {
-    // 1.ɫвѯӦuniformλãѯʱҪʹùɫ
+    // 1.在着色器程序对象中查询对应uniform的位置（查询时不要求使用过着色器程序）
     GLint loc = glGetUniformLocation(ProgramID_, name.c_str());
-    // 2.idxuniformֵʱҪѾʹùɫ
+    // 2.根据idx设置uniform的值（设置时要求必须已经使用过着色器程序）
     glUniform1i(loc, value);
 }
 void GLShaderProgram::set1i(const std::string& name, int value)
@@ -17,19 +17,19 @@ class GLShaderProgram : public QObject, public QOpenGLExtraFunctions
 	//Q_OBJECT
 public:
 
-	// ɫID
+	// 着色器程序对象ID
 	GLuint ProgramID_ = 0;
 
-	// 춥ɫƬɫ
+	// 构造顶点着色器和片段着色器
 	explicit GLShaderProgram(QObject* parent);
 	~GLShaderProgram();
 
 public:
 	void initialize(const char* vertexPath, const char* fragmentPath);
-	// ʹ/
+	// 使用/激活程序
 	void use();
 	void unuse();
-	// uniformֵ
+	// 设置uniform值
 	void set1b(const std::string& name, bool value);
 	void set1i(const std::string& name, int value);
 	void set1f(const std::string& name, float value);
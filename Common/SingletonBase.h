@@ -6,8 +6,8 @@
 #include <atomic>
 #include <exception>
 
-// ʽĻ
-template<typename T>    //T 
+// 懒汉式单例的基类
+template<typename T>    //T 是子类
 class Singleton_Lazy_Base {
 private:
     static void Destory(T* p_sgl) {
@@ -21,7 +21,7 @@ public:
 
     template<typename ...Args>
     static T& GetInstance(Args&&... args) {
-        // &args...ʾò
+        // &args...表示按引用捕获参数包
         std::call_once(of, [&args...]() {
             up.reset(new T(std::forward<Args>(args)...));
             }
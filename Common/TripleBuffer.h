@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+/*
+ * 单写者单读者的三缓冲：读者总是拿到最新发布的值，写者和读者都不等待（各只有一次原子交换）。
+ * 三个缓冲区分别由写者、中间槽和读者持有，发布和读取都是交换下标，值本身不拷贝。
+ * 写得比读得快时，未被读取的旧值被直接覆盖；适合"只关心最新状态"的跨线程数据，
+ * 如人脸位置、最新的纹理、流水线统计。
+ *
+ * 写者：修改 back() 后 publish()，或直接 write(value)
+ * 读者：fetch() 返回true时 front() 为新值；或 readLatest(value)
+ */
+template<typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+    explicit TripleBuffer(const T& init) : buffers_{ init, init, init } {}
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // [写线程调用] 写者持有的缓冲区，内容是之前某次发布的值
+    T& back() noexcept { return buffers_[backIndex_]; }
+
+    /**
+     * @brief [写线程调用] 发布 back()，换回中间槽的缓冲区作为新的 back()。
+     * @return 上一次发布的值还没有被读取、被覆盖时返回true
+     */
+    bool publish() noexcept
+    {
+        const int previous = middle_.exchange(backIndex_ | kFreshFlag, std::memory_order_acq_rel);
+        backIndex_ = previous & kIndexMask;
+        return (previous & kFreshFlag) != 0;
+    }
+
+    // [写线程调用] 写入并发布，返回值同 publish()
+    bool write(const T& value)
+    {
+        back() = value;
+        return publish();
+    }
+
+    // [读线程调用] 是否有尚未读取的新值
+    bool hasFresh() const noexcept { return (middle_.load(std::memory_order_relaxed) & kFreshFlag) != 0; }
+
+    /**
+     * @brief [读线程调用] 有新值时交出 front()，换回最新发布的缓冲区。
+     * @return 没有新值时返回false，front() 不变
+     */
+    bool fetch() noexcept
+    {
+        if (!hasFresh())
+            return false;
+        frontIndex_ = middle_.exchange(frontIndex_, std::memory_order_acq_rel) & kIndexMask;
+        return true;
+    }
+
+    // [读线程调用] 读者持有的缓冲区，在下一次 fetch() 前不会被写者修改
+    T& front() noexcept { return buffers_[frontIndex_]; }
+    const T& front() const noexcept { return buffers_[frontIndex_]; }
+
+    // [读线程调用] 取得最新的值，返回是否为新值
+    bool readLatest(T& value)
+    {
+        const bool fresh = fetch();
+        value = front();
+        return fresh;
+    }
+
+    // 按下标访问全部缓冲区，只能在没有读写时使用（初始化、销毁）
+    T& buffer(size_t index) noexcept { return buffers_[index]; }
+    static constexpr size_t size() noexcept { return 3; }
+
+private:
+    static const int kIndexMask = 3;
+    static const int kFreshFlag = 4;    // 中间槽的值尚未被读取
+
+    T buffers_[3]{};
+
+    // 写者和读者各自的下标分开存放，避免伪共享
+    alignas(64) int backIndex_ = 0;
+    alignas(64) std::atomic<int> middle_{ 1 };
+    alignas(64) int frontIndex_ = 2;
+};
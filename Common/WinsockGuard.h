@@ -0,0 +1,25 @@
+#ifndef WINSOCK_GUARD_H
+#define WINSOCK_GUARD_H
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <QtGlobal>
+
+// 应用程序在使用任何网络套接字 (socket) 功能之前，必须先调用 WSAStartup 函数来初始化 Winsock 库
+// WSAStartup/WSACleanup 内部带引用计数，RTMP 与 RTSP 推流器各自持有一个实例即可
+class WinsockGuard {
+public:
+    WinsockGuard() {
+        WSADATA wsaData;
+        int result = WSAStartup(MAKEWORD(2, 2), &wsaData);
+        if (result != 0) {
+            qFatal("WSAStartup failed with error: %d", result);
+        }
+    }
+    ~WinsockGuard() {
+        WSACleanup();
+    }
+};
+#endif
+
+#endif // WINSOCK_GUARD_H
@@ -40,7 +40,8 @@ LIBS +=     $$PWD/lib/win32/libFFmpeg/lib/libavformat.dll.a \
             $$PWD/lib/win32/libFFmpeg/lib/libswresample.dll.a \
             $$PWD/lib/win32/libFFmpeg/lib/libswscale.dll.a \
             $$PWD/lib/win32/libFFmpeg/lib/libpostproc.dll.a \
-            $$PWD/lib/win32/libFFmpeg/lib/libavfilter.dll.a
+            $$PWD/lib/win32/libFFmpeg/lib/libavfilter.dll.a \
+            $$PWD/lib/win32/libFFmpeg/lib/libavdevice.dll.a
 
 INCLUDEPATH += $$PWD/lib/win32/libfaac/include
 LIBS += -L$$PWD/lib/win32/libfaac/lib -lfaac
@@ -58,6 +59,7 @@ SOURCES += \
     ./MainWidget.cpp \
     ./OpenGLWidget/OpenGLWidget.cpp \
     ./OpenGLWidget/SceneManger/GLSceneManager.cpp \
+    ./OpenGLWidget/SceneManger/FacePosePredictor/FacePosePredictor.cpp \
     ./OpenGLWidget/SceneManger/Object/Frame/GLFrame.cpp \
     ./OpenGLWidget/SceneManger/Object/Model/GLModel.cpp \
     ./OpenGLWidget/SceneManger/Object/Model/Mesh/GLMesh.cpp \
@@ -65,24 +67,37 @@ SOURCES += \
     ./OpenGLWidget/SceneManger/Object/Sun/GLSun.cpp \
     ./OpenGLWidget/VideoCaptureThread/VideoCaptureThread.cpp \
     ./OpenGLWidget/VideoCaptureThread/YUVDraw/GLYuvDraw.cpp \
+    ./OpenGLWidget/VideoCaptureThread/CameraSource/CameraSource.cpp \
     ./AVRecorder/AVRecorder.cpp \
     ./AVRecorder/Muxer/Muxer.cpp \
+    ./AVRecorder/Muxer/AsyncFileWriter/AsyncFileWriter.cpp \
+    ./AVRecorder/HlsSink/HlsSink.cpp \
+    ./AVRecorder/ReplayBuffer/ReplayBuffer.cpp \
+    ./AVRecorder/QualityGovernor/QualityGovernor.cpp \
     ./AVRecorder/AudioEncoder/AudioEncoder.cpp \
+    ./AVRecorder/AudioEncoder/DriftEstimator/DriftEstimator.cpp \
     ./AVRecorder/VideoEncoder/VideoEncoder.cpp \
     ./AVRecorder/AudioCapturer/AudioCapturer.cpp \
     ./AVRecorder/AudioCapturer/IOBuffer/IOBuffer.cpp \
     ./Common/Camera/GLCamera.cpp \
     ./Common/ShaderProgram/GLShaderProgram.cpp \
+    ./Common/EsTap/EsTap.cpp \
     ./RtmpPublisher/RtmpPublisher.cpp \
-    ./RtmpPublisher/RtmpPush/RtmpPush.cpp
+    ./RtmpPublisher/RtmpPush/RtmpPush.cpp \
+    ./RtspPublisher/RtspPublisher.cpp \
+    ./RtspPublisher/RtspPush/RtspPush.cpp \
+    ./RtspPublisher/RtpPacketizer/RtpPacketizer.cpp
 
 INCLUDEPATH += ./Common
 INCLUDEPATH += ./Common/Camera
 INCLUDEPATH += ./Common/ShaderProgram
+INCLUDEPATH += ./Common/EsTap
 INCLUDEPATH += ./OpenGLWidget
 INCLUDEPATH += ./OpenGLWidget/VideoCaptureThread
 INCLUDEPATH += ./OpenGLWidget/VideoCaptureThread/YUVDraw
+INCLUDEPATH += ./OpenGLWidget/VideoCaptureThread/CameraSource
 INCLUDEPATH += ./OpenGLWidget/SceneManger
+INCLUDEPATH += ./OpenGLWidget/SceneManger/FacePosePredictor
 INCLUDEPATH += ./OpenGLWidget/SceneManger/Object
 INCLUDEPATH += ./OpenGLWidget/SceneManger/Object/Frame
 INCLUDEPATH += ./OpenGLWidget/SceneManger/Object/Model
@@ -91,17 +106,25 @@ INCLUDEPATH += ./OpenGLWidget/SceneManger/Object/SkyBox
 INCLUDEPATH += ./OpenGLWidget/SceneManger/Object/Sun
 INCLUDEPATH += ./AVRecorder
 INCLUDEPATH += ./AVRecorder/Muxer
+INCLUDEPATH += ./AVRecorder/HlsSink
+INCLUDEPATH += ./AVRecorder/ReplayBuffer
+INCLUDEPATH += ./AVRecorder/QualityGovernor
 INCLUDEPATH += ./AVRecorder/AudioEncoder
+INCLUDEPATH += ./AVRecorder/AudioEncoder/DriftEstimator
 INCLUDEPATH += ./AVRecorder/VideoEncoder
 INCLUDEPATH += ./AVRecorder/AudioCapturer
 INCLUDEPATH += ./AVRecorder/AudioCapturer/IOBuffer
 INCLUDEPATH += ./RtmpPublisher
 INCLUDEPATH += ./RtmpPublisher/RtmpPush
+INCLUDEPATH += ./RtspPublisher
+INCLUDEPATH += ./RtspPublisher/RtspPush
+INCLUDEPATH += ./RtspPublisher/RtpPacketizer
 
 HEADERS += \
     ./MainWidget.h \
     ./OpenGLWidget/OpenGLWidget.h \
     ./OpenGLWidget/SceneManger/GLSceneManager.h \
+    ./OpenGLWidget/SceneManger/FacePosePredictor/FacePosePredictor.h \
     ./OpenGLWidget/SceneManger/Object/Frame/GLFrame.h \
     ./OpenGLWidget/SceneManger/Object/Model/GLModel.h \
     ./OpenGLWidget/SceneManger/Object/Model/Mesh/GLMesh.h \
@@ -109,9 +132,15 @@ HEADERS += \
     ./OpenGLWidget/SceneManger/Object/Sun/GLSun.h \
     ./OpenGLWidget/VideoCaptureThread/VideoCaptureThread.h \
     ./OpenGLWidget/VideoCaptureThread/YUVDraw/GLYuvDraw.h \
+    ./OpenGLWidget/VideoCaptureThread/CameraSource/CameraSource.h \
     ./AVRecorder/AVRecorder.h \
     ./AVRecorder/Muxer/Muxer.h \
+    ./AVRecorder/Muxer/AsyncFileWriter/AsyncFileWriter.h \
+    ./AVRecorder/HlsSink/HlsSink.h \
+    ./AVRecorder/ReplayBuffer/ReplayBuffer.h \
+    ./AVRecorder/QualityGovernor/QualityGovernor.h \
     ./AVRecorder/AudioEncoder/AudioEncoder.h \
+    ./AVRecorder/AudioEncoder/DriftEstimator/DriftEstimator.h \
     ./AVRecorder/VideoEncoder/VideoEncoder.h \
     ./AVRecorder/AudioCapturer/AudioCapturer.h \
     ./AVRecorder/AudioCapturer/IOBuffer/IOBuffer.h \
@@ -121,8 +150,16 @@ HEADERS += \
     ./Common/LockFreeQueue.h \
     ./Common/SPSCRingBuffer.h \
     ./Common/SingletonBase.h \
+    ./Common/H264NalParser.h \
+    ./Common/WinsockGuard.h \
+    ./Common/MediaClock.h \
+    ./Common/TripleBuffer.h \
+    ./Common/EsTap/EsTap.h \
     ./RtmpPublisher/RtmpPublisher.h \
-    ./RtmpPublisher/RtmpPush/RtmpPush.h
+    ./RtmpPublisher/RtmpPush/RtmpPush.h \
+    ./RtspPublisher/RtspPublisher.h \
+    ./RtspPublisher/RtspPush/RtspPush.h \
+    ./RtspPublisher/RtpPacketizer/RtpPacketizer.h
 
 FORMS += \
     ./MainWidget.ui
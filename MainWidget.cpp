@@ -3,6 +3,8 @@
 #include "Common/DataDefine.h"
 #include <QDebug>
 #include <QIcon>
+#include <QSettings>
+#include <QCoreApplication>
 
 MainWidget::MainWidget(QWidget *parent)
     : QWidget(parent)
@@ -10,8 +12,17 @@ MainWidget::MainWidget(QWidget *parent)
 {
     ui->setupUi(this);
 
+    // 推流地址可在可执行文件目录下的 LMEngine.ini 中覆盖，未配置时使用默认地址：
+    // [push]
+    // rtmpUrl=rtmp://host/live/stream
+    // rtspUrl=rtsp://host/live/stream
+    QSettings settings(QCoreApplication::applicationDirPath() + "/LMEngine.ini", QSettings::IniFormat);
+    ui->openGLWidget->setRtmpUrl(settings.value("push/rtmpUrl", "rtmp://192.168.232.128/live/livestream").toString().toStdString());
+    ui->openGLWidget->setRtspUrl(settings.value("push/rtspUrl", "rtsp://192.168.232.128/live/livestream").toString().toStdString());
+
     connect(ui->btn_record, &QPushButton::clicked, this, &MainWidget::slot_RecordBtnClicked);
     connect(ui->btn_rtmpPush, &QPushButton::clicked, this, &MainWidget::slot_RtmpPushBtnClicked);
+    connect(ui->btn_rtspPush, &QPushButton::clicked, this, &MainWidget::slot_RtspPushBtnClicked);
 }
 
 MainWidget::~MainWidget()
@@ -22,27 +33,47 @@ MainWidget::~MainWidget()
 void MainWidget::slot_RecordBtnClicked()
 {
 	static bool record = false;
-	record = !record;
-    if (record) {
+    if (!record) {
+        // 启动失败时不切换状态，下次点击仍然是启动
+        if (!ui->openGLWidget->startRecord(avACT::RECORD))
+            return;
         ui->btn_record->setIcon(QIcon(":/images/Resource/images/RecordButton_Stop_bg.png"));
-        ui->openGLWidget->startRecord(avACT::RECORD);
     }
     else {
         ui->btn_record->setIcon(QIcon(":/images/Resource/images/RecordButton_Start_bg.png"));
         ui->openGLWidget->stopRecord(avACT::RECORD);
     }
+    record = !record;
 }
 
 void MainWidget::slot_RtmpPushBtnClicked()
 {
     static bool record = false;
-    record = !record;
-    if (record) {
+    if (!record) {
+        // 启动失败时不切换状态，下次点击仍然是启动
+        if (!ui->openGLWidget->startRecord(avACT::RTMPPUSH))
+            return;
         ui->btn_rtmpPush->setIcon(QIcon(":/images/Resource/images/RecordButton_Stop_bg.png"));
-        ui->openGLWidget->startRecord(avACT::RTMPPUSH);
     }
     else {
         ui->btn_rtmpPush->setIcon(QIcon(":/images/Resource/images/RecordButton_Start_bg.png"));
         ui->openGLWidget->stopRecord(avACT::RTMPPUSH);
     }
+    record = !record;
+}
+
+void MainWidget::slot_RtspPushBtnClicked()
+{
+    static bool record = false;
+    if (!record) {
+        // 启动失败时不切换状态，下次点击仍然是启动
+        if (!ui->openGLWidget->startRecord(avACT::RTSPPUSH))
+            return;
+        ui->btn_rtspPush->setIcon(QIcon(":/images/Resource/images/RecordButton_Stop_bg.png"));
+    }
+    else {
+        ui->btn_rtspPush->setIcon(QIcon(":/images/Resource/images/RecordButton_Start_bg.png"));
+        ui->openGLWidget->stopRecord(avACT::RTSPPUSH);
+    }
+    record = !record;
 }
\ No newline at end of file
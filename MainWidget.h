@@ -20,6 +20,7 @@ public:
 private slots:
     void slot_RecordBtnClicked();
     void slot_RtmpPushBtnClicked();
+    void slot_RtspPushBtnClicked();
 
 private:
     Ui::MainWidget *ui;
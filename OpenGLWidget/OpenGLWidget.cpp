@@ -5,23 +5,24 @@
 #include <QTextStream>
 #include <QKeyEvent>
 #include <QPoint>
+#include <algorithm>
 
 
 /*
- * OpenGLWidgetһĹ֣࣬
- * 1. ʼȾģʹVideoCaptureThreadڲƵ֮֡󣬿ֱǸ߳Ⱦtextureϣ
- *		Ȼ󴫸̣߳OpenGLWidget󷢸ӶYUVFrameҲǱOpenGLWidgetõȾ̵߳ģVideoCaptureThreadõȾġ
- * 2. viewprojection󣬽䴫Ӷַ
- * 3. ¼ƵֱʹFBO+˫PBO
- * 4. ڴС仯ʱӿԼز
+ * OpenGLWidget是一个整体的管理类，他负责三部分：
+ * 1. 初始化，创建离屏渲染上下文，使得VideoCaptureThread在捕获视频帧之后，可以直接在那个线程里离屏渲染到texture上，
+ *		然后传给主线程（OpenGLWidget），随后发给子对象（YUVFrame）也就是标明了OpenGLWidget用的是主渲染线程的上下文，VideoCaptureThread用的是离屏渲染上下文。
+ * 2. 更新view，projection矩阵，将其传给其子对象做分发。
+ * 3. 录制视频，直接使用FBO+双PBO即可
+ * 4. 当窗口大小发生变化时，重设置视口以及相关参数
  */
 
 OpenGLWidget::OpenGLWidget(QWidget *parent)
     : QOpenGLWidget(parent)
 {
-	//Ĭ׷꣬ڴƶʱȵһ²Ч
+	//设置默认追踪鼠标，否则在触发鼠标移动时，必须先点一下才有效
 	this->setMouseTracking(true);
-	// ýԣ OpenGLWidget ȡ¼
+	// 设置焦点策略，让 OpenGLWidget 获取键盘事件
 	this->setFocusPolicy(Qt::StrongFocus);
 	this->setFocus();
 
@@ -32,25 +33,28 @@ OpenGLWidget::OpenGLWidget(QWidget *parent)
 
 OpenGLWidget::~OpenGLWidget()
 {
-	pRenderThread_->quit();
-	pRenderThread_->wait();
-	delete pRenderThread_;
+	for (VideoCaptureThread* thread : captureThreads_)
+	{
+		thread->stopCapture();
+		thread->wait();
+		delete thread;
+	}
 }
 
 void OpenGLWidget::initializeGL()
 {
-	// ʼ
+	// 初始化
 	initializeOpenGLFunctions();
 
 	mainCtx_ = QOpenGLContext::currentContext();
 	//qDebug() << mainCtx_;
 
-	/*********************************** ʼͶ߳Դ ***********************************/
+	/*********************************** 初始化场景和多线程离屏资源 ***********************************/
 
 	initOffScreenEnv();
 	pGLSceneManager_->initialize();
 
-	/*********************************** ʼĻɫ ***********************************/
+	/*********************************** 初始化屏幕缓冲区着色器程序对象 ***********************************/
 
 	pMainShaderProg_->initialize(
 		":/shaders/Resource/shaders/mainWidget.vs",
@@ -62,12 +66,12 @@ void OpenGLWidget::initializeGL()
 
 	glGenBuffers(1, &sceneVBO_);
 	glBindBuffer(GL_ARRAY_BUFFER, sceneVBO_);
-	// ݴ
+	// 将数据传至缓存
 	glBufferData(GL_ARRAY_BUFFER, sizeof(sceneVertices_), sceneVertices_, GL_STATIC_DRAW);
-	// λ
+	// 设置位置属性
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
 	glEnableVertexAttribArray(0);
-	// uv
+	// 设置uv坐标
 	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
 	glEnableVertexAttribArray(1);
 
@@ -76,7 +80,7 @@ void OpenGLWidget::initializeGL()
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(sceneIndices_), sceneIndices_, GL_STATIC_DRAW);
 
 	pMainShaderProg_->use();
-	// Ϊǽӵ֡壬еȾָд뵽УҪָԪ
+	// 因为我们将纹理附件附加到了帧缓冲，所有的渲染指令将会写入到这个纹理中，所以我们需要指定纹理单元
 	pMainShaderProg_->set1i("mainTexture", 0);
 	pMainShaderProg_->unuse();
 
@@ -84,6 +88,27 @@ void OpenGLWidget::initializeGL()
 	initRecordFrameBuffer();
 	initRecordPBOs();
 
+	// 提前创建录制用的编码器、工作线程和录音设备，点击录制时只需打开输出文件
+	AVConfig recordConfig = makeAVConfig();
+	if (!CAVRecorder::GetInstance().prepare(recordConfig))
+		qWarning() << "failed to prepare recorder, retry on the first record.";
+	// 停止录制后文件在后台写完，完成时通知
+	connect(&CAVRecorder::GetInstance(), &CAVRecorder::recordingFinished, this, [](const QString& filePath, bool success) {
+		if (success)
+			qInfo() << "record saved to:" << filePath;
+		else
+			qWarning() << "record finished with errors:" << filePath;
+	}, Qt::QueuedConnection);
+	connect(&CAVRecorder::GetInstance(), &CAVRecorder::replaySaved, this, [](const QString& filePath, bool success) {
+		if (success)
+			qInfo() << "replay saved to:" << filePath;
+		else
+			qWarning() << "failed to save replay:" << filePath;
+	}, Qt::QueuedConnection);
+	connect(&CAVRecorder::GetInstance(), &CAVRecorder::qualityChanged, this, [](int level, const QString& description) {
+		qInfo() << "record quality level" << level << ":" << description;
+	}, Qt::QueuedConnection);
+
 	lastTime_ = QDateTime::currentDateTime();
 }
 
@@ -91,74 +116,92 @@ void OpenGLWidget::initOffScreenEnv()
 {
 	auto mainCtx = QOpenGLContext::currentContext();
 
-	if (!pRenderSurface_)
-	{
-		pRenderSurface_ = new QOffscreenSurface(this->screen(), this);
-		//pRenderSurface_ = new QOffscreenSurface(nullptr, this);
-		pRenderSurface_->setFormat(mainCtx->format());
-		pRenderSurface_->create();
-	}
+	if (!captureThreads_.empty())
+		return;
 
-	if (!pRenderThread_)
+	const int cameraCount = std::min(static_cast<int>(cameraCfgs_.size()), CGLFrame::kMaxLayers);
+	const int arrayW = std::max(width(), 1);
+	const int arrayH = std::max(height(), 1);
+
+	// ------------------------- 各路共用的输出纹理数组 -------------------------
+	// 每路占三层作为三缓冲，合成时一次绘制可以采样任意几路
+	glGenTextures(1, &frameArrayID_);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, frameArrayID_);
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_RGB8, arrayW, arrayH, std::max(cameraCount, 1) * 3);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	// 采集线程的共享上下文随后才使用该纹理，先提交给GPU
+	glFlush();
+
+	// ------------------------- 每路一个离屏表面和采集线程 -------------------------
+	for (int i = 0; i < cameraCount; ++i)
 	{
-		pRenderThread_ = new VideoCaptureThread(mainCtx, pRenderSurface_, this);
-		pRenderThread_->updateWH(width(), height());
-		pRenderThread_->start();
-		connect(pRenderThread_, &VideoCaptureThread::signal_NewYuvTexture, this, [this](unsigned int texid) {
-			FrameTexID_ = texid;
-			//qDebug() << "main: " << TexID;
+		QOffscreenSurface* surface = new QOffscreenSurface(this->screen(), this);
+		surface->setFormat(mainCtx->format());
+		surface->create();
+		renderSurfaces_.push_back(surface);
+
+		VideoCaptureThread* thread = new VideoCaptureThread(mainCtx, surface, this);
+		thread->setCameraCfg(cameraCfgs_[i]);
+		thread->setFaceTracking(i == 0);
+		thread->setOutputLayers(frameArrayID_, i * 3, arrayW, arrayH);
+		thread->updateWH(width(), height());
+		thread->start();
+		// 纹理和人脸位置都在paintGL中直接读取，这里只触发重绘；上一次重绘之前不会重复发出
+		connect(thread, &VideoCaptureThread::signal_FrameReady, this, [this]() {
 			this->update();
 		}, Qt::QueuedConnection);
-
-		connect(pRenderThread_, &VideoCaptureThread::signal_NewFacePos, this, [this](const QPoint& pos, const float& scale) {
-			pGLSceneManager_->moveFace(pos, scale);
-		}, Qt::QueuedConnection);
+		captureThreads_.push_back(thread);
 	}
+	frameLayers_.assign(cameraCount, -1);
 }
 
 void OpenGLWidget::initSceneFrameBuffer()
 {
 	qDebug() << "Initializing FBO with size:" << width() << "x" << height();
 
-	// ------------------------- FBO֡ -------------------------
-	// һ֮֡еĶȡд֡ĲӰ쵱ǰ󶨵֡
+	// ------------------------- FBO（帧缓冲对象） -------------------------
+	// 创建并绑定一个帧缓冲对象，之后的所有的读取和写入帧缓冲的操作将会影响当前绑定的帧缓冲
 	GLuint FBO;
     glGenFramebuffers(1, &FBO);
     glBindFramebuffer(GL_FRAMEBUFFER, FBO);
 	
-	// ------------------------- texture -------------------------
-	// һͨݻ(General Purpose Data Buffer)ɶд
+	// ------------------------- texture（纹理附件） -------------------------
+	// 纹理是一个通用数据缓冲(General Purpose Data Buffer)，可读可写
 
-	// һ2D
+	// 创建并绑定一个2D纹理附件
 	glGenTextures(1, &sceneTexID_);
 	glBindTexture(GL_TEXTURE_2D, sceneTexID_);
-	// datanullptrʾڴûȾ֮֡УҲ˵Ⱦ֮ݻҪתΪʽ
+	// 给纹理附件的data传nullptr，表示仅仅分配了内存而没有填充它。填充这个纹理将会在我们渲染到帧缓冲之后来进行，也就是说在渲染好之后，数据还需要转换为纹理格式
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width(), height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	//   ӵ֡GL_FRAMEBUFFERϣͨGL_COLOR_ATTACHMENT0ָ  һɫcolor attachment texture
+	// 将该 纹理附件 附加到帧缓冲GL_FRAMEBUFFER上，并通过GL_COLOR_ATTACHMENT0指明该 纹理 是一个颜色附件纹理（color attachment texture）
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, sceneTexID_, 0);
 
-	// ------------------------- RBOȾ󸽼 -------------------------
-	// RBOȻҲһ壬RBOרűΪ֡帽ʹõģֻͨдģǲҪЩвʱͨѡȾ
-	// ȾֱӽеȾݴ浽ĻУκʽתΪһĿдʡ
+	// ------------------------- RBO（渲染缓冲对象附件） -------------------------
+	// RBO虽然也是一个缓冲，但RBO是专门被设计作为帧缓冲附件使用的，通常都是只写的，当我们不需要从这些缓冲中采样的时候，通常选择渲染缓冲对象
+	// 渲染缓冲对象直接将所有的渲染数据储存到它的缓冲中，不会做任何针对纹理格式的转换，让它变为一个更快的可写储存介质。
 
-	// һ Ⱦ֮еȾӰ쵱ǰRBOǲԸRBO
+	// 创建并绑定一个 渲染缓冲对象，之后所有的渲染缓冲操作影响当前的RBO，不过我们不会对该RBO采样
 	glGenRenderbuffers(1, &sceneRBO_);
 	glBindRenderbuffer(GL_RENDERBUFFER, sceneRBO_);
-	// һȺģȾ󣬴˴ʹõȾͬʱΪȻģ建
+	// 创建一个深度和模板渲染缓冲对象，此处使用单个渲染缓冲对象同时作为深度缓冲对象和模板缓冲对象。
 	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width(), height());
-	//  Ⱦ ӵGL_FRAMEBUFFERϣͨGL_DEPTH_STENCIL_ATTACHMENTָȾ Ȼ  ģ建
+	// 将该 渲染缓冲对象 附加到GL_FRAMEBUFFER上，并通过GL_DEPTH_STENCIL_ATTACHMENT指明该渲染缓冲对象既是 深度缓冲对象 又是 模板缓冲对象
 	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, sceneRBO_);
 
-	// FBOǷ
+	// 检查FBO是否完整
 	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
 	if (status != GL_FRAMEBUFFER_COMPLETE)
 		qDebug() << "ERROR::FRAMEBUFFER:: Framebuffer is not complete: " << hex << status;
-	// ֡Ĭϻǰ֡
+	// 将帧缓冲对象绑定至默认缓冲区，即解绑当前帧缓冲对象
 	glBindFramebuffer(GL_FRAMEBUFFER, defaultFramebufferObject());
 
 	sceneFBO_ = FBO;
@@ -178,7 +221,7 @@ void OpenGLWidget::initRecordFrameBuffer()
 
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, recordTexID_, 0);
 
-	// FBOǷ
+	// 检查FBO是否完整
 	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
 	if (status != GL_FRAMEBUFFER_COMPLETE)
 		qDebug() << "ERROR::FRAMEBUFFER:: Framebuffer is not complete: " << Qt::hex << status;
@@ -189,8 +232,8 @@ void OpenGLWidget::initRecordFrameBuffer()
 
 void OpenGLWidget::initRecordPBOs()
 {
-	// 2.  2 ػ󣬳˳ʱҪɾǡ
-	// 2.1 ʹnullptr glBufferData () Ԥڴռ䡣
+	// 2. 创建 2 个像素缓冲区对象，程序退出时需要删除它们。
+	// 2.1 使用nullptr调用 glBufferData () 仅预留内存空间。
 	glGenBuffers(2, recordPBOIds_);
 
 	glBindBuffer(GL_PIXEL_PACK_BUFFER, recordPBOIds_[0]);
@@ -209,20 +252,20 @@ void OpenGLWidget::paintGL()
 	lastTime_ = currtime;
 	pCamera_->checkInputandUpdateCamera(deltaTime_);
 
-	// ģ;ɸԵobject
+	// 模型矩阵由各自的object创建
 
-	// ۲
+	// 创建观察矩阵
 	glm::mat4 view{ 1.0f };
 	//view = glm::translate(view, glm::vec3{ 0.0f, 0.0f, -3.0f });
 	view = pCamera_->getLookAt();
 
-	// ͶӰ
+	// 创建投影矩阵
 	glm::mat4 projection{ 1.0f };
 	int width = this->width();
 	int height = this->height();
 	projection = glm::perspective(glm::radians(pCamera_->zoom_), static_cast<float>(width / height), 0.1f, 1000.0f);
 
-	// ------------------------- FBOȾ -------------------------
+	// ------------------------- FBO离屏渲染 -------------------------
 	glBindFramebuffer(GL_FRAMEBUFFER, sceneFBO_);
 	glEnable(GL_DEPTH_TEST);
 	glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
@@ -230,27 +273,46 @@ void OpenGLWidget::paintGL()
 
 	glm::vec3 lightPos(3.5f, 3.0f, 3.3f);
 	static int interval_ = 0;
-	interval_ = ++interval_ % 100;	// 1000ָһѭΪ1000
-	double degree = 2.0 * 3.1415926535 * interval_ / 100;	// ʱdegreeֵΪ[0, 2*pi]
+	interval_ = ++interval_ % 100;	// 1000指的是一个循环为1000
+	double degree = 2.0 * 3.1415926535 * interval_ / 100;	// 此时degree的值域为[0, 2*pi]
 	lightPos = glm::vec3(2.0f * cos(degree), 1.0f, 2.0f * sin(degree));
-	pGLSceneManager_->draw(view, projection, FrameTexID_, lightPos, pCamera_->position_);
+	// 取得各路最新完成的摄像头帧，采集线程的栅栏在GPU端等待；只合成可见且已有帧的几路
+	visibleLayers_.clear();
+	for (size_t i = 0; i < captureThreads_.size(); ++i)
+	{
+		const int layer = captureThreads_[i]->acquireFrame();
+		if (layer >= 0)
+			frameLayers_[i] = layer;
+		if (((visibleCameras_ >> i) & 1u) && frameLayers_[i] >= 0)
+			visibleLayers_.push_back(frameLayers_[i]);
+	}
+	// 模型按绘制时刻的预测位置摆放，补偿人脸跟踪的延迟
+	if (!captureThreads_.empty())
+	{
+		VideoCaptureThread::FaceSample face;
+		if (captureThreads_.front()->latestFace(face))
+			pGLSceneManager_->moveFace(face.pos, face.scale, face.captureUs);
+	}
+	pGLSceneManager_->updateFace(CMediaClock::nowUs());
+	pGLSceneManager_->draw(view, projection, frameArrayID_, visibleLayers_, lightPos, pCamera_->position_);
 
-	needPBO = isRecording_ | isRtmpPush_ | isRtspPush_;
+	// 开启即时回放时录制器未录制也在接收画面
+	needPBO = isRecording_ | isRtmpPush_ | isRtspPush_ | CAVRecorder::GetInstance().isCapturing();
 	if (needPBO) {
-		// YUV420PҪֱʱΪżavcodec_open2h.264ʧ
-		// ҪƵ֡ת
+		// YUV420P要求分辨率必须为偶数！！！否则avcodec_open2打开h.264编码器失败
+		// 所以这里需要对视频帧做转换
 
 		glBindFramebuffer(GL_READ_FRAMEBUFFER, sceneFBO_);
 		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, recordFBO_);
 
 		glBlitFramebuffer(
-			0, 0, width, height,		// Դ: FBO
-			0, 0, recordW_, recordH_,	// Ŀ: ¼FBO
+			0, 0, width, height,		// 源: 整个场景FBO
+			0, 0, recordW_, recordH_,	// 目标: 整个录制FBO
 			GL_COLOR_BUFFER_BIT,
 			GL_LINEAR
 		);
 
-		// 󣬷ֹӰ
+		// 解绑，防止后续操作影响
 		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
 		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 
@@ -258,7 +320,7 @@ void OpenGLWidget::paintGL()
         useRecordPBOs();
 	}
 
-	// ------------------------- ǰĻȾȾͼȾǰĻϣ -------------------------
+	// ------------------------- 当前屏幕渲染（将离屏渲染的纹理图像渲染到当前屏幕上） -------------------------
 	glBindFramebuffer(GL_FRAMEBUFFER, defaultFramebufferObject());
 	glDisable(GL_DEPTH_TEST);
 	glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
@@ -292,7 +354,7 @@ void OpenGLWidget::adjustViewPort(const int& w, const int& h)
 	static int viewportY = 0;
 	static int viewportWidth = 0;
 	static int viewportHeight = 0;
-	// 2. ӿڣʹwidgetеͼαʼղ
+	// 2. 调整视口，使得widget中的图形比例始终不变
 	if (width_ > height_)
 	{
 		viewportX = (width_ - height_) / 2;
@@ -307,16 +369,16 @@ void OpenGLWidget::adjustViewPort(const int& w, const int& h)
 		viewportWidth = width_;
 		viewportHeight = width_;
 	}
-	// 3. һҪǵglViewport;
+	// 3. 一定要记得glViewport;
 	glViewport(viewportX, viewportY, viewportWidth, viewportHeight);
 }
 
 void OpenGLWidget::resizeGL(int w, int h)
 {
-	// ȾԣÿλͼҪݴڴС̬FBOеtexturerboĴС
+	// 对于离屏渲染而言，每次绘图都需要根据窗口大小动态调整FBO中的texture和rbo的大小
 	static int org_wh = w * h;
 
-	// ڴСı󣬼ǵøtexturerboСglDrawElementsʱtextureĿռ䲻
+	// 窗口大小改变后，记得更新texture和rbo大小，否则glDrawElements的时候，texture的空间不够
 	if (org_wh != w * h)
 	{
 		qDebug() << w << " " << h;
@@ -325,15 +387,15 @@ void OpenGLWidget::resizeGL(int w, int h)
 	}
 	org_wh = w * h;
 }
-void OpenGLWidget::startRecord(avACT action)
+AVConfig OpenGLWidget::makeAVConfig() const
 {
 	AVRational framerate{ 30, 1 };
 	VideoCodecCfg videoCodecCfg{
 		recordW_, recordH_,
 		1920, 1080,
-		framerate, {1, 30},	// ʱ֡ʱһ
-		static_cast<int>(av_q2d(framerate)),	//  GOP С1һI֡
-		1,		// B֡
+		framerate, {1, 30},	// 时间基与帧率保持一致
+		static_cast<int>(av_q2d(framerate)),	// 设置 GOP 大小：1秒一个I帧
+		1,		// 允许B帧
 		AV_PIX_FMT_YUV420P,
 		AV_CODEC_FLAG_GLOBAL_HEADER,
 		AV_CODEC_ID_H264,
@@ -345,9 +407,9 @@ void OpenGLWidget::startRecord(avACT action)
 	AudioCodecCfg audioCodecCfg{
 		128000, sample_rate, channels,
 		av_get_default_channel_layout(channels),
-		AV_SAMPLE_FMT_FLTP,		// AAC ͨʹ Planar ʽ (FLTP) Ի
-		{ 1, sample_rate },		// ʱԲΪλ
-		AV_CODEC_FLAG_GLOBAL_HEADER	// ƵҲһñ־ƵĹͷAudioSpecificConfigspsppsʹ洢codecCtx->extradata
+		AV_SAMPLE_FMT_FLTP,		// AAC 编码器通常使用 Planar 浮点数格式 (FLTP) 以获得最佳质量
+		{ 1, sample_rate },		// 时间基以采样率为单位
+		AV_CODEC_FLAG_GLOBAL_HEADER	// 音频也加一个该标志，这样音视频的公共头（AudioSpecificConfig，sps，pps）就存储于codecCtx->extradata中了
 	};
 
 	AudioFormat audioFmt{
@@ -365,70 +427,125 @@ void OpenGLWidget::startRecord(avACT action)
 		audioCodecCfg,
 		audioFmt
 	};
+	// 常驻期间一直缓存最近的画面，按 F9 保存
+	config.replayCfg_.enable_ = true;
+	return config;
+}
+
+bool OpenGLWidget::startRecord(avACT action)
+{
+	AVConfig config = makeAVConfig();
 
 	if (action == avACT::RECORD)
 	{
-		// initializepaintGLм¼
+		// initialize，随后在paintGL中记录
 		QDateTime dateTime = QDateTime::currentDateTime();
 		config.path_ = (qApp->applicationDirPath() + "/" + dateTime.toString("yyyyMMddhhmmss") + ".mp4").toStdString();
 		qDebug() << "start record video to: " << config.path_.c_str();
 
 
-		Q_ASSERT(CAVRecorder::GetInstance().initialize(config));
-		CAVRecorder::GetInstance().startRecording();
+		// 录制器常驻，正常情况下已在 initializeGL() 中预热，这里只打开新的输出文件
+		CAVRecorder& recorder = CAVRecorder::GetInstance();
+		if (!recorder.isWarm() && !recorder.prepare(config))
+		{
+			qCritical() << "failed to prepare recorder.";
+			return false;
+		}
+		if (!recorder.startRecording(config.path_))
+		{
+			qCritical() << "failed to start recording.";
+			return false;
+		}
 
 		isRecording_ = true;
 	}
 	else if (action == avACT::RTMPPUSH)
 	{
-		// ע⣺rtmpʱΪ˱֤ƵݵļʱԣҪǽ֡ʣIDR֡ЩҪ޸AVCodecContextĲ
-		config.path_ = "rtmp://192.168.232.128/live/livestream";
+		// 注意：rtmp推流时，为了保证视频数据的及时性，需要考虑降低帧率，缩短IDR帧间隔，这些参数需要修改AVCodecContext的参数
+		if (rtmpUrl_.empty())
+		{
+			qCritical() << "rtmp url is not configured.";
+			return false;
+		}
+		config.path_ = rtmpUrl_;
 		qDebug() << "connect RTMP server to: " << config.path_.c_str();
 
-		config.videoCodecCfg_.max_b_frames_ = 0;	// ֱֹB֡
-		Q_ASSERT(CRtmpPublisher::GetInstance()->initialize(config));
+		// RTMP 通过 FLV 的 CompositionTime 携带 pts - dts，可以推送B帧
+		config.videoCodecCfg_.max_b_frames_ = liveMaxBFrames_;
+		if (!CRtmpPublisher::GetInstance()->initialize(config))
+		{
+			qCritical() << "failed to initialize rtmp push.";
+			return false;
+		}
 		CRtmpPublisher::GetInstance()->startPush();
 		isRtmpPush_ = true;
 	}
 	else if (action == avACT::RTSPPUSH)
 	{
-
+		if (rtspUrl_.empty())
+		{
+			qCritical() << "rtsp url is not configured.";
+			return false;
+		}
+		config.path_ = rtspUrl_;
+		qDebug() << "connect RTSP server to: " << config.path_.c_str();
+
+		config.videoCodecCfg_.max_b_frames_ = liveMaxBFrames_;	// RTP 时间戳即 pts，按解码顺序发送即可携带B帧
+		config.rtpTransport_ = RtpTransport::UDP;
+		if (!CRtspPublisher::GetInstance()->initialize(config) || !CRtspPublisher::GetInstance()->startPush())
+		{
+			qCritical() << "failed to start rtsp push.";
+			return false;
+		}
 		isRtspPush_ = true;
 	}
 	else
 	{
 		qDebug() << "undefined action";
+		return false;
 	}
-	
+	return true;
 }
 
 void OpenGLWidget::useRecordPBOs()
 {
-	// dmaֱָڴʼӲͨCPUͨDMAֱӷʣ޸ģڴԴеݡ
+	// dma指的是直接内存访问技术，硬件不通过CPU，而是通过DMA控制器，直接访问，修改，传输内存或显存中的数据。
 	static int dma = 0;
 	static int read = 0;
+	// 每个PBO对应帧的渲染时间，map 出来的是上一次 glReadPixels 的数据；-1 表示PBO中没有未取走的帧
+	static int64_t renderTimeUs[2] = { -1, -1 };
 
-	/*********************************** USES PBO (Streaming Texture Uploads ʽ) ***********************************/
+	/*********************************** USES PBO (Streaming Texture Uploads 流式纹理更新) ***********************************/
 
 	// ------------------------- pack PBO -------------------------
-	// ʹ glBindBuffer() PBO󶨵GL_PIXEL_PACK_BUFFERϺ
-	// еpack glReadPixels(), glGetTexImage() Ⱥ
-	// Ὣݴ ֡  ͼ 䵽 PBOӦػ
+	// 当使用 glBindBuffer() 将PBO绑定到GL_PIXEL_PACK_BUFFER上后，
+	// 后续所有的pack操作：如 glReadPixels(), glGetTexImage() 等函数
+	// 会将像素数据从 帧缓冲区 或者 纹理图像 传输到 PBO对应的像素缓冲区
 	glBindBuffer(GL_PIXEL_PACK_BUFFER, recordPBOIds_[dma]);
 	//glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, IMAGE_WIDTH, IMAGE_HEIGHT, GL_RGBA, GL_UNSIGNED_BYTE, 0);
 	glReadPixels(0, 0, recordW_, recordH_, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+	renderTimeUs[dma] = CMediaClock::nowUs();
 
 	// ------------------------- update PBO -------------------------
-	// 󶨵PBOڸ
+	// 另一个PBO还没有写入过（开始录制/推流后的第一帧），没有可取回的数据；
+	// 每帧只取回一次，停止后再开始时不会把上一次残留的画面送去编码
+	if (renderTimeUs[read] < 0)
+	{
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		std::swap(dma, read);
+		return;
+	}
+
+	// 更换绑定的PBO，用于更新像素数据
 	glBindBuffer(GL_PIXEL_PACK_BUFFER, recordPBOIds_[read]);
 	//glBufferData(GL_PIXEL_PACK_BUFFER, DATA_SIZE, 0, GL_STREAM_DRAW);
-	//ptrʾGPUϵPBOڴռӳַǲptrʵֱӲGPUеPBO
+	//ptr表示GPU上的PBO在内存空间的映射地址，我们操作ptr，实际上是直接操作的GPU中的PBO
 	GLubyte* ptr = static_cast<GLubyte*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, recordW_ * recordH_ * 4, GL_MAP_READ_BIT));
 	if (ptr)
 	{
-		if (isRecording_)
-			recordAV(ptr);
-		else if (isRtmpPush_)
+		if (CAVRecorder::GetInstance().isCapturing())
+			recordAV(ptr, renderTimeUs[read]);
+		if (isRtmpPush_)
 			rtmpPush(ptr);
 		else if (isRtspPush_)
 			rtspPush(ptr);
@@ -440,9 +557,10 @@ void OpenGLWidget::useRecordPBOs()
 	{
 		qDebug() << "no ptr!";
 	}
+	renderTimeUs[read] = -1;
 
-	// ʹǵͷŰ
-	// glBindBuffer()һ󶨵 0زͻԳ淽ʽС
+	// 使用完后记得释放绑定
+	// glBindBuffer()一旦绑定到 0，所有像素操作就会以常规方式运行。
 	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
 
 	std::swap(dma, read);
@@ -462,13 +580,13 @@ void OpenGLWidget::saveImage(GLubyte* ptr)
 		qDebug() << "save image error";
 }
 
-void OpenGLWidget::recordAV(GLubyte* ptr)
+void OpenGLWidget::recordAV(GLubyte* ptr, int64_t renderTimeUs)
 {
-	if (!isRecording_)
+	if (!CAVRecorder::GetInstance().isCapturing())
 		qDebug() << "can't record video!";
 	//assert(CAVRecorder::GetInstance()->recording(ptr));
 	//CAVRecorder::GetInstance()->recording(ptr);
-	CAVRecorder::GetInstance().pushRGBA(ptr);
+	CAVRecorder::GetInstance().pushRGBA(ptr, renderTimeUs);
 }
 
 void OpenGLWidget::rtmpPush(GLubyte* ptr)
@@ -480,7 +598,10 @@ void OpenGLWidget::rtmpPush(GLubyte* ptr)
 
 void OpenGLWidget::rtspPush(GLubyte* ptr)
 {
-	
+	if (!isRtspPush_)
+		qDebug() << "can't push to rtsp server!";
+	if (!CRtspPublisher::GetInstance()->pushing(ptr))
+		qWarning() << "rtsp push failed.";
 }
 
 void OpenGLWidget::stopRecord(avACT action)
@@ -498,6 +619,7 @@ void OpenGLWidget::stopRecord(avACT action)
 	else if (action == avACT::RTSPPUSH)
 	{
 		isRtspPush_ = false;
+		CRtspPublisher::GetInstance()->stopPush();
 	}
 	else
 	{
@@ -508,6 +630,15 @@ void OpenGLWidget::stopRecord(avACT action)
 
 void OpenGLWidget::keyPressEvent(QKeyEvent* event)
 {
+	// F9 保存即时回放缓存中最近一段内容，录制不受影响
+	if (event->key() == Qt::Key_F9 && !event->isAutoRepeat())
+	{
+		QDateTime dateTime = QDateTime::currentDateTime();
+		QString path = qApp->applicationDirPath() + "/replay_" + dateTime.toString("yyyyMMddhhmmss") + ".mp4";
+		if (!CAVRecorder::GetInstance().saveReplay(path.toStdString()))
+			qWarning() << "failed to save replay.";
+		return;
+	}
 	if (event->key() >= 0 && event->key() < 1024)
 	{
 		pCamera_->keys[event->key()] = true;
@@ -539,7 +670,7 @@ void OpenGLWidget::mouseMoveEvent(QMouseEvent* event)
 
 void OpenGLWidget::mousePressEvent(QMouseEvent* event)
 {
-	//    
+	// 如果是鼠标左键按下   
 	if (event->button() == Qt::LeftButton) {
 		isPressed_ = true;
 		lastPos_ = event->pos();
@@ -6,6 +6,7 @@
 #include <QOffscreenSurface>
 #include <QString>
 #include <QDateTime>
+#include <vector>
 #include <gl/GL.h>
 #include <gl/GLU.h>
 #include <glm/glm.hpp>
@@ -21,6 +22,7 @@
 #include "AVRecorder/AVRecorder.h"
 #include "SceneManger/GLSceneManager.h"
 #include "RtmpPublisher/RtmpPublisher.h"
+#include "RtspPublisher/RtspPublisher.h"
 
 class OpenGLWidget: public QOpenGLWidget, public QOpenGLExtraFunctions
 {
@@ -30,54 +32,69 @@ public:
     ~OpenGLWidget() override;
 
 public:
-    // ʼMP4ļдMP4ͷƵ¼ȾѭrecordAV()
-    void startRecord(avACT action);
-    // дMP4β
+    // 仅初始化MP4文件，写入MP4头，真正开启视频录制在渲染循环的recordAV()中；失败时返回 false
+    bool startRecord(avACT action);
+    // 写入MP4尾，
     void stopRecord(avACT action);
 
+    // 摄像头输入（1~4路，可以是测试文件），须在窗口初始化（initializeGL）之前调用；默认为系统默认摄像头一路；
+    // 多路时各路须指定不同的 device_ 或 file_
+    void setCameraCfgs(const std::vector<CameraCfg>& cfgs) { cameraCfgs_ = cfgs; }
+    // 参与合成的摄像头，第i位对应第i路，可随时修改
+    void setVisibleCameras(unsigned int mask) { visibleCameras_ = mask; }
+    // 推流地址，为空时不能推流；见 MainWidget 中读取的配置文件及默认地址
+    void setRtmpUrl(const std::string& url) { rtmpUrl_ = url; }
+    void setRtspUrl(const std::string& url) { rtspUrl_ = url; }
+
 protected:
     void initializeGL() override;
     void paintGL() override;
     void resizeGL(int w, int h) override;
 
-    void keyPressEvent(QKeyEvent* event) override; //̰¼
-    void keyReleaseEvent(QKeyEvent* event) override; //ɿ¼
+    void keyPressEvent(QKeyEvent* event) override; //键盘按下事件
+    void keyReleaseEvent(QKeyEvent* event) override; //键盘松开事件
 
-    //ƶ¼
+    //鼠标移动事件
     void mouseMoveEvent(QMouseEvent* ev) override;
-    //갴¼
+    //鼠标按下事件
     void mousePressEvent(QMouseEvent* ev) override;
-    //ͷ¼
+    //鼠标释放事件
     void mouseReleaseEvent(QMouseEvent* ev) override;
 
     void wheelEvent(QWheelEvent* event) override;
 
 private:
-    // initializeGL()ʹ
+    // initializeGL()中使用
     void initOffScreenEnv();
     void initSceneFrameBuffer();
     void initRecordFrameBuffer();
     void initRecordPBOs();
-    // resizeGL(int w, int h)ʹ
+    // resizeGL(int w, int h)中使用
     void reallocSceneFrameBuffer(const int& w, const int& h);
     void adjustViewPort(const int& w, const int& h);
-    // ʹ˫PBO¼Ƶ/
+    // 使用双PBO记录视频/推流
     void useRecordPBOs();
-    void recordAV(GLubyte* ptr);
+    void recordAV(GLubyte* ptr, int64_t renderTimeUs);
     void rtmpPush(GLubyte* ptr);
     void rtspPush(GLubyte* ptr);
     void saveImage(GLubyte* ptr);
+    // 录制/推流共用的编码配置，path_ 为空
+    AVConfig makeAVConfig() const;
 
 private:
     QOpenGLContext* mainCtx_ = nullptr;
 
-    // жҪ¼Ƶ
+    // 用于判断需要推流还是录制视频
     bool needPBO = false;
     bool isRecording_ = false;
     bool isRtmpPush_ = false;
     bool isRtspPush_ = false;
+    // 直播时允许的B帧数：0为最低延迟；对延迟不敏感的直播可设为1~2，同等画质下可节省上行带宽
+    int liveMaxBFrames_ = 0;
+    std::string rtmpUrl_;
+    std::string rtspUrl_;
 
-    // -------------------------  -------------------------
+    // ------------------------- 摄像机 -------------------------
     QDateTime lastTime_;
     qint64 deltaTime_ = 0;
     glm::vec3 cameraPos_{ 0.0f, 0.0f, 3.0f };
@@ -85,7 +102,7 @@ private:
     bool isPressed_ = false;
     CGLCamera* pCamera_ = nullptr;
 
-    // ------------------------- ȾݣЩݽȾ -------------------------
+    // ------------------------- 渲染数据，这些数据仅用于渲染 -------------------------
     float sceneVertices_[20] =
     {
 		-1.0f, -1.0f, -1.0f,    0,  0,
@@ -107,22 +124,27 @@ private:
 
     GLShaderProgram* pMainShaderProg_ = nullptr;
 
-    // ------------------------- ¼ݣЩݽ¼ҪȽsceneFBOתrecordFBOֱ֤ͳһ -------------------------
-    GLuint recordFBO_;                      // ¼ƵFBO
-    GLuint recordTexID_;                    // ¼FBO󶨵
+    // ------------------------- 录屏数据，这些数据仅用于录屏，需要先将sceneFBO转换成recordFBO，保证分辨率统一 -------------------------
+    GLuint recordFBO_;                      // 用于录制的FBO
+    GLuint recordTexID_;                    // 录制FBO绑定的纹理
     GLuint recordPBOIds_[2] = { 0, 0 };
-    int recordW_ = 1920;                    // ¼ƵĿ
-    int recordH_ = 1080;                    // ¼ƵĿ߶
+    int recordW_ = 1920;                    // 录制的目标宽度
+    int recordH_ = 1080;                    // 录制的目标高度
 
-    // ------------------------- ȾFBOtextureϵ -------------------------
+    // ------------------------- 渲染到FBO的texture上的所需数据 -------------------------
     GLSceneManager* pGLSceneManager_ = nullptr;
 
-    // ------------------------- ߳Ⱦ -------------------------
-    QOffscreenSurface* pRenderSurface_ = nullptr;
-    // Ⱦ̸߳1. Ƶ֡2. ֡Ⱦtexid
-    VideoCaptureThread* pRenderThread_ = nullptr;
-
-    GLuint FrameTexID_ = 0;
+    // ------------------------- 多线程离屏渲染数据 -------------------------
+    std::vector<CameraCfg> cameraCfgs_{ CameraCfg{} };
+    unsigned int visibleCameras_ = ~0u;
+    // 每路一个离屏表面和采集线程，各自持有共享上下文；采集线程负责：1. 捕获视频帧。2. 将该帧渲染到纹理数组的一层上
+    // 人脸跟踪库是全局的，只在第0路上跟踪
+    std::vector<QOffscreenSurface*> renderSurfaces_;
+    std::vector<VideoCaptureThread*> captureThreads_;
+
+    GLuint frameArrayID_ = 0;           // 各路输出的纹理数组，每路占三层（三缓冲）
+    std::vector<int> frameLayers_;      // 各路最新帧所在的层，-1表示还没有帧
+    std::vector<int> visibleLayers_;    // 本次绘制参与合成的层
 };
 
 #endif // OPENGLWIDGET_H
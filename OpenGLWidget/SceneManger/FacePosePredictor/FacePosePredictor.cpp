@@ -0,0 +1,78 @@
+#include "FacePosePredictor.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // 一阶低通滤波的系数
+    double smoothingFactor(double dt, double cutoffHz)
+    {
+        const double tau = 1.0 / (2.0 * 3.14159265358979323846 * cutoffHz);
+        return 1.0 / (1.0 + tau / dt);
+    }
+}
+
+CFacePosePredictor::CFacePosePredictor()
+{
+    // 位置以像素（1920x1080）为单位，头部移动通常为每秒几百像素；缩放的量级在 1~10
+    x_.params = { 1.0, 0.01, 1.0 };
+    y_.params = { 1.0, 0.01, 1.0 };
+    scale_.params = { 0.5, 0.5, 1.0 };
+}
+
+void CFacePosePredictor::reset()
+{
+    hasSample_ = false;
+    lastUs_ = 0;
+}
+
+void CFacePosePredictor::addSample(float x, float y, float scale, int64_t captureUs)
+{
+    if (!hasSample_ || captureUs - lastUs_ > lostUs_)
+    {
+        x_.reset(x);
+        y_.reset(y);
+        scale_.reset(scale);
+        hasSample_ = true;
+        lastUs_ = captureUs;
+        return;
+    }
+    if (captureUs <= lastUs_)
+        return;
+
+    const double dt = (captureUs - lastUs_) / 1000000.0;
+    x_.update(x, dt);
+    y_.update(y, dt);
+    scale_.update(scale, dt);
+    lastUs_ = captureUs;
+}
+
+bool CFacePosePredictor::predict(int64_t renderUs, float& x, float& y, float& scale) const
+{
+    if (!hasSample_)
+        return false;
+
+    // 匀速外推到绘制时刻，外推时间有上限，避免跟丢后一直飘走
+    const double dt = std::min(std::max<int64_t>(renderUs - lastUs_, 0), maxPredictUs_) / 1000000.0;
+    x = static_cast<float>(x_.value + x_.velocity * dt);
+    y = static_cast<float>(y_.value + y_.velocity * dt);
+    scale = static_cast<float>(scale_.value + scale_.velocity * dt);
+    return true;
+}
+
+void CFacePosePredictor::Channel::reset(double v)
+{
+    value = v;
+    velocity = 0.0;
+}
+
+void CFacePosePredictor::Channel::update(double v, double dt)
+{
+    // 先滤波速度，再按速度调整截止频率滤波位置
+    const double rawVelocity = (v - value) / dt;
+    velocity += smoothingFactor(dt, params.dCutoffHz) * (rawVelocity - velocity);
+
+    const double cutoffHz = params.minCutoffHz + params.beta * std::abs(velocity);
+    value += smoothingFactor(dt, cutoffHz) * (v - value);
+}
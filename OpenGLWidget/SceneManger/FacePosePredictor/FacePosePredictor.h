@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+ * 人脸位置的平滑和预测：跟踪结果带有采集时间，每个分量（x、y、缩放）各用一个 One-Euro 滤波器，
+ * 慢速移动时截止频率低、抖动被滤掉，快速移动时截止频率随速度升高、滞后很小；
+ * 绘制时按滤波后的速度做匀速外推，把位置推算到绘制时刻，补偿跟踪的延迟和较低的跟踪频率。
+ * 只在GUI线程中使用。
+ */
+class CFacePosePredictor
+{
+public:
+    // One-Euro 滤波参数，单位与对应分量一致
+    struct FilterParams
+    {
+        double minCutoffHz = 1.0;   // 静止时的截止频率，越小越平滑
+        double beta = 0.0;          // 截止频率随速度升高的系数
+        double dCutoffHz = 1.0;     // 速度估计的截止频率
+    };
+
+    CFacePosePredictor();
+
+    // 丢弃历史，下一次结果直接作为当前位置
+    void reset();
+
+    /**
+     * @brief 加入一次跟踪结果。
+     * @param captureUs 该帧的采集时间（CMediaClock），早于上一次的结果被忽略
+     */
+    void addSample(float x, float y, float scale, int64_t captureUs);
+
+    /**
+     * @brief 推算 renderUs 时刻的位置。
+     * @return 还没有跟踪结果时返回false
+     */
+    bool predict(int64_t renderUs, float& x, float& y, float& scale) const;
+
+private:
+    struct Channel
+    {
+        FilterParams params;
+        double value = 0.0;         // 滤波后的值
+        double velocity = 0.0;      // 滤波后的速度（每秒）
+
+        void reset(double v);
+        void update(double v, double dt);
+    };
+
+    Channel x_;
+    Channel y_;
+    Channel scale_;
+    bool hasSample_ = false;
+    int64_t lastUs_ = 0;
+
+    // 外推的最长时间：更久没有结果时停在外推的终点，不再继续移动
+    int64_t maxPredictUs_ = 150000;
+    // 超过该时间没有结果视为跟丢，重新出现时直接跳到新位置
+    int64_t lostUs_ = 1000000;
+};
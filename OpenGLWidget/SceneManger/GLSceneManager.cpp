@@ -16,7 +16,7 @@ GLSceneManager::~GLSceneManager()
 
 void GLSceneManager::initialize()
 {
-	// ʼ
+	// 初始化
 	initializeOpenGLFunctions();
 
 	glEnable(GL_DEPTH_TEST);
@@ -27,20 +27,32 @@ void GLSceneManager::initialize()
 	pSkyBox_->initialize();
 }
 
-void GLSceneManager::draw(const glm::mat4& view, const glm::mat4& projection, const GLuint& FrameTexID, const glm::vec3& lightPos, const glm::vec3& viewPos)
+void GLSceneManager::draw(const glm::mat4& view, const glm::mat4& projection, const GLuint& FrameArrayID, const std::vector<int>& frameLayers, const glm::vec3& lightPos, const glm::vec3& viewPos)
 {
-	pFrame_->draw(view, projection, FrameTexID);
+	pFrame_->draw(view, projection, FrameArrayID, frameLayers);
 	pSun_->draw(view, projection, lightPos);
 	pModel_->draw(view, projection, lightPos, viewPos);
-	// պ
+	// 天空盒最后画
 	pSkyBox_->draw(view, projection);
 }
 
-void GLSceneManager::moveFace(const QPoint& pos, const float& scale)
+void GLSceneManager::moveFace(const QPointF& pos, const float& scale, const qint64& captureUs)
 {
+	// 不直接移动模型，由 updateFace 在绘制时按预测位置移动
+	facePredictor_.addSample(pos.x(), pos.y(), scale, captureUs);
+}
+
+void GLSceneManager::updateFace(const qint64& renderUs)
+{
+	float x = 0.0f;
+	float y = 0.0f;
+	float scale = 0.0f;
+	if (!facePredictor_.predict(renderUs, x, y, scale))
+		return;
+
 	if (pModel_)
 	{
-		pModel_->move(pos, scale);
+		pModel_->move(QPointF(x, y), scale);
 	}
 
 	if (pFrame_)
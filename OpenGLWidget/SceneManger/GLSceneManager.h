@@ -10,6 +10,7 @@
 #include "OpenGLWidget/SceneManger/Object/Model/GLModel.h"
 #include "OpenGLWidget/SceneManger/Object/SkyBox/GLSkyBox.h"
 #include "OpenGLWidget/SceneManger/Object/Sun/GLSun.h"
+#include "OpenGLWidget/SceneManger/FacePosePredictor/FacePosePredictor.h"
 
 class GLSceneManager : public QObject, public QOpenGLExtraFunctions
 {
@@ -20,13 +21,19 @@ public:
 
 public:
 	void initialize();
-	void draw(const glm::mat4& view, const glm::mat4& projection, const GLuint& FrameTexID, const glm::vec3& lightPos, const glm::vec3& viewPos);
-	void moveFace(const QPoint& pos, const float& scale);
+	// FrameArrayID、frameLayers 见 CGLFrame::draw
+	void draw(const glm::mat4& view, const glm::mat4& projection, const GLuint& FrameArrayID, const std::vector<int>& frameLayers, const glm::vec3& lightPos, const glm::vec3& viewPos);
+	// 加入一次人脸跟踪结果，captureUs 为该帧的采集时间（CMediaClock）
+	void moveFace(const QPointF& pos, const float& scale, const qint64& captureUs);
+	// 把模型移动到 renderUs 时刻的预测位置，每次绘制前调用
+	void updateFace(const qint64& renderUs);
 
 private:
 	CGLSkybox* pSkyBox_ = nullptr;
 	CGLFrame* pFrame_ = nullptr;
 	CGLSun* pSun_ = nullptr;
 	CGLModel* pModel_ = nullptr;
+
+	CFacePosePredictor facePredictor_;
 };
 
@@ -1,6 +1,8 @@
 #include "GLFrame.h"
 #include <QFrame>
 #include <QDebug>
+#include <algorithm>
+#include <string>
 
 CGLFrame::CGLFrame(QObject* parent)
 	: QObject(parent)
@@ -14,16 +16,16 @@ CGLFrame::~CGLFrame()
 
 void CGLFrame::initialize()
 {
-	// ʼ
+	// 初始化
 	initializeOpenGLFunctions();
 
-	/*********************************** ʼɫ ***********************************/
+	/*********************************** 初始化着色器程序对象 ***********************************/
 	pShaderProg_->initialize(
 		":/shaders/Resource/shaders/frame.vs",
 		":/shaders/Resource/shaders/frame.fs"
 	);
 
-	/*********************************** ʼVAO,VBO,EBO,texture ***********************************/
+	/*********************************** 初始化VAO,VBO,EBO,texture ***********************************/
 	// ------------------------- VAO -------------------------
 	GLuint VAO = 0;
 	glGenVertexArrays(1, &VAO);
@@ -33,38 +35,43 @@ void CGLFrame::initialize()
 	GLuint VBO = 0;
 	glGenBuffers(1, &VBO);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	// ݴ
+	// 将数据传至缓存
 	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices_), vertices_, GL_STATIC_DRAW);
 
-	// λ
+	// 设置位置属性
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
 	glEnableVertexAttribArray(0);
 
-	// uv
+	// 设置uv坐标
 	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
 	glEnableVertexAttribArray(1);
 
-	// ------------------------- texture -------------------------
+	// ------------------------- 绑定texture -------------------------
 	pShaderProg_->use();
-	pShaderProg_->set1i("frameTexture", 0);
+	pShaderProg_->set1i("frameTextures", 0);
 	pShaderProg_->unuse();
 
 	VAO_ = VAO;
 	VBO_ = VBO;
 }
 
-void CGLFrame::draw(const glm::mat4& view, const glm::mat4& projection, const GLuint& FrameTexID)
+void CGLFrame::draw(const glm::mat4& view, const glm::mat4& projection, const GLuint& FrameArrayID, const std::vector<int>& layers)
 {
 	isMoving_ = true;
 	pShaderProg_->use();
 	pShaderProg_->setMatrix4fv("view", 1, GL_FALSE, glm::value_ptr(view));
 	pShaderProg_->setMatrix4fv("projection", 1, GL_FALSE, glm::value_ptr(projection));
 
+	const int layerCount = std::min(static_cast<int>(layers.size()), kMaxLayers);
+	pShaderProg_->set1i("layerCount", layerCount);
+	for (int i = 0; i < layerCount; ++i)
+		pShaderProg_->set1i("layers[" + std::to_string(i) + "]", layers[i]);
+
 	// skybox cube
 	glBindVertexArray(VAO_);
 
 	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, FrameTexID);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, FrameArrayID);
 	glDrawArrays(GL_TRIANGLES, 0, 6);
 
 	glBindVertexArray(0);
@@ -75,7 +82,7 @@ void CGLFrame::move(const QPoint& pos, const float& scale)
 {
 	if (isMoving_)
 	{
-		// ֮1.0ȥ꣬Ϊx,yֵ[0, 2]Ҫӳ䵽[-1, 1]ķΧڣͬʱתxy
+		// 这里之所以用1.0减去坐标，是因为计算后的x,y坐标值域∈[0, 2]，而我们需要将其映射到[-1, 1]的范围内，同时反转x，y轴
 		float x = 1.0f - pos.x() * 2.0 / 1920;
 		float y = 1.0f - pos.y() * 2.0 / 1080;
 		qDebug() << "move pos: " << x << " " << y;
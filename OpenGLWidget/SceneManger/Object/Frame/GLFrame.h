@@ -2,6 +2,7 @@
 
 #include <QObject>
 #include <gl/GL.h>
+#include <vector>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -17,7 +18,15 @@ public:
 	~CGLFrame();
 
     void initialize();
-    void draw(const glm::mat4& view, const glm::mat4& projection, const GLuint& FrameTexID);
+    // 最多合成的摄像头路数，与 frame.fs 中的 layers 数组一致
+    static const int kMaxLayers = 4;
+
+    /**
+     * @brief 一次绘制合成多路摄像头画面。
+     * @param FrameArrayID 各路输出所在的纹理数组
+     * @param layers 参与合成的各路当前帧所在的层，超过 kMaxLayers 的忽略
+     */
+    void draw(const glm::mat4& view, const glm::mat4& projection, const GLuint& FrameArrayID, const std::vector<int>& layers);
     void move(const QPoint& pos, const float& scale);
 
 private:
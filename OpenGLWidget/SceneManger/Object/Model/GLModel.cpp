@@ -33,7 +33,7 @@ void CGLModel::loadModel(const QString& fileName)
 	while (!input.atEnd())
 	{
 		QString str = input.readLine();
-		// listʾһ
+		// 这个list表示的是一行数据
 		QStringList list = str.split(" ");
 
 		if (list[0] == "#") {
@@ -44,22 +44,22 @@ void CGLModel::loadModel(const QString& fileName)
 			qDebug() << "File with materials:" << list[1];
 			continue;
 		}
-		else if (list[0] == "v") {  //  v ͷжһζ
+		else if (list[0] == "v") {  // 以 v 开头的行定义了一个几何顶点
 			pos.append(vec3f{ list[1].toFloat(), list[2].toFloat(), list[3].toFloat() });
 			continue;
 		}
-		else if (list[0] == "vt") { //  vt ͷжһ
+		else if (list[0] == "vt") { // 以 vt 开头的行定义了一个纹理坐标
 			uv.append(vec2f{ list[1].toFloat(), list[2].toFloat() });
 			continue;
 		}
-		else if (list[0] == "vn") { //  vn ͷжһ㷨
+		else if (list[0] == "vn") { // 以 vn 开头的行定义了一个顶点法线
 			norm.append(vec3f{ list[1].toFloat(), list[2].toFloat(), list[3].toFloat() });
 			continue;
 		}
-		else if (list[0] == "f") {  //  f ͷжһ棬ͨǰĶ㡢ͷߵ
+		else if (list[0] == "f") {  // 以 f 开头的行定义一个多边形面，通过引用先前定义的顶点、纹理坐标和法线的索引来构建几何体
 			for (int i = 1; i <= 3; ++i) {
 
-				// list[i] ĸʽΪ "v/vt/vn" v Ƕvt vn Ƿ
+				// list[i] 的格式为 "v/vt/vn"，其中 v 是顶点索引，vt 是纹理坐标索引，vn 是法线索引
 				QStringList attrIdx = list[i].split("/");
 				vertices_.append(
 					VertexAttr{
@@ -86,10 +86,10 @@ void CGLModel::readvi(const QVector<VertexAttr>& vertices, const QVector<GLuint>
 {
 
 	QFile file("D:/LMEngine.txt");
-	//ļ򴴽
+	//打开文件，不存在则创建
 	file.open(QIODevice::Truncate | QIODevice::WriteOnly| QIODevice::Text);
 	QTextStream out(&file);
-	//дļҪַΪQByteArrayʽ
+	//写入文件需要字符串为QByteArray格式
 	for (int i = 0; i < vertices.size(); i++)
 	{
 		out << "pos: " << vertices[i].pos.x << " " << vertices[i].pos.y << " " << vertices[i].pos.z << "\n"
@@ -109,7 +109,7 @@ void CGLModel::readvi(const QVector<VertexAttr>& vertices, const QVector<GLuint>
 
 void CGLModel::initialize(const QString& fileName)
 {
-	// ʼ
+	// 初始化
 	initializeOpenGLFunctions();
 	loadModel(fileName);
     calculateTBN();
@@ -124,7 +124,7 @@ void CGLModel::initialize(const QString& fileName)
 	
 
     pMesh_->initialize(vertices_, indices_);
-	// pMesh_ڲVAO,VBO,EBOȣɹͲҪvertices_indices_
+	// pMesh_将会在内部创建VAO,VBO,EBO等，创建成功后就不需要vertices_和indices_了
     vertices_.clear();
     indices_.clear();
 }
@@ -139,18 +139,18 @@ void CGLModel::draw(const glm::mat4& view, const glm::mat4& projection, const gl
 	pMesh_->draw(view, projection, lightPos, viewPos);
 }
 
-void CGLModel::move(const QPoint& pos, const float& scale)
+void CGLModel::move(const QPointF& pos, const float& scale)
 {
-	// ģ͵M󼴿
+	// 更改模型的M矩阵即可
 	pMesh_->move(pos, scale);
 }
 
 void CGLModel::calculateTBN()
 {
-	// Ϊһ飬TBN󣨼TBNռϵɫ˷߾תռϵ
+	// 以三个顶点为一组，计算这三个顶点的TBN矩阵（计算出来的TBN矩阵基于物体空间坐标系，在着色器中需左乘法线矩阵转换到世界空间坐标系）
 	for (int i = 0; i < vertices_.size(); i += 3)
 	{
-		// ߺ͸ߣTBNеTB
+		// 计算切线和副切线，计算结果不是TBN矩阵中的T和B
 		float deltaU1 = vertices_[i + 1].uv.x - vertices_[i].uv.x;
 		float deltaU2 = vertices_[i + 2].uv.x - vertices_[i].uv.x;
 
@@ -175,20 +175,20 @@ void CGLModel::calculateTBN()
 
 		glm::vec3 bitangent = mu * glm::vec3{ -deltaU2 * E1 - deltaU1 * E2 };
 
-		// ʱǵõtagentbitangentǣ1. ûкͷ2. ûйһ
+		// 此时我们得到了tagent和bitangent，但他们：1. 没有和法线正交化；2. 没有归一化
 
-		// ʩ
+		// 施密特正交化
 		glm::vec3 normal = {
 			vertices_[i].norm.x,
 			vertices_[i].norm.y,
 			vertices_[i].norm.z
 		};
-		//											// ߵķ				// ˽ʾtagentڷ߷ϵͶӰ
+		//											// 法线的方向				// 点乘结果表示tagent在法线方向上的投影长度
 		glm::vec3 T = glm::normalize(tagent - glm::normalize(normal) * glm::dot(tagent, glm::normalize(normal)));
 		glm::vec3 B = glm::normalize(glm::cross(normal, T));
 		glm::vec3 N = glm::normalize(normal);
 
-		// עռϵ
+		// 注意结果基于物体空间坐标系
 		for (int j = 0; j < 3; j++)
 		{
 			vertices_[i + j].tan.x = T.x;
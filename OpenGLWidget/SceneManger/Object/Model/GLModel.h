@@ -21,7 +21,7 @@ public:
 
     void initialize(const QString& fileName);
     void draw(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& lightPos, const glm::vec3& viewPos);
-    void move(const QPoint& pos, const float& scale);
+    void move(const QPointF& pos, const float& scale);
 
 private:
     void loadModel(const QString& filePath);
@@ -31,7 +31,7 @@ private:
 private:
     CGLMesh* pMesh_ = nullptr;
 
-    // vertices[i]indices[i]ֱʾ һ ĶԣVBOEBO
+    // vertices[i]和indices[i]分别表示 一个顶点 的顶点属性（VBO）和索引（EBO）
     // QVector<T> is one of Qt's generic container classes. It stores its items in adjacent memory locations and provides fast index-based access.
     QVector<VertexAttr> vertices_{};
     QVector<GLuint> indices_{};
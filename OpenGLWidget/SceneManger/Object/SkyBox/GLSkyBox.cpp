@@ -15,16 +15,16 @@ CGLSkybox::~CGLSkybox()
 
 void CGLSkybox::initialize()
 {
-	// ʼ
+	// 初始化
 	initializeOpenGLFunctions();
 
-	/*********************************** ʼɫ ***********************************/
+	/*********************************** 初始化着色器程序对象 ***********************************/
 	pShaderProg_->initialize(
 		":/shaders/Resource/shaders/skyBox.vs",
 		":/shaders/Resource/shaders/skyBox.fs"
 	);
 
-	/*********************************** ʼVAO,VBO,EBO,texture ***********************************/
+	/*********************************** 初始化VAO,VBO,EBO,texture ***********************************/
 	// ------------------------- VAO -------------------------
 	GLuint VAO = 0;
 	glGenVertexArrays(1, &VAO);
@@ -34,15 +34,15 @@ void CGLSkybox::initialize()
 	GLuint VBO = 0;
 	glGenBuffers(1, &VBO);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	// ݴ
+	// 将数据传至缓存
 	glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), skyboxVertices, GL_STATIC_DRAW);
 
-	// λ
+	// 设置位置属性
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
 	glEnableVertexAttribArray(0);
 
-	// ------------------------- պ -------------------------
-	// x -> x -> y -> y -> z -> z
+	// ------------------------- 加载天空盒 -------------------------
+	// 正x -> 负x -> 正y -> 负y -> 正z -> 负z
 	QStringList texList{
 		":/images/Resource/images/skyBox_right.jpg",
 		":/images/Resource/images/skyBox_left.jpg",
@@ -54,7 +54,7 @@ void CGLSkybox::initialize()
 	skyBoxTexID_ = loadskyBoxTexture(texList);
 
 	pShaderProg_->use();
-	pShaderProg_->set1i("skybox", 0);	// Ԫ0
+	pShaderProg_->set1i("skybox", 0);	// 绑定纹理单元0
 	pShaderProg_->unuse();
 
 	VAO_ = VAO;
@@ -97,8 +97,8 @@ GLuint CGLSkybox::loadskyBoxTexture(QStringList& fileList)
 	for (int i = 0; i < fileList.size(); i++)
 	{
 		QImage imgContainer{ fileList[i] };
-		QImage rgba1 = imgContainer.rgbSwapped(); //qimageصɫͨ˳openglʾɫͨ˳һ,RͨBͨһԶһalphaͨ
-		//rgba1 = rgba1.mirrored();	// պеԭϽǣqimageԭҲϽǣԲҪת
+		QImage rgba1 = imgContainer.rgbSwapped(); //qimage加载的颜色通道顺序和opengl显示的颜色通道顺序不一致,调换R通道和B通道，且会自动添加一个alpha通道
+		//rgba1 = rgba1.mirrored();	// 天空盒的原点在左上角，qimage的原点也在左上角，所以不需要翻转
 
 		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGBA, rgba1.width(), rgba1.height(),
 			0, GL_RGBA, GL_UNSIGNED_BYTE, rgba1.bits());
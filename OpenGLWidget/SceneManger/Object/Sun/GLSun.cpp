@@ -16,16 +16,16 @@ CGLSun::~CGLSun()
 
 void CGLSun::initialize()
 {
-	// ʼ
+	// 初始化
 	initializeOpenGLFunctions();
 
-	/*********************************** ʼɫ ***********************************/
+	/*********************************** 初始化着色器程序对象 ***********************************/
 	pShaderProg_->initialize(
 		":/shaders/Resource/shaders/sun.vs",
 		":/shaders/Resource/shaders/sun.fs"
 	);
 
-	/*********************************** ʼVAO,VBO,EBO,texture ***********************************/
+	/*********************************** 初始化VAO,VBO,EBO,texture ***********************************/
 
 	// ------------------------- lightVAO -------------------------
 	GLuint lightVAO = 0;
@@ -36,10 +36,10 @@ void CGLSun::initialize()
 	GLuint lightVBO = 0;
 	glGenBuffers(1, &lightVBO);
 	glBindBuffer(GL_ARRAY_BUFFER, lightVBO);
-	// ݴ
+	// 将数据传至缓存
 	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices_), vertices_, GL_STATIC_DRAW);
 
-	// λ
+	// 设置位置属性
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
 	glEnableVertexAttribArray(0);
 
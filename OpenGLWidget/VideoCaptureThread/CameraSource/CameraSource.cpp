@@ -0,0 +1,545 @@
+#include "CameraSource.h"
+
+#include <QDebug>
+#include <chrono>
+#include <algorithm>
+#ifdef _WIN32
+#include <QCameraInfo>
+#endif
+
+#include "Common/MediaClock.h"
+
+extern "C" {
+#include <libavutil/imgutils.h>
+}
+
+CCameraSource::CCameraSource()
+{
+    av_register_all();
+    avdevice_register_all();
+}
+
+CCameraSource::~CCameraSource()
+{
+    close();
+}
+
+bool CCameraSource::open(const CameraCfg& cfg)
+{
+    close();
+    cfg_ = cfg;
+    // 打开设备期间的中断回调也检查该标志
+    isRunning_.store(true);
+
+    // ------------------------- 优先按请求的格式打开设备（或文件） -------------------------
+    if ((cfg_.format_ != CameraFormat::OPENCV || !cfg_.file_.empty()) && openDevice())
+    {
+        for (auto& worker : workers_)
+            worker->thread = std::thread(&CCameraSource::decodeLoop, this, worker.get());
+        readThread_ = std::thread(&CCameraSource::readLoop, this);
+        return true;
+    }
+
+    // ------------------------- 回退到 OpenCV 的默认采集方式 -------------------------
+    if (cfg_.file_.empty() && openOpenCV())
+    {
+        readThread_ = std::thread(&CCameraSource::opencvLoop, this);
+        return true;
+    }
+
+    isRunning_.store(false);
+    qCritical() << "Failed to open camera.";
+    return false;
+}
+
+void CCameraSource::close()
+{
+    isRunning_.store(false);
+    if (readThread_.joinable())
+        readThread_.join();
+    for (auto& worker : workers_)
+    {
+        if (worker->thread.joinable())
+            worker->thread.join();
+        PendingPacket pending;
+        while (worker->input.tryPop(pending))
+            av_packet_free(&pending.packet);
+        avcodec_free_context(&worker->codecCtx);
+        av_frame_free(&worker->frame);
+    }
+    workers_.clear();
+
+    if (fmtCtx_)
+        avformat_close_input(&fmtCtx_);
+    streamIndex_ = -1;
+    needDecode_ = false;
+    dropWhenBusy_ = false;
+    frameIntervalUs_ = 0;
+    if (videoCapture_.isOpened())
+        videoCapture_.release();
+
+    for (Slot& slot : slots_)
+    {
+        av_packet_free(&slot.packet);
+        av_frame_free(&slot.frame);
+        slot.image.release();
+        slot.view = CameraImage{};
+    }
+    mailbox_.store(1);
+    publishIndex_ = 0;
+    consumeIndex_ = 2;
+    publishedSeq_ = -1;
+}
+
+bool CCameraSource::acquireLatest(CameraImage& image, int64_t& grabUs)
+{
+    if (!(mailbox_.load(std::memory_order_acquire) & kFreshFlag))
+        return false;
+
+    // 交出自己持有的槽，换回信箱中最新的一帧
+    consumeIndex_ = mailbox_.exchange(consumeIndex_, std::memory_order_acq_rel) & ~kFreshFlag;
+    const Slot& slot = slots_[consumeIndex_];
+    image = slot.view;
+    grabUs = slot.grabUs;
+    return true;
+}
+
+void CCameraSource::publish(Slot& staging)
+{
+    std::lock_guard<std::mutex> lock{ publishMtx_ };
+
+    // 解码线程乱序完成时，比已发布的帧更旧的帧直接丢弃
+    if (staging.seq <= publishedSeq_)
+    {
+        staleFrames_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    publishedSeq_ = staging.seq;
+
+    // 生产者持有的槽中是已经用过的数据，先释放引用再和 staging 交换
+    Slot& slot = slots_[publishIndex_];
+    clearSlot(slot);
+    std::swap(slot.packet, staging.packet);
+    std::swap(slot.frame, staging.frame);
+    cv::swap(slot.image, staging.image);
+    std::swap(slot.view, staging.view);
+    slot.grabUs = staging.grabUs;
+    slot.seq = staging.seq;
+
+    // 原来的帧还没被取走说明使用者跟不上，该帧被丢弃
+    const int previous = mailbox_.exchange(publishIndex_ | kFreshFlag, std::memory_order_acq_rel);
+    if (previous & kFreshFlag)
+        staleFrames_.fetch_add(1, std::memory_order_relaxed);
+    publishIndex_ = previous & ~kFreshFlag;
+}
+
+bool CCameraSource::openDevice()
+{
+    // ------------------------- 设备和格式协商 -------------------------
+    AVInputFormat* inputFormat = nullptr;
+    std::string url;
+    AVDictionary* options = nullptr;
+
+    if (!cfg_.file_.empty())
+    {
+        url = cfg_.file_;
+    }
+    else
+    {
+#ifdef _WIN32
+        inputFormat = av_find_input_format("dshow");
+        std::string name = cfg_.device_.empty() ? QCameraInfo::defaultCamera().description().toStdString() : cfg_.device_;
+        url = "video=" + name;
+        const char* formatKey = nullptr;
+#else
+        inputFormat = av_find_input_format("v4l2");
+        url = cfg_.device_.empty() ? "/dev/video0" : cfg_.device_;
+        const char* formatKey = "input_format";
+#endif
+        if (!inputFormat)
+        {
+            qWarning() << "Camera input device support is not available in libavdevice.";
+            return false;
+        }
+
+        const std::string videoSize = std::to_string(cfg_.width_) + "x" + std::to_string(cfg_.height_);
+        av_dict_set(&options, "video_size", videoSize.c_str(), 0);
+        av_dict_set_int(&options, "framerate", cfg_.fps_, 0);
+        switch (cfg_.format_)
+        {
+        case CameraFormat::MJPEG:
+            // dshow 用 vcodec 请求压缩格式，v4l2 统一用 input_format
+            av_dict_set(&options, formatKey ? formatKey : "vcodec", "mjpeg", 0);
+            break;
+        case CameraFormat::YUYV:
+            av_dict_set(&options, formatKey ? formatKey : "pixel_format", "yuyv422", 0);
+            break;
+        case CameraFormat::NV12:
+            av_dict_set(&options, formatKey ? formatKey : "pixel_format", "nv12", 0);
+            break;
+        default:
+            break;
+        }
+    }
+
+    fmtCtx_ = avformat_alloc_context();
+    fmtCtx_->interrupt_callback.callback = &CCameraSource::interruptCallback;
+    fmtCtx_->interrupt_callback.opaque = this;
+    int ret = avformat_open_input(&fmtCtx_, url.c_str(), inputFormat, &options);
+    av_dict_free(&options);
+    if (ret < 0)
+    {
+        char err[AV_ERROR_MAX_STRING_SIZE] = { 0 };
+        av_strerror(ret, err, sizeof(err));
+        qWarning() << "Failed to open camera" << url.c_str() << ":" << err;
+        return false;
+    }
+
+    if (avformat_find_stream_info(fmtCtx_, nullptr) < 0 ||
+        (streamIndex_ = av_find_best_stream(fmtCtx_, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0)) < 0)
+    {
+        qWarning() << "No video stream in" << url.c_str();
+        avformat_close_input(&fmtCtx_);
+        return false;
+    }
+
+    const AVStream* stream = fmtCtx_->streams[streamIndex_];
+    const AVCodecParameters* codecpar = stream->codecpar;
+    frameWidth_ = codecpar->width;
+    frameHeight_ = codecpar->height;
+
+    // ------------------------- 原始数据直接上传，其余格式需要解码 -------------------------
+    const AVPixelFormat pixFmt = static_cast<AVPixelFormat>(codecpar->format);
+    if (codecpar->codec_id == AV_CODEC_ID_RAWVIDEO && (pixFmt == AV_PIX_FMT_YUYV422 || pixFmt == AV_PIX_FMT_NV12))
+    {
+        rawLayout_ = pixFmt == AV_PIX_FMT_YUYV422 ? PixelLayout::YUYV : PixelLayout::NV12;
+        needDecode_ = false;
+    }
+    else
+    {
+        needDecode_ = true;
+        if (!openDecoders(codecpar))
+        {
+            avformat_close_input(&fmtCtx_);
+            return false;
+        }
+    }
+
+    // 文件源按帧率播放，设备源由设备决定节奏
+    if (!cfg_.file_.empty())
+    {
+        const AVRational rate = stream->avg_frame_rate;
+        frameIntervalUs_ = (rate.num > 0 && rate.den > 0) ? av_rescale(1000000, rate.den, rate.num) : 1000000 / std::max(1, cfg_.fps_);
+    }
+
+    qInfo() << "Camera opened:" << url.c_str() << frameWidth_ << "x" << frameHeight_
+        << "codec" << avcodec_get_name(codecpar->codec_id)
+        << "pixel format" << (av_get_pix_fmt_name(pixFmt) ? av_get_pix_fmt_name(pixFmt) : "none")
+        << "decode threads" << workers_.size();
+    return true;
+}
+
+bool CCameraSource::openDecoders(const AVCodecParameters* codecpar)
+{
+    AVCodec* codec = avcodec_find_decoder(codecpar->codec_id);
+    if (!codec)
+    {
+        qWarning() << "No decoder for camera codec" << avcodec_get_name(codecpar->codec_id);
+        return false;
+    }
+
+    // MJPEG 每帧独立，可以分给多个解码器并行解码；其他编码的帧之间有依赖，只用一个解码器
+    dropWhenBusy_ = codecpar->codec_id == AV_CODEC_ID_MJPEG;
+    const int count = dropWhenBusy_ ? std::max(1, cfg_.decodeThreads_) : 1;
+    for (int i = 0; i < count; ++i)
+    {
+        std::unique_ptr<DecodeWorker> worker{ new DecodeWorker{} };
+        worker->codecCtx = avcodec_alloc_context3(codec);
+        worker->frame = av_frame_alloc();
+        if (!worker->codecCtx || !worker->frame ||
+            avcodec_parameters_to_context(worker->codecCtx, codecpar) < 0)
+        {
+            qWarning() << "Failed to allocate camera decoder.";
+            avcodec_free_context(&worker->codecCtx);
+            av_frame_free(&worker->frame);
+            return false;
+        }
+        worker->codecCtx->thread_count = 1;
+        if (avcodec_open2(worker->codecCtx, codec, nullptr) < 0)
+        {
+            qWarning() << "Failed to open camera decoder.";
+            avcodec_free_context(&worker->codecCtx);
+            av_frame_free(&worker->frame);
+            return false;
+        }
+        workers_.push_back(std::move(worker));
+    }
+    return true;
+}
+
+bool CCameraSource::openOpenCV()
+{
+    qWarning() << "Falling back to OpenCV capture (BGR).";
+    videoCapture_.open(0);
+    if (!videoCapture_.isOpened())
+    {
+        qDebug() << "Error,can't open camera device.";
+        return false;
+    }
+    videoCapture_.set(cv::CAP_PROP_FRAME_WIDTH, cfg_.width_);
+    videoCapture_.set(cv::CAP_PROP_FRAME_HEIGHT, cfg_.height_);
+    videoCapture_.set(cv::CAP_PROP_FPS, cfg_.fps_);
+    return true;
+}
+
+void CCameraSource::readLoop()
+{
+    AVPacket* packet = av_packet_alloc();
+    Slot staging;
+    int64_t seq = 0;
+    size_t nextWorker = 0;
+    int64_t nextReadUs = 0;
+
+    while (isRunning_.load())
+    {
+        // ------------------------- 文件源按帧率读取 -------------------------
+        if (frameIntervalUs_ > 0)
+        {
+            const int64_t nowUs = CMediaClock::nowUs();
+            if (nextReadUs > nowUs)
+                std::this_thread::sleep_for(std::chrono::microseconds(nextReadUs - nowUs));
+            nextReadUs = std::max(nextReadUs, nowUs) + frameIntervalUs_;
+        }
+
+        const int ret = av_read_frame(fmtCtx_, packet);
+        if (ret < 0)
+        {
+            if (ret == AVERROR_EOF && !cfg_.file_.empty())
+                av_seek_frame(fmtCtx_, streamIndex_, 0, AVSEEK_FLAG_BACKWARD); // 文件读完从头循环
+            else
+                std::this_thread::sleep_for(std::chrono::milliseconds(ret == AVERROR(EAGAIN) ? 1 : 10));
+            continue;
+        }
+        if (packet->stream_index != streamIndex_)
+        {
+            av_packet_unref(packet);
+            continue;
+        }
+        const int64_t grabUs = CMediaClock::nowUs();
+
+        if (!needDecode_)
+        {
+            // ------------------------- YUYV、NV12：引用数据包，直接发布 -------------------------
+            if (!staging.packet)
+                staging.packet = av_packet_alloc();
+            clearSlot(staging);
+            if (av_packet_ref(staging.packet, packet) == 0)
+            {
+                staging.grabUs = grabUs;
+                staging.seq = seq;
+                if (fillPacketView(staging, rawLayout_, frameWidth_, frameHeight_))
+                    publish(staging);
+            }
+        }
+        else
+        {
+            // ------------------------- 交给有空闲的解码线程 -------------------------
+            // MJPEG 都忙时丢弃该帧；其他编码（如文件中的 H.264）丢包会破坏后续帧的参考，等待解码线程取走
+            PendingPacket pending{ av_packet_clone(packet), grabUs, seq };
+            bool queued = false;
+            while (pending.packet && isRunning_.load())
+            {
+                for (size_t i = 0; i < workers_.size() && !queued; ++i)
+                {
+                    DecodeWorker* worker = workers_[(nextWorker + i) % workers_.size()].get();
+                    queued = worker->input.tryPush(pending);
+                }
+                if (queued || dropWhenBusy_)
+                    break;
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            nextWorker = (nextWorker + 1) % workers_.size();
+            if (!queued)
+            {
+                av_packet_free(&pending.packet);
+                if (dropWhenBusy_)
+                    staleFrames_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        ++seq;
+        av_packet_unref(packet);
+    }
+
+    av_packet_free(&packet);
+    av_packet_free(&staging.packet);
+    av_frame_free(&staging.frame);
+}
+
+void CCameraSource::opencvLoop()
+{
+    Slot staging;
+    int64_t seq = 0;
+
+    while (isRunning_.load())
+    {
+        // grab()只从驱动取出一帧，不做解码和颜色转换；驱动中总有空闲缓冲区，取到的总是刚拍到的帧
+        if (!videoCapture_.grab())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        staging.grabUs = CMediaClock::nowUs();
+        if (!videoCapture_.retrieve(staging.image) || staging.image.empty())
+            continue;
+
+        // publish 后 staging.image 换成信箱中的旧帧，下次 retrieve 复用其内存
+        staging.view = CameraImage{};
+        staging.view.layout = (1 == staging.image.channels()) ? PixelLayout::GRAY : PixelLayout::BGR;
+        staging.view.width = staging.image.cols;
+        staging.view.height = staging.image.rows;
+        staging.view.data[0] = staging.image.data;
+        staging.view.stride[0] = static_cast<int>(staging.image.step);
+        staging.seq = seq++;
+        publish(staging);
+    }
+}
+
+void CCameraSource::decodeLoop(DecodeWorker* worker)
+{
+    Slot staging;
+
+    while (isRunning_.load())
+    {
+        PendingPacket pending;
+        if (!worker->input.tryPop(pending))
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        const int ret = avcodec_send_packet(worker->codecCtx, pending.packet);
+        av_packet_free(&pending.packet);
+        if (ret < 0)
+            continue;
+
+        while (avcodec_receive_frame(worker->codecCtx, worker->frame) == 0)
+        {
+            // publish 会把 staging 中的对象换走，这里按需重新分配
+            if (!staging.frame)
+                staging.frame = av_frame_alloc();
+            clearSlot(staging);
+            av_frame_move_ref(staging.frame, worker->frame);
+            staging.grabUs = pending.grabUs;
+            staging.seq = pending.seq;
+            if (fillFrameView(staging))
+                publish(staging);
+        }
+    }
+
+    av_packet_free(&staging.packet);
+    av_frame_free(&staging.frame);
+}
+
+bool CCameraSource::fillPacketView(Slot& slot, PixelLayout layout, int width, int height)
+{
+    CameraImage& view = slot.view;
+    view = CameraImage{};
+    view.layout = layout;
+    view.width = width;
+    view.height = height;
+    view.fullRange = false;     // 摄像头输出的原始 YUV 为有限范围
+    view.data[0] = slot.packet->data;
+
+    int expected = 0;
+    if (layout == PixelLayout::YUYV)
+    {
+        view.stride[0] = width * 2;
+        expected = width * height * 2;
+    }
+    else
+    {
+        // NV12：UV平面紧跟在Y平面之后，每行字节数与Y相同
+        view.stride[0] = width;
+        view.data[1] = slot.packet->data + static_cast<size_t>(width) * height;
+        view.stride[1] = width;
+        expected = width * height * 3 / 2;
+    }
+
+    if (slot.packet->size < expected)
+    {
+        qWarning() << "Camera packet too small:" << slot.packet->size << "expected" << expected;
+        return false;
+    }
+    return true;
+}
+
+bool CCameraSource::fillFrameView(Slot& slot)
+{
+    const AVFrame* frame = slot.frame;
+    CameraImage& view = slot.view;
+    view = CameraImage{};
+    view.width = frame->width;
+    view.height = frame->height;
+    // YUVJ 格式及标明 JPEG 范围的帧为全范围，其余（包括未标明的）按有限范围处理
+    view.fullRange = frame->color_range == AVCOL_RANGE_JPEG || frame->format == AV_PIX_FMT_YUVJ420P || frame->format == AV_PIX_FMT_YUVJ422P;
+
+    // MJPEG 通常解码为 YUVJ422P 或 YUVJ420P，直接按平面上传
+    switch (frame->format)
+    {
+    case AV_PIX_FMT_YUV420P:
+    case AV_PIX_FMT_YUVJ420P:
+        view.layout = PixelLayout::I420;
+        break;
+    case AV_PIX_FMT_YUV422P:
+    case AV_PIX_FMT_YUVJ422P:
+        view.layout = PixelLayout::I422;
+        break;
+    case AV_PIX_FMT_NV12:
+        view.layout = PixelLayout::NV12;
+        break;
+    case AV_PIX_FMT_YUYV422:
+        view.layout = PixelLayout::YUYV;
+        break;
+    case AV_PIX_FMT_GRAY8:
+        view.layout = PixelLayout::GRAY;
+        break;
+    case AV_PIX_FMT_BGR24:
+        view.layout = PixelLayout::BGR;
+        break;
+    default:
+    {
+        static bool warned = false;
+        if (!warned)
+        {
+            warned = true;
+            const char* name = av_get_pix_fmt_name(static_cast<AVPixelFormat>(frame->format));
+            qWarning() << "Unsupported camera pixel format:" << (name ? name : "unknown");
+        }
+        return false;
+    }
+    }
+
+    for (int i = 0; i < 3; ++i)
+    {
+        view.data[i] = frame->data[i];
+        view.stride[i] = frame->linesize[i];
+    }
+    return true;
+}
+
+void CCameraSource::clearSlot(Slot& slot)
+{
+    // cv::Mat 保留内存，供下一次 retrieve 复用
+    if (slot.packet)
+        av_packet_unref(slot.packet);
+    if (slot.frame)
+        av_frame_unref(slot.frame);
+    slot.view = CameraImage{};
+}
+
+int CCameraSource::interruptCallback(void* opaque)
+{
+    // 返回非0时阻塞中的 av_read_frame / avformat_open_input 立即返回
+    return static_cast<CCameraSource*>(opaque)->isRunning_.load() ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+extern "C" {
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavdevice/avdevice.h>
+}
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <memory>
+
+#include "Common/DataDefine.h"
+#include "Common/SPSCRingBuffer.h"
+
+/*
+ * 摄像头采集源：按 CameraCfg 协商采集格式（MJPEG、YUYV、NV12）、分辨率和帧率，
+ * 通过 libavdevice（Windows 下为 dshow，其他平台为 v4l2）读取原始数据，不经过 OpenCV 的 BGR 转换。
+ * - YUYV、NV12：数据包直接作为一帧交给上传阶段（只增加引用计数，不拷贝）
+ * - MJPEG：数据包轮流分给解码线程池，每个线程有独立的解码器，直接解码为平面YUV
+ * - 协商失败或指定 CameraFormat::OPENCV 时回退到 cv::VideoCapture（BGR）
+ * - 指定 file_ 时从文件读取，按帧率循环播放，用于没有摄像头时测试
+ *
+ * 只保留最新的一帧（单槽信箱），使用者总是拿到最新的一帧，处理不及时的帧被直接覆盖。
+ */
+class CCameraSource
+{
+public:
+    CCameraSource();
+    ~CCameraSource();
+
+    CCameraSource(const CCameraSource&) = delete;
+    CCameraSource& operator=(const CCameraSource&) = delete;
+
+    /**
+     * @brief 打开摄像头（或文件）并启动采集线程。
+     * @return 所有方式都打开失败时返回false
+     */
+    bool open(const CameraCfg& cfg);
+
+    // 停止采集线程并关闭设备
+    void close();
+
+    /**
+     * @brief [使用者线程调用] 取得最新的一帧。
+     * @param image 输出该帧，数据在下一次调用 acquireLatest 前有效
+     * @param grabUs 输出从设备取到该帧的时间（CMediaClock）
+     * @return 没有新帧时返回false
+     */
+    bool acquireLatest(CameraImage& image, int64_t& grabUs);
+
+    // 被更新的帧覆盖、未处理就丢弃的帧数（MJPEG 解码线程都忙时丢弃的帧也计入）
+    uint64_t staleFrames() const { return staleFrames_.load(std::memory_order_relaxed); }
+
+private:
+    // 信箱中的一帧，数据由以下三者之一持有
+    struct Slot
+    {
+        AVPacket* packet = nullptr;     // YUYV、NV12 的原始数据
+        AVFrame* frame = nullptr;       // 解码结果
+        cv::Mat image;                  // OpenCV 采集的 BGR 帧
+        CameraImage view;
+        int64_t grabUs = 0;
+        int64_t seq = 0;                // 采集顺序，解码线程可能乱序完成
+    };
+
+    // 交给解码线程的数据包
+    struct PendingPacket
+    {
+        AVPacket* packet = nullptr;
+        int64_t grabUs = 0;
+        int64_t seq = 0;
+    };
+
+    struct DecodeWorker
+    {
+        AVCodecContext* codecCtx = nullptr;
+        AVFrame* frame = nullptr;
+        SpscQueue<PendingPacket, 4> input;
+        std::thread thread;
+    };
+
+    bool openDevice();
+    bool openDecoders(const AVCodecParameters* codecpar);
+    bool openOpenCV();
+
+    // 读取线程：libavdevice / 文件
+    void readLoop();
+    // 读取线程：OpenCV
+    void opencvLoop();
+    void decodeLoop(DecodeWorker* worker);
+
+    // [生产者调用] 把 staging 中的一帧放进信箱，staging 换回信箱中的旧数据（由调用者复用）
+    void publish(Slot& staging);
+
+    static bool fillPacketView(Slot& slot, PixelLayout layout, int width, int height);
+    static bool fillFrameView(Slot& slot);
+    static void clearSlot(Slot& slot);
+
+    static int interruptCallback(void* opaque);
+
+private:
+    CameraCfg cfg_;
+    std::atomic<bool> isRunning_{ false };
+
+    AVFormatContext* fmtCtx_ = nullptr;
+    int streamIndex_ = -1;
+    PixelLayout rawLayout_ = PixelLayout::YUYV;
+    bool needDecode_ = false;
+    bool dropWhenBusy_ = false;         // 解码线程都忙时丢弃数据包，只有帧间无依赖的 MJPEG 可以丢
+    int frameWidth_ = 0;
+    int frameHeight_ = 0;
+    int64_t frameIntervalUs_ = 0;       // 文件源的播放间隔
+
+    cv::VideoCapture videoCapture_;
+
+    std::vector<std::unique_ptr<DecodeWorker>> workers_;
+    std::thread readThread_;
+
+    // ------------------------- 单槽信箱 -------------------------
+    // 三个槽分别由生产者、信箱和使用者持有，通过交换下标传递。
+    // 解码线程池有多个生产者，生产者之间用 publishMtx_ 串行（只交换引用，临界区很短），使用者不加锁
+    static const int kFreshFlag = 4;
+    Slot slots_[3];
+    std::atomic<int> mailbox_{ 1 };
+    int publishIndex_ = 0;
+    int consumeIndex_ = 2;
+    int64_t publishedSeq_ = -1;
+    std::mutex publishMtx_;
+    std::atomic<uint64_t> staleFrames_{ 0 };
+};
@@ -4,6 +4,8 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <QDebug>
 #include <QApplication>
+#include <chrono>
+#include <algorithm>
 #include "Facelandmark.h"
 
 VideoCaptureThread::VideoCaptureThread(QOpenGLContext* mainCtx, QOffscreenSurface* offScreenSurface, QObject *parent)
@@ -20,7 +22,7 @@ VideoCaptureThread::VideoCaptureThread(QOpenGLContext* mainCtx, QOffscreenSurfac
 		pRenderCtx_->moveToThread(this);
 	}
 
-	// GUI߳дGUI߳٣ǿȾ߳ʹá
+	// 离屏表面须在GUI线程中创建，GUI线程中销毁，但是可以在渲染线程中使用。
 	// https://doc.qt.io/archives/qt-5.15/qoffscreensurface.html#details
 	if (!pRenderSurface_)
 	{
@@ -33,15 +35,14 @@ VideoCaptureThread::VideoCaptureThread(QOpenGLContext* mainCtx, QOffscreenSurfac
 		pYuvDraw_->moveToThread(this);
 	}
 
-	connect(pYuvDraw_, &CYuvDraw::textureReady, this, [this](unsigned int texid) {
-		emit signal_NewYuvTexture(texid);
-	}, Qt::QueuedConnection);
+	connect(pYuvDraw_, &CYuvDraw::textureReady, this, &VideoCaptureThread::signal_FrameReady, Qt::DirectConnection);
 }
 
 VideoCaptureThread::~VideoCaptureThread()
 {
 	isRunning_ = false;
 	wait();
+	cameraSource_.close();
 }
 
 void VideoCaptureThread::initOpenCV(int w, int h)
@@ -49,13 +50,15 @@ void VideoCaptureThread::initOpenCV(int w, int h)
 	width_ = w;
 	height_ = h;
 
-	videoCapture_.open(0);
-	if (!videoCapture_.isOpened())
+	// 默认请求 MJPEG：同样的USB带宽下能达到 1080p30，解码由采集源的线程池完成
+	if (!cameraSource_.open(cameraCfg_))
 	{
 		qDebug() << "Error,can't open camera device.";
 	}
 
 	isRunning_ = true;
+	if (!trackFaces_)
+		return;
 
     //QString filePath = "D:/1_Code/QtCreator/LMEngine/facemodel";
 	//QString filePath = "D:/WorkSpace/Clion/GitHubProject/LMEngine/facemodel";
@@ -78,68 +81,181 @@ void VideoCaptureThread::updateWH(const int& w, const int& h)
 	pYuvDraw_->updateWH(w, h);
 }
 
+void VideoCaptureThread::setOutputLayers(GLuint arrayTexID, int firstLayer, int w, int h)
+{
+	pYuvDraw_->setOutputLayers(arrayTexID, firstLayer, w, h);
+}
+
+int VideoCaptureThread::acquireFrame()
+{
+	return pYuvDraw_->acquireFrame();
+}
+
 void VideoCaptureThread::run()
 {
 	pRenderCtx_->makeCurrent(pRenderSurface_);
 	initOpenCV(1920, 1080);
 	pYuvDraw_->initTexture();
 
-	while (isRunning_)
+	for (int i = 0; i < kTrackBufferCount; ++i)
+		(void)trackFreeQueue_.tryPush(i);
+
+	if (trackFaces_)
+		trackThread_ = std::thread(&VideoCaptureThread::trackLoop, this);
+
+	// ------------------------- 上传阶段 -------------------------
+	while (isRunning_.load())
 	{
-		cv::Mat videoFrame;
-		videoCapture_ >> videoFrame;
+		// 没有新帧时等待
+		CameraImage image{};
+		int64_t grabUs = 0;
+		if (!cameraSource_.acquireLatest(image, grabUs))
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			continue;
+		}
+
+		// 按摄像头的原始排列上传，CPU上不再缩放和转换颜色
+		// 离屏渲染结束后，直接把texID发送给OpenGLWidget进行渲染
+		pYuvDraw_->updateTexture(image);
 
-		if (!videoFrame.empty())
+		// 到了跟踪时间且跟踪阶段空闲时交给它一份拷贝
+		const int64_t nowUs = CMediaClock::nowUs();
+		int trackIndex = 0;
+		if (trackFaces_ && nowUs >= nextTrackUs_ && trackFreeQueue_.tryPop(trackIndex))
 		{
-			cv::resize(videoFrame, videoFrame, cv::Size(width_, height_));
-			FACETRACKER_API_facetracker_obj_track(videoFrame);
-			ofVec2f posVec2f = FACETRACKER_API_getPosition(videoFrame);
-			float currScale = FACETRACKER_API_getScale(videoFrame);
+			copyForTracking(image, trackFrames_[trackIndex]);
+			trackGrabUs_[trackIndex] = grabUs;
+			(void)trackQueue_.tryPush(trackIndex);
+			// 按固定节拍累加，与摄像头帧间隔不整除时也能保持设定的频率
+			if (trackCfg_.rateHz_ > 0)
+				nextTrackUs_ = std::max(nextTrackUs_ + 1000000 / trackCfg_.rateHz_, nowUs);
+		}
 
-			if (posVec2f.x != -1 && posVec2f.y != -1) {
-				QPoint facePoint = QPoint(posVec2f.x, posVec2f.y);
-				emit signal_NewFacePos(facePoint, currScale);
-				// qDebug() << "Face Position: " << facePoint << ", Scale: " << currentScale;
-			}
+		// ------------------------- 采集到纹理更新完成的延迟，每10秒输出一次 -------------------------
+		const int64_t latencyUs = nowUs - grabUs;
+		latencyUs_ = latencyUs_ == 0 ? latencyUs : latencyUs_ + (latencyUs - latencyUs_) / 8;
+		latencyMaxUs_ = std::max(latencyMaxUs_, latencyUs);
 
-			cv::Mat bgrCVFrame(videoFrame);
-			cv::Mat yuvCVFrame;
+		++uploadStats_.uploadedFrames;
+		uploadStats_.staleFrames = cameraSource_.staleFrames();
+		uploadStats_.trackedFrames = trackedFrames_.load(std::memory_order_relaxed);
+		uploadStats_.latencyMs = latencyUs_ / 1000.0;
+		uploadStats_.latencyMaxMs = latencyMaxUs_ / 1000.0;
+		stats_.write(uploadStats_);
+		if (latencyLogUs_ < 0)
+			latencyLogUs_ = nowUs;
+		else if (nowUs - latencyLogUs_ >= 10000000)
+		{
+			qInfo() << "Camera grab-to-texture latency:" << latencyUs_ / 1000.0 << "ms, max" << latencyMaxUs_ / 1000.0
+				<< "ms, stale frames skipped:" << cameraSource_.staleFrames();
+			latencyMaxUs_ = 0;
+			latencyLogUs_ = nowUs;
+		}
+	}
 
-			if (1 == videoFrame.channels()) {
-				// ǽvideoFrameGRAYתΪBGRʽbgrCVFrame
-				cv::cvtColor(videoFrame, bgrCVFrame, CV_GRAY2BGR);
-			}
-			// ͬϣbgrCVFrameBGRתΪYUV_I420ʽyuvCVFrame
-			cv::cvtColor(bgrCVFrame, yuvCVFrame, CV_BGR2YUV_I420);
+	// 停止采集后等待跟踪阶段退出
+	cameraSource_.close();
+	if (trackThread_.joinable())
+		trackThread_.join();
+
+	pRenderCtx_->doneCurrent();
+}
 
-			int lumaSize = width_ * height_;
-			// m_videoWidthm_videoHeightҪ1ٳ2ΪǵһͼƬĿ߿ΪҪ1
-			int uv_stride = (width_ + 1) / 2;
-			int uv_height = (height_ + 1) / 2;
-			int chromaSize = uv_stride * uv_height;
+void VideoCaptureThread::copyForTracking(const CameraImage& image, cv::Mat& dst)
+{
+	uint8_t* data = const_cast<uint8_t*>(image.data[0]);
+	switch (image.layout)
+	{
+	case PixelLayout::BGR:
+		cv::Mat(image.height, image.width, CV_8UC3, data, image.stride[0]).copyTo(dst);
+		break;
+	case PixelLayout::YUYV:
+		cv::cvtColor(cv::Mat(image.height, image.width, CV_8UC2, data, image.stride[0]), dst, cv::COLOR_YUV2GRAY_YUY2);
+		break;
+	default:
+		// 平面格式和 GRAY 的第一个平面就是亮度
+		cv::Mat(image.height, image.width, CV_8UC1, data, image.stride[0]).copyTo(dst);
+		break;
+	}
+}
 
-			uint8_t* Y_data_Dst = yuvCVFrame.data;
-			uint8_t* U_data_Dst = yuvCVFrame.data + lumaSize;
-			uint8_t* V_data_Dst = yuvCVFrame.data + lumaSize + chromaSize;
+cv::Rect VideoCaptureThread::trackRegion(const cv::Size& frameSize) const
+{
+	const cv::Rect frameRect{ cv::Point(0, 0), frameSize };
+	if (!faceFound_ || trackCfg_.roiFraction_ >= 1.0f)
+		return frameRect;
 
-			YUVFrame  yuvFrame{};
+	// 人脸仍在当前区域的中间一半内时区域保持不动，避免每次跟踪都重置跟踪器
+	if (trackRoi_.area() > 0)
+	{
+		const cv::Rect inner{ trackRoi_.x + trackRoi_.width / 4, trackRoi_.y + trackRoi_.height / 4,
+			trackRoi_.width / 2, trackRoi_.height / 2 };
+		if (inner.contains(cv::Point(faceCenter_)))
+			return trackRoi_;
+	}
 
-			yuvFrame.luma.dataBuffer = Y_data_Dst;
-			yuvFrame.luma.length = lumaSize;
+	const int roiWidth = static_cast<int>(frameSize.width * trackCfg_.roiFraction_);
+	const int roiHeight = static_cast<int>(frameSize.height * trackCfg_.roiFraction_);
+	const int x = std::min(std::max(static_cast<int>(faceCenter_.x) - roiWidth / 2, 0), frameSize.width - roiWidth);
+	const int y = std::min(std::max(static_cast<int>(faceCenter_.y) - roiHeight / 2, 0), frameSize.height - roiHeight);
+	return cv::Rect(x, y, roiWidth, roiHeight) & frameRect;
+}
 
-			yuvFrame.chromaB.dataBuffer = U_data_Dst;
-			yuvFrame.chromaB.length = chromaSize;
+void VideoCaptureThread::trackLoop()
+{
+	int index = 0;
+	while (waitPop(trackQueue_, index))
+	{
+		const cv::Mat& frame = trackFrames_[index];
+		const cv::Size frameSize = frame.size();
+		const int64_t grabUs = trackGrabUs_[index];
 
-			yuvFrame.chromaR.dataBuffer = V_data_Dst;
-			yuvFrame.chromaR.length = chromaSize;
+		// ------------------------- 裁剪到人脸附近并缩小 -------------------------
+		const cv::Rect roi = trackRegion(frameSize);
+		if (roi != trackRoi_)
+		{
+			// 跟踪器保存的是上一次在图像中的形状，区域移动后须重新检测
+			FACETRACKER_API_facetracker_obj_reset();
+			trackRoi_ = roi;
+		}
+		const double factor = std::min(1.0, static_cast<double>(trackCfg_.trackWidth_) / roi.width);
+		cv::resize(frame(roi), trackImage_, cv::Size(), factor, factor, cv::INTER_AREA);
+		// 跟踪库按BGR图像处理，亮度图在缩小后再扩展，开销很小
+		if (1 == trackImage_.channels())
+			cv::cvtColor(trackImage_, trackImage_, cv::COLOR_GRAY2BGR);
 
-			yuvFrame.width = width_;
-			yuvFrame.height = height_;
+		const bool tracked = FACETRACKER_API_facetracker_obj_track(trackImage_);
+		ofVec2f posVec2f = FACETRACKER_API_getPosition(trackImage_);
+		float currScale = FACETRACKER_API_getScale(trackImage_);
 
-			// ȾֱӰtexID͸OpenGLWidgetȾ
-			pYuvDraw_->updateTexture(&yuvFrame);
+		faceFound_ = tracked && posVec2f.x != -1 && posVec2f.y != -1;
+		if (faceFound_) {
+			// 换算回整帧坐标，再换算到 width_ x height_ 的坐标（与原来的跟踪尺寸一致）
+			faceCenter_ = cv::Point2f(roi.x + posVec2f.x / factor, roi.y + posVec2f.y / factor);
+			const float sx = static_cast<float>(width_) / frameSize.width;
+			const float sy = static_cast<float>(height_) / frameSize.height;
+			FaceSample& face = faceSamples_.back();
+			face.pos = QPointF(faceCenter_.x * sx, faceCenter_.y * sy);
+			face.scale = static_cast<float>(currScale / factor * sx);
+			face.captureUs = grabUs;
+			faceSamples_.publish();
+			// qDebug() << "Face Position: " << face.pos << ", Scale: " << face.scale;
 		}
+		trackedFrames_.fetch_add(1, std::memory_order_relaxed);
+		// 跟踪结束、不再读取该帧后才归还缓冲区，归还后上传阶段会覆盖它
+		(void)trackFreeQueue_.tryPush(index);
 	}
+}
 
-	pRenderCtx_->doneCurrent();
+template<typename Queue>
+bool VideoCaptureThread::waitPop(Queue& queue, int& index)
+{
+	while (isRunning_.load())
+	{
+		if (queue.tryPop(index))
+			return true;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	return false;
 }
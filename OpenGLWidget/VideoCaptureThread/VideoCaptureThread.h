@@ -9,10 +9,16 @@
 #include <QOpenGLContext>
 #include <QOffscreenSurface>
 #include <QMutex>
+#include <atomic>
+#include <thread>
 
 #include "ShaderProgram/GLShaderProgram.h"
 #include "Common/DataDefine.h"
+#include "Common/SPSCRingBuffer.h"
+#include "Common/MediaClock.h"
+#include "Common/TripleBuffer.h"
 #include "YUVDraw/GLYuvDraw.h"
+#include "CameraSource/CameraSource.h"
 
 class VideoCaptureThread  : public QThread
 {
@@ -22,26 +28,108 @@ public:
 	VideoCaptureThread(QOpenGLContext* mainCtx, QOffscreenSurface* offScreenSurface, QObject *parent);
 	~VideoCaptureThread();
 
+	// 一次人脸跟踪结果，坐标为 width_ x height_ 的图像坐标
+	struct FaceSample
+	{
+		QPointF pos;
+		float scale = 0.0f;
+		int64_t captureUs = -1;	// 被跟踪帧的采集时间（CMediaClock），-1 表示还没有结果
+	};
+
+	// 采集流水线统计
+	struct CaptureStats
+	{
+		uint64_t uploadedFrames = 0;	// 上传到纹理的帧数
+		uint64_t staleFrames = 0;		// 被更新的帧覆盖、未处理就丢弃的帧数
+		uint64_t trackedFrames = 0;		// 做过人脸跟踪的帧数
+		double latencyMs = 0.0;			// 采集到纹理更新完成的延迟（平滑后）
+		double latencyMaxMs = 0.0;		// 本统计周期（10秒）内的最大延迟
+	};
+
 public:
 	void initOpenCV(int w, int h);
 	void stopCapture();
 	void updateWH(const int& w, const int& h);
+	// 以下设置须在 start() 之前调用
+	// 摄像头（或测试文件）参数，默认为系统默认摄像头 1080p30 MJPEG
+	void setCameraCfg(const CameraCfg& cfg) { cameraCfg_ = cfg; }
+	// 人脸跟踪参数；跟踪库是全局的，多路摄像头时只在一路上开启
+	void setFaceTrackCfg(const FaceTrackCfg& cfg) { trackCfg_ = cfg; }
+	void setFaceTracking(bool enable) { trackFaces_ = enable; }
+	// 输出写入的纹理数组和起始层，见 CYuvDraw::setOutputLayers
+	void setOutputLayers(GLuint arrayTexID, int firstLayer, int w, int h);
+
+	// 在主线程（共享上下文为当前上下文）中取得最新完成的摄像头帧所在的纹理数组层，见 CYuvDraw::acquireFrame
+	int acquireFrame();
+	// [主线程调用] 最新的人脸跟踪结果，有新结果时返回true；不经过事件队列，可在 paintGL 中直接读取
+	bool latestFace(FaceSample& face) { return faceSamples_.readLatest(face); }
+	// [主线程调用] 最新的流水线统计，有更新时返回true
+	bool latestStats(CaptureStats& stats) { return stats_.readLatest(stats); }
 
 protected:
-	// video󣬽Ⱦtexture
+	// 上传阶段（持有共享上下文）：从采集源取最新帧，按原始排列上传，缩放和颜色转换由着色器完成；
+	// 同时负责启动和回收跟踪线程
 	void run() override;
 
+private:
+	// 跟踪阶段需要的图像：BGR 原样拷贝，YUV 格式只取亮度
+	static void copyForTracking(const CameraImage& image, cv::Mat& dst);
+
+	// ------------------------- 流水线各阶段 -------------------------
+	// 人脸跟踪：与上传并行，按 FaceTrackCfg::rateHz_ 取帧，跟不上时跳过帧，不影响预览帧率
+	void trackLoop();
+	// 本次跟踪的区域（整帧坐标）：跟丢时为整帧，否则为以上一次人脸位置为中心的区域
+	cv::Rect trackRegion(const cv::Size& frameSize) const;
+
+	// 等待队列中的下一帧，停止采集时返回false
+	template<typename Queue>
+	bool waitPop(Queue& queue, int& index);
+
 signals:
 	//void signal_NewYUVFrame(YUVFrame* yuv);
-	void signal_NewFacePos(QPoint pos, float scale);
-	void signal_NewYuvTexture(unsigned int texID);
+	// 有新的摄像头帧，见 CYuvDraw::textureReady；帧本身在 paintGL 中通过 acquireFrame 取得
+	void signal_FrameReady();
 
 private:
 	int					width_ = 0;
 	int					height_ = 0;
 
-	cv::VideoCapture	videoCapture_{};
-	bool				isRunning_ = false;
+	std::atomic<bool>	isRunning_{ false };
+
+	// 采集源：协商摄像头的原生格式，自带采集和解码线程，只保留最新的一帧
+	CameraCfg			cameraCfg_;
+	CCameraSource		cameraSource_;
+	bool				trackFaces_ = true;
+
+	// 采集到纹理更新完成的延迟统计，只在上传阶段使用
+	int64_t latencyUs_ = 0;
+	int64_t latencyMaxUs_ = 0;
+	int64_t latencyLogUs_ = -1;
+	CaptureStats uploadStats_;	// 上传阶段累计的统计，每帧发布到 stats_
+
+	// ------------------------- 发布给主线程的最新状态（单写者三缓冲，读写都不等待） -------------------------
+	TripleBuffer<FaceSample> faceSamples_;	// 跟踪阶段写入
+	TripleBuffer<CaptureStats> stats_;		// 上传阶段写入
+	std::atomic<uint64_t> trackedFrames_{ 0 };
+
+	// ------------------------- 上传阶段到跟踪阶段 -------------------------
+	// 两个缓冲区在两个队列之间循环：上传阶段按跟踪频率取空闲的缓冲区拷贝一帧，跟踪阶段处理完后归还。
+	// 没有空闲缓冲区说明跟踪还没做完，该帧不做跟踪
+	FaceTrackCfg trackCfg_;
+	int64_t nextTrackUs_ = 0;	// 下一次交给跟踪阶段的时间，只在上传阶段使用
+	static const int kTrackBufferCount = 2;
+	cv::Mat trackFrames_[kTrackBufferCount];
+	int64_t trackGrabUs_[kTrackBufferCount] = {};
+	SpscQueue<int, kTrackBufferCount> trackQueue_;
+	SpscQueue<int, kTrackBufferCount> trackFreeQueue_;
+
+	std::thread trackThread_;
+
+	// 以下只在跟踪阶段使用
+	cv::Mat trackImage_;		// 裁剪并缩小后送入跟踪器的图像
+	bool faceFound_ = false;	// 上一次跟踪是否找到人脸
+	cv::Point2f faceCenter_;	// 上一次的人脸位置（整帧坐标）
+	cv::Rect trackRoi_;			// 当前的跟踪区域，人脸接近边缘时才移动
 
 	QOpenGLContext* pRenderCtx_ = nullptr;
 	QOffscreenSurface* pRenderSurface_ = nullptr;
@@ -14,7 +14,7 @@ CYuvDraw::CYuvDraw(QOpenGLContext* renderCtx, QOffscreenSurface* offScreenSurfac
 		pRenderCtx_ = renderCtx;
 	}
 
-	// GUI߳дGUI߳٣ǿȾ߳ʹá
+	// 离屏表面须在GUI线程中创建，GUI线程中销毁，但是可以在渲染线程中使用。
 	// https://doc.qt.io/archives/qt-5.15/qoffscreensurface.html#details
 	if (!pRenderSurface_)
 	{
@@ -26,6 +26,15 @@ CYuvDraw::~CYuvDraw()
 {
 }
 
+void CYuvDraw::setOutputLayers(GLuint arrayTexID, int firstLayer, int w, int h)
+{
+	outputArrayID_ = arrayTexID;
+	outputWidth_ = w;
+	outputHeight_ = h;
+	for (size_t i = 0; i < outputs_.size(); ++i)
+		outputs_.buffer(i).layer = firstLayer + static_cast<int>(i);
+}
+
 void CYuvDraw::initTexture()
 {
 	pRenderCtx_->makeCurrent(pRenderSurface_);
@@ -44,12 +53,12 @@ void CYuvDraw::initTexture()
 
 	f->glGenBuffers(1, &VBO_);
 	f->glBindBuffer(GL_ARRAY_BUFFER, VBO_);
-	// ݴ
+	// 将数据传至缓存
 	f->glBufferData(GL_ARRAY_BUFFER, sizeof(vertices_), vertices_, GL_STATIC_DRAW);
-	// λ
+	// 设置位置属性
 	f->glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
 	f->glEnableVertexAttribArray(0);
-	// uv
+	// 设置uv坐标
 	f->glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
 	f->glEnableVertexAttribArray(1);
 
@@ -57,7 +66,10 @@ void CYuvDraw::initTexture()
 	f->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO_);
 	f->glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices_), indices_, GL_STATIC_DRAW);
 
-	f->glGenTextures(3, yuvTexID_);
+	// 平面纹理在收到第一帧时按帧尺寸分配，这里只创建PBO
+	f->glGenBuffers(kPboCount, pboIDs_);
+	// 平面宽度不一定是4的倍数，所有上传都按1字节对齐
+	f->glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
 	initFrameBuffer();
 
@@ -70,48 +82,160 @@ void CYuvDraw::initFrameBuffer()
 
 	auto f = pRenderCtx_->extraFunctions();
 
-	// ------------------------- FBO֡ -------------------------
-	// һ֮֡еĶȡд֡ĲӰ쵱ǰ󶨵֡
+	// ------------------------- FBO（帧缓冲对象） -------------------------
+	// 创建并绑定一个帧缓冲对象，之后的所有的读取和写入帧缓冲的操作将会影响当前绑定的帧缓冲
 	f->glGenFramebuffers(1, &FBO_);
 	f->glBindFramebuffer(GL_FRAMEBUFFER, FBO_);
 
-	// ------------------------- texture -------------------------
-	// һͨݻ(General Purpose Data Buffer)ɶд
+	// ------------------------- texture（纹理附件） -------------------------
+	// 纹理是一个通用数据缓冲(General Purpose Data Buffer)，可读可写
 
-	// һ2D
-	f->glGenTextures(1, &TexID_);
-	f->glBindTexture(GL_TEXTURE_2D, TexID_);
-	// datanullptrʾڴûȾ֮֡УҲ˵Ⱦ֮ݻҪתΪʽ
-	f->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
-	f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	// 输出纹理数组由主线程创建（见 setOutputLayers），每帧渲染前把三缓冲中的一层附加到帧缓冲上
+	// 将该 纹理附件 附加到帧缓冲GL_FRAMEBUFFER上，并通过GL_COLOR_ATTACHMENT0指明该 纹理 是一个颜色附件纹理（color attachment texture）
+	f->glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, outputArrayID_, 0, outputs_.buffer(0).layer);
 
-	f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	//   ӵ֡GL_FRAMEBUFFERϣͨGL_COLOR_ATTACHMENT0ָ  һɫcolor attachment texture
-	f->glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, TexID_, 0);
+	// ------------------------- RBO（渲染缓冲对象附件） -------------------------
+	// RBO虽然也是一个缓冲，但RBO是专门被设计作为帧缓冲附件使用的，通常都是只写的，当我们不需要从这些缓冲中采样的时候，通常选择渲染缓冲对象
+	// 渲染缓冲对象直接将所有的渲染数据储存到它的缓冲中，不会做任何针对纹理格式的转换，让它变为一个更快的可写储存介质。
 
-	// ------------------------- RBOȾ󸽼 -------------------------
-	// RBOȻҲһ壬RBOרűΪ֡帽ʹõģֻͨдģǲҪЩвʱͨѡȾ
-	// ȾֱӽеȾݴ浽ĻУκʽתΪһĿдʡ
-
-	// һ Ⱦ֮еȾӰ쵱ǰRBOǲԸRBO
+	// 创建并绑定一个 渲染缓冲对象，之后所有的渲染缓冲操作影响当前的RBO，不过我们不会对该RBO采样
 	f->glGenRenderbuffers(1, &RBO_);
 	f->glBindRenderbuffer(GL_RENDERBUFFER, RBO_);
-	// һȺģȾ󣬴˴ʹõȾͬʱΪȻģ建
-	f->glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
-	//  Ⱦ ӵGL_FRAMEBUFFERϣͨGL_DEPTH_STENCIL_ATTACHMENTָȾ Ȼ  ģ建
+	// 创建一个深度和模板渲染缓冲对象，此处使用单个渲染缓冲对象同时作为深度缓冲对象和模板缓冲对象。
+	f->glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, outputWidth_, outputHeight_);
+	// 将该 渲染缓冲对象 附加到GL_FRAMEBUFFER上，并通过GL_DEPTH_STENCIL_ATTACHMENT指明该渲染缓冲对象既是 深度缓冲对象 又是 模板缓冲对象
 	f->glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, RBO_);
 
-	// FBOǷ
+	// 检查FBO是否完整
 	if (f->glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
 		qDebug() << "ERROR::FRAMEBUFFER:: Framebuffer is not complete!";
-	// ֡Ĭϻǰ֡
+	// 将帧缓冲对象绑定至默认缓冲区，即解绑当前帧缓冲对象
 	f->glBindFramebuffer(GL_FRAMEBUFFER, pRenderCtx_->defaultFramebufferObject());
 
 	pRenderCtx_->doneCurrent();
 }
 
+bool CYuvDraw::ensureInputStorage(PixelLayout layout, int w, int h)
+{
+	if (w <= 0 || h <= 0)
+		return false;
+	if (layout == inputLayout_ && w == inputWidth_ && h == inputHeight_)
+		return true;
+	if (layout == PixelLayout::YUYV && (w % 2) != 0)
+	{
+		qWarning() << "YUYV frame width must be even:" << w;
+		return false;
+	}
+
+	auto f = pRenderCtx_->extraFunctions();
+
+	// glTexStorage2D分配的存储不可改变，格式或尺寸变化时重新创建纹理
+	if (yuvTexID_[0])
+		f->glDeleteTextures(3, yuvTexID_);
+	f->glGenTextures(3, yuvTexID_);
+
+	inputPlaneCount_ = describePlanes(layout, w, h, inputPlanes_);
+	pboSize_ = 0;
+	for (int i = 0; i < inputPlaneCount_; ++i)
+	{
+		const InputPlane& plane = inputPlanes_[i];
+		f->glBindTexture(GL_TEXTURE_2D, yuvTexID_[i]);
+		f->glTexStorage2D(GL_TEXTURE_2D, 1, plane.internalFormat, plane.width, plane.height);
+		f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		pboSize_ += static_cast<GLsizeiptr>(plane.rowBytes) * plane.height;
+	}
+	f->glBindTexture(GL_TEXTURE_2D, 0);
+
+	for (int i = 0; i < kPboCount; ++i)
+	{
+		f->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pboIDs_[i]);
+		f->glBufferData(GL_PIXEL_UNPACK_BUFFER, pboSize_, nullptr, GL_STREAM_DRAW);
+	}
+	f->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	inputLayout_ = layout;
+	inputWidth_ = w;
+	inputHeight_ = h;
+	qDebug() << "Camera input textures allocated:" << w << "x" << h << "layout" << static_cast<int>(layout);
+	return true;
+}
+
+int CYuvDraw::describePlanes(PixelLayout layout, int w, int h, InputPlane planes[3])
+{
+	const int chromaW = (w + 1) / 2;
+	const int chromaH = (h + 1) / 2;
+	switch (layout)
+	{
+	case PixelLayout::I420:
+		planes[0] = { GL_R8, GL_RED, w, h, w };
+		planes[1] = { GL_R8, GL_RED, chromaW, chromaH, chromaW };
+		planes[2] = { GL_R8, GL_RED, chromaW, chromaH, chromaW };
+		return 3;
+	case PixelLayout::I422:
+		planes[0] = { GL_R8, GL_RED, w, h, w };
+		planes[1] = { GL_R8, GL_RED, chromaW, h, chromaW };
+		planes[2] = { GL_R8, GL_RED, chromaW, h, chromaW };
+		return 3;
+	case PixelLayout::NV12:
+		planes[0] = { GL_R8, GL_RED, w, h, w };
+		planes[1] = { GL_RG8, GL_RG, chromaW, chromaH, chromaW * 2 };
+		return 2;
+	case PixelLayout::BGR:
+		// 按RGB上传，R、B的交换在着色器中完成
+		planes[0] = { GL_RGB8, GL_RGB, w, h, w * 3 };
+		return 1;
+	case PixelLayout::GRAY:
+		planes[0] = { GL_R8, GL_RED, w, h, w };
+		return 1;
+	case PixelLayout::YUYV:
+		// 每个RGBA纹素对应两个像素（Y0 U Y1 V），在着色器中拆开
+		planes[0] = { GL_RGBA8, GL_RGBA, w / 2, h, w * 2 };
+		return 1;
+	}
+	return 0;
+}
+
+uint8_t* CYuvDraw::mapUploadBuffer()
+{
+	auto f = pRenderCtx_->extraFunctions();
+
+	// INVALIDATE 告诉驱动旧内容不再需要，GPU仍在读取该PBO时驱动会换一块新内存，不会等待
+	f->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pboIDs_[pboIndex_]);
+	mappedPtr_ = static_cast<uint8_t*>(f->glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, pboSize_,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+	f->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	if (!mappedPtr_)
+		qWarning() << "Failed to map camera upload buffer.";
+	return mappedPtr_;
+}
+
+void CYuvDraw::uploadInput()
+{
+	auto f = pRenderCtx_->extraFunctions();
+
+	f->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pboIDs_[pboIndex_]);
+	f->glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+	mappedPtr_ = nullptr;
+
+	// 绑定了PBO时，最后一个参数是PBO内的偏移，函数立即返回，由驱动在GPU端完成拷贝
+	GLintptr offset = 0;
+	for (int i = 0; i < inputPlaneCount_; ++i)
+	{
+		const InputPlane& plane = inputPlanes_[i];
+		f->glActiveTexture(GL_TEXTURE0 + i);
+		f->glBindTexture(GL_TEXTURE_2D, yuvTexID_[i]);
+		f->glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, plane.width, plane.height, plane.format, GL_UNSIGNED_BYTE, (void*)offset);
+		offset += static_cast<GLintptr>(plane.rowBytes) * plane.height;
+	}
+
+	f->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	pboIndex_ = (pboIndex_ + 1) % kPboCount;
+}
+
 void CYuvDraw::updateWH(const int& w, const int& h)
 {
 	QMutexLocker mlk{ &mtx_ };
@@ -120,14 +244,62 @@ void CYuvDraw::updateWH(const int& w, const int& h)
 }
 
 void CYuvDraw::updateTexture(YUVFrame* yuvBuffer)
+{
+	CameraImage image{};
+	image.layout = PixelLayout::I420;
+	image.width = static_cast<int>(yuvBuffer->width);
+	image.height = static_cast<int>(yuvBuffer->height);
+	image.data[0] = yuvBuffer->luma.dataBuffer;
+	image.data[1] = yuvBuffer->chromaB.dataBuffer;
+	image.data[2] = yuvBuffer->chromaR.dataBuffer;
+	image.stride[0] = image.width;
+	image.stride[1] = (image.width + 1) / 2;
+	image.stride[2] = (image.width + 1) / 2;
+	updateTexture(image);
+}
+
+void CYuvDraw::updateTexture(const CameraImage& image)
 {
 	pRenderCtx_->makeCurrent(pRenderSurface_);
 
+	// ------------------------- 拷贝到PBO，这是CPU上唯一的一次整帧操作 -------------------------
+	uint8_t* dst = ensureInputStorage(image.layout, image.width, image.height) ? mapUploadBuffer() : nullptr;
+	if (!dst)
+	{
+		pRenderCtx_->doneCurrent();
+		return;
+	}
+	for (int i = 0; i < inputPlaneCount_; ++i)
+	{
+		// 各平面在PBO中紧密排列，源数据每行可能有填充
+		const InputPlane& plane = inputPlanes_[i];
+		const size_t planeBytes = static_cast<size_t>(plane.rowBytes) * plane.height;
+		if (image.stride[i] == plane.rowBytes)
+		{
+			memcpy(dst, image.data[i], planeBytes);
+		}
+		else
+		{
+			for (int row = 0; row < plane.height; ++row)
+				memcpy(dst + static_cast<size_t>(row) * plane.rowBytes, image.data[i] + static_cast<size_t>(row) * image.stride[i], plane.rowBytes);
+		}
+		dst += planeBytes;
+	}
+
+	inputFullRange_ = image.fullRange;
+	uploadInput();
+	renderOutput();
+
+	pRenderCtx_->doneCurrent();
+}
+
+void CYuvDraw::renderOutput()
+{
 	auto f = pRenderCtx_->extraFunctions();
 
 	/*static int org_wh = width * height;
 
-	// 1. ڴСı󣬼ǵøtexturerboСglDrawElementsʱtextureĿռ䲻
+	// 1. 窗口大小改变后，记得更新texture和rbo大小，否则glDrawElements的时候，texture的空间不够
 	if (org_wh != width * height)
 	{
 		qDebug() << width << " " << height;
@@ -145,7 +317,7 @@ void CYuvDraw::updateTexture(YUVFrame* yuvBuffer)
 	static int viewportY = 0;
 	static int viewportWidth = 0;
 	static int viewportHeight = 0;
-	// 2. ӿڣʹwidgetеͼαʼղ
+	// 2. 调整视口，使得widget中的图形比例始终不变
 	if (width > height)
 	{
 		viewportX = (width - height) / 2;
@@ -160,64 +332,89 @@ void CYuvDraw::updateTexture(YUVFrame* yuvBuffer)
 		viewportWidth = width;
 		viewportHeight = width;
 	}
-	// 3. һҪǵglViewport;
+	// 3. 一定要记得glViewport;
     //f->glViewport(viewportX, viewportY, viewportWidth, viewportHeight);*/
 
+	// 纹理数组的每一层尺寸相同，按数组尺寸绘制
+	f->glViewport(0, 0, outputWidth_, outputHeight_);
+
+	// ------------------------- 选择输出纹理 -------------------------
+	// 写入三缓冲中生产者持有的纹理
+	OutputSlot& slot = outputs_.back();
+	// 上次渲染的帧没有被取走，直接覆盖
+	if (slot.writeFence)
 	{
-		QMutexLocker mlk{ &mtx_ };
-		f->glViewport(0, 0, width, height);
+		f->glDeleteSync(slot.writeFence);
+		slot.writeFence = nullptr;
+	}
+	// 使用者可能仍在读取该纹理，在GPU端等待它读完，CPU不阻塞
+	if (slot.readFence)
+	{
+		f->glWaitSync(slot.readFence, 0, GL_TIMEOUT_IGNORED);
+		f->glDeleteSync(slot.readFence);
+		slot.readFence = nullptr;
 	}
 
 	f->glBindFramebuffer(GL_FRAMEBUFFER, FBO_);
+	f->glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, outputArrayID_, 0, slot.layer);
 	f->glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
 	f->glClear(GL_COLOR_BUFFER_BIT);
 
 	pYuvShaderProg_->use();
 	f->glBindVertexArray(VAO_);
 
+	// 输入纹理在 uploadInput 中已绑定到对应的纹理单元
+	pYuvShaderProg_->set1i("inputFormat", static_cast<int>(inputLayout_));
+	pYuvShaderProg_->set1i("fullRange", inputFullRange_ ? 1 : 0);
 	pYuvShaderProg_->set1i("texY", 0);
-	f->glActiveTexture(GL_TEXTURE0);
-	f->glBindTexture(GL_TEXTURE_2D, yuvTexID_[0]);
-	f->glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-	f->glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, yuvBuffer->width, yuvBuffer->height, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, yuvBuffer->luma.dataBuffer);
-	f->glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
-	f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	
 	pYuvShaderProg_->set1i("texU", 1);
-	f->glActiveTexture(GL_TEXTURE1);
-	f->glBindTexture(GL_TEXTURE_2D, yuvTexID_[1]);
-	f->glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-	f->glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, (yuvBuffer->width + 1) / 2, (yuvBuffer->height + 1) / 2, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, yuvBuffer->chromaB.dataBuffer);
-	f->glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
-	f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
 	pYuvShaderProg_->set1i("texV", 2);
-	f->glActiveTexture(GL_TEXTURE2);
-	f->glBindTexture(GL_TEXTURE_2D, yuvTexID_[2]);
-	f->glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-	f->glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, (yuvBuffer->width + 1) / 2, (yuvBuffer->height + 1) / 2, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, yuvBuffer->chromaR.dataBuffer);
-	f->glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
-	f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	f->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
 	f->glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-	f->glFinish();
 
-	emit textureReady(TexID_);
-    // saveImage();
+	// 栅栏必须提交给GPU（glFlush），否则另一个上下文等待它时可能永远不会触发
+	slot.writeFence = f->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	f->glFlush();
 
-	pRenderCtx_->doneCurrent();
+	// 上一帧还没被取走时使用者已经有一次重绘在排队，不再通知
+	if (!outputs_.publish())
+		emit textureReady();
+    // saveImage();
 }
 
 
+int CYuvDraw::acquireFrame()
+{
+	auto f = QOpenGLContext::currentContext()->extraFunctions();
+
+	if (!outputs_.hasFresh())
+		return hasOutput_ ? outputs_.front().layer : -1;
+
+	// 上一帧已提交的绘制命令都在这个栅栏之前，生产者覆盖它之前等待；
+	// 栅栏在交出缓冲区之前设置，交换下标后对生产者可见
+	if (hasOutput_)
+	{
+		OutputSlot& prev = outputs_.front();
+		if (prev.readFence)
+			f->glDeleteSync(prev.readFence);
+		prev.readFence = f->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	outputs_.fetch();
+	hasOutput_ = true;
+	OutputSlot& slot = outputs_.front();
+	if (slot.writeFence)
+	{
+		// 之后在本上下文中读取该纹理的命令会等到生产者渲染完成
+		f->glWaitSync(slot.writeFence, 0, GL_TIMEOUT_IGNORED);
+		f->glDeleteSync(slot.writeFence);
+		slot.writeFence = nullptr;
+	}
+	f->glFlush();
+
+	return slot.layer;
+}
+
 void CYuvDraw::saveImage()
 {
 
@@ -9,6 +9,7 @@
 
 #include "Common/ShaderProgram/GLShaderProgram.h"
 #include "Common/DataDefine.h"
+#include "Common/TripleBuffer.h"
 
 class CYuvDraw : public QObject, public QOpenGLExtraFunctions
 {
@@ -21,15 +22,51 @@ public:
 	void updateWH(const int& w, const int& h);
 
 public:
+	/**
+	 * @brief 输出写入主线程创建的纹理数组（GL_TEXTURE_2D_ARRAY）中从 firstLayer 开始的三层（三缓冲）。
+	 *        须在 initTexture 之前调用，w、h 为纹理数组的尺寸。
+	 */
+	void setOutputLayers(GLuint arrayTexID, int firstLayer, int w, int h);
 	void initTexture();
+	// 上传一帧I420数据（各平面可以不连续）并渲染到输出纹理
 	void updateTexture(YUVFrame* yuvBuffer);
+	// 按摄像头的原始排列上传一帧，缩放和颜色转换在同一次绘制中由着色器完成
+	void updateTexture(const CameraImage& image);
 	void saveImage();
 
+	/**
+	 * @brief 使用者（主线程，当前为共享上下文）取得最新完成的一帧。
+	 *        有新帧时在使用者的命令流中等待该帧的栅栏（glWaitSync，不阻塞CPU），
+	 *        并为上一帧插入读取完成的栅栏，生产者覆盖该纹理前会等待它。
+	 * @return 最新一帧所在的纹理数组层，尚无帧时返回-1；没有新帧时返回上次的层
+	 */
+	int acquireFrame();
+
 private:
 	void initFrameBuffer();
+	// 输入纹理的一个平面
+	struct InputPlane
+	{
+		GLenum internalFormat;
+		GLenum format;
+		int width;		// 纹理尺寸（纹素）
+		int height;
+		int rowBytes;	// 在PBO中每行的字节数
+	};
+	// 各像素排列对应的输入纹理，返回平面数
+	static int describePlanes(PixelLayout layout, int w, int h, InputPlane planes[3]);
+	// 帧格式或尺寸改变时重新分配输入纹理（不可变存储）和PBO，不变时直接返回
+	bool ensureInputStorage(PixelLayout layout, int w, int h);
+	// 映射下一个上传用的PBO，失败返回nullptr
+	uint8_t* mapUploadBuffer();
+	// 解除映射，由PBO异步更新输入纹理
+	void uploadInput();
+	// 把输入纹理绘制到输出纹理环中的一个纹理上，并通知使用者
+	void renderOutput();
 
 signals:
-	void textureReady(unsigned int texID);
+	// 有新帧可以取（acquireFrame）。使用者取走上一帧之前不会重复发出，事件队列中最多只有一个
+	void textureReady();
 
 private:
 	QOpenGLContext* pRenderCtx_ = nullptr;
@@ -37,10 +74,10 @@ private:
 
 	bool isRunning_ = false;
 
-	// һά
+	// 顶点数组是一维的
 	float vertices_[20] =
 	{
-		//	---- λ ----       ---- uv ----
+		//	---- 位置 ----       ---- uv ----
 		-1.0f, 1.0f, 1.0f,			0, 0,
 		-1.0f,-1.0f, 1.0f,			0, 1,
 		1.0f,-1.0f, 1.0f,			1, 1,
@@ -49,16 +86,41 @@ private:
 
 	GLuint indices_[6] =
 	{
-		0, 1, 3, // һ
-		1, 2, 3  // ڶ
+		0, 1, 3, // 第一个三角形
+		1, 2, 3  // 第二个三角形
 	};
 	GLuint VAO_ = 0;
 	GLuint VBO_ = 0;
 	GLuint EBO_ = 0;
 	GLuint FBO_ = 0;
 	GLuint RBO_ = 0;
-	GLuint yuvTexID_[3];
-	GLuint TexID_ = 0;
+	GLuint yuvTexID_[3] = { 0, 0, 0 };
+
+	// 输出纹理的三缓冲：生产者不会写入最新帧和使用者正在读取的帧，因此使用者始终读到完整的一帧
+	struct OutputSlot
+	{
+		int layer = 0;					// 在输出纹理数组中的层
+		GLsync writeFence = nullptr;	// 生产者渲染完成，使用者读取前等待
+		GLsync readFence = nullptr;		// 使用者读取完成，生产者覆盖前等待
+	};
+	TripleBuffer<OutputSlot> outputs_;
+	bool hasOutput_ = false;	// 使用者是否已经取到过一帧，只在使用者线程中使用
+	GLuint outputArrayID_ = 0;	// 输出纹理数组，由主线程创建，多个采集线程各写其中的几层
+	int outputWidth_ = 0;
+	int outputHeight_ = 0;
+
+	// 上传用的PBO环，驱动从PBO拷贝到纹理时，采集线程已经在填充下一个PBO
+	static const int kPboCount = 3;
+	GLuint pboIDs_[kPboCount] = { 0, 0, 0 };
+	int pboIndex_ = 0;
+	GLsizeiptr pboSize_ = 0;
+	uint8_t* mappedPtr_ = nullptr;	// 当前已映射的PBO，nullptr表示未映射
+	PixelLayout inputLayout_ = PixelLayout::I420;	// 输入纹理按该格式和尺寸分配
+	bool inputFullRange_ = true;	// 当前帧的 YUV 取值范围，见 CameraImage::fullRange
+	int inputWidth_ = 0;
+	int inputHeight_ = 0;
+	InputPlane inputPlanes_[3] = {};
+	int inputPlaneCount_ = 0;
 	
 	GLShaderProgram* pYuvShaderProg_ = nullptr;
 
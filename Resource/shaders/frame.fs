@@ -2,7 +2,10 @@
 out vec4 FragColor;
 
 in vec2 TexCoords;
-uniform sampler2D frameTexture;
+// All camera outputs live in one texture array; a single draw composites them in a grid
+uniform sampler2DArray frameTextures;
+uniform int layerCount;     // number of cameras composited, 0-4
+uniform int layers[4];      // layer of each camera's current frame, grid order from top-left
 
 uniform vec2 pos;
 in vec3 glpos;
@@ -18,5 +21,23 @@ void main()
     {
         FragColor = texture2D(frameTexture, vec2(1.0 - TexCoords.x, TexCoords.y));
     }*/
-	FragColor = texture2D(frameTexture, vec2(1.0 - TexCoords.x, TexCoords.y));
+    if (layerCount <= 0)
+    {
+        FragColor = vec4(0.0, 0.0, 0.0, 1.0);
+        return;
+    }
+
+    // 1 camera fills the view, 2 sit side by side, 3-4 use a 2x2 grid
+    ivec2 grid = ivec2(layerCount > 1 ? 2 : 1, layerCount > 2 ? 2 : 1);
+    vec2 cellCoords = TexCoords * vec2(grid);
+    ivec2 cell = min(ivec2(cellCoords), grid - 1);
+    int index = (grid.y - 1 - cell.y) * grid.x + cell.x;
+    if (index >= layerCount)
+    {
+        FragColor = vec4(0.0, 0.0, 0.0, 1.0);
+        return;
+    }
+
+    vec2 uv = cellCoords - vec2(cell);
+    FragColor = texture(frameTextures, vec3(1.0 - uv.x, uv.y, float(layers[index])));
 }
@@ -1,19 +1,64 @@
 #version 460 core
 out vec4 FragColor;
 
-uniform sampler2D texY;
-uniform sampler2D texU;
+// Input format, same values as PixelLayout: 0 I420, 1 BGR, 2 GRAY, 3 YUYV, 4 NV12, 5 I422
+uniform int inputFormat;
+// YUV range: 1 full (0-255, YUVJ from MJPEG decode), 0 limited (Y 16-235, UV 16-240, raw YUYV/NV12)
+uniform int fullRange;
+
+uniform sampler2D texY;     // Y plane of I420; the only texture of packed formats
+uniform sampler2D texU;     // interleaved UV plane of NV12
 uniform sampler2D texV;
 
 in vec2 TexCoords;
 
+const mat3 yuv2rgb = mat3( 1,1,1, 0,-0.39465,2.03211,1.13983,-0.58060,0);
+
 void main(void)
 {
     vec3 yuv;
     vec3 rgb;
-    yuv.x = texture2D(texY, TexCoords).r;
-    yuv.y = texture2D(texU, TexCoords).r - 0.5;
-    yuv.z = texture2D(texV, TexCoords).r - 0.5;
-    rgb = mat3( 1,1,1, 0,-0.39465,2.03211,1.13983,-0.58060,0) * yuv;
+    if (inputFormat == 1)
+    {
+        // BGR data uploaded as RGB, swap R and B
+        rgb = texture2D(texY, TexCoords).bgr;
+    }
+    else if (inputFormat == 2)
+    {
+        rgb = vec3(texture2D(texY, TexCoords).r);
+    }
+    else
+    {
+        if (inputFormat == 3)
+        {
+            // Each texel is Y0 U Y1 V for two adjacent pixels; pick Y by pixel parity
+            ivec2 texSize = textureSize(texY, 0);
+            ivec2 pixel = ivec2(TexCoords * vec2(texSize.x * 2, texSize.y));
+            pixel = clamp(pixel, ivec2(0), ivec2(texSize.x * 2 - 1, texSize.y - 1));
+            vec4 texel = texelFetch(texY, ivec2(pixel.x / 2, pixel.y), 0);
+            yuv.x = (pixel.x % 2 == 0) ? texel.r : texel.b;
+            yuv.y = texel.g - 0.5;
+            yuv.z = texel.a - 0.5;
+        }
+        else if (inputFormat == 4)
+        {
+            yuv.x = texture2D(texY, TexCoords).r;
+            yuv.yz = texture2D(texU, TexCoords).rg - 0.5;
+        }
+        else
+        {
+            // I420 and I422 differ only in chroma plane height; normalized coords cover both
+            yuv.x = texture2D(texY, TexCoords).r;
+            yuv.y = texture2D(texU, TexCoords).r - 0.5;
+            yuv.z = texture2D(texV, TexCoords).r - 0.5;
+        }
+        if (fullRange == 0)
+        {
+            // Expand limited range to full: Y minus 16 scaled by 255/219, UV around 128 scaled by 255/224
+            yuv.x = (yuv.x - 16.0 / 255.0) * (255.0 / 219.0);
+            yuv.yz *= 255.0 / 224.0;
+        }
+        rgb = yuv2rgb * yuv;
+    }
     FragColor = vec4(rgb, 1.0f);
 }
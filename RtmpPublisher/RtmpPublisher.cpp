@@ -7,24 +7,24 @@
 #ifdef DEBUG
 static void ffmpeg_log_callback(void* ptr, int level, const char* fmt, va_list vargs)
 {
-    // ־ǿԺһЩϸϢ
+    // 检查日志级别，我们可以忽略一些过于详细的信息
     if (level > av_log_get_level())
         return;
 
-    // һ㹻Ļ洢ʽ־Ϣ
+    // 创建一个足够大的缓冲区来存储格式化后的日志消息
     char message[1024];
 
-    // ʹ vsnprintf ȫظʽ־
-    // FFmpeg ݵ fmt ʽַͨѾ "[libx264 @ ...]" Ϣ
+    // 使用 vsnprintf 安全地格式化日志内容
+    // FFmpeg 传递的 fmt 格式字符串通常已经包含了像 "[libx264 @ ...]" 这样的上下文信息
     vsnprintf(message, sizeof(message), fmt, vargs);
 
-    // ȥϢĩβĻзΪqDebugԶ
+    // 去掉消息末尾多余的换行符，因为qDebug会自动添加
     size_t len = strlen(message);
     if (len > 0 && message[len - 1] == '\n') {
         message[len - 1] = '\0';
     }
 
-    // FFmpeg־ѡʹQtĲͬ
+    // 根据FFmpeg的日志级别，选择使用Qt的不同输出流
     switch (level) {
     case AV_LOG_PANIC:
     case AV_LOG_FATAL:
@@ -62,12 +62,12 @@ namespace
 
         auto it = std::search(begin, end, std::begin(startCode4), std::end(startCode4));
         if (it != end) {
-            return it; // ʼĿʼλ
+            return it; // 返回起始码的开始位置
         }
 
         it = std::search(begin, end, std::begin(startCode3), std::end(startCode3));
         if (it != end) {
-            return it; // ʼĿʼλ
+            return it; // 返回起始码的开始位置
         }
 
         return end;
@@ -129,7 +129,7 @@ bool CRtmpPublisher::initialize(AVConfig& config)
     cleanup();
     config_ = config;
 
-    // ------------------------- rtmpPushʼ -------------------------
+    // ------------------------- rtmpPush初始化 -------------------------
     rtmpPush_.reset(new CRtmpPush{});
     if (!rtmpPush_->connect(config_.path_.c_str()))
     {
@@ -138,7 +138,7 @@ bool CRtmpPublisher::initialize(AVConfig& config)
         return false;
     }
 
-    // ------------------------- Ƶʼ -------------------------
+    // ------------------------- 视频编码器初始化 -------------------------
     videoEncoder_.reset(new CVideoEncoder{});
     if (!videoEncoder_->initialize(config_.videoCodecCfg_))
     {
@@ -146,10 +146,10 @@ bool CRtmpPublisher::initialize(AVConfig& config)
         cleanup();
         return false;
     }
-    // ˴timebaseڱpacketʱԶʱתΪ˴õʱ
+    // 此处设置timebase后，在编码成packet时会自动将时间基转换为此处设置的时间基
     videoEncoder_->setTimeBase({ 1, 1000 });
 
-    // ------------------------- ¼豸ʼ -------------------------
+    // ------------------------- 录音设备初始化 -------------------------
     audioCapturer_.reset(new CAudioCapturer{});
     QAudioFormat audioFormat = initAudioFormat(config.audioFmt_);
     if (!audioCapturer_->initialize(audioFormat, config.audioFmt_))
@@ -159,7 +159,7 @@ bool CRtmpPublisher::initialize(AVConfig& config)
         return false;
     }
 
-    // ------------------------- Ƶʼ -------------------------
+    // ------------------------- 音频编码器初始化 -------------------------
     audioEncoder_.reset(new CAudioEncoder{});
     //const QAudioFormat& finalAudioFormat = audioCapturer_->getAudioFormat();
     if (!audioEncoder_->initialize(config.audioCodecCfg_, config.audioFmt_))
@@ -170,7 +170,7 @@ bool CRtmpPublisher::initialize(AVConfig& config)
     }
     audioEncoder_->setTimeBase({ 1, 1000 });
 
-    // ------------------------- Ƿ -------------------------
+    // ------------------------- 检查是否已连接 -------------------------
     if (!rtmpPush_->isConnected())
     {
         qCritical() << "Failed to connect rtmp server.";
@@ -187,45 +187,19 @@ void CRtmpPublisher::startPush()
 {
     if (isPushing_) return;
 
-	// ------------------------- дh.264ļͷ -------------------------
-    QFile h264head = QFile(qApp->applicationDirPath() + "/" + "h264_head.h264");
-    if (h264head.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-        qInfo() << "H264 file opened for writing.";
-    }
-    else {
-        qCritical() << "Failed to open H264 file for writing.";
-    }
-    h264head.write(reinterpret_cast<const char*>(videoEncoder_->getCodecContext()->extradata), videoEncoder_->getCodecContext()->extradata_size);
-	h264head.close();
-
-    h264File = new QFile(qApp->applicationDirPath() + "/" + "h264_data.h264");
-    if (h264File->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-        qInfo() << "H264 file opened for writing.";
-    }
-    else {
-        qCritical() << "Failed to open H264 file for writing.";
-    }
-
-	// ------------------------- дaacļͷ -------------------------
-    QFile aacHead = QFile(qApp->applicationDirPath() + "/" + "aac_head.aac");
-    if (aacHead.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-        qInfo() << "H264 file opened for writing.";
-    }
-    else {
-        qCritical() << "Failed to open H264 file for writing.";
-    }
-    aacHead.write(reinterpret_cast<const char*>(audioEncoder_->getCodecContext()->extradata), audioEncoder_->getCodecContext()->extradata_size);
-	aacHead.close();
-
-    aacFile = new QFile(qApp->applicationDirPath() + "/" + "aac_data.aac");
-    if (aacFile->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-        qInfo() << "AAC file opened for writing.";
-    }
-    else {
-        qCritical() << "Failed to open AAC file for writing.";
+    // ------------------------- 调试用的裸流旁路，默认关闭 -------------------------
+    if (config_.enableEsTap_)
+    {
+        esTap_.reset(new CEsTap{});
+        if (!esTap_->open(qApp->applicationDirPath().toStdString(),
+            videoEncoder_->getCodecContext(), audioEncoder_->getCodecContext()))
+        {
+            qWarning() << "Failed to open elementary stream tap, continue without it.";
+            esTap_.reset();
+        }
     }
 
-    // ------------------------- ý֮ǰҪH.264AACϢ -------------------------
+    // ------------------------- 发送流媒体数据之前，需要发送H.264和AAC的配置信息 -------------------------
 
     std::vector<uint8_t> sps{}, pps{}, asc{};
     if (!getH264Config(sps, pps))
@@ -248,107 +222,160 @@ void CRtmpPublisher::startPush()
         asc.data(), asc.size()
     );
 
-    // ------------------------- ʱ -------------------------
+    // ------------------------- 重置时间戳 -------------------------
     audioEncoder_->resetTimestamp();
 	videoEncoder_->resetTimestamp();
-    audioCapturer_->start(); // ʼ¼Ƶ
+    clearPending();
+    tsOffset_ = 0;
+    tsOffsetSet_ = false;
+    lastTimestamp_ = 0;
+    firstAudioChecked_ = false;
+    audioCapturer_->start(); // 开始录音，填充音频缓冲区
 
     isPushing_ = true;
     qInfo() << "Recording started.";
 }
 
+namespace
+{
+    // 一路没有数据时，另一路最多缓存的时长（毫秒），避免某一路停顿导致整体推流卡住
+    constexpr int64_t MAX_INTERLEAVE_DELAY_MS = 500;
+}
+
 bool CRtmpPublisher::pushing(const unsigned char* rgbData)
 {
     if (!isPushing_) return false;
     if (!rgbData) return false;
 
-    // 󣬲Ĳл涶vlcûУԭǷB֡
-
-    // ------------------------- Ƶ -------------------------
-    // 1. Ƶֱӱ
+    // ------------------------- 视频编码 -------------------------
+    // 1. 视频可以直接编码
     QVector<AVPacket*> videoPackets = videoEncoder_->encode(rgbData);
     for (AVPacket* pkt : videoPackets)
     {
-        // Ϊ̣ͬΪ첽ʱҪ
-        bool isKeyFrame = (pkt->flags & AV_PKT_FLAG_KEY) != 0;
-        // ƳstartCode
-        uint8_t* data = pkt->data;
-        assert(pkt->size >= 4);
-        int startCodeLen = 0;
-        if ((data[0] == 0x00 && data[1] == 0x00 && data[2] == 0x01))
-        {
-            startCodeLen = 3;
-        }
-        else if ((data[0] == 0x00 && data[1] == 0x00 && data[2] == 0x00 && data[3] == 0x01))
+        pendingVideo_.push_back(pkt);
+    }
+
+    // ------------------------- 音频编码 -------------------------
+    // 计算编码一帧音频需要多少字节
+    const int audioBytesPerFrame = audioEncoder_->getBytesPerFrame();
+    // 循环处理所有在缓冲区中积累的完整音频帧
+    while (true)
+    {
+        QByteArray pcmChunk = audioCapturer_->readChunk(audioBytesPerFrame);
+        if (pcmChunk.isEmpty())
         {
-            startCodeLen = 4;
+            break; // 音频数据不够一帧
         }
 
-        uint8_t nalType = data[startCodeLen] & 0x1F;
-        if (0x06 == (nalType & 0x1F))
+        // 2. 音频需要先获取PCM，再编码
+        QVector<AVPacket*> audioPackets = audioEncoder_->encode(reinterpret_cast<const uint8_t*>(pcmChunk.constData()));
+        for (AVPacket* pkt : audioPackets)
         {
-	        qDebug() << "SEI NAL unit detected, skipping.";
-            // SEI NAL unitҪ
-            av_packet_unref(pkt);
-            av_packet_free(&pkt);
-			continue;
+            pendingAudio_.push_back(pkt);
         }
-
-        h264File->write(reinterpret_cast<const char*>(pkt->data), pkt->size);
-        rtmpPush_->sendVideo(pkt->data + startCodeLen, pkt->size - startCodeLen, pkt->dts, isKeyFrame);
-        av_packet_unref(pkt);
-        av_packet_free(&pkt);
     }
 
-    // ------------------------- Ƶ -------------------------
-    // һ֡ƵҪֽ
-    const int audioBytesPerFrame = audioEncoder_->getBytesPerFrame();
-    //qDebug() << "audioBytesPerFrame: " << audioBytesPerFrame;
-    // ѭڻл۵Ƶ֡
-    while (true)
+    // ------------------------- 按 dts 交错发送 -------------------------
+    return sendInterleaved(false);
+}
+
+bool CRtmpPublisher::sendInterleaved(bool flushAll)
+{
+    bool ok = true;
+    while (!pendingVideo_.empty() || !pendingAudio_.empty())
     {
-        QByteArray pcmChunk;
+        bool takeVideo = false;
+        if (!pendingVideo_.empty() && !pendingAudio_.empty())
         {
-            pcmChunk = audioCapturer_->readChunk(audioBytesPerFrame);
-            if (pcmChunk.isEmpty())
-            {
-                //qDebug() << "need more pcm data to encode";
-                break; // Ƶݲһ֡
-            }
+            takeVideo = pendingVideo_.front()->dts <= pendingAudio_.front()->dts;
+        }
+        else
+        {
+            // 只有一路有数据：除非 flush 或缓存已超过上限，否则等待另一路
+            const std::deque<AVPacket*>& queue = pendingVideo_.empty() ? pendingAudio_ : pendingVideo_;
+            if (!flushAll && queue.back()->dts - queue.front()->dts < MAX_INTERLEAVE_DELAY_MS)
+                break;
+            takeVideo = !pendingVideo_.empty();
         }
 
-        // 2. ƵҪȻȡPCMٱ
-        QVector<AVPacket*> audioPackets = audioEncoder_->encode(reinterpret_cast<const uint8_t*>(pcmChunk.constData()));
-        for (AVPacket* pkt : audioPackets)
+        if (takeVideo)
         {
-            /*qDebug() << "Muxer: Writing packet for stream index" << pkt->stream_index
-                << "size:" << pkt->size
-                << "pts:" << pkt->pts
-                << "dts:" << pkt->dts;*/
-        	// Ϊ̣ͬΪ첽ʱҪ
-            static bool firstAudioPacketSent_ = false;
-            if (!firstAudioPacketSent_)
-            {
-                // FFmpeg  aac ȫͷģʽ£
-				// ʱһ "Lavc" 汾ϢķƵݰ
-                if (pkt->size > 4 && pkt->data[0] == 0xDE && pkt->data[1] == 0x04) 
-                {
-                    qDebug() << "Skipping first AAC info packet (Lavc).";
-                    av_packet_unref(pkt);
-                    av_packet_free(&pkt);
-                    firstAudioPacketSent_ = true;
-                    continue;
-                }
-            }
+            AVPacket* pkt = pendingVideo_.front();
+            pendingVideo_.pop_front();
+            ok &= sendVideoPacket(pkt);
+        }
+        else
+        {
+            AVPacket* pkt = pendingAudio_.front();
+            pendingAudio_.pop_front();
+            ok &= sendAudioPacket(pkt);
+        }
+    }
+    return ok;
+}
 
-            aacFile->write(reinterpret_cast<const char*>(pkt->data), pkt->size);
-            rtmpPush_->sendAudio(pkt->data, pkt->size, pkt->dts);
-            av_packet_unref(pkt);
+uint32_t CRtmpPublisher::toRtmpTimestamp(int64_t dts)
+{
+    if (!tsOffsetSet_)
+    {
+        // 第一个发送的包 dts 最小，以它为基准保证后续时间戳非负
+        tsOffset_ = dts < 0 ? -dts : 0;
+        tsOffsetSet_ = true;
+    }
+    // 交错发送只保证队首按 dts 有序，超时强制发送或停止时的冲刷仍可能让某一路落后于另一路，
+    // 因此以两路共同的上一次时间戳为下限，而不是各自的
+    const int64_t ts = std::max<int64_t>(dts + tsOffset_, lastTimestamp_);
+    lastTimestamp_ = static_cast<uint32_t>(ts);
+    return lastTimestamp_;
+}
+
+bool CRtmpPublisher::sendVideoPacket(AVPacket* pkt)
+{
+    const bool isKeyFrame = (pkt->flags & AV_PKT_FLAG_KEY) != 0;
+    const uint32_t dts = toRtmpTimestamp(pkt->dts);
+    // 有 B 帧时 pts > dts，差值即 CompositionTime；dts 被抬高时相应减小，保持显示时间不变
+    const int32_t cts = pkt->pts != AV_NOPTS_VALUE
+        ? static_cast<int32_t>(std::max<int64_t>(pkt->pts + tsOffset_ - dts, 0)) : 0;
+
+    if (esTap_)
+        esTap_->tap(pkt, PacketType::VIDEO);
+    // 整个 Access Unit（包括 SEI）交给 rtmpPush，由其转换为 AVCC 格式
+    const bool ok = rtmpPush_->sendVideo(pkt->data, pkt->size, dts, cts, isKeyFrame);
+    av_packet_free(&pkt);
+    return ok;
+}
+
+bool CRtmpPublisher::sendAudioPacket(AVPacket* pkt)
+{
+    if (!firstAudioChecked_)
+    {
+        firstAudioChecked_ = true;
+        // FFmpeg 的 aac 编码器在全局头模式下，
+        // 有时会先输出一个包含 "Lavc" 版本信息的非音频数据包。
+        if (pkt->size > 4 && pkt->data[0] == 0xDE && pkt->data[1] == 0x04)
+        {
+            qDebug() << "Skipping first AAC info packet (Lavc).";
             av_packet_free(&pkt);
+            return true;
         }
     }
 
-    return true;
+    const uint32_t dts = toRtmpTimestamp(pkt->dts);
+    if (esTap_)
+        esTap_->tap(pkt, PacketType::AUDIO);
+    const bool ok = rtmpPush_->sendAudio(pkt->data, pkt->size, dts);
+    av_packet_free(&pkt);
+    return ok;
+}
+
+void CRtmpPublisher::clearPending()
+{
+    for (AVPacket* pkt : pendingVideo_)
+        av_packet_free(&pkt);
+    for (AVPacket* pkt : pendingAudio_)
+        av_packet_free(&pkt);
+    pendingVideo_.clear();
+    pendingAudio_.clear();
 }
 
 void CRtmpPublisher::stopPush()
@@ -358,35 +385,25 @@ void CRtmpPublisher::stopPush()
     isPushing_ = false;
     qInfo() << "Stopping pushing...";
 
-    audioCapturer_->stop(); // ֹͣ¼
+    audioCapturer_->stop(); // 停止录音
 
     qInfo() << "Flushing encoders...";
 
-    // ------------------------- Ƶ -------------------------
+    // ------------------------- 清空编码器缓存，与已缓存的包一起按 dts 发送 -------------------------
     QVector<AVPacket*> videoPackets = videoEncoder_->flush();
     for (AVPacket* pkt : videoPackets) {
-        // Ϊ̣ͬΪ첽ʱҪ
-        bool isKeyFrame = (pkt->flags & AV_PKT_FLAG_KEY) != 0;
-        rtmpPush_->sendVideo(pkt->data, pkt->size, pkt->dts, isKeyFrame);
-        av_packet_unref(pkt);
-        av_packet_free(&pkt);
+        pendingVideo_.push_back(pkt);
     }
-
-    // ------------------------- Ƶл -------------------------
     QVector<AVPacket*> audioPackets = audioEncoder_->flush();
     for (AVPacket* pkt : audioPackets) {
-        // Ϊ̣ͬΪ첽ʱҪ
-        rtmpPush_->sendAudio(pkt->data, pkt->size, pkt->dts);
-        av_packet_unref(pkt);
-        av_packet_free(&pkt);
+        pendingAudio_.push_back(pkt);
     }
+    sendInterleaved(true);
 
-    // ------------------------- رrtmpPush -------------------------
+    // ------------------------- 关闭rtmpPush -------------------------
     rtmpPush_->disconnect();
 
-    aacFile->close();
-    h264File->close();
-    cleanup(); // Դ
+    cleanup(); // 清理所有资源
     qInfo() << "Recording stopped.";
 }
 
@@ -398,6 +415,8 @@ bool CRtmpPublisher::isRecording() const
 
 void CRtmpPublisher::cleanup()
 {
+    clearPending();
+    esTap_.reset();     // 析构时写完剩余数据并关闭文件
     rtmpPush_.reset();
     videoEncoder_.reset();
     audioEncoder_.reset();
@@ -408,7 +427,7 @@ bool CRtmpPublisher::getH264Config(std::vector<uint8_t>& sps, std::vector<uint8_
 {
     const AVCodecContext* codecCtx = videoEncoder_->getCodecContext();
 
-    // 1. ֤ĺ extradata Ч
+    // 1. 验证输入上下文和 extradata 的有效性
     if (!codecCtx || !codecCtx->extradata || codecCtx->extradata_size <= 0 ||
         !(codecCtx->flags & AV_CODEC_FLAG_GLOBAL_HEADER) ||
         codecCtx->codec_id != AV_CODEC_ID_H264)
@@ -420,40 +439,40 @@ bool CRtmpPublisher::getH264Config(std::vector<uint8_t>& sps, std::vector<uint8_
     sps.clear();
     pps.clear();
 
-    //  extradata  vector Уʹõ
+    // 将 extradata 拷贝到 vector 中，便于使用迭代器进行搜索
     const std::vector<uint8_t> vecExtraData(codecCtx->extradata, codecCtx->extradata + codecCtx->extradata_size);
     auto itExDataCurr = vecExtraData.cbegin();
     auto itExDataEnd = vecExtraData.cend();
 
-    // 2. ѭ extradataҲе NAL Ԫ
+    // 2. 循环遍历 extradata，查找并分离出所有的 NAL 单元
     while (true) {
-        // ҵǰλõ NAL Ԫʼ
+        // 查找当前位置的 NAL 单元起始码
         auto itNalBegin = find_h264_start_code(itExDataCurr, itExDataEnd);
         if (itNalBegin == itExDataEnd)
             break;
         
         size_t start_code_len = (itNalBegin + 3 < itExDataEnd && itNalBegin[3] == 0x01) ? 4 : 3;
         auto itDataBegin = itNalBegin + start_code_len;
-        auto itNalEnd = find_h264_start_code(itDataBegin, itExDataEnd); // ǰ NAL ԪĽλüһNALԪʼλûitExDataEnd
+        auto itNalEnd = find_h264_start_code(itDataBegin, itExDataEnd); // 当前 NAL 单元的结束位置即下一个NAL单元起始码的位置或者是itExDataEnd
 
-        // ȡǰ NAL Ԫ
+        // 提取当前 NAL 单元的数据
         std::vector<uint8_t> vecNalData(itDataBegin, itNalEnd);
 
         if (!vecNalData.empty()) 
         {
-            // ȡ NAL Ԫ (NAL Header ĵ 5 λ)
+            // 获取 NAL 单元类型 (NAL Header 的低 5 位)
             uint8_t nalType = vecNalData[0] & 0x1F;
 
-            // 3.  NAL Ԫͽз
+            // 3. 根据 NAL 单元类型进行分配
             switch (nalType) {
             case 0x07: // SPS
-                if (sps.empty()) // ֻһҵ SPS
+                if (sps.empty()) // 只保存第一个找到的 SPS
                     sps = vecNalData;
                 else
                     qWarning() << "getH264Config: Found multiple SPS NAL units, using the first one.";
                 break;
             case 0x08: // PPS
-                if (pps.empty()) // ֻһҵ PPS
+                if (pps.empty()) // 只保存第一个找到的 PPS
                     pps = vecNalData;
                 else
                     qWarning() << "getH264Config: Found multiple PPS NAL units, using the first one.";
@@ -467,15 +486,15 @@ bool CRtmpPublisher::getH264Config(std::vector<uint8_t>& sps, std::vector<uint8_
             }
         }
 
-        // Ѿͬʱҵ SPS  PPSͿǰ
+        // 如果已经同时找到了 SPS 和 PPS，就可以提前结束搜索
         if (!sps.empty() && !pps.empty())
             break;
 
-        // һ NAL Ԫʼλü
+        // 从下一个 NAL 单元的起始位置继续搜索
         itExDataCurr = itNalEnd;
     }
 
-    // 4. ռǷɹȡ
+    // 4. 最终检查是否成功提取
     if (sps.empty() || pps.empty()) {
         qCritical() << "getH264Config: Failed to find both SPS and PPS in extradata.";
         return false;
@@ -493,9 +512,9 @@ bool CRtmpPublisher::getAacConfig(std::vector<uint8_t>& asc) {
     {
         return false;
     }
-    //  AACextradata ͨ AudioSpecificConfig
-    // Ҳǰ MP4 Audio Decoder Specific Info Ľṹ
-    // ֱӵľ extradata 
+    // 对于 AAC，extradata 通常就是 AudioSpecificConfig
+    // 但也可能是包含 MP4 Audio Decoder Specific Info 的结构
+    // 最常见和直接的就是 extradata 本身
     asc.assign(codecCtx->extradata, codecCtx->extradata + codecCtx->extradata_size);
     return true;
 
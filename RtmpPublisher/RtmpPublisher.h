@@ -1,6 +1,5 @@
 #ifndef RTMP_PUBLISHER_H
 #define RTMP_PUBLISHER_H
-#include <QFile>
 
 extern "C" {
 
@@ -12,6 +11,7 @@ extern "C" {
 #include <iostream>
 #include <mutex>
 #include <QQueue>
+#include <deque>
 #include <QThread>
 #include <QWaitCondition>
 #include "AVRecorder/AudioCapturer/AudioCapturer.h"
@@ -19,25 +19,8 @@ extern "C" {
 #include "AVRecorder/VideoEncoder/VideoEncoder.h"
 #include "RtmpPush/RtmpPush.h"
 #include "Common/DataDefine.h"
-
-#ifdef _WIN32
-#include <winsock2.h>
-
-// 应用程序在使用任何网络套接字 (socket) 功能之前，必须先调用 WSAStartup 函数来初始化 Winsock 库
-class WinsockGuard {
-public:
-    WinsockGuard() {
-        WSADATA wsaData;
-        int result = WSAStartup(MAKEWORD(2, 2), &wsaData);
-        if (result != 0) {
-            qFatal("WSAStartup failed with error: %d", result);
-        }
-    }
-    ~WinsockGuard() {
-        WSACleanup();
-    }
-};
-#endif
+#include "Common/WinsockGuard.h"
+#include "Common/EsTap/EsTap.h"
 
 class CRtmpPublisher : public QObject
 {
@@ -83,6 +66,22 @@ public:
 private:
     QAudioFormat initAudioFormat(const AudioFormat& fmt);
 
+    /**
+     * @brief 按 dts 顺序交错发送已缓存的音视频包。
+     *        有 B 帧时编码器存在输出延迟，音频包会先于视频包产生，
+     *        RTMP 要求整体时间戳单调递增，因此需要先缓存再按 dts 合并。
+     * @param flushAll 为 true 时不再等待另一路，发送全部缓存（停止推流时使用）
+     */
+    bool sendInterleaved(bool flushAll);
+    bool sendVideoPacket(AVPacket* pkt);
+    bool sendAudioPacket(AVPacket* pkt);
+
+    // 将 dts 转换为 RTMP 时间戳（毫秒，非负，且不小于两路中上一次写出的时间戳）
+    uint32_t toRtmpTimestamp(int64_t dts);
+
+    // 释放所有未发送的缓存包
+    void clearPending();
+
 private:
     // 清理所有资源
     void cleanup();
@@ -103,11 +102,21 @@ private:
     // 用于处理音视频时间戳
     qint64 startTime_ = 0;
 
+    // 等待按 dts 交错发送的音视频包（时间基均为 1/1000）
+    std::deque<AVPacket*> pendingVideo_{};
+    std::deque<AVPacket*> pendingAudio_{};
+    // B 帧和 AAC 的编码延迟会产生负的 dts，以第一个发送的包为基准整体平移为非负
+    int64_t tsOffset_ = 0;
+    bool tsOffsetSet_ = false;
+    // 音视频任一路最近一次写出的时间戳，两路共用，保证 FLV 时间戳整体不回退
+    uint32_t lastTimestamp_ = 0;
+    bool firstAudioChecked_ = false;
+
     // 状态管理
     bool isPushing_ = false;
 
-    QFile* h264File = nullptr; // 用于调试，保存H264数据
-    QFile* aacFile = nullptr; // 用于调试，保存AAC数据
+    // 用于调试，异步保存H264/AAC数据（config_.enableEsTap_ 为 true 时启用）
+    QScopedPointer<CEsTap> esTap_;
 };
 
 #endif // RTMP_PUBLISHER_H
\ No newline at end of file
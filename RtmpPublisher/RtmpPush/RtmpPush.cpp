@@ -4,18 +4,18 @@
 #include <algorithm> // For std::max
 #include <QDebug>
 
-// ---  RTMP ͨͰС ---
+// --- 定义 RTMP 通道和包大小 ---
 #define RTMP_CHANNEL_VIDEO 0x04
 #define RTMP_CHANNEL_AUDIO 0x05
 
 CRtmpPush::CRtmpPush(int log_level)
 {
-    // ʼ librtmp ־
+    // 初始化 librtmp 日志级别
     RTMP_LogSetLevel(static_cast<RTMP_LogLevel>(log_level));
 }
 
 CRtmpPush::~CRtmpPush() {
-    disconnect(); // ȷʱϿ
+    disconnect(); // 确保在销毁时断开连接
 }
 
 bool CRtmpPush::connect(const char* rtmp_url) {
@@ -24,48 +24,48 @@ bool CRtmpPush::connect(const char* rtmp_url) {
         return true;
     }
 
-    //  RTMP 
+    // 分配 RTMP 对象
     RTMP* rtmp_raw = RTMP_Alloc();
     if (!rtmp_raw) {
         qCritical() << "Failed to allocate RTMP object.";
         return false;
     }
 
-    // ʹ unique_ptr 
+    // 使用 unique_ptr 管理生命周期
     rtmpPtr_.reset(rtmp_raw);
 
-    // ʼ RTMP 
+    // 初始化 RTMP 对象
     RTMP_Init(rtmp_raw);
-    rtmp_raw->Link.timeout = 10; // óʱʱ
-    rtmp_raw->Link.lFlags |= RTMP_LF_LIVE; // Ϊֱģʽ
+    rtmp_raw->Link.timeout = 10; // 设置超时时间
+    rtmp_raw->Link.lFlags |= RTMP_LF_LIVE; // 设置为直播模式
 
-    //  URL
+    // 设置推流 URL
     if (!RTMP_SetupURL(rtmp_raw, const_cast<char*>(rtmp_url))) {
         qCritical() << "Failed to setup RTMP URL: " << rtmp_url;
-        rtmpPtr_.reset(); // ָ룬 RTMP_Free
+        rtmpPtr_.reset(); // 重置指针，触发 RTMP_Free
         return false;
     }
 
-    // дģʽ ()
+    // 启用写入模式 (推流)
     RTMP_EnableWrite(rtmp_raw);
 
-    // 
+    // 建立连接
     if (!RTMP_Connect(rtmp_raw, nullptr)) {
         qCritical() << "Failed to connect to RTMP server.";
         rtmpPtr_.reset();
         return false;
     }
 
-    // 
+    // 创建流
     if (!RTMP_ConnectStream(rtmp_raw, 0)) {
         qCritical() << "Failed to connect to RTMP stream.";
-        RTMP_Close(rtmp_raw); // ر
+        RTMP_Close(rtmp_raw); // 关闭连接
         rtmpPtr_.reset();
         return false;
     }
 
     isConnected_ = true;
-    // ÷״̬ȴ initialize 
+    // 重置发送状态，等待 initialize 调用
     sps_pps_sent_ = false;
     asc_sent_ = false;
     qDebug() << "Connected to RTMP server: " << rtmp_url;
@@ -75,13 +75,13 @@ bool CRtmpPush::connect(const char* rtmp_url) {
 void CRtmpPush::disconnect() {
     if (rtmpPtr_ && isConnected_) {
         RTMP_Close(rtmpPtr_.get());
-        // rtmpPtr_.reset() ʽʱ RTMP_Free
+        // rtmpPtr_.reset() 会在作用域结束或显式调用时调用 RTMP_Free
         qDebug() << "Disconnected from RTMP server.";
     }
     isConnected_ = false;
     sps_pps_sent_ = false;
     asc_sent_ = false;
-    // ջ
+    // 清空缓存
     sps_.clear();
     pps_.clear();
     asc_.clear();
@@ -123,7 +123,7 @@ bool CRtmpPush::setAVConfig(const uint8_t* sps, size_t sps_len,
         qCritical() << "Invalid ASC provided to initialize.";
     }
 
-    // ʼͣȵһ IDR ֡Ƶ֡ʱٷ
+    // 初始化后不立即发送，等第一个 IDR 帧或音频帧时再发送
     sps_pps_sent_ = false;
     asc_sent_ = false;
 
@@ -131,7 +131,7 @@ bool CRtmpPush::setAVConfig(const uint8_t* sps, size_t sps_len,
 }
 
 
-bool CRtmpPush::sendVideo(const uint8_t* data, size_t len, uint32_t dts, bool is_keyframe) {
+bool CRtmpPush::sendVideo(const uint8_t* data, size_t len, uint32_t dts, int32_t cts, bool is_keyframe) {
     if (!isConnected() || !data || len == 0) {
         return false;
     }
@@ -139,7 +139,7 @@ bool CRtmpPush::sendVideo(const uint8_t* data, size_t len, uint32_t dts, bool is
     //qDebug() << "Sending Video data, length:" << len << ", dts:" << dts
 		//<< ", is_keyframe:" << (is_keyframe ? "true" : "false");
 
-    // ǹؼ֡ SPS/PPS ûͣȷ
+    // 如果是关键帧且 SPS/PPS 还没发送，则先发送
     if (is_keyframe && !sps_pps_sent_ && !sps_.empty() && !pps_.empty()) {
         if (!sendVideoHeader()) {
             return false;
@@ -147,11 +147,11 @@ bool CRtmpPush::sendVideo(const uint8_t* data, size_t len, uint32_t dts, bool is
         sps_pps_sent_ = true;
     }
 
-    // ͨƵ֡ݰ
-    RTMPPacket* video_packet = createVideoPacket(data, len, dts, is_keyframe);
+    // 创建并发送普通视频帧数据包
+    RTMPPacket* video_packet = createVideoPacket(data, len, dts, cts, is_keyframe);
     if (video_packet) {
         bool res = sendPacket(video_packet);
-        // sendPacket ڲ RTMPPacket_Free  free(packet)
+        // sendPacket 内部会调用 RTMPPacket_Free 和 free(packet)
         return res;
     }
     return false;
@@ -164,20 +164,20 @@ bool CRtmpPush::sendAudio(const uint8_t* data, size_t len, uint32_t dts) {
 
 	//qDebug() << "Sending Audio data, length:" << len << ", dts:" << dts;
 
-    //  Sequence Header һûͣȷ
+    // 如果是 Sequence Header 且还没发送，则先发送
     if (!asc_sent_ && !asc_.empty()) {
         if (!sendAudioHeader()) {
             return false;
         }
         asc_sent_ = true;
-        return true; // Sequence Header 
+        // Sequence Header 发送完毕后继续发送本帧数据，不能丢弃
     }
 
-    //  AAC ԭʼ֡
+    // 发送 AAC 原始数据帧
     RTMPPacket* audio_packet = createAudioPacket(data, len, dts);
     if (audio_packet) {
         bool res = sendPacket(audio_packet);
-        // sendPacket ڲ RTMPPacket_Free  free(packet)
+        // sendPacket 内部会调用 RTMPPacket_Free 和 free(packet)
         return res;
     }
     return false;
@@ -189,10 +189,10 @@ bool CRtmpPush::sendPacket(RTMPPacket* packet, int queue) {
     if (!packet || !isConnected()) {
         return false;
     }
-    // RTMP_SendPacket  1 ʾɹ0 ʾʧ
+    // RTMP_SendPacket 返回 1 表示成功，0 表示失败
     int result = RTMP_SendPacket(rtmpPtr_.get(), packet, queue);
-    RTMPPacket_Free(packet); // ͺͷ packet ڴ
-    free(packet);            // ͷ packet ṹ屾 ( createPacket )
+    RTMPPacket_Free(packet); // 发送后立即释放 packet 内存
+    free(packet);            // 释放 packet 结构体本身 (由 createPacket 分配)
     return result == 1;
 }
 
@@ -201,7 +201,7 @@ bool CRtmpPush::sendVideoHeader() {
     if (!packet) return false;
     RTMPPacket_Reset(packet);
 
-    // С
+    // 计算包体大小
     size_t body_size = 11 + sps_.size() + 1 + 2 + pps_.size() + 2;
     RTMPPacket_Alloc(packet, body_size);
 
@@ -216,7 +216,7 @@ bool CRtmpPush::sendVideoHeader() {
     body[i++] = sps_[1]; // AVCProfileIndication
     body[i++] = sps_[2]; // profile_compatibility
     body[i++] = sps_[3]; // AVCLevelIndication
-    body[i++] = 0xFF; // lengthSizeMinusOne (ͨΪ 3 bytes for length)
+    body[i++] = 0xFF; // lengthSizeMinusOne (通常为 3 bytes for length)
 
     // SPS
     body[i++] = 0xE1; // numOfSequenceParameterSets (1)
@@ -233,15 +233,15 @@ bool CRtmpPush::sendVideoHeader() {
     i += pps_.size();
 
     packet->m_packetType = RTMP_PACKET_TYPE_VIDEO;
-    packet->m_nBodySize = i; // ʵдĴС
+    packet->m_nBodySize = i; // 实际写入的大小
     packet->m_nChannel = RTMP_CHANNEL_VIDEO;
-    packet->m_nTimeStamp = 0; // SPS/PPS ʱͨΪ 0
+    packet->m_nTimeStamp = 0; // SPS/PPS 时间戳通常为 0
     packet->m_hasAbsTimestamp = 0;
     packet->m_headerType = RTMP_PACKET_SIZE_MEDIUM;
     packet->m_nInfoField2 = rtmpPtr_->m_stream_id;
 
-    bool res = sendPacket(packet); // sendPacket ᴦڴͷ
-    // ע⣺packet ָڴ֮ʧЧ
+    bool res = sendPacket(packet); // sendPacket 会处理内存释放
+    // 注意：packet 指针在此之后已失效
     return res;
 }
 
@@ -267,40 +267,61 @@ bool CRtmpPush::sendAudioHeader() {
     packet->m_packetType = RTMP_PACKET_TYPE_AUDIO;
     packet->m_nBodySize = i;
     packet->m_nChannel = RTMP_CHANNEL_AUDIO;
-    packet->m_nTimeStamp = 0; // ASC ʱͨΪ 0
+    packet->m_nTimeStamp = 0; // ASC 时间戳通常为 0
     packet->m_hasAbsTimestamp = 0;
     packet->m_headerType = RTMP_PACKET_SIZE_LARGE;
     packet->m_nInfoField2 = rtmpPtr_->m_stream_id;
 
-    bool res = sendPacket(packet); // sendPacket ᴦڴͷ
-    // ע⣺packet ָڴ֮ʧЧ
+    bool res = sendPacket(packet); // sendPacket 会处理内存释放
+    // 注意：packet 指针在此之后已失效
     return res;
 }
 
 
-RTMPPacket* CRtmpPush::createVideoPacket(const uint8_t* data, size_t len, uint32_t dts, bool is_keyframe) {
+RTMPPacket* CRtmpPush::createVideoPacket(const uint8_t* data, size_t len, uint32_t dts, int32_t cts, bool is_keyframe) {
+    // 拆分 Access Unit 中的所有 NAL（例如 SEI + IDR），没有起始码时整体视为一个 NAL
+    if (splitAnnexB(data, len, nals_) == 0) {
+        nals_.push_back(NalUnit{ data, len });
+    }
+
+    size_t payload_size = 0;
+    for (const NalUnit& nal : nals_) {
+        // AUD 在 FLV 中没有意义，SPS/PPS 已经在 Sequence Header 中发送
+        if (nal.type() == H264_NAL_AUD || nal.type() == H264_NAL_SPS || nal.type() == H264_NAL_PPS)
+            continue;
+        payload_size += 4 + nal.size;
+    }
+    if (payload_size == 0) {
+        return nullptr;
+    }
+
     RTMPPacket* packet = static_cast<RTMPPacket*>(malloc(sizeof(RTMPPacket)));
     if (!packet) return nullptr;
     RTMPPacket_Reset(packet);
 
-    size_t body_size = 9 + len; // 9 bytes for FLV VideoTagHeader + NALU length header
+    size_t body_size = 5 + payload_size; // 5 bytes for FLV VideoTagHeader
     RTMPPacket_Alloc(packet, body_size);
 
     uint8_t* body = reinterpret_cast<uint8_t*>(packet->m_body);
-    int i = 0;
+    size_t i = 0;
     body[i++] = is_keyframe ? 0x17 : 0x27; // FrameType + CodecID
     body[i++] = 0x01; // AVCPacketType = 1 (NALU)
-    body[i++] = 0x00; body[i++] = 0x00; body[i++] = 0x00; // CompositionTime = 0
-
-    // NALU Length (Big Endian)
-    body[i++] = (len >> 24) & 0xFF;
-    body[i++] = (len >> 16) & 0xFF;
-    body[i++] = (len >> 8) & 0xFF;
-    body[i++] = len & 0xFF;
-
-    // NALU Data
-    if (len > 0) {
-        memcpy(body + i, data, len);
+    // CompositionTime：有符号 24 位整数 (Big Endian)
+    body[i++] = (cts >> 16) & 0xFF;
+    body[i++] = (cts >> 8) & 0xFF;
+    body[i++] = cts & 0xFF;
+
+    for (const NalUnit& nal : nals_) {
+        if (nal.type() == H264_NAL_AUD || nal.type() == H264_NAL_SPS || nal.type() == H264_NAL_PPS)
+            continue;
+
+        // NALU Length (Big Endian) + NALU Data
+        body[i++] = (nal.size >> 24) & 0xFF;
+        body[i++] = (nal.size >> 16) & 0xFF;
+        body[i++] = (nal.size >> 8) & 0xFF;
+        body[i++] = nal.size & 0xFF;
+        memcpy(body + i, nal.data, nal.size);
+        i += nal.size;
     }
 
     packet->m_packetType = RTMP_PACKET_TYPE_VIDEO;
@@ -315,7 +336,7 @@ RTMPPacket* CRtmpPush::createVideoPacket(const uint8_t* data, size_t len, uint32
 }
 
 RTMPPacket* CRtmpPush::createAudioPacket(const uint8_t* data, size_t len, uint32_t dts) {
-    // ˺Ӧֻ Raw AAC DataΪ Sequence Header  sendAudioHeader 
+    // 此函数现在应该只处理 Raw AAC Data，因为 Sequence Header 由 sendAudioHeader 处理
 
     RTMPPacket* packet = static_cast<RTMPPacket*>(malloc(sizeof(RTMPPacket)));
     if (!packet) return nullptr;
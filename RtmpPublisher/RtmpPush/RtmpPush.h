@@ -15,11 +15,13 @@ extern "C" {
 #include <memory> // For smart pointers
 #include <cstdint> // For fixed-width integer types
 
+#include "Common/H264NalParser.h"
+
 /**
- * @brief RTMP 
+ * @brief RTMP 推流器类
  *
- * װʹ librtmp  RTMP Ļܡ
- * ֧ H.264 Ƶ AAC Ƶݵķ͡
+ * 该类封装了使用 librtmp 进行 RTMP 推流的基本功能。
+ * 支持 H.264 视频和 AAC 音频数据的发送。
  */
 class CRtmpPush {
 public:
@@ -37,17 +39,17 @@ public:
     bool isConnected() const;
 
     /**
-     * @brief ʼ SPS/PPS  AudioSpecificConfig
+     * @brief 初始化推流器，设置 SPS/PPS 和 AudioSpecificConfig
      *
-     * ˷Ӧ connect ֮󣬿ʼý֮ǰá
+     * 此方法应在 connect 之后，开始发送媒体数据之前调用。
      *
-     * @param sps ָ H.264 SPS ݵָ
-     * @param sps_len SPS ݳ
-     * @param pps ָ H.264 PPS ݵָ
-     * @param pps_len PPS ݳ
-     * @param asc ָ AAC AudioSpecificConfig ݵָ
-     * @param asc_len AudioSpecificConfig ݳ
-     * @return true ʼɹ, false ʧ
+     * @param sps 指向 H.264 SPS 数据的指针
+     * @param sps_len SPS 数据长度
+     * @param pps 指向 H.264 PPS 数据的指针
+     * @param pps_len PPS 数据长度
+     * @param asc 指向 AAC AudioSpecificConfig 数据的指针
+     * @param asc_len AudioSpecificConfig 数据长度
+     * @return true 初始化成功, false 失败
      */
     bool setAVConfig(
         const uint8_t* sps, size_t sps_len,
@@ -55,74 +57,80 @@ public:
         const uint8_t* asc, size_t asc_len);
 
     /**
-     * @brief  H.264 Ƶ
+     * @brief 发送 H.264 视频数据
+     *
+     * 一个 Access Unit 内的所有 NAL 会被转换为 4 字节长度前缀 (AVCC) 格式放入同一个 FLV Tag。
+     * 有 B 帧时 pts != dts，两者之差写入 FLV 的 CompositionTime 字段，播放端据此恢复显示顺序。
      *
-     * @param data ָ H.264 NALU ݵָ (ʼ)
-     * @param len ݳ
-     * @param dts ʱ ()
-     * @param is_keyframe ǷΪؼ֡ (IDR)
-     * @return true ͳɹ, false ʧ
+     * @param data 指向 H.264 Access Unit 的指针 (Annex B 格式，含起始码)。
+     * @param len 数据长度
+     * @param dts 解码时间戳 (毫秒)，调用者需保证音视频整体按 dts 递增发送
+     * @param cts 显示时间与解码时间之差 pts - dts (毫秒)，没有 B 帧时为 0
+     * @param is_keyframe 是否为关键帧 (IDR)
+     * @return true 发送成功, false 发送失败
      */
-    bool sendVideo(const uint8_t* data, size_t len, uint32_t dts, bool is_keyframe);
+    bool sendVideo(const uint8_t* data, size_t len, uint32_t dts, int32_t cts, bool is_keyframe);
 
     /**
-     * @brief  AAC Ƶ
+     * @brief 发送 AAC 音频数据
      *
-     * @param data ָ AAC ԭʼָ֡ ( ADTS ͷ)
-     * @param len ݳ
-     * @param dts ʱ ()
-     * @return true ͳɹ, false ʧ
+     * @param data 指向 AAC 原始数据帧的指针 (不含 ADTS 头)。
+     * @param len 数据长度
+     * @param dts 解码时间戳 (毫秒)
+     * @return true 发送成功, false 发送失败
      */
     bool sendAudio(const uint8_t* data, size_t len, uint32_t dts);
 
 private:
 	/**
-	 * @brief ڲ RTMPPacket
-	 * @param packet Ҫ͵ݰ
-	 * @param queue Ƿݰеȴ (ͨΪ 1)
-	 * @return true ͳɹ, false ʧ
+	 * @brief 内部辅助函数：发送 RTMPPacket
+	 * @param packet 要发送的数据包
+	 * @param queue 是否将数据包放入队列等待发送 (通常设为 1)
+	 * @return true 发送成功, false 发送失败
 	 */
     bool sendPacket(RTMPPacket* packet, int queue = 1);
 
     /**
-     * @brief ڲ AVC Sequence Header ( SPS  PPS)
-     * @return true ͳɹ, false ʧ
+     * @brief 内部辅助函数：发送 AVC Sequence Header (包含 SPS 和 PPS)
+     * @return true 发送成功, false 发送失败
      */
     bool sendVideoHeader();
 
     /**
-     * @brief ڲ AAC Sequence Header ( AudioSpecificConfig)
-     * @return true ͳɹ, false ʧ
+     * @brief 内部辅助函数：发送 AAC Sequence Header (包含 AudioSpecificConfig)
+     * @return true 发送成功, false 发送失败
      */
     bool sendAudioHeader();
 
     /**
-     * @brief ڲ H.264 Ƶ RTMPPacket
-     * @param data NALU 
-     * @param len ݳ
-     * @param dts ʱ
-     * @param is_keyframe ǷΪؼ֡
-     * @return õ RTMPPacket ָ (Ҫ߸ͷŻͺ sendPacket ͷ)
+     * @brief 内部辅助函数：创建 H.264 视频 RTMPPacket
+     * @param data Annex B 格式的 Access Unit
+     * @param len 数据长度
+     * @param dts 时间戳
+     * @param cts CompositionTime (pts - dts)
+     * @param is_keyframe 是否为关键帧
+     * @return 创建好的 RTMPPacket 指针 (需要调用者负责释放或发送后由 sendPacket 释放)
      */
-    RTMPPacket* createVideoPacket(const uint8_t* data, size_t len, uint32_t dts, bool is_keyframe);
+    RTMPPacket* createVideoPacket(const uint8_t* data, size_t len, uint32_t dts, int32_t cts, bool is_keyframe);
 
     /**
-     * @brief ڲ AAC Ƶ RTMPPacket
-     * @param data AAC 
-     * @param len ݳ
-     * @param dts ʱ
-     * @return õ RTMPPacket ָ (Ҫ߸ͷŻͺ sendPacket ͷ)
+     * @brief 内部辅助函数：创建 AAC 音频 RTMPPacket
+     * @param data AAC 数据
+     * @param len 数据长度
+     * @param dts 时间戳
+     * @return 创建好的 RTMPPacket 指针 (需要调用者负责释放或发送后由 sendPacket 释放)
      */
     RTMPPacket* createAudioPacket(const uint8_t* data, size_t len, uint32_t dts);
 
 private:
-    std::unique_ptr<RTMP, decltype(&RTMP_Free)> rtmpPtr_{ nullptr, &RTMP_Free }; // ʹָ RTMP 
+    std::unique_ptr<RTMP, decltype(&RTMP_Free)> rtmpPtr_{ nullptr, &RTMP_Free }; // 使用智能指针管理 RTMP 对象
     bool isConnected_ = false;
-    std::vector<uint8_t> sps_{}; //  SPS
-    std::vector<uint8_t> pps_{}; //  PPS
-    std::vector<uint8_t> asc_{}; //  AAC AudioSpecificConfig
-    bool sps_pps_sent_ = false;     // Ƿѷ SPS/PPS
-    bool asc_sent_ = false;         // Ƿѷ AudioSpecificConfig
+    std::vector<uint8_t> sps_{}; // 缓存 SPS
+    std::vector<uint8_t> pps_{}; // 缓存 PPS
+    std::vector<uint8_t> asc_{}; // 缓存 AAC AudioSpecificConfig
+    bool sps_pps_sent_ = false;     // 标记是否已发送 SPS/PPS
+    bool asc_sent_ = false;         // 标记是否已发送 AudioSpecificConfig
+    std::vector<NalUnit> nals_{};   // 复用的 NAL 列表，避免每帧分配
 };
 
 #endif // RTMP_PUSH_H
\ No newline at end of file
@@ -0,0 +1,298 @@
+#include "RtpPacketizer.h"
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+
+namespace
+{
+    // NTP 纪元（1900-01-01）与 Unix 纪元（1970-01-01）之间的秒数
+    constexpr uint64_t NTP_UNIX_EPOCH_DIFF = 2208988800ULL;
+
+    constexpr uint8_t NAL_TYPE_STAP_A = 24;
+    constexpr uint8_t NAL_TYPE_FU_A = 28;
+
+    inline void writeU16(uint8_t* p, uint16_t v)
+    {
+        p[0] = static_cast<uint8_t>(v >> 8);
+        p[1] = static_cast<uint8_t>(v);
+    }
+
+    inline void writeU32(uint8_t* p, uint32_t v)
+    {
+        p[0] = static_cast<uint8_t>(v >> 24);
+        p[1] = static_cast<uint8_t>(v >> 16);
+        p[2] = static_cast<uint8_t>(v >> 8);
+        p[3] = static_cast<uint8_t>(v);
+    }
+}
+
+// ------------------------- CRtpPacketizer -------------------------
+
+CRtpPacketizer::CRtpPacketizer(uint8_t payloadType, uint32_t clockRate, uint32_t ssrc, size_t mtu)
+    : payloadType_(payloadType & 0x7F), clockRate_(clockRate), ssrc_(ssrc),
+    mtu_(std::max<size_t>(mtu, RTP_HEADER_SIZE + 64))
+{
+    packetBuf_.resize(mtu_);
+    // RFC 3550 建议序列号初值随机，这里用 ssrc 派生即可
+    seq_ = static_cast<uint16_t>(ssrc_ ^ (ssrc_ >> 16));
+}
+
+bool CRtpPacketizer::emitPacket(const uint8_t* prefix, size_t prefixLen,
+    const uint8_t* payload, size_t payloadLen,
+    uint32_t rtpTimestamp, bool marker)
+{
+    const size_t total = RTP_HEADER_SIZE + prefixLen + payloadLen;
+    if (total > packetBuf_.size())
+        packetBuf_.resize(total);
+
+    uint8_t* p = packetBuf_.data();
+    p[0] = 0x80;    // V=2, P=0, X=0, CC=0
+    p[1] = static_cast<uint8_t>((marker ? 0x80 : 0x00) | payloadType_);
+    writeU16(p + 2, seq_++);
+    writeU32(p + 4, rtpTimestamp);
+    writeU32(p + 8, ssrc_);
+
+    if (prefixLen > 0)
+        memcpy(p + RTP_HEADER_SIZE, prefix, prefixLen);
+    if (payloadLen > 0)
+        memcpy(p + RTP_HEADER_SIZE + prefixLen, payload, payloadLen);
+
+    ++packetCount_;
+    octetCount_ += static_cast<uint32_t>(prefixLen + payloadLen);
+
+    return sink_ ? sink_(p, total) : false;
+}
+
+// ------------------------- CH264RtpPacketizer -------------------------
+
+CH264RtpPacketizer::CH264RtpPacketizer(uint8_t payloadType, uint32_t ssrc, size_t mtu)
+    : CRtpPacketizer(payloadType, 90000, ssrc, mtu)
+{
+}
+
+void CH264RtpPacketizer::setParameterSets(const std::vector<uint8_t>& sps, const std::vector<uint8_t>& pps)
+{
+    sps_ = sps;
+    pps_ = pps;
+}
+
+bool CH264RtpPacketizer::packetize(const uint8_t* data, size_t len, uint32_t rtpTimestamp)
+{
+    std::vector<NalUnit> auNals;
+    splitAnnexB(data, len, auNals);
+
+    // ------------------------- 整理本 AU 需要发送的 NAL -------------------------
+    nals_.clear();
+    bool hasIdr = false;
+    bool hasSps = false;
+    for (const NalUnit& nal : auNals)
+    {
+        hasIdr |= (nal.type() == H264_NAL_IDR);
+        hasSps |= (nal.type() == H264_NAL_SPS);
+    }
+    // 全局头模式下 IDR 前不带 SPS/PPS，这里带内补上
+    if (hasIdr && !hasSps && !sps_.empty() && !pps_.empty())
+    {
+        nals_.push_back(NalUnit{ sps_.data(), sps_.size() });
+        nals_.push_back(NalUnit{ pps_.data(), pps_.size() });
+    }
+    for (const NalUnit& nal : auNals)
+    {
+        // AUD 对 RTP 没有意义，直接丢弃
+        if (nal.type() == H264_NAL_AUD)
+            continue;
+        nals_.push_back(nal);
+    }
+
+    if (nals_.empty())
+        return false;
+
+    // ------------------------- 贪心选择打包方式 -------------------------
+    const size_t n = nals_.size();
+    size_t i = 0;
+    while (i < n)
+    {
+        if (nals_[i].size > maxPayload())
+        {
+            if (!sendFuA(nals_[i], rtpTimestamp, i == n - 1))
+                return false;
+            ++i;
+            continue;
+        }
+
+        // 尽可能多地把后续小 NAL 聚合进一个 STAP-A：1 字节 STAP 头 + 每个 NAL 2 字节长度
+        size_t aggSize = 1;
+        size_t j = i;
+        while (j < n && nals_[j].size <= maxPayload() && aggSize + 2 + nals_[j].size <= maxPayload())
+        {
+            aggSize += 2 + nals_[j].size;
+            ++j;
+        }
+
+        const size_t count = j - i;
+        const bool marker = (j == n);
+        if (count <= 1)
+        {
+            if (!sendSingle(nals_[i], rtpTimestamp, marker))
+                return false;
+            ++i;
+        }
+        else
+        {
+            if (!sendStapA(nals_, i, count, rtpTimestamp, marker))
+                return false;
+            i = j;
+        }
+    }
+    return true;
+}
+
+bool CH264RtpPacketizer::sendSingle(const NalUnit& nal, uint32_t rtpTimestamp, bool marker)
+{
+    return emitPacket(nullptr, 0, nal.data, nal.size, rtpTimestamp, marker);
+}
+
+bool CH264RtpPacketizer::sendStapA(const std::vector<NalUnit>& nals, size_t first, size_t count, uint32_t rtpTimestamp, bool marker)
+{
+    stapBuf_.clear();
+    stapBuf_.push_back(0);  // STAP-A 头，最后再填
+
+    uint8_t fBit = 0;
+    uint8_t nri = 0;
+    for (size_t k = first; k < first + count; ++k)
+    {
+        const NalUnit& nal = nals[k];
+        fBit |= nal.data[0] & 0x80;
+        nri = std::max<uint8_t>(nri, nal.data[0] & 0x60);
+
+        stapBuf_.push_back(static_cast<uint8_t>(nal.size >> 8));
+        stapBuf_.push_back(static_cast<uint8_t>(nal.size));
+        stapBuf_.insert(stapBuf_.end(), nal.data, nal.data + nal.size);
+    }
+    // F 位取所有 NAL 的或，NRI 取最大值
+    stapBuf_[0] = static_cast<uint8_t>(fBit | nri | NAL_TYPE_STAP_A);
+
+    return emitPacket(nullptr, 0, stapBuf_.data(), stapBuf_.size(), rtpTimestamp, marker);
+}
+
+bool CH264RtpPacketizer::sendFuA(const NalUnit& nal, uint32_t rtpTimestamp, bool marker)
+{
+    const uint8_t nalHeader = nal.data[0];
+    const uint8_t* payload = nal.data + 1;  // FU-A 不携带原始 NAL Header
+    size_t remain = nal.size - 1;
+    const size_t chunkMax = maxPayload() - 2;
+
+    uint8_t fu[2];
+    fu[0] = static_cast<uint8_t>((nalHeader & 0xE0) | NAL_TYPE_FU_A);  // FU indicator
+
+    bool start = true;
+    while (remain > 0)
+    {
+        const size_t chunk = std::min(remain, chunkMax);
+        const bool end = (chunk == remain);
+
+        fu[1] = static_cast<uint8_t>((start ? 0x80 : 0x00) | (end ? 0x40 : 0x00) | (nalHeader & 0x1F));   // FU header
+        if (!emitPacket(fu, 2, payload, chunk, rtpTimestamp, end && marker))
+            return false;
+
+        payload += chunk;
+        remain -= chunk;
+        start = false;
+    }
+    return true;
+}
+
+// ------------------------- CAacRtpPacketizer -------------------------
+
+CAacRtpPacketizer::CAacRtpPacketizer(uint8_t payloadType, uint32_t sampleRate, uint32_t ssrc, size_t mtu)
+    : CRtpPacketizer(payloadType, sampleRate, ssrc, mtu)
+{
+}
+
+bool CAacRtpPacketizer::packetize(const uint8_t* data, size_t len, uint32_t rtpTimestamp)
+{
+    // AU-size 只有 13 位
+    if (!data || len == 0 || len > 0x1FFF)
+        return false;
+
+    uint8_t auHeader[4];
+    writeU16(auHeader, 16);     // AU-headers-length，单位 bit：一个 16 bit 的 AU-header
+    writeU16(auHeader + 2, static_cast<uint16_t>(len << 3));    // AU-size(13) + AU-index(3)=0
+
+    const size_t chunkMax = maxPayload() - sizeof(auHeader);
+    size_t offset = 0;
+    while (offset < len)
+    {
+        const size_t chunk = std::min(len - offset, chunkMax);
+        const bool last = (offset + chunk == len);
+        if (!emitPacket(auHeader, sizeof(auHeader), data + offset, chunk, rtpTimestamp, last))
+            return false;
+        offset += chunk;
+    }
+    return true;
+}
+
+// ------------------------- RTCP -------------------------
+
+namespace Rtcp
+{
+    std::vector<uint8_t> buildSenderReport(uint32_t ssrc, uint64_t ntpTime, uint32_t rtpTimestamp,
+        uint32_t packetCount, uint32_t octetCount, const std::string& cname)
+    {
+        std::vector<uint8_t> out;
+
+        // ------------------------- SR：28 字节，无 report block -------------------------
+        out.resize(28);
+        uint8_t* p = out.data();
+        p[0] = 0x80;        // V=2, P=0, RC=0
+        p[1] = 200;         // PT=SR
+        writeU16(p + 2, 6); // 长度：32 bit 字数 - 1
+        writeU32(p + 4, ssrc);
+        writeU32(p + 8, static_cast<uint32_t>(ntpTime >> 32));
+        writeU32(p + 12, static_cast<uint32_t>(ntpTime));
+        writeU32(p + 16, rtpTimestamp);
+        writeU32(p + 20, packetCount);
+        writeU32(p + 24, octetCount);
+
+        // ------------------------- SDES：一个 chunk，只含 CNAME -------------------------
+        const size_t cnameLen = std::min<size_t>(cname.size(), 255);
+        // chunk = SSRC(4) + type(1) + len(1) + text + 至少 1 字节 END，整体按 4 字节对齐
+        size_t chunkLen = 4 + 2 + cnameLen + 1;
+        chunkLen = (chunkLen + 3) & ~static_cast<size_t>(3);
+        const size_t sdesLen = 4 + chunkLen;
+
+        const size_t sdesOffset = out.size();
+        out.resize(sdesOffset + sdesLen, 0);
+        p = out.data() + sdesOffset;
+        p[0] = 0x81;        // V=2, P=0, SC=1
+        p[1] = 202;         // PT=SDES
+        writeU16(p + 2, static_cast<uint16_t>(sdesLen / 4 - 1));
+        writeU32(p + 4, ssrc);
+        p[8] = 1;           // CNAME
+        p[9] = static_cast<uint8_t>(cnameLen);
+        memcpy(p + 10, cname.data(), cnameLen);
+        // 剩余字节已填 0，作为 END 与对齐
+
+        return out;
+    }
+
+    std::vector<uint8_t> buildBye(uint32_t ssrc)
+    {
+        std::vector<uint8_t> out(8);
+        out[0] = 0x81;      // V=2, P=0, SC=1
+        out[1] = 203;       // PT=BYE
+        writeU16(out.data() + 2, 1);
+        writeU32(out.data() + 4, ssrc);
+        return out;
+    }
+
+    uint64_t ntpNow()
+    {
+        using namespace std::chrono;
+        const auto sinceEpoch = system_clock::now().time_since_epoch();
+        const uint64_t us = static_cast<uint64_t>(duration_cast<microseconds>(sinceEpoch).count());
+        const uint64_t sec = us / 1000000 + NTP_UNIX_EPOCH_DIFF;
+        const uint64_t frac = ((us % 1000000) << 32) / 1000000;
+        return (sec << 32) | frac;
+    }
+}
@@ -0,0 +1,153 @@
+#ifndef RTP_PACKETIZER_H
+#define RTP_PACKETIZER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <string>
+#include <functional>
+
+#include "Common/H264NalParser.h"
+
+/*
+ * RTP/RTCP 打包器，只负责组包，不关心传输方式（UDP 或 RTSP over TCP interleaved）。
+ * 每生成一个完整的 RTP 包就调用一次 sink 回调，由 CRtspPush 决定如何发送。
+ */
+
+// 参数：完整的 RTP 包（含 12 字节 RTP Header）及其长度；返回 false 表示发送失败
+using RtpPacketSink = std::function<bool(const uint8_t* data, size_t len)>;
+
+class CRtpPacketizer
+{
+public:
+    static constexpr size_t RTP_HEADER_SIZE = 12;
+
+    /**
+     * @param payloadType SDP 中声明的动态负载类型（如 96/97）
+     * @param clockRate RTP 时钟频率（视频 90000，音频为采样率）
+     * @param ssrc 同步源标识
+     * @param mtu 单个 RTP 包（含 RTP Header）的最大字节数
+     */
+    CRtpPacketizer(uint8_t payloadType, uint32_t clockRate, uint32_t ssrc, size_t mtu);
+    virtual ~CRtpPacketizer() = default;
+
+    CRtpPacketizer(const CRtpPacketizer&) = delete;
+    CRtpPacketizer& operator=(const CRtpPacketizer&) = delete;
+
+    void setSink(RtpPacketSink sink) { sink_ = std::move(sink); }
+
+    uint8_t getPayloadType() const { return payloadType_; }
+    uint32_t getClockRate() const { return clockRate_; }
+    uint32_t getSsrc() const { return ssrc_; }
+    // RTCP SR 需要的统计信息
+    uint32_t getPacketCount() const { return packetCount_; }
+    uint32_t getOctetCount() const { return octetCount_; }
+
+protected:
+    /**
+     * @brief 组装 RTP Header + payload 并交给 sink。
+     *        payload 可以分成前缀（如 FU 头、AU 头）和数据两段传入，避免额外拷贝。
+     */
+    bool emitPacket(const uint8_t* prefix, size_t prefixLen,
+        const uint8_t* payload, size_t payloadLen,
+        uint32_t rtpTimestamp, bool marker);
+
+    // 单个 RTP 包可承载的最大负载
+    size_t maxPayload() const { return mtu_ - RTP_HEADER_SIZE; }
+
+private:
+    RtpPacketSink sink_;
+    std::vector<uint8_t> packetBuf_;    // 复用的组包缓冲区，避免每个包都分配内存
+
+    uint8_t payloadType_ = 96;
+    uint32_t clockRate_ = 90000;
+    uint32_t ssrc_ = 0;
+    size_t mtu_ = 1400;
+    uint16_t seq_ = 0;
+
+    uint32_t packetCount_ = 0;
+    uint32_t octetCount_ = 0;
+};
+
+/**
+ * @brief H.264 RTP 打包（RFC 6184, packetization-mode=1）。
+ *
+ * 一个 Access Unit 内：
+ * 1. 能放进一个包的连续小 NAL 聚合为 STAP-A（例如 SPS + PPS + SEI）；
+ * 2. 只剩一个能放下的 NAL 时使用 Single NAL Unit 模式；
+ * 3. 超过 MTU 的 NAL 使用 FU-A 分片。
+ * Access Unit 的最后一个包置 marker 位。
+ */
+class CH264RtpPacketizer : public CRtpPacketizer
+{
+public:
+    CH264RtpPacketizer(uint8_t payloadType, uint32_t ssrc, size_t mtu = 1400);
+
+    /**
+     * @brief 设置 SPS/PPS，之后每个 IDR 前都会带内重发一次，方便中途加入的播放端解码。
+     */
+    void setParameterSets(const std::vector<uint8_t>& sps, const std::vector<uint8_t>& pps);
+
+    /**
+     * @brief 打包并发送一个 Access Unit。
+     * @param data Annex B 格式的数据（含起始码）
+     * @param len 数据长度
+     * @param rtpTimestamp 90kHz 的 RTP 时间戳（对应 pts）
+     */
+    bool packetize(const uint8_t* data, size_t len, uint32_t rtpTimestamp);
+
+private:
+    bool sendSingle(const NalUnit& nal, uint32_t rtpTimestamp, bool marker);
+    bool sendStapA(const std::vector<NalUnit>& nals, size_t first, size_t count, uint32_t rtpTimestamp, bool marker);
+    bool sendFuA(const NalUnit& nal, uint32_t rtpTimestamp, bool marker);
+
+private:
+    std::vector<uint8_t> sps_{};
+    std::vector<uint8_t> pps_{};
+    std::vector<NalUnit> nals_{};       // 复用的 NAL 列表
+    std::vector<uint8_t> stapBuf_{};    // 复用的 STAP-A 负载缓冲区
+};
+
+/**
+ * @brief AAC RTP 打包（RFC 3640, mode=AAC-hbr）。
+ *
+ * 每个包携带一个 AU：AU-headers-length(16bit) + AU-header(13bit size + 3bit index)。
+ * 超过 MTU 的 AU 按 RFC 3640 3.2.3 分片，每个分片都携带完整 AU 大小，仅最后一片置 marker。
+ */
+class CAacRtpPacketizer : public CRtpPacketizer
+{
+public:
+    CAacRtpPacketizer(uint8_t payloadType, uint32_t sampleRate, uint32_t ssrc, size_t mtu = 1400);
+
+    /**
+     * @param data 原始 AAC 帧（不含 ADTS 头）
+     * @param len 数据长度
+     * @param rtpTimestamp 以采样率为单位的 RTP 时间戳
+     */
+    bool packetize(const uint8_t* data, size_t len, uint32_t rtpTimestamp);
+};
+
+/**
+ * @brief RTCP 相关的辅助函数
+ */
+namespace Rtcp
+{
+    /**
+     * @brief 生成 SR + SDES(CNAME) 复合包（RFC 3550 6.4.1 / 6.5）
+     * @param ntpTime 64 位 NTP 时间戳（高 32 位秒，低 32 位小数）
+     * @param rtpTimestamp 与 ntpTime 同一时刻的 RTP 时间戳
+     * @return 复合 RTCP 包
+     */
+    std::vector<uint8_t> buildSenderReport(uint32_t ssrc, uint64_t ntpTime, uint32_t rtpTimestamp,
+        uint32_t packetCount, uint32_t octetCount, const std::string& cname);
+
+    /**
+     * @brief 生成 BYE 包，推流结束时发送。
+     */
+    std::vector<uint8_t> buildBye(uint32_t ssrc);
+
+    // 当前系统时间对应的 NTP 时间戳
+    uint64_t ntpNow();
+}
+
+#endif // RTP_PACKETIZER_H
@@ -0,0 +1,289 @@
+#include "RtspPublisher.h"
+#include <QDebug>
+#include <qguiapplication.h>
+#include "Common/H264NalParser.h"
+
+CRtspPublisher::CRtspPublisher(QObject* parent)
+    : QObject(parent)
+{
+    av_register_all();
+    avcodec_register_all();
+}
+
+CRtspPublisher::~CRtspPublisher()
+{
+    if (isPushing_)
+    {
+        stopPush();
+    }
+}
+
+CRtspPublisher* CRtspPublisher::GetInstance()
+{
+    static CRtspPublisher objRtspPublisher{};
+
+    return &objRtspPublisher;
+}
+
+QAudioFormat CRtspPublisher::initAudioFormat(const AudioFormat& fmt)
+{
+    QAudioFormat audioFormat;
+    audioFormat.setSampleRate(fmt.sample_rate_);
+    audioFormat.setChannelCount(fmt.channels_);
+    audioFormat.setSampleSize(fmt.sample_size_);
+    audioFormat.setSampleType(fmt.sample_fmt_);
+    audioFormat.setByteOrder(fmt.byte_order_);
+    audioFormat.setCodec(fmt.codec_);
+
+    return audioFormat;
+}
+
+bool CRtspPublisher::initialize(AVConfig& config)
+{
+    if (isPushing_)
+    {
+        qWarning() << "Controller is busy. Please stop pushing first.";
+        return false;
+    }
+
+    cleanup();
+    config_ = config;
+
+    // ------------------------- rtspPush初始化 -------------------------
+    rtspPush_.reset(new CRtspPush{ config_.rtpTransport_ });
+    if (!rtspPush_->connect(config_.path_.c_str()))
+    {
+        qCritical() << "Failed to initialize rtspPush.";
+        cleanup();
+        return false;
+    }
+
+    // ------------------------- 视频编码器初始化 -------------------------
+    videoEncoder_.reset(new CVideoEncoder{});
+    if (!videoEncoder_->initialize(config_.videoCodecCfg_))
+    {
+        qCritical() << "Failed to initialize Video Encoder.";
+        cleanup();
+        return false;
+    }
+    // H.264 的 RTP 时钟固定为 90kHz，编码器直接输出该时间基的时间戳
+    videoEncoder_->setTimeBase({ 1, 90000 });
+
+    // ------------------------- 录音设备初始化 -------------------------
+    audioCapturer_.reset(new CAudioCapturer{});
+    QAudioFormat audioFormat = initAudioFormat(config_.audioFmt_);
+    if (!audioCapturer_->initialize(audioFormat, config_.audioFmt_))
+    {
+        qCritical() << "Failed to initialize Audio Capturer.";
+        cleanup();
+        return false;
+    }
+
+    // ------------------------- 音频编码器初始化 -------------------------
+    audioEncoder_.reset(new CAudioEncoder{});
+    if (!audioEncoder_->initialize(config_.audioCodecCfg_, config_.audioFmt_))
+    {
+        qCritical() << "Failed to initialize Audio Encoder.";
+        cleanup();
+        return false;
+    }
+    // AAC 的 RTP 时钟等于采样率
+    audioEncoder_->setTimeBase({ 1, config_.audioCodecCfg_.sample_rate_ });
+
+    qInfo() << "RtspPublisher initialized successfully.";
+
+    return true;
+}
+
+bool CRtspPublisher::startPush()
+{
+    if (isPushing_) return true;
+    if (!rtspPush_ || !rtspPush_->isConnected())
+    {
+        qCritical() << "RtspPublisher is not initialized.";
+        return false;
+    }
+
+    // ------------------------- SDP 需要 H.264 和 AAC 的配置信息 -------------------------
+    std::vector<uint8_t> sps{}, pps{}, asc{};
+    if (!getH264Config(sps, pps))
+    {
+        qCritical() << "Failed to get H.264 config.";
+        cleanup();
+        return false;
+    }
+
+    if (!getAacConfig(asc))
+    {
+        qCritical() << "Failed to get AAC config.";
+        cleanup();
+        return false;
+    }
+
+    if (!rtspPush_->setAVConfig(
+        sps.data(), sps.size(),
+        pps.data(), pps.size(),
+        asc.data(), asc.size(),
+        config_.audioCodecCfg_.sample_rate_, config_.audioCodecCfg_.channels_))
+    {
+        qCritical() << "Failed to start RTSP session.";
+        cleanup();
+        return false;
+    }
+
+    // ------------------------- 调试用的裸流旁路，默认关闭 -------------------------
+    if (config_.enableEsTap_)
+    {
+        esTap_.reset(new CEsTap{});
+        if (!esTap_->open(qApp->applicationDirPath().toStdString(),
+            videoEncoder_->getCodecContext(), audioEncoder_->getCodecContext()))
+        {
+            qWarning() << "Failed to open elementary stream tap, continue without it.";
+            esTap_.reset();
+        }
+    }
+
+    // ------------------------- 重置时间戳 -------------------------
+    audioEncoder_->resetTimestamp();
+    videoEncoder_->resetTimestamp();
+    audioCapturer_->start(); // 开始录音，填充音频缓冲区
+
+    isPushing_ = true;
+    qInfo() << "Rtsp pushing started.";
+    return true;
+}
+
+bool CRtspPublisher::sendVideoPackets(QVector<AVPacket*>& packets)
+{
+    bool ok = true;
+    for (AVPacket* pkt : packets)
+    {
+        // RTP 时间戳对应显示时间，使用 pts；打包器会自行拆分 Annex B 中的所有 NAL
+        if (esTap_)
+            esTap_->tap(pkt, PacketType::VIDEO);
+        ok &= rtspPush_->sendVideo(pkt->data, static_cast<size_t>(pkt->size), pkt->pts);
+        av_packet_free(&pkt);
+    }
+    packets.clear();
+    return ok;
+}
+
+bool CRtspPublisher::sendAudioPackets(QVector<AVPacket*>& packets)
+{
+    bool ok = true;
+    for (AVPacket* pkt : packets)
+    {
+        if (esTap_)
+            esTap_->tap(pkt, PacketType::AUDIO);
+        ok &= rtspPush_->sendAudio(pkt->data, static_cast<size_t>(pkt->size), pkt->pts);
+        av_packet_free(&pkt);
+    }
+    packets.clear();
+    return ok;
+}
+
+bool CRtspPublisher::pushing(const unsigned char* rgbData)
+{
+    if (!isPushing_) return false;
+    if (!rgbData) return false;
+
+    // ------------------------- 视频编码 -------------------------
+    QVector<AVPacket*> videoPackets = videoEncoder_->encode(rgbData);
+    bool ok = sendVideoPackets(videoPackets);
+
+    // ------------------------- 音频编码 -------------------------
+    // 循环处理所有在缓冲区中积累的完整音频帧
+    const int audioBytesPerFrame = audioEncoder_->getBytesPerFrame();
+    while (true)
+    {
+        QByteArray pcmChunk = audioCapturer_->readChunk(audioBytesPerFrame);
+        if (pcmChunk.isEmpty())
+            break; // 音频数据不够一帧
+
+        QVector<AVPacket*> audioPackets = audioEncoder_->encode(reinterpret_cast<const uint8_t*>(pcmChunk.constData()));
+        ok &= sendAudioPackets(audioPackets);
+    }
+
+    return ok;
+}
+
+void CRtspPublisher::stopPush()
+{
+    if (!isPushing_) return;
+
+    isPushing_ = false;
+    qInfo() << "Stopping rtsp pushing...";
+
+    audioCapturer_->stop(); // 停止录音
+
+    // ------------------------- 清空编码器缓存 -------------------------
+    QVector<AVPacket*> videoPackets = videoEncoder_->flush();
+    sendVideoPackets(videoPackets);
+    QVector<AVPacket*> audioPackets = audioEncoder_->flush();
+    sendAudioPackets(audioPackets);
+
+    // ------------------------- 发送 BYE/TEARDOWN -------------------------
+    rtspPush_->disconnect();
+
+    cleanup(); // 清理所有资源
+    qInfo() << "Rtsp pushing stopped.";
+}
+
+bool CRtspPublisher::isPushing() const
+{
+    return isPushing_;
+}
+
+void CRtspPublisher::cleanup()
+{
+    esTap_.reset();     // 析构时写完剩余数据并关闭文件
+    rtspPush_.reset();
+    videoEncoder_.reset();
+    audioEncoder_.reset();
+    audioCapturer_.reset();
+}
+
+bool CRtspPublisher::getH264Config(std::vector<uint8_t>& sps, std::vector<uint8_t>& pps)
+{
+    const AVCodecContext* codecCtx = videoEncoder_->getCodecContext();
+    if (!codecCtx || !codecCtx->extradata || codecCtx->extradata_size <= 0 ||
+        codecCtx->codec_id != AV_CODEC_ID_H264)
+    {
+        qWarning() << "getH264Config: Invalid video encoder context or extradata is not available/valid.";
+        return false;
+    }
+
+    sps.clear();
+    pps.clear();
+
+    std::vector<NalUnit> nals;
+    splitAnnexB(codecCtx->extradata, static_cast<size_t>(codecCtx->extradata_size), nals);
+    for (const NalUnit& nal : nals)
+    {
+        // 只保存第一个找到的 SPS/PPS
+        if (nal.type() == H264_NAL_SPS && sps.empty())
+            sps.assign(nal.data, nal.data + nal.size);
+        else if (nal.type() == H264_NAL_PPS && pps.empty())
+            pps.assign(nal.data, nal.data + nal.size);
+    }
+
+    if (sps.empty() || pps.empty())
+    {
+        qCritical() << "getH264Config: Failed to find both SPS and PPS in extradata.";
+        return false;
+    }
+    return true;
+}
+
+bool CRtspPublisher::getAacConfig(std::vector<uint8_t>& asc)
+{
+    const AVCodecContext* codecCtx = audioEncoder_->getCodecContext();
+    if (!codecCtx || !codecCtx->extradata || codecCtx->extradata_size <= 0 ||
+        codecCtx->codec_id != AV_CODEC_ID_AAC)
+    {
+        return false;
+    }
+    // 全局头模式下 extradata 即 AudioSpecificConfig
+    asc.assign(codecCtx->extradata, codecCtx->extradata + codecCtx->extradata_size);
+    return true;
+}
@@ -0,0 +1,79 @@
+#ifndef RTSP_PUBLISHER_H
+#define RTSP_PUBLISHER_H
+
+extern "C" {
+
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+}
+#include <QObject>
+#include <QScopedPointer>
+#include "AVRecorder/AudioCapturer/AudioCapturer.h"
+#include "AVRecorder/AudioEncoder/AudioEncoder.h"
+#include "AVRecorder/VideoEncoder/VideoEncoder.h"
+#include "RtspPush/RtspPush.h"
+#include "Common/DataDefine.h"
+#include "Common/WinsockGuard.h"
+#include "Common/EsTap/EsTap.h"
+
+/**
+ * @brief RTSP 推流（ANNOUNCE/RECORD），流程与 CRtmpPublisher 一致：
+ *        在绘制线程中同步完成 视频编码、音频编码 和 RTP 发送。
+ *        视频时间基为 1/90000，音频时间基为 1/采样率，编码器输出的 pts 可直接作为 RTP 时间戳偏移。
+ */
+class CRtspPublisher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit CRtspPublisher(QObject* parent = nullptr);
+    ~CRtspPublisher();
+    static CRtspPublisher* GetInstance();
+
+public:
+    bool initialize(AVConfig& config);
+
+    bool startPush();
+
+    /**
+     * @brief 处理一帧视频和所有可用的音频。
+     * @param rgbData OpenGL捕获的rgb数据（方向与FFmpeg相反）。
+     * @return 编码发送成功返回true，否则返回false
+     */
+    bool pushing(const unsigned char* rgbData);
+
+    void stopPush();
+
+    bool isPushing() const;
+
+private:
+    QAudioFormat initAudioFormat(const AudioFormat& fmt);
+
+    // 从 extradata 中提取 SPS/PPS/AudioSpecificConfig
+    bool getH264Config(std::vector<uint8_t>& sps, std::vector<uint8_t>& pps);
+    bool getAacConfig(std::vector<uint8_t>& asc);
+
+    bool sendVideoPackets(QVector<AVPacket*>& packets);
+    bool sendAudioPackets(QVector<AVPacket*>& packets);
+
+    // 清理所有资源
+    void cleanup();
+
+private:
+    // 核心组件
+    QScopedPointer<CRtspPush> rtspPush_;
+    QScopedPointer<CVideoEncoder> videoEncoder_;
+    QScopedPointer<CAudioEncoder> audioEncoder_;
+    QScopedPointer<CAudioCapturer> audioCapturer_;
+    // 用于调试，异步保存H264/AAC数据（config_.enableEsTap_ 为 true 时启用）
+    QScopedPointer<CEsTap> esTap_;
+
+#ifdef _WIN32
+    WinsockGuard winsockGuard_{};
+#endif
+
+    AVConfig config_{};
+
+    bool isPushing_ = false;
+};
+
+#endif // RTSP_PUBLISHER_H
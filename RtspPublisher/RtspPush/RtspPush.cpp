@@ -0,0 +1,787 @@
+#include "RtspPush.h"
+#include <cstring>
+#include <cstdlib>
+#include <random>
+#include <algorithm>
+#include <QDebug>
+
+#ifdef _WIN32
+#pragma comment(lib, "ws2_32.lib")
+using socklen_type = int;
+#define RTSP_SEND_FLAGS 0
+#else
+#include <netdb.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <sys/select.h>
+#include <sys/time.h>
+using socklen_type = socklen_t;
+#define RTSP_SEND_FLAGS MSG_NOSIGNAL
+#endif
+
+namespace
+{
+    constexpr uint8_t VIDEO_PAYLOAD_TYPE = 96;
+    constexpr uint8_t AUDIO_PAYLOAD_TYPE = 97;
+    constexpr size_t RTP_MTU = 1400;
+    constexpr uint16_t CLIENT_PORT_BASE = 50000;
+    constexpr int CLIENT_PORT_TRIES = 100;
+    constexpr int CTRL_RECV_TIMEOUT_MS = 5000;
+    constexpr int SEND_BUFFER_SIZE = 1024 * 1024;
+    const char* const USER_AGENT = "LMEngine";
+
+    void closeSocket(rtsp_socket_t& sock)
+    {
+        if (sock == RTSP_INVALID_SOCKET)
+            return;
+#ifdef _WIN32
+        closesocket(sock);
+#else
+        close(sock);
+#endif
+        sock = RTSP_INVALID_SOCKET;
+    }
+
+    void setRecvTimeout(rtsp_socket_t sock, int ms)
+    {
+#ifdef _WIN32
+        DWORD tv = static_cast<DWORD>(ms);
+#else
+        timeval tv{ ms / 1000, (ms % 1000) * 1000 };
+#endif
+        setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&tv), sizeof(tv));
+    }
+
+    void setSockAddrPort(sockaddr_storage& addr, uint16_t port)
+    {
+        if (addr.ss_family == AF_INET6)
+            reinterpret_cast<sockaddr_in6*>(&addr)->sin6_port = htons(port);
+        else
+            reinterpret_cast<sockaddr_in*>(&addr)->sin_port = htons(port);
+    }
+
+    // 套接字在 select 判定下是否可读（不阻塞）
+    bool isReadable(rtsp_socket_t sock)
+    {
+        if (sock == RTSP_INVALID_SOCKET)
+            return false;
+        fd_set rfds;
+        FD_ZERO(&rfds);
+        FD_SET(sock, &rfds);
+        timeval tv{ 0, 0 };
+        return select(static_cast<int>(sock) + 1, &rfds, nullptr, nullptr, &tv) > 0;
+    }
+
+    std::string base64Encode(const uint8_t* data, size_t len)
+    {
+        static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        std::string out;
+        out.reserve((len + 2) / 3 * 4);
+        for (size_t i = 0; i < len; i += 3)
+        {
+            uint32_t v = static_cast<uint32_t>(data[i]) << 16;
+            if (i + 1 < len) v |= static_cast<uint32_t>(data[i + 1]) << 8;
+            if (i + 2 < len) v |= data[i + 2];
+            out.push_back(table[(v >> 18) & 0x3F]);
+            out.push_back(table[(v >> 12) & 0x3F]);
+            out.push_back(i + 1 < len ? table[(v >> 6) & 0x3F] : '=');
+            out.push_back(i + 2 < len ? table[v & 0x3F] : '=');
+        }
+        return out;
+    }
+
+    std::string hexEncode(const uint8_t* data, size_t len)
+    {
+        static const char table[] = "0123456789ABCDEF";
+        std::string out;
+        out.reserve(len * 2);
+        for (size_t i = 0; i < len; ++i)
+        {
+            out.push_back(table[data[i] >> 4]);
+            out.push_back(table[data[i] & 0x0F]);
+        }
+        return out;
+    }
+
+    // 在响应头中查找指定字段（不区分大小写），返回去掉首尾空白的值
+    std::string findHeader(const std::string& headers, const char* name)
+    {
+        const size_t nameLen = strlen(name);
+        size_t pos = 0;
+        while (pos < headers.size())
+        {
+            size_t lineEnd = headers.find("\r\n", pos);
+            if (lineEnd == std::string::npos)
+                lineEnd = headers.size();
+
+            if (lineEnd - pos > nameLen && headers[pos + nameLen] == ':')
+            {
+                bool match = true;
+                for (size_t i = 0; i < nameLen && match; ++i)
+                    match = tolower(static_cast<unsigned char>(headers[pos + i])) == tolower(static_cast<unsigned char>(name[i]));
+                if (match)
+                {
+                    size_t b = pos + nameLen + 1;
+                    while (b < lineEnd && headers[b] == ' ') ++b;
+                    size_t e = lineEnd;
+                    while (e > b && headers[e - 1] == ' ') --e;
+                    return headers.substr(b, e - b);
+                }
+            }
+            pos = lineEnd + 2;
+        }
+        return {};
+    }
+
+    // 解析 Transport 头里形如 key=a-b 的端口/通道对
+    bool parseRange(const std::string& transport, const char* key, int& first, int& second)
+    {
+        const size_t pos = transport.find(key);
+        if (pos == std::string::npos)
+            return false;
+        const char* p = transport.c_str() + pos + strlen(key);
+        char* endPtr = nullptr;
+        first = static_cast<int>(strtol(p, &endPtr, 10));
+        if (endPtr == p)
+            return false;
+        second = (*endPtr == '-') ? static_cast<int>(strtol(endPtr + 1, nullptr, 10)) : first + 1;
+        return true;
+    }
+}
+
+CRtspPush::CRtspPush(RtpTransport transport)
+    : transport_(transport)
+{
+    // RFC 3550 要求 SSRC、序列号、时间戳起点均为随机值
+    std::random_device rd;
+    std::mt19937 gen(rd());
+    std::uniform_int_distribution<uint32_t> dist;
+
+    videoPacketizer_.reset(new CH264RtpPacketizer(VIDEO_PAYLOAD_TYPE, dist(gen), RTP_MTU));
+    audioPacketizer_.reset(new CAacRtpPacketizer(AUDIO_PAYLOAD_TYPE, sampleRate_, dist(gen), RTP_MTU));
+    videoChannel_.rtpBase = dist(gen);
+    audioChannel_.rtpBase = dist(gen);
+
+    char cname[32];
+    snprintf(cname, sizeof(cname), "lmengine-%08x", dist(gen));
+    cname_ = cname;
+}
+
+CRtspPush::~CRtspPush()
+{
+    disconnect(); // 确保在销毁时断开连接
+}
+
+bool CRtspPush::parseUrl(const std::string& url)
+{
+    const std::string prefix = "rtsp://";
+    if (url.compare(0, prefix.size(), prefix) != 0)
+    {
+        qCritical() << "Invalid RTSP URL:" << url.c_str();
+        return false;
+    }
+
+    std::string hostPort = url.substr(prefix.size());
+    const size_t slash = hostPort.find('/');
+    if (slash != std::string::npos)
+        hostPort = hostPort.substr(0, slash);
+
+    // 暂不支持鉴权，带用户名密码的地址只取主机部分
+    const size_t at = hostPort.rfind('@');
+    if (at != std::string::npos)
+    {
+        qWarning() << "RTSP authentication is not supported, credentials ignored.";
+        hostPort = hostPort.substr(at + 1);
+    }
+
+    port_ = 554;
+    if (!hostPort.empty() && hostPort[0] == '[')
+    {
+        // IPv6 字面量：[::1]:8554
+        const size_t close = hostPort.find(']');
+        if (close == std::string::npos)
+            return false;
+        host_ = hostPort.substr(1, close - 1);
+        if (close + 1 < hostPort.size() && hostPort[close + 1] == ':')
+            port_ = static_cast<uint16_t>(atoi(hostPort.c_str() + close + 2));
+    }
+    else
+    {
+        const size_t colon = hostPort.find(':');
+        host_ = hostPort.substr(0, colon);
+        if (colon != std::string::npos)
+            port_ = static_cast<uint16_t>(atoi(hostPort.c_str() + colon + 1));
+    }
+
+    if (host_.empty() || port_ == 0)
+    {
+        qCritical() << "Invalid RTSP URL:" << url.c_str();
+        return false;
+    }
+
+    url_ = url;
+    // 去掉末尾的 '/'，便于拼接轨道控制地址
+    while (url_.size() > prefix.size() && url_.back() == '/')
+        url_.pop_back();
+    return true;
+}
+
+bool CRtspPush::connect(const char* rtsp_url)
+{
+    if (isConnected_)
+    {
+        qCritical() << "Already connected.";
+        return true;
+    }
+
+    if (!rtsp_url || !parseUrl(rtsp_url))
+        return false;
+
+    // ------------------------- 解析地址并建立 TCP 控制连接 -------------------------
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result = nullptr;
+    const std::string portStr = std::to_string(port_);
+    if (getaddrinfo(host_.c_str(), portStr.c_str(), &hints, &result) != 0 || !result)
+    {
+        qCritical() << "Failed to resolve RTSP server:" << host_.c_str();
+        return false;
+    }
+
+    for (addrinfo* ai = result; ai; ai = ai->ai_next)
+    {
+        rtsp_socket_t sock = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (sock == RTSP_INVALID_SOCKET)
+            continue;
+        if (::connect(sock, ai->ai_addr, static_cast<socklen_type>(ai->ai_addrlen)) == 0)
+        {
+            ctrlSock_ = sock;
+            memcpy(&serverAddr_, ai->ai_addr, ai->ai_addrlen);
+            serverAddrLen_ = static_cast<int>(ai->ai_addrlen);
+            break;
+        }
+        closeSocket(sock);
+    }
+    freeaddrinfo(result);
+
+    if (ctrlSock_ == RTSP_INVALID_SOCKET)
+    {
+        qCritical() << "Failed to connect to RTSP server:" << host_.c_str() << port_;
+        return false;
+    }
+
+    // 关闭 Nagle，避免小包（RTSP 请求、音频帧）被延迟合并；增大发送缓冲应对关键帧突发
+    int noDelay = 1;
+    setsockopt(ctrlSock_, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+    int sndBuf = SEND_BUFFER_SIZE;
+    setsockopt(ctrlSock_, SOL_SOCKET, SO_SNDBUF, reinterpret_cast<const char*>(&sndBuf), sizeof(sndBuf));
+    setRecvTimeout(ctrlSock_, CTRL_RECV_TIMEOUT_MS);
+
+    isConnected_ = true;
+
+    // ------------------------- OPTIONS -------------------------
+    const int status = sendRequest("OPTIONS", url_, "", "");
+    if (status != 200)
+    {
+        qCritical() << "RTSP OPTIONS failed, status:" << status;
+        disconnect();
+        return false;
+    }
+
+    qDebug() << "Connected to RTSP server: " << rtsp_url;
+    return true;
+}
+
+void CRtspPush::disconnect()
+{
+    if (!isConnected_)
+        return;
+
+    if (isRecording_)
+    {
+        // 通知接收端流已结束
+        for (RtpChannel* channel : { &videoChannel_, &audioChannel_ })
+        {
+            if (!channel->packetizer)
+                continue;
+            const std::vector<uint8_t> bye = Rtcp::buildBye(channel->packetizer->getSsrc());
+            sendRtcp(*channel, bye.data(), bye.size());
+        }
+        sendRequest("TEARDOWN", url_, "", "");
+        isRecording_ = false;
+    }
+
+    closeChannel(videoChannel_);
+    closeChannel(audioChannel_);
+    closeSocket(ctrlSock_);
+    recvBuf_.clear();
+    session_.clear();
+    isConnected_ = false;
+    qDebug() << "Disconnected from RTSP server.";
+}
+
+bool CRtspPush::isConnected() const
+{
+    return isConnected_ && ctrlSock_ != RTSP_INVALID_SOCKET;
+}
+
+// ------------------------- RTSP 信令 -------------------------
+
+int CRtspPush::sendRequest(const std::string& method, const std::string& url,
+    const std::string& extraHeaders, const std::string& body,
+    std::string* responseHeaders)
+{
+    if (ctrlSock_ == RTSP_INVALID_SOCKET)
+        return -1;
+
+    std::string req;
+    req.reserve(256 + body.size());
+    req += method + " " + url + " RTSP/1.0\r\n";
+    req += "CSeq: " + std::to_string(++cseq_) + "\r\n";
+    req += std::string("User-Agent: ") + USER_AGENT + "\r\n";
+    if (!session_.empty())
+        req += "Session: " + session_ + "\r\n";
+    req += extraHeaders;
+    if (!body.empty())
+        req += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+    req += "\r\n";
+    req += body;
+
+    size_t sent = 0;
+    while (sent < req.size())
+    {
+        const int ret = send(ctrlSock_, req.data() + sent, static_cast<int>(req.size() - sent), RTSP_SEND_FLAGS);
+        if (ret <= 0)
+        {
+            qCritical() << "Failed to send RTSP" << method.c_str() << "request.";
+            return -1;
+        }
+        sent += static_cast<size_t>(ret);
+    }
+
+    std::string headers;
+    if (!readResponse(headers))
+    {
+        qCritical() << "No response for RTSP" << method.c_str() << "request.";
+        return -1;
+    }
+
+    // 状态行：RTSP/1.0 200 OK
+    const size_t sp = headers.find(' ');
+    const int status = (sp != std::string::npos) ? atoi(headers.c_str() + sp + 1) : -1;
+
+    const std::string session = findHeader(headers, "Session");
+    if (!session.empty())
+        session_ = session.substr(0, session.find(';'));   // 去掉 ;timeout=xx
+
+    if (responseHeaders)
+        *responseHeaders = std::move(headers);
+    return status;
+}
+
+bool CRtspPush::readResponse(std::string& headers)
+{
+    char buf[4096];
+    while (true)
+    {
+        // TCP interleaved 模式下，服务器可能在响应之前发送 RTCP RR，直接丢弃
+        if (!recvBuf_.empty() && recvBuf_[0] == '$')
+        {
+            if (recvBuf_.size() >= 4)
+            {
+                const size_t frameLen = 4 + ((static_cast<uint8_t>(recvBuf_[2]) << 8) | static_cast<uint8_t>(recvBuf_[3]));
+                if (recvBuf_.size() >= frameLen)
+                {
+                    recvBuf_.erase(0, frameLen);
+                    continue;
+                }
+            }
+        }
+        else
+        {
+            const size_t headerEnd = recvBuf_.find("\r\n\r\n");
+            if (headerEnd != std::string::npos)
+            {
+                const std::string head = recvBuf_.substr(0, headerEnd + 2);
+                const size_t bodyLen = static_cast<size_t>(atoi(findHeader(head, "Content-Length").c_str()));
+                if (recvBuf_.size() >= headerEnd + 4 + bodyLen)
+                {
+                    recvBuf_.erase(0, headerEnd + 4 + bodyLen);
+                    headers = head;
+                    return true;
+                }
+            }
+        }
+
+        const int ret = recv(ctrlSock_, buf, sizeof(buf), 0);
+        if (ret <= 0)
+            return false;   // 超时或连接关闭
+        recvBuf_.append(buf, static_cast<size_t>(ret));
+    }
+}
+
+std::string CRtspPush::buildSdp() const
+{
+    const bool ipv6 = serverAddr_.ss_family == AF_INET6;
+    const char* addrType = ipv6 ? "IP6" : "IP4";
+
+    std::string sdp;
+    sdp += "v=0\r\n";
+    sdp += std::string("o=- 0 0 IN ") + addrType + " " + host_ + "\r\n";
+    sdp += std::string("s=") + USER_AGENT + "\r\n";
+    sdp += std::string("c=IN ") + addrType + " " + host_ + "\r\n";
+    sdp += "t=0 0\r\n";
+    sdp += std::string("a=tool:") + USER_AGENT + "\r\n";
+
+    // ------------------------- 视频：H.264 -------------------------
+    const std::string pt = std::to_string(VIDEO_PAYLOAD_TYPE);
+    sdp += "m=video 0 RTP/AVP " + pt + "\r\n";
+    sdp += "a=rtpmap:" + pt + " H264/90000\r\n";
+    sdp += "a=fmtp:" + pt + " packetization-mode=1";
+    if (sps_.size() >= 4)
+        sdp += ";profile-level-id=" + hexEncode(sps_.data() + 1, 3);  // profile_idc, constraint flags, level_idc
+    sdp += ";sprop-parameter-sets=" + base64Encode(sps_.data(), sps_.size()) + "," + base64Encode(pps_.data(), pps_.size()) + "\r\n";
+    sdp += "a=control:" + videoChannel_.control + "\r\n";
+
+    // ------------------------- 音频：AAC (RFC 3640) -------------------------
+    const std::string apt = std::to_string(AUDIO_PAYLOAD_TYPE);
+    sdp += "m=audio 0 RTP/AVP " + apt + "\r\n";
+    sdp += "a=rtpmap:" + apt + " MPEG4-GENERIC/" + std::to_string(sampleRate_) + "/" + std::to_string(channels_) + "\r\n";
+    sdp += "a=fmtp:" + apt + " profile-level-id=1;mode=AAC-hbr;sizelength=13;indexlength=3;indexdeltalength=3;config="
+        + hexEncode(asc_.data(), asc_.size()) + "\r\n";
+    sdp += "a=control:" + audioChannel_.control + "\r\n";
+
+    return sdp;
+}
+
+bool CRtspPush::setAVConfig(
+    const uint8_t* sps, size_t sps_len,
+    const uint8_t* pps, size_t pps_len,
+    const uint8_t* asc, size_t asc_len,
+    int sampleRate, int channels)
+{
+    if (!isConnected())
+    {
+        qCritical() << "Not connected to RTSP server.";
+        return false;
+    }
+    if (!sps || sps_len == 0 || !pps || pps_len == 0 || !asc || asc_len == 0 || sampleRate <= 0)
+    {
+        qCritical() << "Invalid AV config for RTSP.";
+        return false;
+    }
+
+    sps_.assign(sps, sps + sps_len);
+    pps_.assign(pps, pps + pps_len);
+    asc_.assign(asc, asc + asc_len);
+    sampleRate_ = sampleRate;
+    channels_ = channels;
+
+    // 音频 RTP 时钟等于采样率，需要按实际采样率重建打包器
+    if (audioPacketizer_->getClockRate() != static_cast<uint32_t>(sampleRate_))
+        audioPacketizer_.reset(new CAacRtpPacketizer(AUDIO_PAYLOAD_TYPE, sampleRate_, audioPacketizer_->getSsrc(), RTP_MTU));
+    videoPacketizer_->setParameterSets(sps_, pps_);
+
+    videoChannel_.packetizer = videoPacketizer_.get();
+    videoChannel_.control = "streamid=0";
+    audioChannel_.packetizer = audioPacketizer_.get();
+    audioChannel_.control = "streamid=1";
+
+    // ------------------------- ANNOUNCE -------------------------
+    int status = sendRequest("ANNOUNCE", url_, "Content-Type: application/sdp\r\n", buildSdp());
+    if (status != 200)
+    {
+        qCritical() << "RTSP ANNOUNCE failed, status:" << status;
+        return false;
+    }
+
+    // ------------------------- SETUP -------------------------
+    if (!setupChannel(videoChannel_, 0) || !setupChannel(audioChannel_, 2))
+        return false;
+
+    // ------------------------- RECORD -------------------------
+    status = sendRequest("RECORD", url_, "Range: npt=0.000-\r\n", "");
+    if (status != 200)
+    {
+        qCritical() << "RTSP RECORD failed, status:" << status;
+        return false;
+    }
+
+    // RTP 包直接交给对应通道发送
+    videoPacketizer_->setSink([this](const uint8_t* data, size_t len) { return sendRtp(videoChannel_, data, len); });
+    audioPacketizer_->setSink([this](const uint8_t* data, size_t len) { return sendRtp(audioChannel_, data, len); });
+
+    isRecording_ = true;
+    qDebug() << "RTSP session" << session_.c_str() << "is recording.";
+    return true;
+}
+
+bool CRtspPush::bindUdpPair(RtpChannel& channel, uint16_t& rtpPort)
+{
+    // RFC 3550：RTP 使用偶数端口，RTCP 使用紧随其后的奇数端口
+    for (int i = 0; i < CLIENT_PORT_TRIES; ++i)
+    {
+        const uint16_t port = static_cast<uint16_t>(CLIENT_PORT_BASE + i * 2);
+        rtsp_socket_t socks[2] = { RTSP_INVALID_SOCKET, RTSP_INVALID_SOCKET };
+        bool ok = true;
+        for (int k = 0; k < 2 && ok; ++k)
+        {
+            socks[k] = socket(serverAddr_.ss_family, SOCK_DGRAM, IPPROTO_UDP);
+            sockaddr_storage local{};
+            local.ss_family = serverAddr_.ss_family;
+            setSockAddrPort(local, static_cast<uint16_t>(port + k));
+            const socklen_type localLen = static_cast<socklen_type>(
+                serverAddr_.ss_family == AF_INET6 ? sizeof(sockaddr_in6) : sizeof(sockaddr_in));
+            ok = socks[k] != RTSP_INVALID_SOCKET && bind(socks[k], reinterpret_cast<sockaddr*>(&local), localLen) == 0;
+        }
+        if (!ok)
+        {
+            closeSocket(socks[0]);
+            closeSocket(socks[1]);
+            continue;
+        }
+
+        int sndBuf = SEND_BUFFER_SIZE;
+        setsockopt(socks[0], SOL_SOCKET, SO_SNDBUF, reinterpret_cast<const char*>(&sndBuf), sizeof(sndBuf));
+        channel.rtpSock = socks[0];
+        channel.rtcpSock = socks[1];
+        rtpPort = port;
+        return true;
+    }
+    return false;
+}
+
+bool CRtspPush::setupChannel(RtpChannel& channel, uint8_t interleavedBase)
+{
+    std::string transport;
+    uint16_t clientPort = 0;
+    if (transport_ == RtpTransport::TCP_INTERLEAVED)
+    {
+        transport = "RTP/AVP/TCP;unicast;interleaved=" + std::to_string(interleavedBase) + "-" + std::to_string(interleavedBase + 1);
+    }
+    else
+    {
+        if (!bindUdpPair(channel, clientPort))
+        {
+            qCritical() << "Failed to bind local RTP/RTCP ports.";
+            return false;
+        }
+        transport = "RTP/AVP/UDP;unicast;client_port=" + std::to_string(clientPort) + "-" + std::to_string(clientPort + 1);
+    }
+    transport += ";mode=record";
+
+    std::string headers;
+    const int status = sendRequest("SETUP", url_ + "/" + channel.control, "Transport: " + transport + "\r\n", "", &headers);
+    if (status != 200)
+    {
+        qCritical() << "RTSP SETUP failed for" << channel.control.c_str() << ", status:" << status;
+        return false;
+    }
+
+    // ------------------------- 以服务器返回的 Transport 为准 -------------------------
+    const std::string reply = findHeader(headers, "Transport");
+    int first = 0, second = 0;
+    if (transport_ == RtpTransport::TCP_INTERLEAVED)
+    {
+        if (!parseRange(reply, "interleaved=", first, second))
+        {
+            first = interleavedBase;
+            second = interleavedBase + 1;
+        }
+        channel.rtpChannelId = static_cast<uint8_t>(first);
+        channel.rtcpChannelId = static_cast<uint8_t>(second);
+    }
+    else
+    {
+        if (!parseRange(reply, "server_port=", first, second))
+        {
+            qCritical() << "RTSP SETUP reply has no server_port:" << reply.c_str();
+            return false;
+        }
+        channel.rtpAddr = serverAddr_;
+        channel.rtcpAddr = serverAddr_;
+        setSockAddrPort(channel.rtpAddr, static_cast<uint16_t>(first));
+        setSockAddrPort(channel.rtcpAddr, static_cast<uint16_t>(second));
+        channel.addrLen = serverAddrLen_;
+    }
+    return true;
+}
+
+// ------------------------- RTP/RTCP 发送 -------------------------
+
+bool CRtspPush::sendInterleaved(uint8_t channelId, const uint8_t* data, size_t len)
+{
+    if (len > 0xFFFF)
+        return false;
+
+    // RFC 2326 10.12：'$' + 通道号 + 2 字节长度
+    const uint8_t header[4] = { '$', channelId, static_cast<uint8_t>(len >> 8), static_cast<uint8_t>(len) };
+    const uint8_t* parts[2] = { header, data };
+    const size_t sizes[2] = { sizeof(header), len };
+    for (int k = 0; k < 2; ++k)
+    {
+        size_t sent = 0;
+        while (sent < sizes[k])
+        {
+            const int ret = send(ctrlSock_, reinterpret_cast<const char*>(parts[k]) + sent,
+                static_cast<int>(sizes[k] - sent), RTSP_SEND_FLAGS);
+            if (ret <= 0)
+            {
+                qCritical() << "Failed to send interleaved RTP data.";
+                return false;
+            }
+            sent += static_cast<size_t>(ret);
+        }
+    }
+    return true;
+}
+
+bool CRtspPush::sendRtp(RtpChannel& channel, const uint8_t* data, size_t len)
+{
+    if (transport_ == RtpTransport::TCP_INTERLEAVED)
+        return sendInterleaved(channel.rtpChannelId, data, len);
+
+    const int ret = sendto(channel.rtpSock, reinterpret_cast<const char*>(data), static_cast<int>(len), 0,
+        reinterpret_cast<const sockaddr*>(&channel.rtpAddr), static_cast<socklen_type>(channel.addrLen));
+    return ret == static_cast<int>(len);
+}
+
+bool CRtspPush::sendRtcp(RtpChannel& channel, const uint8_t* data, size_t len)
+{
+    if (transport_ == RtpTransport::TCP_INTERLEAVED)
+        return sendInterleaved(channel.rtcpChannelId, data, len);
+
+    if (channel.rtcpSock == RTSP_INVALID_SOCKET)
+        return false;
+    const int ret = sendto(channel.rtcpSock, reinterpret_cast<const char*>(data), static_cast<int>(len), 0,
+        reinterpret_cast<const sockaddr*>(&channel.rtcpAddr), static_cast<socklen_type>(channel.addrLen));
+    return ret == static_cast<int>(len);
+}
+
+void CRtspPush::maybeSendSenderReport(RtpChannel& channel)
+{
+    const auto now = std::chrono::steady_clock::now();
+    if (channel.hasSent && now - channel.lastSrTime < std::chrono::seconds(1))
+        return;
+
+    // SR 中的 RTP 时间戳需要与 NTP 时间对应同一时刻：由最近一次发送的时间戳按流逝时间外推
+    const auto elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(now - channel.lastSendTime).count();
+    const uint32_t rtpTs = channel.lastRtpTs +
+        static_cast<uint32_t>(elapsedUs * channel.packetizer->getClockRate() / 1000000);
+
+    const std::vector<uint8_t> sr = Rtcp::buildSenderReport(channel.packetizer->getSsrc(), Rtcp::ntpNow(), rtpTs,
+        channel.packetizer->getPacketCount(), channel.packetizer->getOctetCount(), cname_);
+    sendRtcp(channel, sr.data(), sr.size());
+    channel.lastSrTime = now;
+}
+
+void CRtspPush::drainIncoming()
+{
+    char buf[2048];
+
+    // UDP 模式下服务器会向 RTCP 端口发送 RR
+    if (transport_ == RtpTransport::UDP)
+    {
+        for (RtpChannel* channel : { &videoChannel_, &audioChannel_ })
+        {
+            while (isReadable(channel->rtcpSock))
+            {
+                if (recv(channel->rtcpSock, buf, sizeof(buf), 0) <= 0)
+                    break;
+            }
+        }
+    }
+
+    // 控制连接上的 interleaved RTCP 以及服务器主动发送的消息
+    while (isReadable(ctrlSock_))
+    {
+        const int ret = recv(ctrlSock_, buf, sizeof(buf), 0);
+        if (ret <= 0)
+        {
+            qWarning() << "RTSP control connection closed by server.";
+            // 连接已断开，不再发送 BYE/TEARDOWN，只释放套接字并复位连接状态，之后可以重新 connect()
+            isRecording_ = false;
+            disconnect();
+            return;
+        }
+        recvBuf_.append(buf, static_cast<size_t>(ret));
+    }
+
+    while (!recvBuf_.empty())
+    {
+        size_t consumed = 0;
+        if (recvBuf_[0] == '$')
+        {
+            if (recvBuf_.size() >= 4)
+            {
+                const size_t frameLen = 4 + ((static_cast<uint8_t>(recvBuf_[2]) << 8) | static_cast<uint8_t>(recvBuf_[3]));
+                if (recvBuf_.size() >= frameLen)
+                    consumed = frameLen;
+            }
+        }
+        else
+        {
+            const size_t headerEnd = recvBuf_.find("\r\n\r\n");
+            if (headerEnd != std::string::npos)
+            {
+                const size_t bodyLen = static_cast<size_t>(atoi(findHeader(recvBuf_.substr(0, headerEnd + 2), "Content-Length").c_str()));
+                if (recvBuf_.size() >= headerEnd + 4 + bodyLen)
+                    consumed = headerEnd + 4 + bodyLen;
+            }
+        }
+        if (consumed == 0)
+            break;  // 数据不完整，等下次再处理
+        recvBuf_.erase(0, consumed);
+    }
+}
+
+bool CRtspPush::sendVideo(const uint8_t* data, size_t len, int64_t pts)
+{
+    if (!isRecording_ || !data || len == 0)
+        return false;
+
+    const uint32_t rtpTs = videoChannel_.rtpBase + static_cast<uint32_t>(pts);
+    if (!videoPacketizer_->packetize(data, len, rtpTs))
+    {
+        qCritical() << "Failed to send RTP video packet.";
+        return false;
+    }
+
+    videoChannel_.lastRtpTs = rtpTs;
+    videoChannel_.lastSendTime = std::chrono::steady_clock::now();
+    maybeSendSenderReport(videoChannel_);
+    videoChannel_.hasSent = true;
+
+    drainIncoming();
+    return true;
+}
+
+bool CRtspPush::sendAudio(const uint8_t* data, size_t len, int64_t pts)
+{
+    if (!isRecording_ || !data || len == 0)
+        return false;
+
+    const uint32_t rtpTs = audioChannel_.rtpBase + static_cast<uint32_t>(pts);
+    if (!audioPacketizer_->packetize(data, len, rtpTs))
+    {
+        qCritical() << "Failed to send RTP audio packet.";
+        return false;
+    }
+
+    audioChannel_.lastRtpTs = rtpTs;
+    audioChannel_.lastSendTime = std::chrono::steady_clock::now();
+    maybeSendSenderReport(audioChannel_);
+    audioChannel_.hasSent = true;
+    return true;
+}
+
+void CRtspPush::closeChannel(RtpChannel& channel)
+{
+    closeSocket(channel.rtpSock);
+    closeSocket(channel.rtcpSock);
+    channel.hasSent = false;
+}
@@ -0,0 +1,173 @@
+#ifndef RTSP_PUSH_H
+#define RTSP_PUSH_H
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+using rtsp_socket_t = SOCKET;
+#define RTSP_INVALID_SOCKET INVALID_SOCKET
+#else
+#include <sys/socket.h>
+using rtsp_socket_t = int;
+#define RTSP_INVALID_SOCKET (-1)
+#endif
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <cstdint>
+
+#include "RtspPublisher/RtpPacketizer/RtpPacketizer.h"
+#include "Common/DataDefine.h"
+
+/**
+ * @brief RTSP 推流器（ANNOUNCE/RECORD 模式）
+ *
+ * 负责 RTSP 信令（OPTIONS -> ANNOUNCE -> SETUP x2 -> RECORD -> TEARDOWN）
+ * 以及 RTP/RTCP 的发送，支持 UDP 与 TCP interleaved 两种传输方式。
+ * 与 CRtmpPush 一样，所有接口都在调用线程同步执行。
+ */
+class CRtspPush {
+public:
+    explicit CRtspPush(RtpTransport transport = RtpTransport::UDP);
+
+    ~CRtspPush();
+
+    CRtspPush(const CRtspPush&) = delete;
+    CRtspPush& operator=(const CRtspPush&) = delete;
+
+    /**
+     * @brief 建立 RTSP 控制连接并发送 OPTIONS
+     * @param rtsp_url 形如 rtsp://host[:port]/app/stream
+     */
+    bool connect(const char* rtsp_url);
+
+    /**
+     * @brief 发送 TEARDOWN 并关闭所有套接字
+     */
+    void disconnect();
+
+    bool isConnected() const;
+
+    /**
+     * @brief 根据编码参数生成 SDP，并完成 ANNOUNCE、SETUP 与 RECORD。
+     *
+     * 此方法应在 connect 之后，开始发送媒体数据之前调用。
+     *
+     * @param sps H.264 SPS（不含起始码）
+     * @param pps H.264 PPS（不含起始码）
+     * @param asc AAC AudioSpecificConfig
+     * @param sampleRate 音频采样率，同时也是音频 RTP 时钟频率
+     * @param channels 音频声道数
+     * @return true 服务器已进入 RECORD 状态
+     */
+    bool setAVConfig(
+        const uint8_t* sps, size_t sps_len,
+        const uint8_t* pps, size_t pps_len,
+        const uint8_t* asc, size_t asc_len,
+        int sampleRate, int channels);
+
+    /**
+     * @brief 发送一个 H.264 Access Unit
+     * @param data Annex B 格式数据（含起始码，可包含多个 NAL）
+     * @param len 数据长度
+     * @param pts 显示时间戳，单位 1/90000 秒
+     */
+    bool sendVideo(const uint8_t* data, size_t len, int64_t pts);
+
+    /**
+     * @brief 发送一帧 AAC
+     * @param data 原始 AAC 帧（不含 ADTS 头）
+     * @param len 数据长度
+     * @param pts 显示时间戳，单位 1/sampleRate 秒
+     */
+    bool sendAudio(const uint8_t* data, size_t len, int64_t pts);
+
+private:
+    // 单条媒体轨道的发送通道
+    struct RtpChannel
+    {
+        CRtpPacketizer* packetizer = nullptr;
+        std::string control;                // SDP 中的 a=control
+
+        // UDP 模式
+        rtsp_socket_t rtpSock = RTSP_INVALID_SOCKET;
+        rtsp_socket_t rtcpSock = RTSP_INVALID_SOCKET;
+        sockaddr_storage rtpAddr{};
+        sockaddr_storage rtcpAddr{};
+        int addrLen = 0;
+
+        // TCP interleaved 模式
+        uint8_t rtpChannelId = 0;
+        uint8_t rtcpChannelId = 1;
+
+        // RTP 时间戳随机起点，以及用于生成 SR 的最近一次发送记录
+        uint32_t rtpBase = 0;
+        uint32_t lastRtpTs = 0;
+        bool hasSent = false;
+        std::chrono::steady_clock::time_point lastSendTime{};
+        std::chrono::steady_clock::time_point lastSrTime{};
+    };
+
+    bool parseUrl(const std::string& url);
+
+    /**
+     * @brief 发送一个 RTSP 请求并等待响应
+     * @return 响应状态码，网络错误时返回 -1
+     */
+    int sendRequest(const std::string& method, const std::string& url,
+        const std::string& extraHeaders, const std::string& body,
+        std::string* responseHeaders = nullptr);
+
+    // 从控制连接读取一个完整的 RTSP 响应，跳过夹杂的 interleaved 帧
+    bool readResponse(std::string& headers);
+
+    std::string buildSdp() const;
+
+    bool setupChannel(RtpChannel& channel, uint8_t interleavedBase);
+    bool bindUdpPair(RtpChannel& channel, uint16_t& rtpPort);
+
+    bool sendRtp(RtpChannel& channel, const uint8_t* data, size_t len);
+    bool sendRtcp(RtpChannel& channel, const uint8_t* data, size_t len);
+    bool sendInterleaved(uint8_t channelId, const uint8_t* data, size_t len);
+
+    // 距离上一次 SR 超过 1 秒时发送 RTCP SR
+    void maybeSendSenderReport(RtpChannel& channel);
+
+    // 丢弃服务器发来的 RTCP RR 等数据，防止接收缓冲区堆积
+    void drainIncoming();
+
+    void closeChannel(RtpChannel& channel);
+
+private:
+    RtpTransport transport_ = RtpTransport::UDP;
+
+    rtsp_socket_t ctrlSock_ = RTSP_INVALID_SOCKET;
+    sockaddr_storage serverAddr_{};
+    int serverAddrLen_ = 0;
+    std::string recvBuf_{};                 // 控制连接的接收缓存
+
+    std::string url_{};
+    std::string host_{};
+    uint16_t port_ = 554;
+    std::string session_{};
+    int cseq_ = 0;
+    std::string cname_{};
+
+    bool isConnected_ = false;
+    bool isRecording_ = false;
+
+    std::vector<uint8_t> sps_{};
+    std::vector<uint8_t> pps_{};
+    std::vector<uint8_t> asc_{};
+    int sampleRate_ = 48000;
+    int channels_ = 2;
+
+    std::unique_ptr<CH264RtpPacketizer> videoPacketizer_{};
+    std::unique_ptr<CAacRtpPacketizer> audioPacketizer_{};
+    RtpChannel videoChannel_{};
+    RtpChannel audioChannel_{};
+};
+
+#endif // RTSP_PUSH_H